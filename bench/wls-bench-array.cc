@@ -0,0 +1,165 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-array.cc
+/// \brief Memory and navigation speed of the cube-array geometry
+//
+// Usage: wls-bench-array [nrays] [n ...]
+//
+//   Builds the n x n x n array (default n = 3 30 100) with
+//   WLSDetectorConstruction, closes the geometry (voxelisation included)
+//   and reports the resident memory it took, the number of physical
+//   volumes in the store and the time to build.  Then nrays straight rays
+//   (default 10000) start at random points inside the block with random
+//   directions and are navigated to the block surface; the report gives
+//   the navigation steps per ray and the time per step.  No physics is
+//   involved.  Every size runs in its own process so that the memory
+//   figures do not mix.
+//
+
+#include "WLSDetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+
+double ResidentMB()
+{
+    long pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    std::fclose(f);
+    return resident * (double) sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+}
+
+void RunSize(int n, long nrays)
+{
+    // fibers of 2 m, readout 1 m from the centre: long enough for 100^3
+    G4RunManager* runManager = new G4RunManager;
+    WLSDetectorConstruction* detector = new WLSDetectorConstruction(200, 100, 0, 0.97);
+    detector->SetArraySize(n, n, n);
+
+    double before = ResidentMB();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    G4VPhysicalVolume* world = detector->Construct();
+    G4GeometryManager::GetInstance()->CloseGeometry(true);
+    double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double memory = ResidentMB() - before;
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+
+    G4double half = n * detector->GetCubePitch() / 2;
+    long steps = 0;
+    start = std::chrono::steady_clock::now();
+    for (long r = 0; r < nrays; r++)
+    {
+        G4ThreeVector p(half * (2 * G4UniformRand() - 1), half * (2 * G4UniformRand() - 1),
+                        half * (2 * G4UniformRand() - 1));
+        G4double cost = 2 * G4UniformRand() - 1;
+        G4double phi = twopi * G4UniformRand();
+        G4double sint = std::sqrt(1 - cost * cost);
+        G4ThreeVector dir(sint * std::cos(phi), sint * std::sin(phi), cost);
+
+        navigator.LocateGlobalPointAndSetup(p, &dir, false, false);
+        // the limit only guards against a navigator stuck on a surface
+        for (long k = 0; k < 100000 && std::fabs(p.x()) < half && std::fabs(p.y()) < half &&
+             std::fabs(p.z()) < half; k++)
+        {
+            G4double safety = 0;
+            G4double step = navigator.ComputeStep(p, dir, kInfinity, safety);
+            if (step == kInfinity)
+                break;
+            p += step * dir;
+            navigator.SetGeometricallyLimitedStep();
+            if (!navigator.LocateGlobalPointAndSetup(p, &dir, true))
+                break;
+            steps++;
+        }
+    }
+    double navigate = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%5d^3 %10.0f %10ld %10.1f %10.3f %10.1f %10.1f\n", n, std::pow((double) n, 3),
+                (long) G4PhysicalVolumeStore::GetInstance()->size(), memory, build,
+                nrays ? (double) steps / nrays : 0., steps ? 1e9 * navigate / steps : 0.);
+    std::fflush(stdout);
+
+    delete runManager;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long nrays = argc > 1 ? std::atol(argv[1]) : 10000;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; i++)
+        sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty())
+    {
+        sizes.push_back(3);
+        sizes.push_back(30);
+        sizes.push_back(100);
+    }
+
+    std::printf("%7s %10s %10s %10s %10s %10s %10s\n",
+                "array", "cubes", "PVs", "MB", "build s", "steps/ray", "ns/step");
+    std::fflush(stdout);
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        pid_t pid = fork();
+        if (pid > 0)
+        {
+            waitpid(pid, 0, 0);
+            continue;
+        }
+        if (pid < 0)
+            return 1;
+
+        CLHEP::HepRandom::setTheSeed(12345);
+        RunSize(sizes[s], nrays);
+        return 0;
+    }
+    return 0;
+}
@@ -0,0 +1,315 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-cell.cc
+/// \brief Time per photon of WLSCellTracer, and its capture against Geant4
+//
+// Usage: wls-bench-cell [nphotons] [x y z]
+//        wls-bench-cell -v [photons per event] [events] [x y z]
+//
+//   The first form traces nphotons (default 200000) scintillation photons
+//   from the point (x, y, z) of the cube, in mm from its centre (default
+//   the centre), handing them to Trace() in calls of 1, 16, 256 and all
+//   photons.  The report gives the time per photon, which shows what the
+//   batches gain, and the fraction captured by each view.  The cell is
+//   the one WLSDetectorConstruction builds by default.
+//
+//   -v (validation) builds a single cube with the wls geometry and
+//   physics list and shoots events of photons per event (default 1000)
+//   optical photons from the point, events times (default 100).  A
+//   stepping action kills every optical photon that leaves the cell and
+//   counts those in a fiber; the same photons go through the tracer.
+//   The report gives the captured fraction of each view and end for
+//   both, the pull of the difference and the time per photon of each.
+//
+
+#include "WLSCellTracer.hh"
+#include "WLSDetectorConstruction.hh"
+#include "WLSPhysicsList.hh"
+
+#include "G4Event.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4UImanager.hh"
+#include "G4UserSteppingAction.hh"
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Timing: the same photons, handed to Trace() in calls of `call` photons
+void Time(const WLSCellTracer& tracer, const G4ThreeVector& position, G4int nphotons)
+{
+    std::printf("%-10s %9s %9s %9s %9s %9s %9s %12s\n", "per call", "X", "Y", "Z",
+                "coating", "escaped", "wls", "us/photon");
+    const G4int calls[] = { 1, 16, WLSCellTracer::kBatch, nphotons };
+    for (size_t c = 0; c < sizeof(calls) / sizeof(calls[0]); c++)
+    {
+        CLHEP::HepRandom::setTheSeed(12345);
+        WLSCellTracer::Photons all;
+        tracer.Generate(position, nphotons, all);
+
+        WLSCellTracer::Tally tally;
+        WLSCellTracer::Photons part;
+        double seconds = 0;
+        for (G4int first = 0; first < nphotons; first += calls[c])
+        {
+            G4int n = std::min(calls[c], nphotons - first);
+            part.Resize(n);
+            for (G4int i = 0; i < n; i++)
+            {
+                part.x[i] = all.x[first + i];
+                part.y[i] = all.y[first + i];
+                part.z[i] = all.z[first + i];
+                part.dx[i] = all.dx[first + i];
+                part.dy[i] = all.dy[first + i];
+                part.dz[i] = all.dz[first + i];
+                part.px[i] = all.px[first + i];
+                part.py[i] = all.py[first + i];
+                part.pz[i] = all.pz[first + i];
+                part.energy[i] = all.energy[first + i];
+                part.time[i] = all.time[first + i];
+            }
+            Clock::time_point start = Clock::now();
+            tracer.Trace(part);
+            seconds += Seconds(start);
+            tally.Add(part);
+        }
+        char name[32];
+        std::sprintf(name, "%d", calls[c]);
+        std::printf("%-10s", name);
+        for (G4int v = 0; v < 3; v++)
+            std::printf(" %9.5f", tally.Efficiency(v));
+        std::printf(" %9.5f %9.5f %9.5f %12.3f\n",
+                    G4double(tally.fates[WLSCellTracer::kAbsorbedCoating]) / tally.photons,
+                    G4double(tally.fates[WLSCellTracer::kEscaped]) / tally.photons,
+                    G4double(tally.wls) / tally.photons, 1e6 * seconds / nphotons);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Optical photons from the tracer's Generate(), as primaries; the same
+// photons go through the tracer
+class Source : public G4VUserPrimaryGeneratorAction
+{
+  public:
+
+    Source(const WLSCellTracer& tracer, const G4ThreeVector& centre,
+           const G4ThreeVector& position, G4int n)
+      : fTracer(tracer), fCentre(centre), fPosition(position), fN(n), fSeconds(0) {}
+
+    virtual void GeneratePrimaries(G4Event* event)
+    {
+        WLSCellTracer::Photons photons;
+        fTracer.Generate(fPosition, fN, photons);
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(fCentre + fPosition, 0);
+        for (G4int i = 0; i < fN; i++)
+        {
+            G4PrimaryParticle* particle = new G4PrimaryParticle(G4OpticalPhoton::Definition());
+            particle->SetMomentumDirection(G4ThreeVector(photons.dx[i], photons.dy[i], photons.dz[i]));
+            particle->SetKineticEnergy(photons.energy[i]);
+            particle->SetPolarization(photons.px[i], photons.py[i], photons.pz[i]);
+            vertex->SetPrimary(particle);
+        }
+        event->AddPrimaryVertex(vertex);
+
+        Clock::time_point start = Clock::now();
+        fTracer.Trace(photons);
+        fSeconds += Seconds(start);
+        fTally.Add(photons);
+    }
+
+    const WLSCellTracer::Tally& GetTally() const { return fTally; }
+    double GetSeconds() const { return fSeconds; }
+
+  private:
+
+    const WLSCellTracer& fTracer;
+    G4ThreeVector fCentre;
+    G4ThreeVector fPosition;
+    G4int fN;
+    WLSCellTracer::Tally fTally;
+    double fSeconds;
+};
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Kills optical photons where they leave the cell and counts them as the
+// tracer does: captured if in a fiber, else escaped
+class Counter : public G4UserSteppingAction
+{
+  public:
+
+    Counter(const WLSCellTracer& tracer, const G4ThreeVector& centre)
+      : fTracer(tracer), fCentre(centre) {}
+
+    virtual void UserSteppingAction(const G4Step* step)
+    {
+        G4Track* track = step->GetTrack();
+        if (track->GetDefinition() != G4OpticalPhoton::Definition())
+            return;
+        if (track->GetCurrentStepNumber() == 1 && track->GetParentID() == 0)
+            fTally.photons++;
+        if (step->GetPostStepPoint()->GetProcessDefinedStep() &&
+            step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName() == "OpWLS")
+            fTally.wls++;
+
+        G4ThreeVector p = step->GetPostStepPoint()->GetPosition() - fCentre;
+        G4double edge = fTracer.GetCell().pitch / 2 - 1e-6 * mm;
+        if (std::abs(p.x()) < edge && std::abs(p.y()) < edge && std::abs(p.z()) < edge)
+            return;
+        G4int view = fTracer.FiberAt(p);
+        if (view >= 0)
+        {
+            fTally.fates[WLSCellTracer::kCapturedX + view]++;
+            fTally.ends[view][p.dot(fTracer.GetFiberAxis(view)) > 0 ? 0 : 1]++;
+        }
+        else
+            fTally.fates[WLSCellTracer::kEscaped]++;
+        track->SetTrackStatus(fStopAndKill);
+    }
+
+    const WLSCellTracer::Tally& GetTally() const { return fTally; }
+
+  private:
+
+    const WLSCellTracer& fTracer;
+    G4ThreeVector fCentre;
+    WLSCellTracer::Tally fTally;
+};
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Validate(const G4ThreeVector& position, G4int perEvent, G4int events)
+{
+    G4RunManager* runManager = new G4RunManager;
+    WLSDetectorConstruction* detector = new WLSDetectorConstruction(200, 100, 0, 0.97);
+    detector->SetArraySize(1, 1, 1);
+    runManager->SetUserInitialization(detector);
+    runManager->SetUserInitialization(new WLSPhysicsList("FTFP_BERT"));
+    G4UImanager::GetUIpointer()->ApplyCommand("/control/verbose 0");
+    G4UImanager::GetUIpointer()->ApplyCommand("/run/verbose 0");
+    runManager->Initialize();
+
+    WLSCellTracer tracer((WLSCellTracer::Cell(detector)));
+    G4ThreeVector centre = detector->GetCubeCentre(0);
+    Source* source = new Source(tracer, centre, position, perEvent);
+    Counter* counter = new Counter(tracer, centre);
+    runManager->SetUserAction(source);
+    runManager->SetUserAction(counter);
+
+    CLHEP::HepRandom::setTheSeed(12345);
+    Clock::time_point start = Clock::now();
+    runManager->BeamOn(events);
+    // the generator traced the photons too
+    double geant4 = Seconds(start) - source->GetSeconds();
+
+    const WLSCellTracer::Tally& fast = source->GetTally();
+    const WLSCellTracer::Tally& full = counter->GetTally();
+    std::printf("\n%-10s %9s %9s %9s %9s\n", "", "X", "Y", "Z", "escaped");
+    const WLSCellTracer::Tally* tallies[2] = { &fast, &full };
+    const char* names[2] = { "tracer", "Geant4" };
+    G4double pull[4];
+    for (G4int t = 0; t < 2; t++)
+    {
+        std::printf("%-10s", names[t]);
+        for (G4int v = 0; v < 4; v++)
+        {
+            G4double eff = v < 3 ? tallies[t]->Efficiency(v)
+                                 : G4double(tallies[t]->fates[WLSCellTracer::kEscaped]) / tallies[t]->photons;
+            std::printf(" %9.5f", eff);
+        }
+        std::printf("\n");
+    }
+    for (G4int v = 0; v < 4; v++)
+    {
+        G4double p[2], var = 0;
+        for (G4int t = 0; t < 2; t++)
+        {
+            p[t] = v < 3 ? tallies[t]->Efficiency(v)
+                         : G4double(tallies[t]->fates[WLSCellTracer::kEscaped]) / tallies[t]->photons;
+            var += p[t] * (1 - p[t]) / tallies[t]->photons;
+        }
+        pull[v] = var > 0 ? (p[0] - p[1]) / std::sqrt(var) : 0;
+    }
+    std::printf("%-10s %9.2f %9.2f %9.2f %9.2f\n", "pull", pull[0], pull[1], pull[2], pull[3]);
+    for (G4int t = 0; t < 2; t++)
+    {
+        std::printf("%-10s ends", names[t]);
+        for (G4int v = 0; v < 3; v++)
+            std::printf("  %ld/%ld", tallies[t]->ends[v][0], tallies[t]->ends[v][1]);
+        std::printf("  wls/photon %.4f\n", G4double(tallies[t]->wls) / tallies[t]->photons);
+    }
+    std::printf("us/photon: tracer %.3f, Geant4 %.3f\n",
+                1e6 * source->GetSeconds() / fast.photons, 1e6 * geant4 / full.photons);
+
+    delete runManager;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    G4bool validate = argc > 1 && !std::strcmp(argv[1], "-v");
+    G4int first = validate ? 2 : 1;
+    G4int counts = validate ? 2 : 1;
+    G4int n[2] = { validate ? 1000 : 200000, 100 };
+    for (G4int i = 0; i < counts && first < argc; i++)
+        n[i] = std::atoi(argv[first++]);
+    G4ThreeVector position;
+    if (argc >= first + 3)
+        position.set(std::atof(argv[first]) * mm, std::atof(argv[first + 1]) * mm, std::atof(argv[first + 2]) * mm);
+
+    if (validate)
+    {
+        Validate(position, n[0], n[1]);
+        return 0;
+    }
+
+    WLSDetectorConstruction detector(200, 100, 0, 0.97);
+    WLSCellTracer tracer((WLSCellTracer::Cell(&detector)));
+    Time(tracer, position, n[0]);
+    return 0;
+}
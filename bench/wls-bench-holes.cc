@@ -0,0 +1,216 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-holes.cc
+/// \brief Boolean holes against daughter holes: time per optical step
+//
+// Usage: wls-bench-holes [nphotons]
+//
+//   Builds the nine-cube layer once with the holes subtracted from the
+//   cube and coating solids ("boolean") and once with plain boxes and air
+//   tube daughters ("daughter"), and tracks nphotons (default 100000) toy
+//   optical photons in each.  A photon starts at a random point of the
+//   centre scintillator with a random direction and goes straight through
+//   the cube and the holes; on the coating it is reflected diffusely with
+//   probability 0.97 and absorbed otherwise, and it is captured by the
+//   first fiber cladding it enters.  The report gives the navigation steps
+//   per photon, the time per step and the fraction captured by each view.
+//   Both modes get the same random numbers, so the captured fractions
+//   must agree within their errors; the last line gives the pull of the
+//   total.  No physics list is involved; a full comparison is
+//   "/WLS/setHoleMode" in two runs of wls.
+//
+
+#include "WLSDetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const double kReflectivity = 0.97;
+const long kMaxSteps = 100000;
+
+struct Result
+{
+    long photons;
+    long steps;
+    long captured[3];
+    long absorbed;
+    long escaped;
+    double seconds;
+};
+
+G4ThreeVector Isotropic()
+{
+    G4double cost = 2 * G4UniformRand() - 1;
+    G4double phi = twopi * G4UniformRand();
+    G4double sint = std::sqrt(1 - cost * cost);
+    return G4ThreeVector(sint * std::cos(phi), sint * std::sin(phi), cost);
+}
+
+// Cosine-weighted direction about the unit vector n
+G4ThreeVector Lambertian(const G4ThreeVector& n)
+{
+    G4ThreeVector dir;
+    do
+    {
+        dir = n + Isotropic();
+    }
+    while (dir.mag2() < 1e-12);
+    return dir.unit();
+}
+
+Result Run(WLSDetectorConstruction* detector, const G4String& mode, long nphotons)
+{
+    detector->SetHoleMode(mode);
+    G4VPhysicalVolume* world = detector->Construct();
+    G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+
+    Result r = { nphotons, 0, { 0, 0, 0 }, 0, 0, 0. };
+    G4double half = detector->GetBarBase() / 2;
+    G4double cell = detector->GetCubePitch() / 2;
+
+    CLHEP::HepRandom::setTheSeed(12345);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < nphotons; i++)
+    {
+        G4ThreeVector p;
+        G4ThreeVector dir = Isotropic();
+        G4VPhysicalVolume* pv = 0;
+        do
+        {
+            p = G4ThreeVector(half * (2 * G4UniformRand() - 1), half * (2 * G4UniformRand() - 1),
+                              half * (2 * G4UniformRand() - 1));
+            pv = navigator.LocateGlobalPointAndSetup(p, &dir, false, false);
+        }
+        while (!pv || pv->GetName() != "SciCube");
+
+        long k = 0;
+        for (; k < kMaxSteps; k++)
+        {
+            G4double safety = 0;
+            G4double step = navigator.ComputeStep(p, dir, kInfinity, safety);
+            if (step == kInfinity)
+                break;
+            p += step * dir;
+            navigator.SetGeometricallyLimitedStep();
+            pv = navigator.LocateGlobalPointAndSetup(p, &dir, true);
+            r.steps++;
+            if (!pv || std::fabs(p.x()) > cell || std::fabs(p.y()) > cell || std::fabs(p.z()) > cell)
+            {
+                // out through a hole into the neighbouring cubes
+                r.escaped++;
+                break;
+            }
+            const G4String& name = pv->GetName();
+            if (name.compare(0, 13, "WLSFiberClad2") == 0)
+            {
+                r.captured[name[13] - 'X']++;
+                break;
+            }
+            if (name == "Extrusion")
+            {
+                if (G4UniformRand() > kReflectivity)
+                {
+                    r.absorbed++;
+                    break;
+                }
+                G4bool valid = false;
+                G4ThreeVector n = navigator.GetGlobalExitNormal(p, &valid);
+                if (!valid)
+                    n = dir;
+                p -= 1 * nm * dir;
+                dir = Lambertian(-n);
+                navigator.LocateGlobalPointAndSetup(p, &dir, false, false);
+            }
+        }
+        if (k == kMaxSteps)
+            r.escaped++;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return r;
+}
+
+double Fraction(const Result& r, double* error)
+{
+    double f = (double) (r.captured[0] + r.captured[1] + r.captured[2]) / r.photons;
+    *error = std::sqrt(f * (1 - f) / r.photons);
+    return f;
+}
+
+void Print(const G4String& mode, const Result& r)
+{
+    double error = 0;
+    double f = Fraction(r, &error);
+    std::printf("%-9s %10ld %10.1f %10.1f %9.4f %9.4f %9.4f %9.4f +- %.4f\n", mode.c_str(), r.photons,
+                (double) r.steps / r.photons, r.steps ? 1e9 * r.seconds / r.steps : 0.,
+                (double) r.captured[0] / r.photons, (double) r.captured[1] / r.photons,
+                (double) r.captured[2] / r.photons, f, error);
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long nphotons = argc > 1 ? std::atol(argv[1]) : 100000;
+    if (nphotons <= 0)
+        return 1;
+
+    G4RunManager* runManager = new G4RunManager;
+    WLSDetectorConstruction* detector = new WLSDetectorConstruction(200, 100, 0, kReflectivity);
+
+    std::printf("%-9s %10s %10s %10s %9s %9s %9s %9s\n",
+                "holes", "photons", "steps/ph", "ns/step", "X", "Y", "Z", "captured");
+    Result boolean = Run(detector, "boolean", nphotons);
+    Print("boolean", boolean);
+    Result daughter = Run(detector, "daughter", nphotons);
+    Print("daughter", daughter);
+
+    double eb = 0, ed = 0;
+    double fb = Fraction(boolean, &eb);
+    double fd = Fraction(daughter, &ed);
+    double pull = eb + ed > 0 ? (fd - fb) / std::sqrt(eb * eb + ed * ed) : 0.;
+    std::printf("captured fraction difference %.5f, pull %.2f (%s)\n", fd - fb, pull,
+                std::fabs(pull) < 3 ? "agree" : "DISAGREE");
+
+    delete runManager;
+    return std::fabs(pull) < 3 ? 0 : 2;
+}
@@ -0,0 +1,197 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-output.cc
+/// \brief Bytes written and time per event for each output backend
+//
+// Usage: wls-bench-output [nevents] [backend ...]
+//
+//   Books the "cube" ntuple and the trigger histograms exactly as
+//   WLSRunAction does and fills nevents rows (default 100000) of
+//   plausible values through each backend (default: root csv bin).
+//   Every backend writes into its own temporary directory; the report
+//   gives the wall time, the time per event and the bytes on disk.
+//   No geometry or physics is involved, so this measures the output
+//   path alone.  Each backend runs in its own process, because the
+//   Geant4 analysis managers are per-process singletons.
+//
+
+#include "WLSOutputWriter.hh"
+
+#include "Randomize.hh"
+#include "G4Poisson.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+namespace {
+
+const int kNColumns = 48;   // n e x y z nPhotons npx* npy* npz** time lasttime hittimez** in/out edep edep**
+
+void Book(WLSOutputWriter* w)
+{
+    char name[32];
+    w->CreateNtuple("cube", "nine cubes");
+    const char* head[] = { "n", "e", "x", "y", "z", "nPhotons" };
+    for (int i = 0; i < 6; i++)
+        w->CreateNtupleDColumn(0, head[i]);
+    for (int i = 0; i < 3; i++) { std::sprintf(name, "npx%d", i); w->CreateNtupleDColumn(0, name); }
+    for (int i = 0; i < 3; i++) { std::sprintf(name, "npy%d", i); w->CreateNtupleDColumn(0, name); }
+    for (int i = 0; i < 9; i++) { std::sprintf(name, "npz%d%d", i / 3, i % 3); w->CreateNtupleDColumn(0, name); }
+    w->CreateNtupleDColumn(0, "time");
+    w->CreateNtupleDColumn(0, "lasttime");
+    for (int i = 0; i < 9; i++) { std::sprintf(name, "hittimez%d%d", i / 3, i % 3); w->CreateNtupleDColumn(0, name); }
+    const char* tail[] = { "cubeinposx", "cubeinposy", "cubeinposz",
+                           "cubeoutposx", "cubeoutposy", "cubeoutposz" };
+    for (int i = 0; i < 6; i++)
+        w->CreateNtupleDColumn(0, tail[i]);
+    w->CreateNtupleDColumn(0, "edep");
+    for (int i = 0; i < 9; i++) { std::sprintf(name, "edep%d%d", i / 3, i % 3); w->CreateNtupleDColumn(0, name); }
+    w->FinishNtuple(0);
+
+    w->CreateH1("trigger", "rejected (0) / accepted (1) events", 2, -0.5, 1.5);
+    w->CreateH1("rejectedTotal", "total photons of rejected events", 200, -0.5, 199.5);
+}
+
+long DirectoryBytes(const std::string& dir)
+{
+    long bytes = 0;
+    DIR* d = opendir(dir.c_str());
+    if (!d)
+        return 0;
+    while (dirent* e = readdir(d))
+    {
+        struct stat st;
+        std::string path = dir + "/" + e->d_name;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            bytes += st.st_size;
+    }
+    closedir(d);
+    return bytes;
+}
+
+void RemoveDirectory(const std::string& dir)
+{
+    DIR* d = opendir(dir.c_str());
+    if (!d)
+        return;
+    while (dirent* e = readdir(d))
+    {
+        std::string path = dir + "/" + e->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            unlink(path.c_str());
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long nevents = argc > 1 ? std::atol(argv[1]) : 100000;
+    std::vector<std::string> backends;
+    for (int i = 2; i < argc; i++)
+        backends.push_back(argv[i]);
+    if (backends.empty())
+    {
+        backends.push_back("root");
+        backends.push_back("csv");
+        backends.push_back("bin");
+    }
+
+    std::printf("%-6s %12s %14s %14s %14s\n", "format", "events", "seconds", "us/event", "bytes");
+    std::fflush(stdout);
+    for (size_t b = 0; b < backends.size(); b++)
+    {
+        pid_t pid = fork();
+        if (pid > 0)
+        {
+            waitpid(pid, 0, 0);
+            continue;
+        }
+        if (pid < 0)
+            return 1;
+
+        WLSOutputWriter* w = WLSOutputWriter::Create(backends[b]);
+        if (!w)
+        {
+            std::fprintf(stderr, "unknown backend %s\n", backends[b].c_str());
+            return 1;
+        }
+        char dir[] = "/tmp/wls-bench-output-XXXXXX";
+        if (!mkdtemp(dir))
+            return 1;
+        Book(w);
+
+        CLHEP::HepRandom::setTheSeed(12345);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        w->OpenFile(std::string(dir) + "/cube");
+        for (long e = 0; e < nevents; e++)
+        {
+            double v[kNColumns];
+            v[0] = e;
+            v[1] = 1.0;
+            for (int c = 2; c < 5; c++)
+                v[c] = 10 * (G4UniformRand() - 0.5);
+            v[5] = G4Poisson(8000);
+            for (int c = 6; c < 21; c++)
+                v[c] = G4Poisson(c == 7 || c == 10 || c == 16 ? 20 : 1);
+            v[21] = 2 + 3 * G4UniformRand();
+            v[22] = v[21] + 40 * G4UniformRand();
+            for (int c = 23; c < 38; c++)
+                v[c] = G4UniformRand();
+            v[38] = 0;  // deposit in the central cube (edep11) only
+            for (int c = 39; c < kNColumns; c++)
+                v[38] += (v[c] = c == 43 ? 2 * G4UniformRand() : 0);
+
+            w->FillH1(0, 1);
+            for (int c = 0; c < kNColumns; c++)
+                w->FillNtupleDColumn(0, c, v[c]);
+            w->AddNtupleRow(0);
+        }
+        w->Write();
+        w->CloseFile();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-6s %12ld %14.3f %14.3f %14ld\n", backends[b].c_str(), nevents,
+                    seconds, 1e6 * seconds / nevents, DirectoryBytes(dir));
+        std::fflush(stdout);
+        delete w;
+        RemoveDirectory(dir);
+        return 0;
+    }
+    return 0;
+}
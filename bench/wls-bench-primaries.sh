@@ -0,0 +1,56 @@
+#!/bin/bash
+#
+# Events per second of the GPS path (gen_mutex) and of /WLS/gun/beam
+#
+# Usage: bench/wls-bench-primaries.sh [nevents] [threads ...]
+#
+#   Runs wls (WLS=path, default ./wls) without optical physics, so that
+#   the start of an event weighs as much as possible, once with the GPS
+#   and once with the pencil beam of the same particle, for each number
+#   of threads (default 1 8 32 64).  nevents (default 20000) are timed
+#   after 200 warm-up events.  PARTICLE and ENERGY (default e+ 1 MeV)
+#   set the primary.  Needs a multithreaded Geant4.
+
+WLS=${WLS:-./wls}
+WLS=`cd $(dirname $WLS) && pwd`/`basename $WLS`
+NEVENTS=${1:-20000}
+shift
+THREADS=${@:-1 8 32 64}
+PARTICLE=${PARTICLE:-e+}
+ENERGY=${ENERGY:-1 MeV}
+
+DIR=`mktemp -d /tmp/wls-bench-primaries-XXXXXX`
+cd $DIR
+
+printf "%-6s %8s %10s %10s %12s\n" "source" "threads" "events" "seconds" "events/s"
+for t in $THREADS; do
+    for source in gps beam; do
+        {
+            echo "/run/initialize"
+            if [ $source = gps ]; then
+                echo "/gps/particle $PARTICLE"
+                echo "/gps/ene/mono $ENERGY"
+                echo "/gps/direction 0 0 -1"
+                echo "/gps/position 0 0 5 cm"
+            else
+                echo "/WLS/gun/beam pencil"
+                echo "/WLS/gun/beamParticle $PARTICLE"
+                echo "/WLS/gun/beamEnergy $ENERGY"
+            fi
+            echo "/run/beamOn 200"
+            echo "/control/shell date +%s.%N > start"
+            echo "/run/beamOn $NEVENTS"
+            echo "/control/shell date +%s.%N > stop"
+        } > bench.mac
+        rm -f start stop
+        $WLS bench.mac bench /WLS/phys/optical=off /run/numberOfThreads=$t > log 2>&1
+        if [ ! -s stop ]; then
+            echo "wls failed, see $DIR/log" >&2
+            exit 1
+        fi
+        seconds=`echo "$(cat stop) - $(cat start)" | bc`
+        printf "%-6s %8d %10d %10.3f %12.0f\n" $source $t $NEVENTS $seconds \
+               `echo "$NEVENTS / $seconds" | bc -l`
+    done
+done
+rm -rf $DIR
@@ -0,0 +1,190 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-scint.cc
+/// \brief Time per step of G4Scintillation and WLSBatchScintillation
+//
+// Usage: wls-bench-scint [nsteps] [edep/MeV ...]
+//
+//   Puts an electron step of 1 mm in a block of the scintillator of
+//   WLSMaterials and calls PostStepDoIt() of both processes nsteps times
+//   (default 2000) for each energy deposit (default 0.01 0.1 1 10 MeV),
+//   deleting the photons after every step as the stack eventually does.
+//   The report gives the photons per step, the time per step and per
+//   photon, and the mean energy, time after the step start and
+//   |direction . polarization| of the photons, which have to agree
+//   between the two.  Birks saturation is left out, so both make the
+//   same mean number of photons.
+//
+
+#include "WLSMaterials.hh"
+#include "WLSBatchScintillation.hh"
+
+#include "G4Box.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PVPlacement.hh"
+#include "G4Scintillation.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Track.hh"
+#include "G4VParticleChange.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Result
+{
+    double seconds;
+    double photons;
+    double energy;
+    double time;
+    double dot;
+};
+
+Result Run(G4Scintillation* process, G4Track* track, G4Step* step, long nsteps)
+{
+    Result r = { 0, 0, 0, 0, 0 };
+    long sampled = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long s = 0; s < nsteps; s++)
+    {
+        G4VParticleChange* change = process->PostStepDoIt(*track, *step);
+        for (G4int i = 0; i < change->GetNumberOfSecondaries(); i++)
+        {
+            G4Track* photon = change->GetSecondary(i);
+            // sums of every 16th photon: cheap next to the generation
+            if ((i & 15) == 0)
+            {
+                r.energy += photon->GetKineticEnergy();
+                r.time += photon->GetGlobalTime();
+                r.dot += std::fabs(photon->GetMomentumDirection().dot(photon->GetPolarization()));
+                sampled++;
+            }
+            delete photon;
+        }
+        r.photons += change->GetNumberOfSecondaries();
+        change->Clear();
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (sampled > 0)
+    {
+        r.energy /= sampled;
+        r.time /= sampled;
+        r.dot /= sampled;
+    }
+    r.photons /= nsteps;
+    return r;
+}
+
+void Print(const char* name, double edep, const Result& r, long nsteps)
+{
+    std::printf("%-7s %10.3f %10.0f %10.2f %10.2f %10.4f %10.3f %10.2e\n", name, edep / MeV,
+                r.photons, 1e6 * r.seconds / nsteps,
+                r.photons > 0 ? 1e9 * r.seconds / (r.photons * nsteps) : 0.,
+                r.energy / eV, r.time / ns, r.dot);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long nsteps = argc > 1 ? std::atol(argv[1]) : 2000;
+    std::vector<double> deposits;
+    for (int i = 2; i < argc; i++)
+        deposits.push_back(std::atof(argv[i]) * MeV);
+    if (deposits.empty())
+    {
+        deposits.push_back(0.01 * MeV);
+        deposits.push_back(0.1 * MeV);
+        deposits.push_back(1 * MeV);
+        deposits.push_back(10 * MeV);
+    }
+
+    G4Electron::ElectronDefinition();
+    G4OpticalPhoton::OpticalPhotonDefinition();
+    G4Material* scintillator = WLSMaterials::GetInstance()->GetMaterial("Polystyrene");
+
+    G4Box* box = new G4Box("Block", 1 * m, 1 * m, 1 * m);
+    G4LogicalVolume* logic = new G4LogicalVolume(box, scintillator, "Block");
+    G4VPhysicalVolume* world = new G4PVPlacement(0, G4ThreeVector(), logic, "Block", 0, false, 0);
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+    navigator.LocateGlobalPointAndSetup(G4ThreeVector());
+    G4TouchableHandle touchable(navigator.CreateTouchableHistory());
+
+    G4DynamicParticle* electron =
+        new G4DynamicParticle(G4Electron::Electron(), G4ThreeVector(0, 0, 1), 100 * MeV);
+    G4Track* track = new G4Track(electron, 0., G4ThreeVector());
+    G4Step* step = new G4Step();
+    track->SetStep(step);
+    track->SetTouchableHandle(touchable);
+    step->SetTrack(track);
+    step->SetStepLength(1 * mm);
+    G4StepPoint* points[] = { step->GetPreStepPoint(), step->GetPostStepPoint() };
+    for (int i = 0; i < 2; i++)
+    {
+        points[i]->SetPosition(G4ThreeVector(0, 0, i * mm));
+        points[i]->SetGlobalTime(i * mm / c_light);
+        points[i]->SetVelocity(c_light);
+        points[i]->SetMaterial(scintillator);
+        points[i]->SetTouchableHandle(touchable);
+    }
+
+    // set up as in WLSOpticalPhysics, without the saturation
+    G4Scintillation* processes[] = { new G4Scintillation(), new WLSBatchScintillation() };
+    for (int i = 0; i < 2; i++)
+    {
+        processes[i]->SetScintillationYieldFactor(1.);
+        processes[i]->SetTrackSecondariesFirst(true);
+        processes[i]->SetScintillationExcitationRatio(0.0);
+        processes[i]->BuildPhysicsTable(*G4Electron::Electron());
+    }
+
+    std::printf("%-7s %10s %10s %10s %10s %10s %10s %10s\n", "process", "edep MeV", "photons",
+                "us/step", "ns/photon", "<E> eV", "<t> ns", "<|d.p|>");
+    for (size_t d = 0; d < deposits.size(); d++)
+    {
+        step->SetTotalEnergyDeposit(deposits[d]);
+        for (int i = 0; i < 2; i++)
+        {
+            CLHEP::HepRandom::setTheSeed(12345);
+            Result r = Run(processes[i], track, step, nsteps);
+            Print(i == 0 ? "G4" : "batch", deposits[d], r, nsteps);
+        }
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/bench/wls-bench-surfaces.cc
+/// \brief Cost of the optical surface lookup at a boundary step
+//
+// Usage: wls-bench-surfaces [npasses] [n ...]
+//
+//   Builds the n x n x n array with mirrors (default n = 3 10 30) and
+//   collects every pair of touching volumes: each physical volume and the
+//   one its mother logical volume is placed as, and the three layers of
+//   every fiber leader against the photon detector or the mirror its end
+//   is flush with, all both ways round.  Each pair is resolved npasses
+//   times (default 200) the way G4OpBoundaryProcess does it: the border
+//   surface of the pair, else the skin of the volume entered if it is a
+//   daughter of the one left, else the skin of the volume left, then of
+//   the one entered.  The report gives the sizes of the border and skin
+//   tables, the time per lookup, and the fiber-end steps that do not
+//   resolve to the photon detector or mirror surface (the exit status is
+//   1 if there are any).  Every size runs in its own process.
+//
+
+#include "WLSDetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalBorderSurface.hh"
+#include "G4LogicalSkinSurface.hh"
+#include "G4OpticalSurface.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+
+typedef std::pair<const G4VPhysicalVolume*, const G4VPhysicalVolume*> VolumePair;
+
+const G4LogicalSurface* Resolve(const G4VPhysicalVolume* pre, const G4VPhysicalVolume* post)
+{
+    const G4LogicalSurface* surface = G4LogicalBorderSurface::GetSurface(pre, post);
+    if (surface)
+        return surface;
+    const G4LogicalVolume* first = pre->GetLogicalVolume();
+    const G4LogicalVolume* second = post->GetLogicalVolume();
+    if (post->GetMotherLogical() == pre->GetLogicalVolume())
+        std::swap(first, second);
+    surface = G4LogicalSkinSurface::GetSurface(first);
+    if (!surface)
+        surface = G4LogicalSkinSurface::GetSurface(second);
+    return surface;
+}
+
+std::vector<VolumePair> TouchingPairs()
+{
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    std::map<const G4LogicalVolume*, const G4VPhysicalVolume*> placed;
+    for (size_t i = 0; i < store->size(); i++)
+        placed.insert(std::make_pair((*store)[i]->GetLogicalVolume(), (*store)[i]));
+
+    std::vector<VolumePair> pairs;
+    for (size_t i = 0; i < store->size(); i++)
+    {
+        const G4VPhysicalVolume* pv = (*store)[i];
+        std::map<const G4LogicalVolume*, const G4VPhysicalVolume*>::const_iterator mother =
+            placed.find(pv->GetMotherLogical());
+        if (mother == placed.end())
+            continue;
+        pairs.push_back(VolumePair(pv, mother->second));
+        pairs.push_back(VolumePair(mother->second, pv));
+    }
+    return pairs;
+}
+
+// Fiber layer -> photon detector or mirror at the ends of the leaders,
+// with the surface that must apply there
+std::vector<std::pair<VolumePair, const G4LogicalSurface*> > FiberEndPairs()
+{
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    const char* viewName[3] = { "X", "Y", "Z" };
+    std::vector<std::pair<VolumePair, const G4LogicalSurface*> > ends;
+    for (int v = 0; v < 3; v++)
+    {
+        const G4VPhysicalVolume* target[2] = { store->GetVolume(G4String("PhotonDet") + viewName[v], false), 0 };
+        for (size_t i = 0; i < store->size(); i++)
+            if ((*store)[i]->GetName() == "Mirror" && (*store)[i]->GetMotherLogical() &&
+                (*store)[i]->GetMotherLogical()->GetName() == G4String("MirrorEnvelope") + viewName[v])
+                target[1] = (*store)[i];
+
+        const char* side[2] = { "Read", "Far" };
+        for (int s = 0; s < 2; s++)
+        {
+            if (!target[s])
+                continue;
+            const G4LogicalSurface* expected = G4LogicalSkinSurface::GetSurface(target[s]->GetLogicalVolume());
+            G4String envelope = G4String("FiberEnvelope") + viewName[v] + side[s];
+            for (size_t i = 0; i < store->size(); i++)
+            {
+                const G4VPhysicalVolume* layer = (*store)[i];
+                if (!layer->GetMotherLogical() || layer->GetMotherLogical()->GetName() != envelope)
+                    continue;
+                // outer cladding, inner cladding, core
+                for (int l = 0; l < 3 && layer; l++)
+                {
+                    ends.push_back(std::make_pair(VolumePair(layer, target[s]), expected));
+                    const G4LogicalVolume* logical = layer->GetLogicalVolume();
+                    layer = logical->GetNoDaughters() ? logical->GetDaughter(0) : 0;
+                }
+            }
+        }
+    }
+    return ends;
+}
+
+double TimeLookups(const std::vector<VolumePair>& pairs, long npasses)
+{
+    size_t found = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long p = 0; p < npasses; p++)
+        for (size_t i = 0; i < pairs.size(); i++)
+            found += Resolve(pairs[i].first, pairs[i].second) != 0;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (found == (size_t) -1)
+        std::printf("\n");
+    return 1e9 * seconds / (npasses * (double) pairs.size());
+}
+
+int RunSize(int n, long npasses)
+{
+    G4RunManager* runManager = new G4RunManager;
+    WLSDetectorConstruction* detector = new WLSDetectorConstruction(200, 100, 0, 0.97);
+    detector->SetArraySize(n, n, n);
+    detector->SetMirror(true);
+    detector->Construct();
+    G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+    std::vector<VolumePair> pairs = TouchingPairs();
+    std::vector<std::pair<VolumePair, const G4LogicalSurface*> > ends = FiberEndPairs();
+    size_t wrong = 0;
+    for (size_t i = 0; i < ends.size(); i++)
+    {
+        pairs.push_back(ends[i].first);
+        pairs.push_back(VolumePair(ends[i].first.second, ends[i].first.first));
+        const G4LogicalSurface* surface = Resolve(ends[i].first.first, ends[i].first.second);
+        if (surface != ends[i].second)
+        {
+            wrong++;
+            std::fprintf(stderr, "%s -> %s: %s instead of %s\n",
+                         ends[i].first.first->GetName().c_str(), ends[i].first.second->GetName().c_str(),
+                         surface ? surface->GetName().c_str() : "no surface",
+                         ends[i].second ? ends[i].second->GetName().c_str() : "no surface");
+        }
+    }
+    size_t borders = G4LogicalBorderSurface::GetNumberOfBorderSurfaces();
+    size_t skins = G4LogicalSkinSurface::GetNumberOfSkinSurfaces();
+    double now = TimeLookups(pairs, npasses);
+
+    std::printf("%5d^3 %8lu %8lu %8lu %10.1f %8lu %8lu\n", n, (unsigned long) pairs.size(),
+                (unsigned long) borders, (unsigned long) skins, now,
+                (unsigned long) ends.size(), (unsigned long) wrong);
+    std::fflush(stdout);
+
+    delete runManager;
+    return wrong ? 1 : 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    long npasses = argc > 1 ? std::atol(argv[1]) : 200;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; i++)
+        sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty())
+    {
+        sizes.push_back(3);
+        sizes.push_back(10);
+        sizes.push_back(30);
+    }
+
+    std::printf("%7s %8s %8s %8s %10s %8s %8s\n",
+                "array", "pairs", "borders", "skins", "ns/lookup", "ends", "wrong");
+    std::fflush(stdout);
+    int status = 0;
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        pid_t pid = fork();
+        if (pid > 0)
+        {
+            int child = 0;
+            waitpid(pid, &child, 0);
+            if (!WIFEXITED(child) || WEXITSTATUS(child) != 0)
+                status = 1;
+            continue;
+        }
+        if (pid < 0)
+            return 1;
+
+        return RunSize(sizes[s], npasses);
+    }
+    return status;
+}
@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSAliasTable.hh
+/// \brief Definition of the WLSAliasTable class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSAliasTable_h
+#define WLSAliasTable_h 1
+
+#include "globals.hh"
+
+#include <algorithm>
+#include <vector>
+
+// Walker's alias table for a spectrum given at nodes x[i] with values
+// y[i].  Bin i is drawn with the weight of its trapezoid and the value is
+// uniform inside the bin, which is the distribution G4Scintillation gets
+// by inverting the linear integral of the same table.  A draw costs two
+// uniform numbers and no search, whatever the number of nodes.
+
+class WLSAliasTable
+{
+  public:
+
+    WLSAliasTable() {}
+    WLSAliasTable(const std::vector<G4double>& x, const std::vector<G4double>& y);
+
+    // Fewer than two nodes or no positive weight leave the table empty
+    void Build(const std::vector<G4double>& x, const std::vector<G4double>& y);
+
+    G4bool IsEmpty() const { return fProbability.empty(); }
+
+    // u picks the bin and decides between the bin and its alias, v is
+    // the position inside the bin
+    G4double Sample(G4double u, G4double v) const
+    {
+        const G4int n = fProbability.size();
+        G4double s = u * n;
+        G4int i = std::min(G4int(s), n - 1);
+        s -= i;
+        i = s < fProbability[i] ? i : fAlias[i];
+        return fLow[i] + v * fWidth[i];
+    }
+
+    // Sample() for n pairs, out[k] from u[k] and v[k]
+    void Sample(G4int n, const G4double* u, const G4double* v, G4double* out) const;
+
+  private:
+
+    std::vector<G4double> fProbability;
+    std::vector<G4int> fAlias;
+    std::vector<G4double> fLow;
+    std::vector<G4double> fWidth;
+};
+
+#endif
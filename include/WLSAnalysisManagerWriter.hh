@@ -0,0 +1,69 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSAnalysisManagerWriter.hh
+/// \brief Definition of the WLSAnalysisManagerWriter class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSAnalysisManagerWriter_h
+#define WLSAnalysisManagerWriter_h 1
+
+#include "WLSOutputWriter.hh"
+
+class G4VAnalysisManager;
+
+// ROOT or CSV output through the Geant4 analysis managers
+
+class WLSAnalysisManagerWriter : public WLSOutputWriter
+{
+  public:
+
+    WLSAnalysisManagerWriter(G4VAnalysisManager*);
+    virtual ~WLSAnalysisManagerWriter();
+
+    virtual G4String GetType() const;
+
+    virtual G4bool OpenFile(const G4String&);
+    virtual G4bool Write();
+    virtual G4bool CloseFile();
+
+    virtual G4int  CreateNtuple(const G4String&, const G4String&);
+    virtual G4int  CreateNtupleDColumn(G4int, const G4String&);
+    virtual void   FinishNtuple(G4int);
+    virtual void   FillNtupleDColumn(G4int, G4int, G4double);
+    virtual void   AddNtupleRow(G4int);
+
+    virtual G4int  CreateH1(const G4String&, const G4String&, G4int, G4double, G4double);
+    virtual void   FillH1(G4int, G4double, G4double = 1.0);
+
+  private:
+
+    G4VAnalysisManager* fManager;
+};
+
+#endif
@@ -0,0 +1,71 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSArrayParameterisation.hh
+/// \brief Definition of the WLSArrayParameterisation class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSArrayParameterisation_h
+#define WLSArrayParameterisation_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "G4VPVParameterisation.hh"
+
+class G4VPhysicalVolume;
+
+// Places the copies of one volume on a regular two-dimensional grid:
+// copy k sits at origin + (k % n1) * step1 + (k / n1) * step2, all with the
+// same rotation.  Used for the fiber leaders, photon detectors and mirrors
+// of every fiber view, so that the copy number is the channel index within
+// the view.
+
+class WLSArrayParameterisation : public G4VPVParameterisation
+{
+  public:
+
+    WLSArrayParameterisation(G4int n1, const G4ThreeVector& step1,
+                             const G4ThreeVector& step2,
+                             const G4ThreeVector& origin,
+                             G4RotationMatrix* rotation);
+    virtual ~WLSArrayParameterisation();
+
+    virtual void ComputeTransformation(const G4int copyNo,
+                                       G4VPhysicalVolume* physVol) const;
+
+  private:
+
+    G4int             fN1;
+    G4ThreeVector     fStep1;
+    G4ThreeVector     fStep2;
+    G4ThreeVector     fOrigin;
+    G4RotationMatrix* fRotation;
+};
+
+#endif
@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSBatchScintillation.hh
+/// \brief Definition of the WLSBatchScintillation class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSBatchScintillation_h
+#define WLSBatchScintillation_h 1
+
+#include "globals.hh"
+#include "G4Scintillation.hh"
+
+#include "WLSAliasTable.hh"
+
+#include <deque>
+#include <vector>
+
+// G4Scintillation that makes the photons of a step in batches
+// (/WLS/phys/batchScintillation).  For a material with a single
+// FASTCOMPONENT, as the scintillator here, all uniform numbers of a batch
+// are drawn in one flatArray() call, the energies come from an alias
+// table of the spectrum (the shared sampler of WLSOpticalTables when it is
+// the scintilFast table, else one of its own) and the directions, polarizations, positions and
+// times are computed in plain loops over arrays.  The photon number, the
+// Birks correction and the distributions are those of G4Scintillation;
+// only the random sequence differs.  Anything else (two components,
+// finite rise time, yields by particle type) is left to G4Scintillation.
+
+class WLSBatchScintillation : public G4Scintillation
+{
+  public:
+
+    WLSBatchScintillation(const G4String& processName = "Scintillation",
+                          G4ProcessType type = fElectromagnetic);
+    virtual ~WLSBatchScintillation();
+
+    virtual void BuildPhysicsTable(const G4ParticleDefinition&);
+
+    virtual G4VParticleChange* AtRestDoIt(const G4Track&, const G4Step&);
+    virtual G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
+
+  private:
+
+    // Photons per batch: the buffers stay in the L1/L2 cache
+    static const G4int kBatch = 256;
+
+    void BuildSpectra();
+    void MakeBatch(G4int n, const G4Step&, G4double timeConstant,
+                   const WLSAliasTable&);
+
+    // By material index; null where G4Scintillation does the work
+    std::vector<const WLSAliasTable*> fSpectra;
+    std::deque<WLSAliasTable> fOwnSpectra;
+    std::vector<G4double> fTimeConstant;
+
+    // The batch, one array per quantity
+    std::vector<G4double> fRandom;
+    std::vector<G4double> fEnergy;
+    std::vector<G4double> fDirX, fDirY, fDirZ;
+    std::vector<G4double> fPolX, fPolY, fPolZ;
+    std::vector<G4double> fAlong, fTime;
+};
+
+#endif
@@ -0,0 +1,224 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSCellTracer.hh
+/// \brief Definition of the WLSCellTracer class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSCellTracer_h
+#define WLSCellTracer_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include "WLSAliasTable.hh"
+#include "WLSDetectorConstruction.hh"
+#include "WLSOpticalTables.hh"
+
+#include <vector>
+
+// Optical photons in one cell of the array, without the Geant4 navigator:
+// the scintillator cube, its TiO2 coating, the three holes and the three
+// fiber segments, in the frame of the cube centre.  The cell is what
+// ConstructDetector() builds and the optics are those of WLSMaterials:
+//
+//   scintillator   bulk absorption (absPS)
+//   coating        unified groundbackpainted dielectric_metal: Lambertian
+//                  reflection with the cube reflectivity, else absorbed
+//   hole walls     glisur ground dielectric_dielectric (polish 0.99),
+//                  Fresnel with the polarization as G4OpBoundaryProcess
+//   fiber layers   polished Fresnel/TIR between air, both claddings and
+//                  the core; bulk absorption in the claddings (absClad)
+//   core           WLS absorption (absWLSfiber), one photon re-emitted
+//                  from emissionFib as G4OpWLS does
+//
+// A photon is traced until it is absorbed, leaves the cell through the
+// air (escaped) or leaves it inside a fiber (captured by that view).
+// Photons move in batches of kBatch in structure-of-arrays form: the
+// distances to all surfaces and the absorption lengths are computed for
+// every photon of the batch in loops the compiler vectorizes, and only
+// the interaction at the chosen surface is done photon by photon.
+// Finished photons are replaced at once by the next ones, so the batch
+// stays full.  Times use the phase velocity c/n; the WLS delay is the
+// WLSTIMECONSTANT, as the default G4OpWLS time profile.
+//
+// Trace() takes any photons of the cell, e.g. those a fast simulation
+// model removes from the stack, and leaves each at the end of its path:
+// a captured photon stops where it leaves the cell along the fiber, with
+// the energy and time it arrives there.
+
+class WLSCellTracer
+{
+  public:
+
+    // Geometry of the cell; lengths in Geant4 units
+    struct Cell
+    {
+        // The defaults of WLSDetectorConstruction
+        Cell();
+        // The cell the detector builds with its current parameters
+        explicit Cell(WLSDetectorConstruction* detector);
+
+        G4double barBase;        // edge of the scintillator cube
+        G4double coating;        // thickness of the TiO2 coating
+        G4double pitch;          // edge of the air cell around the cube
+        G4double holeRadius;
+        G4double holePosition;   // offset of the holes, as SetHolePosition
+        G4double coreRadius;
+        G4double clad1Radius;
+        G4double clad2Radius;
+        G4double reflectivity;   // of the coating
+        G4double holePolish;     // glisur polish of the hole walls
+    };
+
+    // End state of a photon after Trace()
+    enum Fate
+    {
+        kCapturedX, kCapturedY, kCapturedZ,
+        kAbsorbedScintillator, kAbsorbedCoating, kAbsorbedCladding,
+        kEscaped, kLost, kNFates
+    };
+
+    struct Photons
+    {
+        void Resize(size_t n);
+        size_t Size() const { return energy.size(); }
+
+        std::vector<G4double> x, y, z;        // position
+        std::vector<G4double> dx, dy, dz;     // direction
+        std::vector<G4double> px, py, pz;     // polarization
+        std::vector<G4double> energy, time;
+        std::vector<G4int> fate;              // after Trace()
+        std::vector<G4int> wls;               // re-emissions in the cores
+    };
+
+    struct Tally
+    {
+        Tally();
+        void Add(const Photons& photons);
+        // Captured fraction of a view, both ends
+        G4double Efficiency(G4int view) const;
+
+        G4long photons;
+        G4long fates[kNFates];
+        G4long ends[3][2];    // captured by view, toward +axis (0) or -axis (1)
+        G4long wls;
+    };
+
+    static const G4int kBatch = 256;
+    // Interactions after which a photon is given up as lost
+    static const G4int kMaxSteps = 10000;
+
+    // Fatal (WLSCell01) if the holes and fibers do not fit the cube
+    explicit WLSCellTracer(const Cell& cell,
+                           const WLSOpticalTables* tables = WLSOpticalTables::GetInstance());
+
+    const Cell& GetCell() const { return fCell; }
+
+    // n scintillation photons at a point of the cell, as G4Scintillation
+    // makes them: isotropic, energy from scintilFast, random polarization
+    // perpendicular to the direction, exponential time (scintiTime)
+    void Generate(const G4ThreeVector& position, G4int n, Photons& photons) const;
+    // Follow all photons to their fate
+    void Trace(Photons& photons) const;
+
+    // View (0 X, 1 Y, 2 Z) of the fiber whose outer cladding contains
+    // the point, -1 if none
+    G4int FiberAt(const G4ThreeVector& position) const;
+    // Unit vector along the fibers of a view
+    G4ThreeVector GetFiberAxis(G4int view) const;
+
+  private:
+
+    // Where a photon is: the scintillator, the air of the cell outside
+    // the coating, the air of hole v and the layers of fiber v
+    enum Region
+    {
+        kScintillator = 0, kAir = 1, kHole = 2, kClad2 = 5, kClad1 = 8, kCore = 11,
+        kCoatingBulk = -1, kOutside = -2
+    };
+    enum Material { kPS, kAirMaterial, kClad2Material, kClad1Material, kCoreMaterial, kNMaterials };
+
+    struct Lanes;
+
+    G4int Locate(const G4double* p) const;
+    Material MaterialOf(G4int region) const;
+    // Load() is false if the photon ends where it starts (outside the
+    // cell, in the bulk of the coating) and sets its fate
+    G4bool Load(Lanes& lanes, G4int k, Photons& photons, size_t i) const;
+    void Store(const Lanes& lanes, G4int k, Photons& photons) const;
+    void Move(Lanes& lanes, G4int from, G4int to) const;
+    void UpdateOptics(Lanes& lanes, G4int k) const;
+    void Distances(Lanes& lanes, G4int n) const;
+    void Step(Lanes& lanes, G4int k) const;
+
+    // Interactions; the normal points back into the medium the photon
+    // comes from.  Fresnel() is true if the photon crosses.
+    G4bool Fresnel(G4ThreeVector& dir, G4ThreeVector& pol, const G4ThreeVector& normal,
+                   G4double n1, G4double n2, G4double polish) const;
+    G4bool Coating(G4ThreeVector& dir, G4ThreeVector& pol, const G4ThreeVector& normal) const;
+    void Reemit(G4ThreeVector& dir, G4ThreeVector& pol, G4double& energy) const;
+
+    static G4double Value(const WLSOpticalTables::Table& table, G4double energy);
+
+    Cell fCell;
+    // Per view: axis, the two transverse axes and the fiber centre in them
+    G4int fAxis[3];
+    G4int fU[3];
+    G4int fW[3];
+    G4double fCu[3];
+    G4double fCw[3];
+    // Squared radii of the hole and the fiber layers, outside in
+    G4double fRadius2[4];
+
+    WLSOpticalTables::Table fIndex[kNMaterials];
+    WLSOpticalTables::Table fAbsorption[kNMaterials];
+    WLSAliasTable fScintSpectrum;
+    WLSAliasTable fWLSSpectrum;
+    G4double fScintTime;
+    G4double fWLSTime;
+};
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Inline, so that the library does not need the detector construction
+inline WLSCellTracer::Cell::Cell(WLSDetectorConstruction* detector)
+  : barBase(detector->GetBarBase()),
+    coating(detector->GetCoatingThickness()),
+    pitch(detector->GetCubePitch()),
+    holeRadius(detector->GetHoleRadius()),
+    holePosition(detector->GetHolePosition()),
+    coreRadius(detector->GetFiberCoreRadius()),
+    clad1Radius(detector->GetFiberInnerCladRadius()),
+    clad2Radius(detector->GetFiberOuterCladRadius()),
+    reflectivity(detector->GetCubeReflectivity()),
+    holePolish(0.99)
+{
+}
+
+#endif
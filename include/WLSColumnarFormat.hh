@@ -0,0 +1,93 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSColumnarFormat.hh
+/// \brief Layout of the "bin" output format (/WLS/output/format bin)
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSColumnarFormat_h
+#define WLSColumnarFormat_h 1
+
+// Shared by wls and the stand-alone readers, so no Geant4 header here.
+
+#include <stdint.h>
+
+/*
+    One file per ntuple, <file>_nt_<ntuple>.wlscol, and one per histogram,
+    <file>_h1_<histogram>.wlscol, all with the same layout:
+
+    offset 0                : WLSColumnarHeader                  (128 bytes)
+    offset 128 + 64 * c     : WLSColumnarColumn c,  c = 0 .. ncolumns-1
+    offset dataOffset       : data blocks
+
+    Values are stored in blocks of blockRows rows.  Inside a block the
+    values of one column are contiguous:
+
+        value(row, c) at dataOffset
+                       + ((row / blockRows) * ncolumns + c) * blockRows * 8
+                       + (row % blockRows) * 8
+
+    Only the first nrows rows are valid; the last block is zero padded.
+    With numpy:
+
+        d = np.memmap(f, np.float64, offset=dataOffset)
+        d = d.reshape(-1, ncolumns, blockRows).transpose(1, 0, 2).reshape(ncolumns, -1)[:, :nrows]
+
+    Histograms have the columns low, high, content, sumw2; row 0 is the
+    underflow and row nbins+1 the overflow.
+
+    All values are in host byte order, doubles are IEEE 754.
+*/
+
+const char     kWLSColumnarMagic[8] = { 'W', 'L', 'S', 'C', 'O', 'L', 0, 0 };
+const uint32_t kWLSColumnarVersion  = 1;
+const uint32_t kWLSColumnarFloat64  = 1;
+
+struct WLSColumnarHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t ncolumns;
+    uint64_t nrows;         // updated on Write() and at close
+    uint64_t blockRows;
+    uint64_t dataOffset;
+    char     title[64];
+    uint64_t reserved[3];
+};
+
+struct WLSColumnarColumn
+{
+    char     name[56];
+    uint32_t type;          // kWLSColumnarFloat64
+    uint32_t reserved;
+};
+
+static_assert(sizeof(WLSColumnarHeader) == 128, "WLSColumnarHeader must stay 128 bytes");
+static_assert(sizeof(WLSColumnarColumn) == 64, "WLSColumnarColumn must stay 64 bytes");
+
+#endif
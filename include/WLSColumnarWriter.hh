@@ -0,0 +1,115 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSColumnarWriter.hh
+/// \brief Definition of the WLSColumnarWriter class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSColumnarWriter_h
+#define WLSColumnarWriter_h 1
+
+#include "WLSOutputWriter.hh"
+
+#include <stdint.h>
+#include <vector>
+
+// Writes every ntuple and histogram to a memory-mapped file in the layout
+// of WLSColumnarFormat.hh.  The files grow in steps of whole blocks, so
+// AddNtupleRow() is a copy into the mapping and an occasional ftruncate.
+//
+// In multi-threaded runs every worker writes its ntuples to files of its
+// own, <file>_t<thread>_nt_<ntuple>.wlscol, and hands its histograms to
+// the master when it closes them.  The master, whose run ends after the
+// workers', appends those rows to its files on Write() and removes them,
+// so a run leaves the same files as a sequential one.
+
+class WLSColumnarWriter : public WLSOutputWriter
+{
+  public:
+
+    WLSColumnarWriter(G4int blockRows = 4096);
+    virtual ~WLSColumnarWriter();
+
+    virtual G4String GetType() const { return "bin"; }
+
+    virtual G4bool OpenFile(const G4String&);
+    virtual G4bool Write();
+    virtual G4bool CloseFile();
+
+    virtual G4int  CreateNtuple(const G4String&, const G4String&);
+    virtual G4int  CreateNtupleDColumn(G4int, const G4String&);
+    virtual void   FinishNtuple(G4int);
+    virtual void   FillNtupleDColumn(G4int, G4int, G4double);
+    virtual void   AddNtupleRow(G4int);
+
+    virtual G4int  CreateH1(const G4String&, const G4String&, G4int, G4double, G4double);
+    virtual void   FillH1(G4int, G4double, G4double = 1.0);
+
+  private:
+
+    struct Table
+    {
+        G4String              name;
+        G4String              title;
+        std::vector<G4String> columns;
+        std::vector<G4double> row;       // values of the row being filled
+
+        int      fd;
+        char*    map;
+        size_t   mapSize;
+        uint64_t nrows;
+    };
+
+    struct H1
+    {
+        G4String              name;
+        G4String              title;
+        G4int                 nbins;
+        G4double              xmin;
+        G4double              xmax;
+        std::vector<G4double> content;   // nbins + 2, with under/overflow
+        std::vector<G4double> sumw2;
+    };
+
+    // Rows of the files the workers closed, appended on the master
+    void   MergeWorkers();
+    G4bool AppendTable(G4int ntupleId, const G4String& path);
+
+    G4bool OpenTable(Table&, const G4String& path);
+    G4bool GrowTable(Table&, uint64_t nrows);
+    void   SyncHeader(Table&);
+    void   CloseTable(Table&);
+    size_t DataOffset(const Table&) const;
+
+    G4int               fBlockRows;
+    G4String            fFileName;
+    std::vector<Table>  fNtuples;
+    std::vector<H1>     fH1s;
+};
+
+#endif
@@ -0,0 +1,107 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSCommandLine.hh
+/// \brief Definition of the WLSCommandLine class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSCommandLine_h
+#define WLSCommandLine_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+// Command line of wls:
+//
+//   wls [macro] [name] [seed] [key=value ...] [-p physicsList]
+//
+// The positional arguments are the historical ones.  Every setting can
+// also be given as key=value: macro, name, seed, and the detector
+// parameters fiber_length (cm), gap_length (cm), mirror_reflectivity,
+// cube_reflectivity, hole_radius (mm), hole_position (mm) and
+// coating_thickness (mm).  A key starting with '/' is any UI command, applied
+// with the value as its parameters (e.g. "/WLS/array/size=5 5 1").
+//
+// A value can be a sweep: a comma separated list ("0.90,0.95,0.97") or an
+// inclusive range lo:hi:step ("50:200:50").  The macro is then executed
+// once for every combination of the swept values, each time with its own
+// output name (name_key1value1_key2value2...).
+
+class WLSCommandLine
+{
+  public:
+
+    WLSCommandLine();
+
+    // Returns false (after printing why) if the arguments are not valid
+    G4bool Parse(int argc, char** argv);
+    static void PrintUsage();
+
+    const G4String& GetMacro() const { return fMacro; }
+    const G4String& GetName() const { return fName; }
+    G4long GetSeed() const { return fSeed; }
+    const G4String& GetPhysicsList() const { return fPhysicsList; }
+
+    // First value of a detector parameter, or def if it was not given
+    G4double GetValue(const G4String& key, G4double def) const;
+
+    // Number of combinations of the swept values (1 without a sweep)
+    G4int GetNumberOfPoints() const;
+    // UI commands setting combination i: the swept parameters and, for
+    // i = 0 only, the single-valued ones not taken by the constructor
+    std::vector<G4String> GetCommands(G4int i) const;
+    // Output name of combination i
+    G4String GetName(G4int i) const;
+
+    void Print() const;
+
+  private:
+
+    struct Parameter
+    {
+        G4String key;
+        std::vector<G4String> values;
+    };
+
+    static G4bool Expand(const G4String& text, std::vector<G4String>& values);
+    // Keys passed to the WLSDetectorConstruction constructor (GetValue)
+    static G4bool IsConstructorParameter(const G4String& key);
+    // UI command of a known key with the given value, "" for others
+    static G4String CommandFor(const G4String& key, const G4String& value);
+    // Value index of parameter p in combination i
+    size_t Index(size_t p, G4int i) const;
+
+    G4String fMacro;
+    G4String fName;
+    G4long   fSeed;
+    G4String fPhysicsList;
+    std::vector<Parameter> fParameters;
+};
+
+#endif
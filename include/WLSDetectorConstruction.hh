@@ -39,6 +39,10 @@
 #include "G4ios.hh"
 
 #include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+
+#include <utility>
+#include <vector>
 
 class G4Box;
 class G4Tubs;
@@ -46,9 +50,11 @@ class G4EllipticalTube;
 
 class G4LogicalVolume;
 class G4VPhysicalVolume;
+class G4VTouchable;
 
 class WLSMaterials;
 class G4Material;
+class G4OpticalSurface;
 
 class WLSDetectorMessenger;
 
@@ -60,6 +66,11 @@ class WLSPhotonDetSD;
 class WLSDetectorConstruction : public G4VUserDetectorConstruction
 {
 public:
+    // What a parameter change needs: surface- and material-only changes
+    // are applied to the existing property tables, shape changes rebuild
+    // the geometry
+    enum ChangeKind { kSurfaceOnly, kMaterialOnly, kShapeChanging };
+
     WLSDetectorConstruction(G4double, G4double, G4double, G4double);
     virtual ~WLSDetectorConstruction();
 
@@ -77,6 +88,10 @@ public:
     void SetNumberOfCladding(G4int);        // Maximum 2 claddings
 
     void SetWLSLength(G4double);     // Total length of WLS fiber
+    // Full fiber length, keeping the cube-to-readout distance
+    void SetFiberLength(G4double);
+    // Distance from the cube centre to the readout end of the fiber
+    void SetGapLength(G4double);
     void SetWLSRadius(G4double);
     void SetClad1Radius(G4double);
     void SetClad2Radius(G4double);
@@ -95,14 +110,37 @@ public:
     void SetPhotonDetReflectivity(G4double);
     // Set the polish of the mirror
     void SetPhotonDetPolish(G4double);
+    // Photon detectors detect every photon they absorb; the efficiency
+    // curves of WLSPhotonDetEfficiency are applied per event instead
+    void SetPhotonDetDeferred(G4bool);
+    G4bool IsPhotonDetDeferred() const { return fDeferredPDE; }
+    // Set the reflectivity of the cube coating
+    void SetCubeReflectivity(G4double);
+    // Set the scintillation yield of the cubes (per energy)
+    void SetScintillationYield(G4double);
 
     void SetMirror(G4bool);
 
     void SetBarLength(G4double);
     void SetBarBase(G4double);
     void SetHoleRadius(G4double);
+    // Offset of the fiber holes (and fibers) from the cube centre
+    void SetHolePosition(G4double);
     void SetCoatingThickness(G4double);
     void SetCoatingRadius(G4double);
+    // "boolean": cube and coating are boxes with the fiber holes subtracted;
+    // "daughter": plain boxes with the holes as air tube daughters
+    void SetHoleMode(G4String);
+
+    // Number of cubes along x, y and z; 3 x 3 x 1 is the nine-cube layer
+    void SetArraySize(G4int, G4int, G4int);
+
+    // Write the constructed geometry (volumes, materials with their
+    // property tables, optical surfaces and the parameters above) to GDML
+    void ExportGeometry(const G4String& fileName);
+    // Take the world from a file written by ExportGeometry() instead of
+    // building it; "none" goes back to building
+    void SetGeometryFile(const G4String& fileName);
 
     G4double GetWLSFiberLength();
     G4double GetWLSFiberEnd();
@@ -114,9 +152,55 @@ public:
     G4double GetHoleRadius();
     G4double GetHoleLength();
     G4double GetFiberRadius();
+    // Radii of the fiber layers as BuildFiber() makes them
+    G4double GetFiberCoreRadius() const;
+    G4double GetFiberInnerCladRadius() const;
+    G4double GetFiberOuterCladRadius() const;
 
     G4double GetCoatingThickness();
     G4double GetCoatingRadius();
+    G4String GetHoleMode() const { return fHoleMode; }
+    // Offset of the holes from the cube centre (SetHolePosition)
+    G4double GetHolePosition() const { return fHolePos; }
+    G4double GetCubeReflectivity() const { return fCubeReflectivity; }
+
+    G4int    GetArrayNX() const { return fNX; }
+    G4int    GetArrayNY() const { return fNY; }
+    G4int    GetArrayNZ() const { return fNZ; }
+    // True for the original 3 x 3 x 1 layer, the only layout the fixed
+    // npx/npy/npz columns of the "cube" ntuple describe
+    G4bool   IsNineCubeLayer() const;
+    // Centre-to-centre distance of neighbouring cubes
+    G4double GetCubePitch();
+    // z of the top face of the top scintillator layer
+    G4double GetScintillatorTopZ();
+
+    // Readout channels are numbered from 1: first the X view fibers
+    // (ix + NX*iz), then the Y view (iy + NY*iz), then the Z view
+    // (iy + NY*ix).  For 3 x 3 x 1 this is X1..3, Y4..6, Z7..15, the copy
+    // numbers the nine-cube geometry has always used.
+    //
+    // Channel of photon detector copy copyNo, 0 if pv is not a photon detector
+    G4int GetChannel(const G4VPhysicalVolume* pv, G4int copyNo) const;
+    // View of a channel: 0 = X, 1 = Y, 2 = Z, -1 if there is no such channel
+    G4int GetChannelView(G4int channel) const;
+    G4int GetNumberOfChannels() const;
+
+    // Cubes are numbered from 0 as ix + NX*(iy + NY*iz); -1 if the
+    // touchable is not a scintillator cube
+    G4int GetCube(const G4VTouchable* touchable) const;
+    G4int GetNumberOfCubes() const { return fNX * fNY * fNZ; }
+    // The extrusion around every cube, whose skin is the TiO2 coating
+    G4bool IsCubeCoating(const G4VPhysicalVolume* pv) const { return pv && pv == fPhysExtrusion; }
+    G4bool IsScintillator(const G4VPhysicalVolume* pv) const { return pv && pv == physScintillator; }
+    // Global position of the centre of a cube (numbering as GetCube())
+    G4ThreeVector GetCubeCentre(G4int cube);
+    // Channel of the fiber of a view (0 = X, 1 = Y, 2 = Z) through a cube
+    G4int GetCubeChannel(G4int cube, G4int view) const;
+
+    // Every parameter the light reaching the photon detectors depends on,
+    // one per line; what WLSResponseCache keys its statistics with
+    void WriteResponseParameters(std::ostream&) const;
 
     // StringToRotationMatrix() converts a string "X90,Y45" into a
     // G4RotationMatrix.
@@ -135,21 +219,24 @@ private:
 
     G4LogicalVolume* fLogiWorld;
     G4LogicalVolume* fLogiExtrusion;
+    G4LogicalVolume* fLogiCell;
     G4LogicalVolume* fLogiHole;
-    G4LogicalVolume* fLogiFiberHoleX;
-    G4LogicalVolume* fLogiFiberHoleY;
-    G4LogicalVolume* fLogiFiberHoleZ;
+    // Holes of the "daughter" mode, per view: through the scintillator and
+    // through the coating (placed on both sides of the scintillator)
+    G4LogicalVolume* fLogiFiberHole[3];
+    G4LogicalVolume* fLogiCoatHole[3];
 
     G4LogicalVolume* logicScintillator;
     G4VPhysicalVolume* physScintillator;
 
 
     G4VPhysicalVolume* fPhysWorld;
-    G4VPhysicalVolume* fPhysExtrusion[3][3];
+    G4VPhysicalVolume* fPhysCell;
+    G4VPhysicalVolume* fPhysExtrusion;
+    G4VPhysicalVolume* fPhysPhotonDet[3];
     G4VPhysicalVolume* fPhysHole;
-    G4VPhysicalVolume* fPhysFiberHoleX;
-    G4VPhysicalVolume* fPhysFiberHoleY;
-    G4VPhysicalVolume* fPhysFiberHoleZ;
+    G4VPhysicalVolume* fPhysFiberHole[3];
+    G4VPhysicalVolume* fPhysCoatHole[3][2];
 
     G4double fWorldSizeX;
     G4double fWorldSizeY;
@@ -198,6 +285,7 @@ private:
     G4double fMirrorReflectivity;
     G4double fMPPCPolish;
     G4double fMPPCReflectivity;
+    G4bool   fDeferredPDE;
     G4double fSurfaceRoughness;
     G4double fXYRatio;
 
@@ -209,11 +297,58 @@ private:
     G4double fCoatingThickness;
     G4double fCoatingRadius;
     G4double fCubeReflectivity;
+    G4String fHoleMode;
+
+    G4int fNX;
+    G4int fNY;
+    G4int fNZ;
+
+    G4String fGeometryFile;
+    G4double fScintillationYield;
+
+    // Surfaces the surface-only setters update
+    G4OpticalSurface* fTiO2Surface;
+    G4OpticalSurface* fMirrorSurface;
+    G4OpticalSurface* fPhotonDetSurface;
 private:
     void ConstructFiber();
 
+    // World read from fGeometryFile, 0 if GDML is not available
+    G4VPhysicalVolume* ReadGeometry();
+    // Parameters the rest of the program takes from the detector, stored
+    // as auxiliary information of the world volume in the GDML file
+    void GetStoredParameters(std::vector<std::pair<G4String, G4double*> >&);
+
+    // Fiber (outer cladding, inner cladding, core) of the given half
+    // length along z; returns the outer cladding
+    G4LogicalVolume* BuildFiber(const G4String& name, G4double halfLength,
+                                G4OpticalSurface* innerSurface);
+
+    // Border surfaces of a placed fiber: outer cladding against its mother
+    // and, unless innerSurface is 0 (placement already covered), inner
+    // against outer cladding
+    void AddCladdingSurfaces(G4VPhysicalVolume* cladOt, G4VPhysicalVolume* mother,
+                             G4OpticalSurface* outerSurface, G4OpticalSurface* innerSurface);
+
+    // Air box of the given half sizes placed in the world
+    G4VPhysicalVolume* PlaceEnvelope(const G4String& name,
+                                     const G4ThreeVector& halfSize,
+                                     const G4ThreeVector& position);
+
     void UpdateGeometryParameters();
 
+    // Regions "CubeArray" (the block of cubes), "Fibers" (every fiber
+    // piece, inside the cubes too) and "Readout" (photon detectors and
+    // mirrors); the rest stays in the default world region.  Their cuts
+    // and step limits are set by WLSPhysicsList.
+    void AssignRegions();
+    void ReleaseRegions();
+
+    void GeometryChanged(ChangeKind);
+    void UpdateSurfaces();
+    void UpdateMaterials();
+    static G4OpticalSurface* FindSkinSurface(const G4String& name);
+
     WLSDetectorMessenger* fDetectorMessenger;
     G4Cache<WLSPhotonDetSD*> fmppcSD;
 };
@@ -41,6 +41,7 @@
 #include "WLSDetectorConstruction.hh"
 
 class G4UIdirectory;
+class G4UIcommand;
 class G4UIcmdWithABool;
 class G4UIcmdWithAString;
 
@@ -72,6 +73,8 @@ class WLSDetectorMessenger : public G4UImessenger
     G4UIcmdWithADoubleAndUnit* fSetClad1RadiusCmd;
     G4UIcmdWithADoubleAndUnit* fSetClad2RadiusCmd;
     G4UIcmdWithADoubleAndUnit* fSetPhotonDetHalfLengthCmd;
+    G4UIcmdWithADoubleAndUnit* fSetFiberLengthCmd;
+    G4UIcmdWithADoubleAndUnit* fSetGapLengthCmd;
     G4UIcmdWithADoubleAndUnit* fSetGapCmd;
     G4UIcmdWithADoubleAndUnit* fSetPhotonDetAlignmentCmd;
     G4UIcmdWithADouble*        fSetXYRatioCmd;
@@ -80,12 +83,27 @@ class WLSDetectorMessenger : public G4UImessenger
     G4UIcmdWithADouble*        fSetMirrorReflectivityCmd;
     G4UIcmdWithADouble*        fSetPhotonDetPolishCmd;
     G4UIcmdWithADouble*        fSetPhotonDetReflectivityCmd;
+    G4UIcmdWithABool*          fSetPhotonDetDeferredCmd;
+    G4UIcommand*               fAddPhotonDetPDECmd;
+    G4UIcmdWithADouble*        fSetCubeReflectivityCmd;
+    G4UIcmdWithADouble*        fSetScintillationYieldCmd;
     G4UIcmdWithABool*          fSetMirrorCmd;
     G4UIcmdWithADoubleAndUnit* fSetBarLengthCmd;
     G4UIcmdWithADoubleAndUnit* fSetBarBaseCmd;
     G4UIcmdWithADoubleAndUnit* fSetHoleRadiusCmd;
+    G4UIcmdWithADoubleAndUnit* fSetHolePositionCmd;
     G4UIcmdWithADoubleAndUnit* fSetCoatingThicknessCmd;
     G4UIcmdWithADoubleAndUnit* fSetCoatingRadiusCmd;
+    G4UIcmdWithAString*        fSetHoleModeCmd;
+
+    G4UIdirectory*             fArrayDir;
+    G4UIcommand*               fSetArraySizeCmd;
+
+    G4UIdirectory*             fGeometryDir;
+    G4UIcmdWithAString*        fExportGeometryCmd;
+    G4UIcmdWithAString*        fLoadGeometryCmd;
+
+    G4UIcmdWithAString*        fSetOpticalTablesCmd;
 
 };
 
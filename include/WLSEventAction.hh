@@ -40,8 +40,14 @@
 #include "G4ThreeVector.hh"
 #include "WLSPrimaryGeneratorAction.hh"
 #include "WLSStackingAction.hh"
+#include "WLSEventRecord.hh"
+#include "WLSUserTrackInformation.hh"
+
+#include <map>
+#include <vector>
 
 class WLSRunAction;
+class WLSDetectorConstruction;
 class WLSEventActionMessenger;
 class WLSPrimaryGeneratorAction;
 class WLSStackingAction;
@@ -51,7 +57,8 @@ class WLSEventAction : public G4UserEventAction
 public:
     // WLSEventAction(WLSRunAction*,);
     // WLSEventAction(WLSRunAction*,WLSPrimaryGeneratorAction*);
-    WLSEventAction(WLSRunAction*, WLSPrimaryGeneratorAction*, WLSStackingAction*);
+    WLSEventAction(WLSRunAction*, WLSPrimaryGeneratorAction*, WLSStackingAction*,
+                   WLSDetectorConstruction*);
     virtual ~WLSEventAction();
 public:
     virtual void BeginOfEventAction(const G4Event*);
@@ -81,6 +88,10 @@ public:
         fForceNoPhotons = b;
     }
 
+    // Events failing the trigger are not written to the ntuple or the
+    // event stream; mode is one of none, any, coincidence, total
+    void SetTrigger(const G4String& mode, G4int threshold);
+
     void SetBeamPrimaryX(G4int a)
     {
         fPrimaryX = a;
@@ -96,20 +107,49 @@ public:
         fPrimaryZ = a;
     }                                                // add
 
-    void AddPhotCountX(G4int i, G4int a)
+    // A photon detected on a readout channel (see
+    // WLSDetectorConstruction::GetChannel) at global time t
+    void AddChannelHit(G4int channel, G4double t)
     {
-        fPhotCountX[i] += a;
-    }                                                           // add
+        ChannelHits& hits = fChannelHits[channel];
+        if (hits.photons == 0 || hits.firstTime > t)
+            hits.firstTime = t;
+        hits.photons++;
+    }
 
-    void AddPhotCountY(G4int j, G4int a)
+    G4int    GetChannelPhotons(G4int channel) const;
+    // 0 if the channel has no photon
+    G4double GetChannelFirstTime(G4int channel) const;
+
+    // Energy deposited in a scintillator cube (see
+    // WLSDetectorConstruction::GetCube); filled with or without optical
+    // physics
+    void AddCubeDeposit(G4int cube, G4double edep)
     {
-        fPhotCountY[j] += a;
-    }                                                           // add
+        fCubeDeposits[cube] += edep;
+        fTotalDeposit += edep;
+    }
+
+    G4double GetCubeDeposit(G4int cube) const;
 
-    void AddPhotCountZ(G4int i, G4int j, G4int a)
+    // Whether the photon detectors leave the efficiency to this class
+    // (WLSDetectorConstruction::SetPhotonDetDeferred); fixed for the event
+    G4bool IsPhotonDetDeferred() const { return fDeferredPDE; }
+
+    // A photon absorbed by a photon detector in deferred mode; true if
+    // curve 0 of WLSPhotonDetEfficiency accepts it
+    G4bool AddArrivingPhoton(G4int channel, G4double t, G4double energy);
+
+    // Whether detected photons are written with their history; fixed for
+    // the event
+    G4bool IsPhotonHistoryOn() const { return fPhotonHistory; }
+
+    void AddDetectedPhoton(G4int channel, G4double t, G4double energy,
+                           const WLSPhotonHistory& history)
     {
-        fPhotCountZ[i][j] += a;
-    }                                                                         // add
+        DetectedPhoton photon = { channel, t, energy, history };
+        fDetectedPhotons.push_back(photon);
+    }
 
     // そのイベントで最初にMPPCに光子が来た時間
     void AddPhottime(G4double a)
@@ -123,13 +163,6 @@ public:
         if (fPhotlasttime < a)
             fPhotlasttime = a;
     }                                                    // add
-    // z readout ごとに最初に来た時間
-    void AddHittimeZ(G4int i, G4int j, G4double a)
-    {
-        if (fHittimeZ[i][j] == 0 || fHittimeZ[i][j] > a)
-            fHittimeZ[i][j] = a;
-    }
-
     // Trackの軌跡
     // void AddTrackPos(G4ThreeVector pos)
     // {
@@ -150,10 +183,19 @@ public:
     void GiveParticleInitialPosi(G4ThreeVector a);
 
 private:
+    // Copy the per-event quantities written to the ntuple into a record
+    void FillEventRecord(const G4Event*, WLSEventRecord&);
+
+    G4bool PassesTrigger() const;
+
+    // "pde" and "arrivals" ntuples of a deferred-efficiency event
+    void FillEfficiencyCurves(const G4Event*);
+
     WLSRunAction* fRunAction;
     WLSEventActionMessenger* fEventMessenger;
     WLSPrimaryGeneratorAction* fPrimarysource;
     WLSStackingAction* fStacking;
+    WLSDetectorConstruction* fDetector;
 
     G4int fVerboseLevel;
     G4int fPrintModulo;
@@ -165,15 +207,47 @@ private:
     G4bool fForceDrawPhotons;
     G4bool fForceNoPhotons;
 
+    enum TriggerMode { kTriggerNone, kTriggerAny, kTriggerCoincidence, kTriggerTotal };
+    TriggerMode fTriggerMode;
+    G4int       fTriggerThreshold;
+
     int fPrimaryX; // add
     int fPrimaryY; // add
     int fPrimaryZ; // add
-    int fPhotCountX[3]; // add
-    int fPhotCountY[3]; // add
-    int fPhotCountZ[3][3]; // add
+    // Only channels that saw a photon are stored, so the per-event cost
+    // does not depend on the size of the array
+    struct ChannelHits
+    {
+        ChannelHits() : photons(0), firstTime(0) {}
+        G4int    photons;
+        G4double firstTime;
+    };
+    std::map<G4int, ChannelHits> fChannelHits;
+    std::map<G4int, G4double> fCubeDeposits;
+    G4double fTotalDeposit;
+
+    struct DetectedPhoton
+    {
+        G4int            channel;
+        G4double         time;
+        G4double         energy;
+        WLSPhotonHistory history;
+    };
+    G4bool fPhotonHistory;
+    std::vector<DetectedPhoton> fDetectedPhotons;
+
+    // u decides for every curve (see WLSPhotonDetEfficiency)
+    struct ArrivingPhoton
+    {
+        G4int    channel;
+        G4double time;
+        G4double energy;
+        G4double u;
+    };
+    G4bool fDeferredPDE;
+    std::vector<ArrivingPhoton> fArrivingPhotons;
     double fPhottime; // add
     double fPhotlasttime; // add
-    double fHittimeZ[3][3];
 
     // std::vector<G4ThreeVector> fTrajectory;
     G4ThreeVector fCubeInPos;
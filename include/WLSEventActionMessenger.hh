@@ -41,6 +41,7 @@
 class EventAction;
 class G4UIcmdWithAString;
 class G4UIcmdWithAnInteger;
+class G4UIcommand;
 
 class WLSEventActionMessenger: public G4UImessenger
 {
@@ -58,6 +59,7 @@ class WLSEventActionMessenger: public G4UImessenger
     G4UIcmdWithAnInteger* fSetVerboseCmd;
     G4UIcmdWithAString*   fDrawCmd;
     G4UIcmdWithAnInteger* fPrintCmd;
+    G4UIcommand*          fTriggerCmd;
 };
 
 #endif
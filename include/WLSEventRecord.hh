@@ -0,0 +1,122 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSEventRecord.hh
+/// \brief Binary layout of the per-event shared-memory stream
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSEventRecord_h
+#define WLSEventRecord_h 1
+
+// This header is shared by wls and by stand-alone consumers
+// (tools/wls-shm-consumer.cc), so it must not include any Geant4 header.
+
+#include <stdint.h>
+#include <atomic>
+
+/*
+    Shared-memory segment (POSIX shm_open, name given by /WLS/output/shm)
+
+    offset 0                       : WLSShmHeader   (64 bytes)
+    offset 64 + k * sizeof(slot)   : WLSShmSlot k,  k = 0 .. capacity-1
+
+    All values are in host byte order; doubles are IEEE 754.
+    Energies are in MeV, lengths in mm and times in ns (Geant4 internal units).
+
+    Writers take a ticket t from WLSShmHeader::writeIndex and fill slot
+    t % capacity.  The slot sequence is 2t+1 while the record is written and
+    2t+2 once it is complete.  A reader expecting ticket t accepts the record
+    only if the sequence reads 2t+2 both before and after copying it; a larger
+    value means the writer has lapped the reader and events were lost.
+*/
+
+const char     kWLSShmMagic[8]  = { 'W', 'L', 'S', 'S', 'H', 'M', 0, 0 };
+const uint32_t kWLSShmVersion   = 2;
+const uint64_t kWLSShmDefaultCapacity = 4096;
+
+// Channels carried per record; an event lighting more channels has
+// nChannelsHit > nChannels and only the lowest channel numbers are kept
+const int32_t  kWLSShmMaxChannels = 64;
+
+struct WLSChannelRecord
+{
+    int32_t channel;         // readout channel, numbered from 1
+    int32_t photons;
+    double  firstTime;       // first photon arrival
+};
+
+// Same fields, same order as the "cube" ntuple filled in EndOfEventAction,
+// followed by the channels of the "hits" ntuple.  npx, npy, npz and
+// hittimez are only filled for the 3 x 3 x 1 array.
+struct WLSEventRecord
+{
+    int32_t eventID;
+    int32_t runID;
+    double  energy;          // primary energy
+    double  position[3];     // primary vertex
+    double  nPhotons;        // optical photons created in the event
+    double  npx[3];
+    double  npy[3];
+    double  npz[3][3];
+    double  time;            // first photon arrival at any MPPC
+    double  lasttime;        // last photon arrival at any MPPC
+    double  hittimez[3][3];  // first arrival per Z readout, 0 if none
+    double  cubeInPos[3];
+    double  cubeOutPos[3];
+    int32_t nChannelsHit;    // channels with at least one photon
+    int32_t nChannels;       // entries used in channels[]
+    WLSChannelRecord channels[kWLSShmMaxChannels];
+};
+
+struct WLSShmHeader
+{
+    char                  magic[8];
+    uint32_t              version;
+    uint32_t              recordSize;   // sizeof(WLSEventRecord)
+    uint64_t              capacity;     // number of slots
+    std::atomic<uint64_t> writeIndex;   // next ticket to be handed out
+    uint64_t              reserved[4];
+};
+
+struct WLSShmSlot
+{
+    std::atomic<uint64_t> sequence;
+    uint64_t              padding;
+    WLSEventRecord        record;
+};
+
+static_assert(sizeof(WLSShmHeader) == 64, "WLSShmHeader must stay 64 bytes");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "std::atomic<uint64_t> must be usable in shared memory");
+
+inline uint64_t WLSShmSegmentSize(uint64_t capacity)
+{
+    return sizeof(WLSShmHeader) + capacity * sizeof(WLSShmSlot);
+}
+
+#endif
@@ -48,6 +48,10 @@
 
 #include "G4VPhysicsConstructor.hh"
 
+#include "WLSRegionProcess.hh"
+
+#include <map>
+
 class WLSOpticalPhysics : public G4VPhysicsConstructor
 {
   public:
@@ -68,17 +72,37 @@ class WLSOpticalPhysics : public G4VPhysicsConstructor
 
     void SetNbOfPhotonsCerenkov(G4int);
 
+    // Cerenkov and scintillation per region of WLSDetectorConstruction
+    // (by name, "DefaultRegionForTheWorld" for the rest).  The switches
+    // are shared by the processes of every thread, so they may also be
+    // changed between runs.
+    void SetCerenkovInRegion(const G4String& region, G4bool);
+    void SetScintillationInRegion(const G4String& region, G4bool);
+    // Cerenkov off before /run/initialize: the process is not even added
+    void SetCerenkov(G4bool);
+    // WLSBatchScintillation instead of G4Scintillation (before /run/initialize)
+    void SetBatchScintillation(G4bool on) {fBatchScintOn = on;}
+    // Take over the settings above from another instance
+    void CopySwitches(const WLSOpticalPhysics&);
+
 private:
 
-    G4OpWLS*             fWLSProcess;
-    G4Cerenkov*          fCerenkovProcess;
-    G4Scintillation*     fScintProcess;
-    G4OpAbsorption*      fAbsorptionProcess;
-    G4OpRayleigh*        fRayleighScattering;
-    G4OpMieHG*           fMieHGScatteringProcess;
-    G4OpBoundaryProcess* fBoundaryProcess;
- 
+    // every thread constructs its own processes
+    static G4ThreadLocal G4OpWLS*             fWLSProcess;
+    static G4ThreadLocal G4Cerenkov*          fCerenkovProcess;
+    static G4ThreadLocal G4Scintillation*     fScintProcess;
+    static G4ThreadLocal G4OpAbsorption*      fAbsorptionProcess;
+    static G4ThreadLocal G4OpRayleigh*        fRayleighScattering;
+    static G4ThreadLocal G4OpMieHG*           fMieHGScatteringProcess;
+    static G4ThreadLocal G4OpBoundaryProcess* fBoundaryProcess;
+
     G4bool fAbsorptionOn;
+    G4bool fCerenkovOn;
+    G4bool fBatchScintOn;
+    G4int  fMaxNumPhotons;
+    std::map<G4String, G4bool> fCerenkovRegions;
+    WLSRegionSwitches fCerenkovSwitches;
+    WLSRegionSwitches fScintSwitches;
 
 };
 #endif
@@ -0,0 +1,126 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSOpticalTables.hh
+/// \brief Definition of the WLSOpticalTables class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSOpticalTables_h
+#define WLSOpticalTables_h 1
+
+#include "globals.hh"
+
+#include "WLSAliasTable.hh"
+
+#include <map>
+#include <vector>
+
+class G4MaterialPropertiesTable;
+
+// Optical spectra and constants used by WLSMaterials and the photon
+// detector surface.  The defaults are the compiled-in tables of
+// parameter.hh; Load() replaces any of them from a text file:
+//
+//   wls-optical-tables 1
+//   # comment
+//   table absWLSfiber eV m        <- name, energy unit, value unit
+//   2.00  4.5
+//   ...                           <- increasing energies, 2 points or more
+//   end
+//   const scintiLY 20000 /MeV     <- name, value, unit ("1" if none)
+//
+// Tables: absPS scintilFast refractiveIndexPS absWLSfiber emissionFib
+// refractiveIndexWLSfiber absClad refractiveIndexClad1 refractiveIndexClad2
+// effi_mppc.  Constants: scintiLY scintiTime WLSTime.  Names not in the
+// file keep their default; an invalid file is a fatal error.
+//
+// The tables are loaded on the master before the materials are built and
+// never change afterwards: the materials copy them into their property
+// vectors once, and the worker threads share those read-only.  The same
+// holds for the samplers of the emission spectra, built by Lock().
+
+class WLSOpticalTables
+{
+  public:
+
+    struct Table
+    {
+        std::vector<G4double> energy;
+        std::vector<G4double> value;
+    };
+
+    static WLSOpticalTables* GetInstance();
+
+    void Load(const G4String& fileName);
+    // Called when the materials are built; Load() is refused afterwards
+    void Lock();
+
+    const Table& GetTable(const G4String& name) const;
+    G4double GetConstant(const G4String& name) const;
+    // Alias sampler of an emission spectrum (scintilFast, emissionFib):
+    // Sample(u, v) is an energy with the distribution G4Scintillation and
+    // G4OpWLS draw from the table.  Fatal before Lock() or for other tables.
+    const WLSAliasTable& GetSampler(const G4String& name) const;
+    // mpt->AddProperty(key, ...) with the table name
+    void AddProperty(G4MaterialPropertiesTable* mpt, const G4String& key,
+                     const G4String& name) const;
+
+    // Table `name` of a file in the format above without touching the
+    // tables in use, e.g. the effi_mppc of other sensors for
+    // WLSPhotonDetEfficiency; fatal if the file is invalid or lacks it
+    Table ReadTable(const G4String& fileName, const G4String& name) const;
+
+    // "compiled-in" or the file name
+    const G4String& GetSource() const { return fSource; }
+
+    // Everything in use, by name (the key of WLSResponseCache)
+    const std::map<G4String, Table>& GetTables() const { return fTables; }
+    const std::map<G4String, G4double>& GetConstants() const { return fConstants; }
+
+  private:
+
+    WLSOpticalTables();
+
+    void SetDefault(const G4String& name, const G4double* energy,
+                    const G4double* value, G4int n);
+    // Parse and check a whole file; false (after a fatal exception) if invalid
+    G4bool Read(const G4String& fileName, std::map<G4String, Table>& tables,
+                std::map<G4String, G4double>& constants) const;
+    // Empty if the table is acceptable for its name, else the reason
+    static G4String Check(const G4String& name, const Table&);
+
+    std::map<G4String, Table> fTables;
+    std::map<G4String, G4double> fConstants;
+    std::map<G4String, WLSAliasTable> fSamplers;
+    G4String fSource;
+    G4bool fLocked;
+
+    static WLSOpticalTables* fInstance;
+};
+
+#endif
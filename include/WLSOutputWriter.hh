@@ -0,0 +1,72 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSOutputWriter.hh
+/// \brief Definition of the WLSOutputWriter class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSOutputWriter_h
+#define WLSOutputWriter_h 1
+
+#include "globals.hh"
+
+// Output backend used by the run and event actions.  The interface is the
+// part of G4VAnalysisManager that wls uses, so "root" and "csv" simply
+// forward to the Geant4 analysis managers; "bin" writes the memory-mapped
+// columnar files described in WLSColumnarFormat.hh.
+//
+// Ntuples and histograms are booked once; OpenFile()/CloseFile() are then
+// called for every run.
+
+class WLSOutputWriter
+{
+  public:
+
+    virtual ~WLSOutputWriter() {}
+
+    // format is one of "root", "csv", "bin"; returns 0 for anything else
+    static WLSOutputWriter* Create(const G4String& format);
+
+    virtual G4String GetType() const = 0;
+
+    virtual G4bool OpenFile(const G4String& fileName) = 0;
+    virtual G4bool Write() = 0;
+    virtual G4bool CloseFile() = 0;
+
+    virtual G4int  CreateNtuple(const G4String& name, const G4String& title) = 0;
+    virtual G4int  CreateNtupleDColumn(G4int ntupleId, const G4String& name) = 0;
+    virtual void   FinishNtuple(G4int ntupleId) = 0;
+    virtual void   FillNtupleDColumn(G4int ntupleId, G4int columnId, G4double value) = 0;
+    virtual void   AddNtupleRow(G4int ntupleId) = 0;
+
+    virtual G4int  CreateH1(const G4String& name, const G4String& title,
+                            G4int nbins, G4double xmin, G4double xmax) = 0;
+    virtual void   FillH1(G4int id, G4double value, G4double weight = 1.0) = 0;
+};
+
+#endif
@@ -0,0 +1,86 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSPhotonDetEfficiency.hh
+/// \brief Definition of the WLSPhotonDetEfficiency class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSPhotonDetEfficiency_h
+#define WLSPhotonDetEfficiency_h 1
+
+#include "globals.hh"
+
+#include "WLSOpticalTables.hh"
+
+#include <vector>
+
+// Photon detection efficiency curves applied to the photons reaching the
+// MPPCs when the surface itself detects all of them
+// (/WLS/setPhotonDetDeferred).  Curve 0 is the effi_mppc table in use
+// (WLSOpticalTables); /WLS/addPhotonDetPDE adds the effi_mppc table of
+// another wls-optical-tables file under a name.
+//
+// Every arriving photon carries one uniform number u, and it counts for
+// curve k if u < GetEfficiency(k, energy): the curves see the same
+// photons, so their differences are not blurred by independent sampling.
+//
+// Curves are added on the master between runs; the worker threads only
+// read them during a run.
+
+class WLSPhotonDetEfficiency
+{
+  public:
+
+    static WLSPhotonDetEfficiency* GetInstance();
+
+    // A curve of the same name is replaced
+    void AddCurve(const G4String& name, const G4String& fileName);
+
+    G4int GetNumberOfCurves() const { return fNames.size(); }
+    const G4String& GetName(G4int curve) const { return fNames[curve]; }
+
+    // Linear in energy, the end values outside the table (as
+    // G4PhysicsVector::Value())
+    G4double GetEfficiency(G4int curve, G4double energy) const;
+
+    void Print() const;
+
+  private:
+
+    WLSPhotonDetEfficiency();
+
+    std::vector<G4String> fNames;
+    // Curve 0 stays the table of WLSOpticalTables, which may still load a
+    // file; fCurves[k - 1] is curve k
+    const WLSOpticalTables::Table* fDefault;
+    std::vector<WLSOpticalTables::Table> fCurves;
+
+    static WLSPhotonDetEfficiency* fInstance;
+};
+
+#endif
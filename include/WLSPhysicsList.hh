@@ -38,6 +38,8 @@
 #include "globals.hh"
 #include "G4VModularPhysicsList.hh"
 
+#include <map>
+
 class G4VPhysicsConstructor;
 class WLSPhysicsListMessenger;
 
@@ -60,6 +62,12 @@ class WLSPhysicsList: public G4VModularPhysicsList
     WLSStepMax* GetStepMaxProcess();
     void AddStepMax();
 
+    // Production cut (gamma, e-, e+, proton) and charged step limit of a
+    // region of WLSDetectorConstruction; "World" is the default region.
+    // Settings given before the region exists are applied in SetCuts().
+    void SetRegionCut(const G4String& region, G4double);
+    void SetRegionStepMax(const G4String& region, G4double);
+
     /// Remove specific physics from physics list.
     void RemoveFromPhysicsList(const G4String&);
 
@@ -74,10 +82,28 @@ class WLSPhysicsList: public G4VModularPhysicsList
 
     void SetNbOfPhotonsCerenkov(G4int);
 
+    // Optical photon sources per region ("World" = default region), see
+    // WLSOpticalPhysics
+    void SetCerenkovInRegion(const G4String& region, G4bool);
+    void SetScintillationInRegion(const G4String& region, G4bool);
+    void SetCerenkov(G4bool);
+    // Scintillation photons made in batches (WLSBatchScintillation)
+    void SetBatchScintillation(G4bool);
+
+    // Register WLSOpticalPhysics or not (before /run/initialize); without
+    // it no optical photon is produced and only energy deposits are left
+    void SetOptical(G4bool);
+
     void SetVerbose(G4int);
 
+    // The optical switches the light reaching the photon detectors
+    // depends on, one per line (see WLSResponseCache)
+    void WriteResponseParameters(std::ostream&) const;
+
 private:
 
+    void ApplyRegionSettings();
+
     G4double fCutForGamma;
     G4double fCutForElectron;
     G4double fCutForPositron;
@@ -89,6 +115,10 @@ private:
     WLSPhysicsListMessenger* fMessenger;
 
     G4bool fAbsorptionOn;
+    G4bool fOpticalOn;
+
+    std::map<G4String, G4double> fRegionCuts;
+    std::map<G4String, G4double> fRegionStepMax;
     
     G4VMPLData::G4PhysConstVectorData* fPhysicsVector;
 
@@ -82,6 +82,15 @@ class WLSPhysicsListMessenger : public G4UImessenger
     G4UIcmdWithADoubleAndUnit* fAllCutCMD;
     G4UIcmdWithADoubleAndUnit* fStepMaxCMD;
 
+    G4UIcommand*               fRegionCutCMD;
+    G4UIcommand*               fRegionStepMaxCMD;
+
+    G4UIcmdWithABool*          fCerenkovOnCMD;
+    G4UIcommand*               fRegionCerenkovCMD;
+    G4UIcommand*               fRegionScintCMD;
+    G4UIcmdWithAString*        fOpticalCMD;
+    G4UIcmdWithABool*          fBatchScintCMD;
+
     G4UIcmdWithAString*        fRemovePhysicsCMD;
     G4UIcmdWithoutParameter*   fClearPhysicsCMD;
 
@@ -0,0 +1,76 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSPrimaryFile.hh
+/// \brief Definition of the WLSPrimaryFile class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSPrimaryFile_h
+#define WLSPrimaryFile_h 1
+
+#include "globals.hh"
+
+#include "WLSPrimaryRecord.hh"
+
+#include <vector>
+
+// Read-only memory map of a primary event file (WLSPrimaryRecord.hh).
+// Each generator thread maps the file itself; the pages are shared by the
+// operating system, and nothing is copied or locked per event.
+
+class WLSPrimaryFile
+{
+  public:
+
+    WLSPrimaryFile();
+    ~WLSPrimaryFile();
+
+    // False (after a warning, the previous file closed) if the file
+    // cannot be mapped or is not a primary event file
+    G4bool Open(const G4String& fileName);
+    void Close();
+    G4bool IsOpen() const { return fRecords != 0; }
+
+    const G4String& GetFileName() const { return fFileName; }
+    G4int GetNumberOfEvents() const { return fEventStart.size(); }
+
+    // The n records of event i, 0 <= i < GetNumberOfEvents()
+    const WLSPrimaryRecord* GetEvent(G4int i, G4int& n) const;
+
+  private:
+
+    G4String fFileName;
+    void* fMap;
+    size_t fMapSize;
+    const WLSPrimaryRecord* fRecords;
+    uint64_t fCount;
+    // Index of the first record of every event
+    std::vector<uint64_t> fEventStart;
+};
+
+#endif
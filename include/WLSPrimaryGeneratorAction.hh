@@ -40,14 +40,17 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4AffineTransform.hh"
 #include "G4GeneralParticleSource.hh"
+#include "G4ThreeVector.hh"
 
 class G4GeneralParticleSource;
+class G4Navigator;
+class G4ParticleDefinition;
 
 class G4Event;
-class G4PhysicsTable;
 
 class WLSDetectorConstruction;
 class WLSPrimaryGeneratorMessenger;
+class WLSPrimaryFile;
 
 class WLSPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -61,31 +64,102 @@ class WLSPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 
     virtual void GeneratePrimaries(G4Event*);
 
-    void BuildEmissionSpectrum();
-
     void SetOptPhotonPolar(G4double);
 
     void SetDecayTimeConstant(G4double);
 
 	 G4GeneralParticleSource* GetSouce();
 
-  protected:
-
-    G4PhysicsTable* fIntegralTable;
+    // Photon bomb: instead of the GPS primary, n optical photons start
+    // at one point in the scintillator with the scintilFast spectrum, an
+    // isotropic direction, a random polarization and an exponential time
+    // (scintiTime).  The point is random in the cube given (-1: in a
+    // random cube) unless SetBombPosition() fixed it.  n = 0 is off.
+    void SetBombPhotons(G4int n) { fBombPhotons = n; }
+    void SetBombCube(G4int cube) { fBombCube = cube; fBombFixed = false; }
+    void SetBombPosition(const G4ThreeVector& p) { fBombPosition = p; fBombFixed = true; }
+    G4int GetBombPhotons() const { return fBombPhotons; }
+
+    // Beam: a source of our own for the usual beam shapes, used instead of
+    // the GPS when the shape is not "off".  Its settings belong to the
+    // thread, so unlike the GPS path it never takes gen_mutex.
+    //   pencil  every particle at the centre
+    //   gauss   centre + Gaussian offsets of sigma_r in x and y (GPS Beam)
+    //   square  uniform in centre +- (halfx, halfy, 0) (GPS Plane Square)
+    // Optical photons get a random polarization and the decay time
+    // constant, as on the GPS path.  Returns false for an unknown shape.
+    G4bool SetBeamShape(const G4String&);
+    // False (settings unchanged) for an unknown particle
+    G4bool SetBeamParticle(const G4String&);
+    void SetBeamEnergy(G4double e) { fBeamEnergy = e; }
+    void SetBeamCentre(const G4ThreeVector& p) { fBeamCentre = p; }
+    void SetBeamDirection(const G4ThreeVector& d) { fBeamDirection = d.unit(); }
+    void SetBeamSigma(G4double sigma) { fBeamSigma = sigma; }
+    void SetBeamHalfX(G4double half) { fBeamHalfX = half; }
+    void SetBeamHalfY(G4double half) { fBeamHalfY = half; }
+
+    // Primary event file (WLSPrimaryRecord.hh), used instead of the beam
+    // and the GPS while open; "none" closes it.  Event n of the run is
+    // file event (offset + n) modulo the events in the file, whichever
+    // thread runs it.  With partitioning each thread instead reads its own
+    // contiguous share of the file in order, which only repeats exactly
+    // with the same number of threads and events per thread.
+    G4bool SetPrimaryFile(const G4String&);
+    void SetPrimaryFileOffset(G4int offset) { fFileOffset = offset; fFileCursor = 0; }
+    void SetPrimaryFilePartition(G4bool on) { fFilePartition = on; fFileCursor = 0; }
+
+    // What the event was started with: the GPS particle, the beam, the
+    // file (total kinetic energy, first vertex), or the photon bomb
+    // (total photon energy, bomb point)
+    G4double      GetPrimaryEnergy();
+    G4ThreeVector GetPrimaryPosition();
 
   private:
 
     void SetOptPhotonPolar();
     void SetOptPhotonTime();
+    // Linear polarization at angle w.r.t. the (k,n) plane
+    static G4ThreeVector PolarizationFor(const G4ThreeVector& kphoton, G4double angle);
+
+    void GeneratePhotonBomb(G4Event*);
+    G4ThreeVector SampleBombPosition();
+    G4double SampleBombEnergy();
+
+    enum BeamShape { kBeamOff, kBeamPencil, kBeamGauss, kBeamSquare };
+    void GenerateBeam(G4Event*);
+    void GenerateFromFile(G4Event*);
  
     WLSDetectorConstruction*   fDetector;
     G4GeneralParticleSource*   fParticleGun;
     WLSPrimaryGeneratorMessenger* fGunMessenger;
 
-    static G4bool fFirst;
-
     G4double fTimeConstant;
 
+    G4int         fBombPhotons;
+    G4int         fBombCube;
+    G4bool        fBombFixed;
+    G4ThreeVector fBombPosition;
+    G4double      fBombEnergy;
+    G4Navigator*  fNavigator;
+
+    BeamShape             fBeamShape;
+    G4ParticleDefinition* fBeamParticle;
+    G4double              fBeamEnergy;
+    G4ThreeVector         fBeamCentre;
+    G4ThreeVector         fBeamDirection;
+    G4double              fBeamSigma;
+    G4double              fBeamHalfX;
+    G4double              fBeamHalfY;
+    G4ThreeVector         fBeamPosition;
+
+    WLSPrimaryFile*       fPrimaryFile;
+    G4int                 fFileOffset;
+    G4bool                fFilePartition;
+    G4int                 fFileCursor;
+    G4bool                fFileWarned;
+    G4double              fFileEnergy;
+    G4ThreeVector         fFilePosition;
+
     //WLSEventAction* fEventAction; // add
 
 };
@@ -40,6 +40,11 @@
 
 class G4UIdirectory;
 class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWith3Vector;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
 
 class WLSPrimaryGeneratorAction;
 
@@ -60,6 +65,22 @@ class WLSPrimaryGeneratorMessenger : public G4UImessenger
 
     G4UIcmdWithADoubleAndUnit*   fSetPolarizationCmd;
     G4UIcmdWithADoubleAndUnit*   fSetDecayTimeConstantCmd;
+    G4UIcmdWithAnInteger*        fBombPhotonsCmd;
+    G4UIcmdWithAnInteger*        fBombCubeCmd;
+    G4UIcmdWith3VectorAndUnit*   fBombPositionCmd;
+
+    G4UIcmdWithAString*          fBeamShapeCmd;
+    G4UIcmdWithAString*          fBeamParticleCmd;
+    G4UIcmdWithADoubleAndUnit*   fBeamEnergyCmd;
+    G4UIcmdWith3VectorAndUnit*   fBeamCentreCmd;
+    G4UIcmdWith3Vector*          fBeamDirectionCmd;
+    G4UIcmdWithADoubleAndUnit*   fBeamSigmaCmd;
+    G4UIcmdWithADoubleAndUnit*   fBeamHalfXCmd;
+    G4UIcmdWithADoubleAndUnit*   fBeamHalfYCmd;
+
+    G4UIcmdWithAString*          fFileCmd;
+    G4UIcmdWithAnInteger*        fFileOffsetCmd;
+    G4UIcmdWithABool*            fFilePartitionCmd;
 };
 
 #endif
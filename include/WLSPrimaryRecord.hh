@@ -0,0 +1,80 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSPrimaryRecord.hh
+/// \brief Binary layout of the primary event files
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSPrimaryRecord_h
+#define WLSPrimaryRecord_h 1
+
+// This header is shared by wls and by stand-alone tools
+// (tools/wls-primaries.cc), so it must not include any Geant4 header.
+
+#include <stdint.h>
+
+/*
+    Primary event file (/WLS/gun/file), written by wls-primaries
+
+    offset 0                         : WLSPrimaryFileHeader (32 bytes)
+    offset 32 + k * sizeof(record)   : WLSPrimaryRecord k, k = 0 .. count-1
+
+    All values are in host byte order; doubles are IEEE 754.
+    Energies are in MeV, lengths in mm and times in ns (Geant4 internal units).
+
+    Consecutive records with the same event number make one event, each
+    record one primary vertex.  Event numbers only have to change between
+    events; they need not be consecutive.
+*/
+
+const char     kWLSPrimaryMagic[8] = { 'W', 'L', 'S', 'P', 'R', 'I', 'M', 0 };
+const uint32_t kWLSPrimaryVersion  = 1;
+
+struct WLSPrimaryRecord
+{
+    int32_t  pdg;            // PDG code, -22 for an optical photon
+    uint32_t event;
+    double   energy;         // kinetic energy
+    double   position[3];
+    double   direction[3];   // need not be normalised
+    double   time;
+};
+
+struct WLSPrimaryFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;     // sizeof(WLSPrimaryRecord)
+    uint64_t count;          // number of records
+    uint64_t reserved;
+};
+
+static_assert(sizeof(WLSPrimaryFileHeader) == 32, "WLSPrimaryFileHeader must stay 32 bytes");
+static_assert(sizeof(WLSPrimaryRecord) == 72, "WLSPrimaryRecord must stay 72 bytes");
+
+#endif
@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSRegionProcess.hh
+/// \brief Definition of the WLSRegionProcess class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSRegionProcess_h
+#define WLSRegionProcess_h 1
+
+#include "globals.hh"
+#include "G4WrapperProcess.hh"
+#include "G4Threading.hh"
+
+#include <atomic>
+#include <map>
+
+class G4Region;
+
+// Region switches of one process, shared by its copies in every thread.
+// They may change between runs; each copy picks the change up at the
+// start of its next track.
+
+class WLSRegionSwitches
+{
+  public:
+
+    WLSRegionSwitches();
+
+    // Switch the process in one region (by name), or by default in every
+    // region not named
+    void SetActive(const G4String& region, G4bool);
+    void SetActive(G4bool);
+
+    // Bumped by every change
+    G4int GetVersion() const { return fVersion; }
+    void  Get(std::map<G4String, G4bool>& regions, G4bool& active) const;
+    void  Set(const WLSRegionSwitches&);
+
+  private:
+
+    mutable G4Mutex fMutex;
+    std::map<G4String, G4bool> fRegions;
+    G4bool fDefault;
+    std::atomic<G4int> fVersion;
+};
+
+// Runs the wrapped process (Cerenkov, Scintillation) only in the regions
+// where it is switched on.  Elsewhere it neither limits the step nor
+// produces anything.  It takes the name of the wrapped process, so
+// creator-process checks and /process/ commands still see that name.
+
+class WLSRegionProcess : public G4WrapperProcess
+{
+  public:
+
+    WLSRegionProcess(G4VProcess* process, const WLSRegionSwitches* switches);
+    virtual ~WLSRegionProcess();
+
+    virtual void StartTracking(G4Track*);
+    virtual G4double PostStepGetPhysicalInteractionLength(const G4Track&,
+                                                  G4double previousStepSize,
+                                                  G4ForceCondition*);
+    virtual G4VParticleChange* AtRestDoIt(const G4Track&, const G4Step&);
+
+  private:
+
+    G4bool IsActive(const G4Track&);
+
+    // this thread's copy of the switches
+    const WLSRegionSwitches* fSwitches;
+    G4int fVersion;
+    std::map<G4String, G4bool> fRegions;
+    G4bool fDefault;
+
+    // regions are looked up by name only when the track changes region
+    const G4Region* fLastRegion;
+    G4bool fLastActive;
+};
+
+#endif
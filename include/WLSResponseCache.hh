@@ -0,0 +1,159 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSResponseCache.hh
+/// \brief Definition of the WLSResponseCache class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSResponseCache_h
+#define WLSResponseCache_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <map>
+
+class WLSDetectorConstruction;
+class WLSPhysicsList;
+
+// Detection probability of a scintillation photon as a function of where
+// it starts, filled by every full-tracking run and kept on disk
+// (/WLS/output/responseCache).  Each cube is cut into cubic voxels in its
+// own frame; a voxel counts the photons that started in it and how many of
+// them were detected on the X, Y and Z fiber through that cube and on any
+// other channel (with the default efficiency curve).
+//
+// The statistics belong to one geometry, one optical physics and one set
+// of optical tables: the key is a hash of the parameters the response
+// depends on, of the optical physics switches and of every table and
+// constant of WLSOpticalTables, and the file is
+// <directory>/<key>.wlsresp.  A run loads the file of its key if there is
+// one and adds what it tracked at the end, so the tables of a sweep build
+// up point by point.  Saving locks the file and re-reads it, so several
+// jobs can share a directory.  The file is text:
+//
+//   wls-response-cache 1
+//   key 1f0c5e7a9b2d4c68
+//   voxel 1              <- mm
+//   array 3 3 1
+//   size 10              <- mm, edge of the scintillator cubes
+//   pitch 10.21          <- mm, cube centre to cube centre
+//   cube ix iy iz emitted x y z other
+//   4 0 0 0 8123 151 139 160 33
+//   ...
+//
+// A voxel is flagged while the relative error of one of its three fiber
+// probabilities is above /WLS/output/responseMaxError; GetResponse()
+// refuses flagged voxels.  tools/wls-response lists them and writes a
+// photon-bomb macro that fills them.
+
+class WLSResponseCache
+{
+  public:
+
+    enum Relation { kFiberX, kFiberY, kFiberZ, kOther, kNRelations };
+
+    struct Voxel
+    {
+        Voxel() : emitted(0) { for (int r = 0; r < kNRelations; r++) detected[r] = 0; }
+
+        G4long emitted;
+        G4long detected[kNRelations];
+    };
+
+    static WLSResponseCache* GetInstance();
+
+    // Directory of the cache files, "none" disables the cache
+    void SetDirectory(const G4String&);
+    // Edge of the voxels of a new file; an existing file keeps its own
+    void SetVoxelSize(G4double);
+    void SetMaxError(G4double val) { fMaxError = val; }
+
+    G4bool IsEnabled() const { return fDirectory != ""; }
+
+    // Master, start of run: the key of the current geometry, physics and
+    // tables, and the file of that key read if the key changed
+    void BeginRun(WLSDetectorConstruction*, const WLSPhysicsList*);
+    // Every thread, end of run: its counts go to the run total
+    void Flush();
+    // Master, end of run (after the workers): the run total is added to
+    // the file
+    void EndRun();
+
+    // Voxel of a point in the frame of the cube, -1 outside
+    G4int GetVoxel(const G4ThreeVector& local) const;
+    // Counts of this thread, written out by Flush()
+    void AddEmitted(G4int cube, G4int voxel);
+    void AddDetected(G4int cube, G4int voxel, Relation);
+
+    // Probabilities (kNRelations) of a photon starting at a point in the
+    // frame of the cube, as of the start of the run; false if the voxel is
+    // empty or flagged
+    G4bool GetResponse(G4int cube, const G4ThreeVector& local, G4double* response) const;
+    // Largest relative error of the three fiber probabilities
+    static G4double GetError(const Voxel&);
+
+  private:
+
+    typedef std::map<G4long, Voxel> VoxelMap;
+
+    WLSResponseCache();
+
+    G4long GetKey(G4int cube, G4int voxel) const { return (G4long) cube * fNVoxels + voxel; }
+    Voxel& GetLocal(G4long key);
+
+    G4String GetFileName() const;
+    // Voxels of a file into map; false if there is no file.  Fatal if the
+    // file is invalid or belongs to another key.
+    G4bool Read(const G4String& fileName, VoxelMap& voxels, G4double& size) const;
+    void Write(const G4String& fileName, const VoxelMap& voxels) const;
+    void Print(const G4String& what) const;
+
+    G4String fDirectory;
+    G4double fVoxelSize;
+    G4double fMaxError;
+
+    // Fixed by BeginRun() for the whole run
+    G4String fKey;
+    G4double fCubeSize;
+    G4double fPitch;
+    G4int    fArray[3];
+    G4double fSize;     // voxel edge in use
+    G4int    fPerSide;
+    G4long   fNVoxels;  // per cube
+
+    VoxelMap fVoxels;   // the file as of the last read or write
+    VoxelMap fRun;      // flushed by the threads, not written yet
+
+    static WLSResponseCache* fInstance;
+    static G4ThreadLocal VoxelMap* fLocal;
+    static G4ThreadLocal G4long fLastKey;
+    static G4ThreadLocal Voxel* fLastVoxel;
+};
+
+#endif
@@ -36,7 +36,6 @@
 #define WLSRunAction_h 1
 
 #include "globals.hh"
-#include "g4root.hh"
 
 #include "G4String.hh"
 #include "G4UserRunAction.hh"
@@ -44,6 +43,7 @@
 class G4Run;
 
 class WLSRunActionMessenger;
+class WLSOutputWriter;
 
 class WLSRunAction : public G4UserRunAction
 {
@@ -62,14 +62,64 @@ class WLSRunAction : public G4UserRunAction
 
     inline void SetAutoSeed (const G4bool val) { fAutoSeed = val; }
 
+    // Per-event seeds (/rndm/perEvent): every event starts from seeds
+    // made of the run seed and its event number, so two runs started from
+    // the same seed give event n the same random numbers whatever the
+    // geometry, the thread or what earlier events consumed.  Called by
+    // WLSPrimaryGeneratorAction before it draws anything.
+    static void SetEventSeeds(G4bool on) { fEventSeeds = on; }
+    static void SeedEvent(G4int eventID);
+
+    // Output file name (without extension), used from the next run on
+    inline void SetFileName(const G4String& name) { fName = name; }
+
+    // Shared-memory event stream (see WLSSharedMemorySink)
+    void SetStreamName(const G4String&);
+    void SetStreamCapacity(G4int);
+
+    // Response cache (see WLSResponseCache): directory or "none", voxel
+    // edge of new cache files, largest relative error of a usable voxel
+    void SetResponseCache(const G4String&);
+    void SetResponseVoxel(G4double);
+    void SetResponseMaxError(G4double);
+
+    // Output backend: root (default), csv or bin, see WLSOutputWriter
+    void SetOutputFormat(const G4String&);
+    WLSOutputWriter* GetWriter() { return fWriter; }
+
+    // "photons" ntuple with the path of every detected photon (see
+    // WLSPhotonHistory); fixed at the first run like the format
+    void SetPhotonHistory(G4bool);
+    G4bool GetPhotonHistory() const { return fPhotonHistory; }
+
+    // Ids of the optional ntuples, -1 if not booked: "photons" with the
+    // photon history, "pde" and "arrivals" if the photon detectors were
+    // deferred (WLSDetectorConstruction::SetPhotonDetDeferred) at the
+    // first run
+    G4int GetPhotonsNtuple() const { return fPhotonsNtuple; }
+    G4int GetPDENtuple() const { return fPDENtuple; }
+    G4int GetArrivalsNtuple() const { return fArrivalsNtuple; }
+
   private:
+
+    void Book();
  
     WLSRunActionMessenger* fRunMessenger;
+    WLSOutputWriter*       fWriter;
+    G4String               fOutputFormat;
+    G4bool                 fPhotonHistory;
+    G4int                  fPhotonsNtuple;
+    G4int                  fPDENtuple;
+    G4int                  fArrivalsNtuple;
 
     G4int fSaveRndm;
     G4bool fAutoSeed;
     G4String fName;
 
+    // Set by the master at the start of every run, read by the workers
+    static G4bool fEventSeeds;
+    static G4long fEventSeedBase;
+
 };
 
 #endif
@@ -65,6 +65,17 @@ class WLSRunActionMessenger : public G4UImessenger
     G4UIcmdWithAnInteger*      fRndmSaveCmd;
     G4UIcmdWithAString*        fRndmReadCmd;
     G4UIcmdWithABool*          fSetAutoSeedCmd;
+    G4UIcmdWithABool*          fPerEventSeedCmd;
+
+    G4UIdirectory*             fOutputDir;
+    G4UIcmdWithAString*        fShmNameCmd;
+    G4UIcmdWithAnInteger*      fShmSlotsCmd;
+    G4UIcmdWithAString*        fFormatCmd;
+    G4UIcmdWithAString*        fFileNameCmd;
+    G4UIcmdWithABool*          fPhotonHistoryCmd;
+    G4UIcmdWithAString*        fResponseCacheCmd;
+    G4UIcmdWithADoubleAndUnit* fResponseVoxelCmd;
+    G4UIcmdWithADouble*        fResponseMaxErrorCmd;
 
 };
 
@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/include/WLSSharedMemorySink.hh
+/// \brief Definition of the WLSSharedMemorySink class
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSSharedMemorySink_h
+#define WLSSharedMemorySink_h 1
+
+#include "globals.hh"
+
+#include "WLSEventRecord.hh"
+
+// Publishes one WLSEventRecord per event into a POSIX shared-memory ring
+// buffer (see WLSEventRecord.hh for the layout).  There is one sink per
+// process; worker threads publish concurrently without locking.
+
+class WLSSharedMemorySink
+{
+  public:
+
+    virtual ~WLSSharedMemorySink();
+
+    static WLSSharedMemorySink* GetInstance();
+
+    // An empty name (or "none") disables the sink
+    void SetName(const G4String&);
+    void SetCapacity(G4int);
+
+    G4bool IsEnabled() const { return fName != ""; }
+    G4bool IsOpen() const { return fHeader != 0; }
+
+    // Create and map the segment; does nothing if it is already open
+    void Open();
+    void Close();
+
+    void Publish(const WLSEventRecord&);
+
+  private:
+
+    WLSSharedMemorySink();
+
+    static WLSSharedMemorySink* fInstance;
+
+    G4String fName;
+    G4int    fCapacity;
+
+    WLSShmHeader* fHeader;
+    WLSShmSlot*   fSlots;
+    size_t        fSize;
+};
+
+#endif
@@ -38,6 +38,12 @@
 #include "globals.hh"
 #include "G4UserStackingAction.hh"
 
+#include <map>
+#include <utility>
+
+class G4Region;
+class G4VProcess;
+
 class WLSStackingAction : public G4UserStackingAction
 {
   public:
@@ -53,9 +59,27 @@ class WLSStackingAction : public G4UserStackingAction
     virtual void PrepareNewEvent();
     virtual int GetOpticalNPhotons();
 
+    // Optical photons created in the current run, by creator process
+    // (Scintillation, Cerenkov, OpWLS) and region, summed over threads;
+    // the master run action resets and prints them
+    static void ResetPhotonSources();
+    static void PrintPhotonSources();
+
   private:
 
+    // (region, process) -> photons
+    typedef std::map<std::pair<G4String, G4String>, G4long> SourceMap;
+
+    void FlushPhotonSources();
+
     G4int fPhotonCounter;
+
+    SourceMap fSources;
+    const G4VProcess* fLastCreator;
+    const G4Region* fLastRegion;
+    G4long* fLastCount;
+
+    static SourceMap fTotalSources;
 };
 
 #endif
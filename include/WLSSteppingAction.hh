@@ -41,11 +41,13 @@
 
 class WLSDetectorConstruction;
 class WLSSteppingActionMessenger;
+class WLSResponseCache;
 
 class G4Track;
 class G4StepPoint;
 
 class G4OpBoundaryProcess;
+class G4Material;
 
 class WLSSteppingAction : public G4UserSteppingAction
 {
@@ -91,6 +93,14 @@ class WLSSteppingAction : public G4UserSteppingAction
 
     G4OpBoundaryProcess* fOpProcess;
 
+    // Materials whose path lengths go into WLSPhotonHistory, looked up at
+    // the first step
+    const G4Material* fScintillatorMaterial;
+    const G4Material* fCoreMaterial;
+
+    // Where scintillation photons start and which fibers see them
+    WLSResponseCache* fResponseCache;
+
     // maximum number of save states
     static G4int fMaxRndmSave;
 
@@ -47,6 +47,11 @@ class WLSTrackingAction : public G4UserTrackingAction {
     virtual void PreUserTrackingAction(const G4Track*);
     virtual void PostUserTrackingAction(const G4Track*);
 
+  private:
+
+    // Give the photons re-emitted by OpWLS the history of the absorbed one
+    void PassHistory(const G4Track*);
+
 };
 
 #endif
@@ -59,6 +59,27 @@ enum TrackStatus { undefined=0,
   OutsideOfFiber          Flag is on if the photon is outside of fiber
 */
 
+// Optical path of a photon and of the photons it was re-emitted from,
+// kept for offline reweighting (/WLS/output/photonHistory).  Each factor
+// a reflectivity or attenuation length enters with is recorded:
+// reflections on the TiO2 coating and on the mirrors, path lengths in the
+// scintillator and in the fiber core, and the photon energy before the
+// first and after the last wavelength shift.
+struct WLSPhotonHistory
+{
+    WLSPhotonHistory()
+      : cubeReflections(0), mirrorReflections(0), shifts(0),
+        cubePathBefore(0), cubePath(0), fiberPath(0), energyBefore(0) {}
+
+    G4int    cubeReflections;
+    G4int    mirrorReflections;
+    G4int    shifts;          // OpWLS absorptions and re-emissions
+    G4double cubePathBefore;  // in polystyrene, before the first shift
+    G4double cubePath;        // in polystyrene, after the last shift
+    G4double fiberPath;       // in the fiber core, after the last shift
+    G4double energyBefore;    // energy of the photon before the first shift
+};
+
 class WLSUserTrackInformation : public G4VUserTrackInformation
 {
 
@@ -79,10 +100,23 @@ class WLSUserTrackInformation : public G4VUserTrackInformation
     G4bool isStatus(TrackStatus s)
        { return s == undefined ? !(fStatus &= defined) : fStatus & s; }
 
+    WLSPhotonHistory& GetHistory() { return fHistory; }
+    const WLSPhotonHistory& GetHistory() const { return fHistory; }
+
+    // Cube and voxel (WLSResponseCache) the scintillation photon started
+    // in, kept through wavelength shifts; -1 if not recorded
+    void SetOrigin(G4int cube, G4int voxel)
+       { fOriginCube = cube; fOriginVoxel = voxel; }
+    G4int GetOriginCube() const { return fOriginCube; }
+    G4int GetOriginVoxel() const { return fOriginVoxel; }
+
   private:
 
     G4int fStatus;
     G4ThreeVector fExitPosition;
+    WLSPhotonHistory fHistory;
+    G4int fOriginCube;
+    G4int fOriginVoxel;
 
 };
 
@@ -25,8 +25,23 @@ namespace parameter
     // 476.923  471.483     466.165     460.967  455.882     450.909     446.043  441.281     436.62      432.056
     // 427.586  423.208     418.919     414.716  410.596     406.557     402.597  398.714     394.904     391.167
     // 387.5    383.901     380.368     376.9    373.494     370.149     366.864  363.636     360.465     357.349
-
-
+    const G4double photonEnergy[NSpectrum] = {
+        2.00 * eV, 2.03 * eV, 2.06 * eV, 2.09 * eV, 2.12 * eV, 2.15 * eV, 2.18 * eV, 2.21 * eV, 2.24 * eV, 2.27 * eV,
+        2.30 * eV, 2.33 * eV, 2.36 * eV, 2.39 * eV, 2.42 * eV, 2.45 * eV, 2.48 * eV, 2.51 * eV, 2.54 * eV, 2.57 * eV,
+        2.60 * eV, 2.63 * eV, 2.66 * eV, 2.69 * eV, 2.72 * eV, 2.75 * eV, 2.78 * eV, 2.81 * eV, 2.84 * eV, 2.87 * eV,
+        2.90 * eV, 2.93 * eV, 2.96 * eV, 2.99 * eV, 3.02 * eV, 3.05 * eV, 3.08 * eV, 3.11 * eV, 3.14 * eV, 3.17 * eV,
+        3.20 * eV, 3.23 * eV, 3.26 * eV, 3.29 * eV, 3.32 * eV, 3.35 * eV, 3.38 * eV, 3.41 * eV, 3.44 * eV, 3.47 * eV };
+
+    // These are the defaults of WLSOpticalTables; /WLS/setOpticalTables
+    // replaces them from a file without recompiling
+
+    // refractive index of sci-cube
+    const G4double refractiveIndexPS[NSpectrum] = {
+        1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
+        1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
+        1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
+        1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
+        1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50 };
 
     // att. length of sci-cube
     // http://lss.fnal.gov/archive/2005/pub/fermilab-pub-05-344.pdf
@@ -73,7 +73,7 @@ void WLSActionInitialization::Build() const
 
 	WLSStackingAction* stacking = new WLSStackingAction();
   	//WLSEventAction* eventAction = new WLSEventAction(runAction); // original
-  	WLSEventAction* eventAction = new WLSEventAction(runAction,primaryGenarator,stacking);
+  	WLSEventAction* eventAction = new WLSEventAction(runAction,primaryGenarator,stacking,fDetector);
 
   	SetUserAction(runAction);
   	SetUserAction(eventAction);
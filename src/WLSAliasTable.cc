@@ -0,0 +1,107 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSAliasTable.cc
+/// \brief Implementation of the WLSAliasTable class
+//
+//
+#include "WLSAliasTable.hh"
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSAliasTable::WLSAliasTable(const std::vector<G4double>& x, const std::vector<G4double>& y)
+{
+    Build(x, y);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSAliasTable::Build(const std::vector<G4double>& x, const std::vector<G4double>& y)
+{
+    fProbability.clear();
+    fAlias.clear();
+    fLow.clear();
+    fWidth.clear();
+
+    const size_t nodes = std::min(x.size(), y.size());
+    if (nodes < 2)
+        return;
+
+    std::vector<G4double> weight;
+    G4double total = 0;
+    for (size_t i = 1; i < nodes; i++)
+    {
+        G4double w = 0.5 * (y[i - 1] + y[i]) * (x[i] - x[i - 1]);
+        weight.push_back(w > 0 ? w : 0);
+        total += weight.back();
+        fLow.push_back(x[i - 1]);
+        fWidth.push_back(x[i] - x[i - 1]);
+    }
+    if (total <= 0)
+    {
+        fLow.clear();
+        fWidth.clear();
+        return;
+    }
+
+    // Vose's construction: bins below the mean are topped up by one bin
+    // above it, which becomes their alias
+    const G4int n = weight.size();
+    fProbability.resize(n);
+    fAlias.resize(n);
+    std::vector<G4int> small, large;
+    for (G4int i = 0; i < n; i++)
+    {
+        fProbability[i] = weight[i] * n / total;
+        fAlias[i] = i;
+        (fProbability[i] < 1 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        G4int s = small.back();
+        G4int l = large.back();
+        small.pop_back();
+        fAlias[s] = l;
+        fProbability[l] -= 1 - fProbability[s];
+        if (fProbability[l] < 1)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // what is left is 1 up to rounding
+    for (size_t i = 0; i < small.size(); i++)
+        fProbability[small[i]] = 1;
+    for (size_t i = 0; i < large.size(); i++)
+        fProbability[large[i]] = 1;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSAliasTable::Sample(G4int n, const G4double* u, const G4double* v, G4double* out) const
+{
+    for (G4int k = 0; k < n; k++)
+        out[k] = Sample(u[k], v[k]);
+}
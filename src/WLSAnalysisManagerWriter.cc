@@ -0,0 +1,108 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSAnalysisManagerWriter.cc
+/// \brief Implementation of the WLSAnalysisManagerWriter class
+//
+//
+#include "WLSAnalysisManagerWriter.hh"
+
+#include "G4VAnalysisManager.hh"
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSAnalysisManagerWriter::WLSAnalysisManagerWriter(G4VAnalysisManager* manager)
+    : fManager(manager)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSAnalysisManagerWriter::~WLSAnalysisManagerWriter()
+{
+    // the analysis managers are Geant4 singletons, not owned here
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String WLSAnalysisManagerWriter::GetType() const
+{
+    return fManager->GetType();
+}
+
+G4bool WLSAnalysisManagerWriter::OpenFile(const G4String& fileName)
+{
+    return fManager->OpenFile(fileName);
+}
+
+G4bool WLSAnalysisManagerWriter::Write()
+{
+    return fManager->Write();
+}
+
+G4bool WLSAnalysisManagerWriter::CloseFile()
+{
+    return fManager->CloseFile();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSAnalysisManagerWriter::CreateNtuple(const G4String& name, const G4String& title)
+{
+    return fManager->CreateNtuple(name, title);
+}
+
+G4int WLSAnalysisManagerWriter::CreateNtupleDColumn(G4int ntupleId, const G4String& name)
+{
+    return fManager->CreateNtupleDColumn(ntupleId, name);
+}
+
+void WLSAnalysisManagerWriter::FinishNtuple(G4int ntupleId)
+{
+    fManager->FinishNtuple(ntupleId);
+}
+
+void WLSAnalysisManagerWriter::FillNtupleDColumn(G4int ntupleId, G4int columnId, G4double value)
+{
+    fManager->FillNtupleDColumn(ntupleId, columnId, value);
+}
+
+void WLSAnalysisManagerWriter::AddNtupleRow(G4int ntupleId)
+{
+    fManager->AddNtupleRow(ntupleId);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSAnalysisManagerWriter::CreateH1(const G4String& name, const G4String& title,
+                                         G4int nbins, G4double xmin, G4double xmax)
+{
+    return fManager->CreateH1(name, title, nbins, xmin, xmax);
+}
+
+void WLSAnalysisManagerWriter::FillH1(G4int id, G4double value, G4double weight)
+{
+    fManager->FillH1(id, value, weight);
+}
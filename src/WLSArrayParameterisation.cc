@@ -0,0 +1,59 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSArrayParameterisation.cc
+/// \brief Implementation of the WLSArrayParameterisation class
+//
+//
+#include "WLSArrayParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSArrayParameterisation::WLSArrayParameterisation(G4int n1,
+                                                   const G4ThreeVector& step1,
+                                                   const G4ThreeVector& step2,
+                                                   const G4ThreeVector& origin,
+                                                   G4RotationMatrix* rotation)
+    : fN1(n1 > 0 ? n1 : 1), fStep1(step1), fStep2(step2), fOrigin(origin),
+    fRotation(rotation)
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSArrayParameterisation::~WLSArrayParameterisation()
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSArrayParameterisation::ComputeTransformation(const G4int copyNo,
+                                                     G4VPhysicalVolume* physVol) const
+{
+    physVol->SetTranslation(fOrigin + (copyNo % fN1) * fStep1 + (copyNo / fN1) * fStep2);
+    physVol->SetRotation(fRotation);
+}
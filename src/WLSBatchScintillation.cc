@@ -0,0 +1,270 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSBatchScintillation.cc
+/// \brief Implementation of the WLSBatchScintillation class
+//
+//
+#include "WLSBatchScintillation.hh"
+#include "WLSOpticalTables.hh"
+
+#include "G4EmSaturation.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Poisson.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Uniform numbers per photon: alias bin, energy in the bin, cos(theta),
+// phi, polarization angle, position along the step, decay time
+const G4int kDraws = 7;
+
+}
+
+// std::min takes it by reference
+const G4int WLSBatchScintillation::kBatch;
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSBatchScintillation::WLSBatchScintillation(const G4String& processName, G4ProcessType type)
+    : G4Scintillation(processName, type)
+{
+    fRandom.resize(kDraws * kBatch);
+    fEnergy.resize(kBatch);
+    fDirX.resize(kBatch);
+    fDirY.resize(kBatch);
+    fDirZ.resize(kBatch);
+    fPolX.resize(kBatch);
+    fPolY.resize(kBatch);
+    fPolZ.resize(kBatch);
+    fAlong.resize(kBatch);
+    fTime.resize(kBatch);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSBatchScintillation::~WLSBatchScintillation() {}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSBatchScintillation::BuildPhysicsTable(const G4ParticleDefinition& particle)
+{
+    G4Scintillation::BuildPhysicsTable(particle);
+    // again for every particle and run: the optical tables may have been
+    // reloaded in between, and the spectra are short
+    BuildSpectra();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSBatchScintillation::BuildSpectra()
+{
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    fSpectra.assign(materials->size(), 0);
+    fOwnSpectra.clear();
+    fTimeConstant.assign(materials->size(), 0.);
+    if (GetFiniteRiseTime() || GetScintillationByParticleType())
+        return;
+
+    const WLSOpticalTables* tables = WLSOpticalTables::GetInstance();
+    const WLSOpticalTables::Table& scintilFast = tables->GetTable("scintilFast");
+    for (size_t m = 0; m < materials->size(); m++)
+    {
+        G4MaterialPropertiesTable* mpt = (*materials)[m]->GetMaterialPropertiesTable();
+        if (!mpt || mpt->GetProperty("SLOWCOMPONENT") ||
+            !mpt->ConstPropertyExists("FASTTIMECONSTANT"))
+            continue;
+        G4MaterialPropertyVector* fast = mpt->GetProperty("FASTCOMPONENT");
+        if (!fast)
+            continue;
+        std::vector<G4double> energy, value;
+        for (size_t i = 0; i < fast->GetVectorLength(); i++)
+        {
+            energy.push_back(fast->Energy(i));
+            value.push_back((*fast)[i]);
+        }
+        if (energy == scintilFast.energy && value == scintilFast.value)
+            fSpectra[m] = &tables->GetSampler("scintilFast");
+        else
+        {
+            fOwnSpectra.push_back(WLSAliasTable(energy, value));
+            if (!fOwnSpectra.back().IsEmpty())
+                fSpectra[m] = &fOwnSpectra.back();
+        }
+        fTimeConstant[m] = mpt->GetConstProperty("FASTTIMECONSTANT");
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* WLSBatchScintillation::AtRestDoIt(const G4Track& aTrack, const G4Step& aStep)
+{
+    // G4Scintillation::AtRestDoIt calls its own PostStepDoIt
+    return PostStepDoIt(aTrack, aStep);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* WLSBatchScintillation::PostStepDoIt(const G4Track& aTrack, const G4Step& aStep)
+{
+    const G4Material* material = aTrack.GetMaterial();
+    const size_t index = material->GetIndex();
+    if (index >= fSpectra.size() || !fSpectra[index])
+        return G4Scintillation::PostStepDoIt(aTrack, aStep);
+
+    aParticleChange.Initialize(aTrack);
+
+    // the photon number exactly as G4Scintillation
+    G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+    G4double yield = mpt->GetConstProperty("SCINTILLATIONYIELD") * GetScintillationYieldFactor();
+    G4double resolution = mpt->GetConstProperty("RESOLUTIONSCALE");
+    G4EmSaturation* saturation = GetSaturation();
+    G4double mean = yield * (saturation ? saturation->VisibleEnergyDepositionAtAStep(&aStep)
+                                        : aStep.GetTotalEnergyDeposit());
+    G4int photons;
+    if (mean > 10.)
+    {
+        G4double sigma = resolution * std::sqrt(mean);
+        photons = G4int(G4RandGauss::shoot(mean, sigma) + 0.5);
+    }
+    else
+        photons = G4int(G4Poisson(mean));
+
+    if (photons <= 0 || !GetStackPhotons())
+    {
+        aParticleChange.SetNumberOfSecondaries(0);
+        return G4VRestDiscreteProcess::PostStepDoIt(aTrack, aStep);
+    }
+
+    aParticleChange.SetNumberOfSecondaries(photons);
+    if (GetTrackSecondariesFirst() && aTrack.GetTrackStatus() == fAlive)
+        aParticleChange.ProposeTrackStatus(fSuspend);
+
+    const G4StepPoint* pre = aStep.GetPreStepPoint();
+    const G4ThreeVector x0 = pre->GetPosition();
+    const G4ThreeVector delta = aStep.GetDeltaPosition();
+    const G4TouchableHandle& touchable = pre->GetTouchableHandle();
+    const G4int parent = aTrack.GetTrackID();
+
+    for (G4int done = 0; done < photons; done += kBatch)
+    {
+        G4int n = std::min(kBatch, photons - done);
+        MakeBatch(n, aStep, fTimeConstant[index], *fSpectra[index]);
+        for (G4int k = 0; k < n; k++)
+        {
+            // G4Track and G4DynamicParticle come from their G4Allocator pools
+            G4DynamicParticle* photon = new G4DynamicParticle(
+                G4OpticalPhoton::OpticalPhoton(), G4ThreeVector(fDirX[k], fDirY[k], fDirZ[k]),
+                fEnergy[k]);
+            photon->SetPolarization(fPolX[k], fPolY[k], fPolZ[k]);
+            G4Track* track = new G4Track(photon, fTime[k], x0 + fAlong[k] * delta);
+            track->SetTouchableHandle(touchable);
+            track->SetParentID(parent);
+            aParticleChange.AddSecondary(track);
+        }
+    }
+
+    if (verboseLevel > 0)
+        G4cout << "\n Exiting from WLSBatchScintillation::DoIt -- NumberOfSecondaries = "
+               << aParticleChange.GetNumberOfSecondaries() << G4endl;
+
+    return G4VRestDiscreteProcess::PostStepDoIt(aTrack, aStep);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSBatchScintillation::MakeBatch(G4int n, const G4Step& aStep, G4double timeConstant,
+                                      const WLSAliasTable& spectrum)
+{
+    G4Random::getTheEngine()->flatArray(kDraws * n, &fRandom[0]);
+    const G4double* bin = &fRandom[0];
+    const G4double* inBin = bin + n;
+    const G4double* cosTheta = inBin + n;
+    const G4double* phi = cosTheta + n;
+    const G4double* polAngle = phi + n;
+    const G4double* along = polAngle + n;
+    const G4double* decay = along + n;
+
+    spectrum.Sample(n, bin, inBin, &fEnergy[0]);
+
+    // Isotropic direction, and a polarization perpendicular to it: the
+    // unit vector along -theta turned by a random angle about the direction
+    G4double* dx = &fDirX[0];
+    G4double* dy = &fDirY[0];
+    G4double* dz = &fDirZ[0];
+    G4double* sx = &fPolX[0];
+    G4double* sy = &fPolY[0];
+    G4double* sz = &fPolZ[0];
+    for (G4int k = 0; k < n; k++)
+    {
+        G4double cost = 1. - 2. * cosTheta[k];
+        G4double sint = std::sqrt((1. - cost) * (1. + cost));
+        G4double cosp = std::cos(twopi * phi[k]);
+        G4double sinp = std::sin(twopi * phi[k]);
+        dx[k] = sint * cosp;
+        dy[k] = sint * sinp;
+        dz[k] = cost;
+        sx[k] = cost * cosp;
+        sy[k] = cost * sinp;
+        sz[k] = -sint;
+    }
+    for (G4int k = 0; k < n; k++)
+    {
+        G4double cosa = std::cos(twopi * polAngle[k]);
+        G4double sina = std::sin(twopi * polAngle[k]);
+        // direction x theta-vector, a unit vector along +phi
+        G4double px = dy[k] * sz[k] - dz[k] * sy[k];
+        G4double py = dz[k] * sx[k] - dx[k] * sz[k];
+        G4double pz = dx[k] * sy[k] - dy[k] * sx[k];
+        sx[k] = cosa * sx[k] + sina * px;
+        sy[k] = cosa * sy[k] + sina * py;
+        sz[k] = cosa * sz[k] + sina * pz;
+    }
+
+    // Uniform along the step (at its end for a neutral particle), plus the
+    // exponential decay
+    const G4StepPoint* pre = aStep.GetPreStepPoint();
+    const G4StepPoint* post = aStep.GetPostStepPoint();
+    const G4double t0 = pre->GetGlobalTime();
+    const G4double velocity = 0.5 * (pre->GetVelocity() + post->GetVelocity());
+    const G4double flight = velocity > 0 ? aStep.GetStepLength() / velocity : 0.;
+    const G4bool charged = aStep.GetTrack()->GetDefinition()->GetPDGCharge() != 0;
+    G4double* a = &fAlong[0];
+    G4double* t = &fTime[0];
+    for (G4int k = 0; k < n; k++)
+    {
+        a[k] = charged ? along[k] : 1.;
+        t[k] = t0 + a[k] * flight - timeConstant * std::log(decay[k]);
+    }
+}
@@ -0,0 +1,903 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSCellTracer.cc
+/// \brief Implementation of the WLSCellTracer class
+//
+//
+#include "WLSCellTracer.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4RandomDirection.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+// Fiber axis of the X, Y and Z views (y, x, z), as ConstructFiber()
+const G4int kViewAxis[3] = { 1, 0, 2 };
+
+// G4GeometryTolerance's kCarTolerance: distances below it are the surface
+// the photon stands on
+const G4double kTolerance = 1e-9 * mm;
+// Below this the direction is taken as parallel to a fiber
+const G4double kParallel = 1e-14;
+
+// Isotropic direction and a random polarization perpendicular to it, in
+// the order G4Scintillation and G4OpWLS draw them
+void RandomDirection(G4ThreeVector& dir, G4ThreeVector& pol)
+{
+    G4double cost = 1. - 2. * G4UniformRand();
+    G4double sint = std::sqrt((1. - cost) * (1. + cost));
+    G4double phi = twopi * G4UniformRand();
+    G4double sinp = std::sin(phi);
+    G4double cosp = std::cos(phi);
+    dir.set(sint * cosp, sint * sinp, cost);
+
+    pol.set(cost * cosp, cost * sinp, -sint);
+    G4ThreeVector perp = dir.cross(pol);
+    phi = twopi * G4UniformRand();
+    pol = std::cos(phi) * pol + std::sin(phi) * perp;
+    pol = pol.unit();
+}
+
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// State of one batch, one entry per lane
+struct WLSCellTracer::Lanes
+{
+    G4double p[3][kBatch];
+    G4double d[3][kBatch];
+    G4double e[3][kBatch];
+    G4double energy[kBatch];
+    G4double time[kBatch];
+    G4double index[kBatch];        // refractive index where the photon is
+    G4double absorption[kBatch];   // absorption length there, DBL_MAX if none
+    G4int region[kBatch];
+    G4int fate[kBatch];            // -1 while the photon is traced
+    G4int steps[kBatch];
+    G4int wls[kBatch];
+    size_t photon[kBatch];         // index in Photons
+
+    // Distances along the direction, from Distances()
+    G4double cylinder[3][4][kBatch];   // hole, outer and inner cladding, core of each view
+    G4double box[kBatch];              // out of the scintillator
+    G4int boxAxis[kBatch];
+    G4double coating[kBatch];          // into the coating, from the cell air
+    G4int coatingAxis[kBatch];
+    G4double cell[kBatch];             // out of the cell
+    G4double absorb[kBatch];           // to the next bulk absorption
+    G4double random[kBatch];
+    G4double far[kBatch];
+};
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSCellTracer::Cell::Cell()
+  : barBase(1. * cm), coating(0.1 * mm), pitch(1. * cm + 2 * 0.1 * mm + 0.01 * mm),
+    holeRadius(0.70 * mm), holePosition(2.1 * mm),
+    coreRadius(0.46 * mm), clad1Radius(0.48 * mm), clad2Radius(0.50 * mm),
+    reflectivity(0.97), holePolish(0.99)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Photons::Resize(size_t n)
+{
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    dx.resize(n);
+    dy.resize(n);
+    dz.resize(n);
+    px.resize(n);
+    py.resize(n);
+    pz.resize(n);
+    energy.resize(n);
+    time.resize(n);
+    fate.resize(n);
+    wls.resize(n);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSCellTracer::Tally::Tally()
+  : photons(0), wls(0)
+{
+    std::fill(fates, fates + kNFates, 0);
+    for (G4int v = 0; v < 3; v++)
+        ends[v][0] = ends[v][1] = 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Tally::Add(const Photons& photons)
+{
+    for (size_t i = 0; i < photons.Size(); i++)
+    {
+        this->photons++;
+        fates[photons.fate[i]]++;
+        wls += photons.wls[i];
+        G4int view = photons.fate[i];
+        if (view > kCapturedZ)
+            continue;
+        const G4double position[3] = { photons.x[i], photons.y[i], photons.z[i] };
+        ends[view][position[kViewAxis[view]] > 0 ? 0 : 1]++;
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSCellTracer::Tally::Efficiency(G4int view) const
+{
+    return photons ? G4double(ends[view][0] + ends[view][1]) / photons : 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSCellTracer::WLSCellTracer(const Cell& cell, const WLSOpticalTables* tables)
+  : fCell(cell)
+{
+    const G4double half = cell.barBase / 2;
+    const G4double h = std::abs(cell.holePosition);
+    G4ExceptionDescription o;
+    if (!(cell.coreRadius > 0 && cell.coreRadius < cell.clad1Radius &&
+          cell.clad1Radius < cell.clad2Radius && cell.clad2Radius < cell.holeRadius))
+        o << "The fiber layers (" << cell.coreRadius / mm << ", " << cell.clad1Radius / mm << ", "
+          << cell.clad2Radius / mm << " mm) do not nest in the hole (" << cell.holeRadius / mm << " mm)";
+    else if (h <= cell.holeRadius || h + cell.holeRadius >= half)
+        o << "Holes of " << cell.holeRadius / mm << " mm at " << h / mm
+          << " mm from the centre overlap or do not fit in a cube of " << cell.barBase / mm << " mm";
+    else if (half + cell.coating > cell.pitch / 2)
+        o << "The coated cube (" << (cell.barBase + 2 * cell.coating) / mm
+          << " mm) does not fit in the cell (" << cell.pitch / mm << " mm)";
+    if (!o.str().empty())
+        G4Exception("WLSCellTracer::WLSCellTracer()", "WLSCell01", FatalException, o);
+
+    // The holes of ConstructDetector(): X at (+h, ., +h), Y at (., +h, -h)
+    // and Z at (-h, -h, .)
+    const G4double centre[3][3] = { { cell.holePosition, 0, cell.holePosition },
+                                    { 0, cell.holePosition, -cell.holePosition },
+                                    { -cell.holePosition, -cell.holePosition, 0 } };
+    for (G4int v = 0; v < 3; v++)
+    {
+        fAxis[v] = kViewAxis[v];
+        fU[v] = (fAxis[v] + 1) % 3;
+        fW[v] = (fAxis[v] + 2) % 3;
+        fCu[v] = centre[v][fU[v]];
+        fCw[v] = centre[v][fW[v]];
+    }
+    fRadius2[0] = cell.holeRadius * cell.holeRadius;
+    fRadius2[1] = cell.clad2Radius * cell.clad2Radius;
+    fRadius2[2] = cell.clad1Radius * cell.clad1Radius;
+    fRadius2[3] = cell.coreRadius * cell.coreRadius;
+
+    // The properties WLSMaterials gives Polystyrene, FPethylene, PMMA and
+    // Pethylene; the core has no ABSLENGTH, only WLSABSLENGTH
+    const char* index[kNMaterials] = { "refractiveIndexPS", 0, "refractiveIndexClad2",
+                                       "refractiveIndexClad1", "refractiveIndexWLSfiber" };
+    const char* absorption[kNMaterials] = { "absPS", 0, "absClad", "absClad", "absWLSfiber" };
+    for (G4int m = 0; m < kNMaterials; m++)
+    {
+        if (index[m])
+            fIndex[m] = tables->GetTable(index[m]);
+        if (absorption[m])
+            fAbsorption[m] = tables->GetTable(absorption[m]);
+    }
+    const WLSOpticalTables::Table& scint = tables->GetTable("scintilFast");
+    const WLSOpticalTables::Table& wls = tables->GetTable("emissionFib");
+    fScintSpectrum.Build(scint.energy, scint.value);
+    fWLSSpectrum.Build(wls.energy, wls.value);
+    fScintTime = tables->GetConstant("scintiTime");
+    fWLSTime = tables->GetConstant("WLSTime");
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Generate(const G4ThreeVector& position, G4int n, Photons& photons) const
+{
+    photons.Resize(n);
+    for (G4int i = 0; i < n; i++)
+    {
+        G4ThreeVector dir, pol;
+        RandomDirection(dir, pol);
+        G4double u = G4UniformRand();  // the two draws in a fixed order
+        photons.energy[i] = fScintSpectrum.Sample(u, G4UniformRand());
+        photons.time[i] = -fScintTime * std::log(G4UniformRand());
+        photons.x[i] = position.x();
+        photons.y[i] = position.y();
+        photons.z[i] = position.z();
+        photons.dx[i] = dir.x();
+        photons.dy[i] = dir.y();
+        photons.dz[i] = dir.z();
+        photons.px[i] = pol.x();
+        photons.py[i] = pol.y();
+        photons.pz[i] = pol.z();
+        photons.fate[i] = -1;
+        photons.wls[i] = 0;
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Trace(Photons& photons) const
+{
+    // About 70 kB: on the heap rather than on the stack of a worker thread
+    Lanes* lanes = new Lanes;
+    const size_t total = photons.Size();
+    size_t next = 0;
+    G4int n = 0;
+    for (;;)
+    {
+        while (n < kBatch && next < total)
+        {
+            if (Load(*lanes, n, photons, next++))
+                n++;
+        }
+        if (n == 0)
+            break;
+
+        Distances(*lanes, n);
+        for (G4int k = 0; k < n; k++)
+            Step(*lanes, k);
+
+        // Finished photons leave the batch and the last lane takes the
+        // place; the free lanes are refilled on the next pass
+        for (G4int k = 0; k < n;)
+        {
+            if (lanes->fate[k] < 0)
+            {
+                k++;
+                continue;
+            }
+            Store(*lanes, k, photons);
+            if (k != --n)
+                Move(*lanes, n, k);
+        }
+    }
+    delete lanes;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSCellTracer::FiberAt(const G4ThreeVector& position) const
+{
+    const G4double p[3] = { position.x(), position.y(), position.z() };
+    const G4double r = fCell.clad2Radius + kTolerance;
+    for (G4int v = 0; v < 3; v++)
+    {
+        G4double qu = p[fU[v]] - fCu[v];
+        G4double qw = p[fW[v]] - fCw[v];
+        if (qu * qu + qw * qw < r * r)
+            return v;
+    }
+    return -1;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector WLSCellTracer::GetFiberAxis(G4int view) const
+{
+    G4ThreeVector axis;
+    axis[fAxis[view]] = 1;
+    return axis;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSCellTracer::Locate(const G4double* p) const
+{
+    const G4double half = fCell.barBase / 2;
+    const G4double coated = half + fCell.coating;
+    const G4double cell = fCell.pitch / 2;
+    for (G4int v = 0; v < 3; v++)
+    {
+        G4double s = std::abs(p[fAxis[v]]);
+        G4double qu = p[fU[v]] - fCu[v];
+        G4double qw = p[fW[v]] - fCw[v];
+        G4double q2 = qu * qu + qw * qw;
+        if (s > cell || q2 >= fRadius2[0])
+            continue;
+        for (G4int layer = 3; layer > 0; layer--)
+        {
+            if (q2 < fRadius2[layer])
+                return kHole + 3 * layer + v;
+        }
+        if (s < coated)
+            return kHole + v;
+    }
+    G4double m = std::max(std::abs(p[0]), std::max(std::abs(p[1]), std::abs(p[2])));
+    if (m < half)
+        return kScintillator;
+    if (m < coated)
+        return kCoatingBulk;
+    if (m <= cell)
+        return kAir;
+    return kOutside;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSCellTracer::Material WLSCellTracer::MaterialOf(G4int region) const
+{
+    if (region == kScintillator)
+        return kPS;
+    if (region < kClad2)
+        return kAirMaterial;
+    if (region < kClad1)
+        return kClad2Material;
+    if (region < kCore)
+        return kClad1Material;
+    return kCoreMaterial;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCellTracer::Load(Lanes& l, G4int k, Photons& photons, size_t i) const
+{
+    const G4double p[3] = { photons.x[i], photons.y[i], photons.z[i] };
+    G4int region = Locate(p);
+    if (region < 0)
+    {
+        // Nothing is traced in the bulk of the coating
+        photons.fate[i] = region == kOutside ? kEscaped : kLost;
+        photons.wls[i] = 0;
+        return false;
+    }
+    G4ThreeVector dir = G4ThreeVector(photons.dx[i], photons.dy[i], photons.dz[i]).unit();
+    G4ThreeVector pol(photons.px[i], photons.py[i], photons.pz[i]);
+    for (G4int a = 0; a < 3; a++)
+    {
+        l.p[a][k] = p[a];
+        l.d[a][k] = dir[a];
+        l.e[a][k] = pol[a];
+    }
+    l.energy[k] = photons.energy[i];
+    l.time[k] = photons.time[i];
+    l.region[k] = region;
+    l.fate[k] = -1;
+    l.steps[k] = 0;
+    l.wls[k] = 0;
+    l.photon[k] = i;
+    UpdateOptics(l, k);
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Store(const Lanes& l, G4int k, Photons& photons) const
+{
+    size_t i = l.photon[k];
+    photons.x[i] = l.p[0][k];
+    photons.y[i] = l.p[1][k];
+    photons.z[i] = l.p[2][k];
+    photons.dx[i] = l.d[0][k];
+    photons.dy[i] = l.d[1][k];
+    photons.dz[i] = l.d[2][k];
+    photons.px[i] = l.e[0][k];
+    photons.py[i] = l.e[1][k];
+    photons.pz[i] = l.e[2][k];
+    photons.energy[i] = l.energy[k];
+    photons.time[i] = l.time[k];
+    photons.fate[i] = l.fate[k];
+    photons.wls[i] = l.wls[k];
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Move(Lanes& l, G4int from, G4int to) const
+{
+    for (G4int a = 0; a < 3; a++)
+    {
+        l.p[a][to] = l.p[a][from];
+        l.d[a][to] = l.d[a][from];
+        l.e[a][to] = l.e[a][from];
+    }
+    l.energy[to] = l.energy[from];
+    l.time[to] = l.time[from];
+    l.index[to] = l.index[from];
+    l.absorption[to] = l.absorption[from];
+    l.region[to] = l.region[from];
+    l.fate[to] = l.fate[from];
+    l.steps[to] = l.steps[from];
+    l.wls[to] = l.wls[from];
+    l.photon[to] = l.photon[from];
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::UpdateOptics(Lanes& l, G4int k) const
+{
+    Material m = MaterialOf(l.region[k]);
+    l.index[k] = fIndex[m].energy.empty() ? 1. : Value(fIndex[m], l.energy[k]);
+    l.absorption[k] = fAbsorption[m].energy.empty() ? DBL_MAX : Value(fAbsorption[m], l.energy[k]);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Distances(Lanes& l, G4int n) const
+{
+    // Every distance for every lane, whatever region the lane is in: the
+    // loops have no data-dependent branches and vectorize
+    const G4double half = fCell.barBase / 2;
+    const G4double coated = half + fCell.coating;
+    const G4double cell = fCell.pitch / 2;
+
+    for (G4int v = 0; v < 3; v++)
+    {
+        const G4double* pu = l.p[fU[v]];
+        const G4double* pw = l.p[fW[v]];
+        const G4double* du = l.d[fU[v]];
+        const G4double* dw = l.d[fW[v]];
+        const G4double cu = fCu[v];
+        const G4double cw = fCw[v];
+        for (G4int r = 0; r < 4; r++)
+        {
+            G4double* t = l.cylinder[v][r];
+            const G4double r2 = fRadius2[r];
+            for (G4int k = 0; k < n; k++)
+            {
+                G4double qu = pu[k] - cu;
+                G4double qw = pw[k] - cw;
+                G4double a = du[k] * du[k] + dw[k] * dw[k];
+                G4double b = du[k] * qu + dw[k] * qw;
+                G4double disc = b * b - a * (qu * qu + qw * qw - r2);
+                G4double root = std::sqrt(std::max(disc, 0.));
+                G4double inverse = 1. / std::max(a, kParallel);
+                G4double t1 = (-b - root) * inverse;
+                G4double t2 = (-b + root) * inverse;
+                G4double tt = t1 > kTolerance ? t1 : t2;
+                // & rather than &&: no branch
+                G4bool hit = (disc > 0) & (a > kParallel) & (tt > kTolerance);
+                t[k] = hit ? tt : DBL_MAX;
+            }
+        }
+    }
+
+    for (G4int k = 0; k < n; k++)
+    {
+        l.box[k] = DBL_MAX;
+        l.boxAxis[k] = 0;
+        l.cell[k] = DBL_MAX;
+        l.coating[k] = -DBL_MAX;
+        l.coatingAxis[k] = 0;
+        l.far[k] = DBL_MAX;
+    }
+    for (G4int a = 0; a < 3; a++)
+    {
+        const G4double* p = l.p[a];
+        const G4double* d = l.d[a];
+        for (G4int k = 0; k < n; k++)
+        {
+            G4bool moving = d[k] != 0;
+            G4double inverse = 1. / (moving ? d[k] : 1.);
+            // out of the scintillator and out of the cell, from inside
+            G4double t = moving ? (std::copysign(half, d[k]) - p[k]) * inverse : DBL_MAX;
+            l.boxAxis[k] = t < l.box[k] ? a : l.boxAxis[k];
+            l.box[k] = std::min(t, l.box[k]);
+            t = moving ? (std::copysign(cell, d[k]) - p[k]) * inverse : DBL_MAX;
+            l.cell[k] = std::min(t, l.cell[k]);
+            // slabs of the coated cube, from outside
+            G4double inside = std::abs(p[k]) < coated ? -DBL_MAX : DBL_MAX;
+            G4double tNear = moving ? (-std::copysign(coated, d[k]) - p[k]) * inverse : inside;
+            G4double tFar = moving ? (std::copysign(coated, d[k]) - p[k]) * inverse : DBL_MAX;
+            l.coatingAxis[k] = tNear > l.coating[k] ? a : l.coatingAxis[k];
+            l.coating[k] = std::max(tNear, l.coating[k]);
+            l.far[k] = std::min(tFar, l.far[k]);
+        }
+    }
+    for (G4int k = 0; k < n; k++)
+    {
+        G4bool hit = (l.coating[k] > kTolerance) & (l.coating[k] <= l.far[k]);
+        l.coating[k] = hit ? l.coating[k] : DBL_MAX;
+    }
+
+    G4Random::getTheEngine()->flatArray(n, l.random);
+    for (G4int k = 0; k < n; k++)
+        l.absorb[k] = l.absorption[k] < DBL_MAX ? -std::log(l.random[k]) * l.absorption[k] : DBL_MAX;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Step(Lanes& l, G4int k) const
+{
+    enum Surface { kBulk, kBox, kCoatingFace, kCellWall, kOuter, kInner, kEnd };
+
+    const G4double half = fCell.barBase / 2;
+    const G4double coated = half + fCell.coating;
+    const G4double cell = fCell.pitch / 2;
+    const G4int region = l.region[k];
+    // view and layer (0 hole, 1 outer cladding, 2 inner cladding, 3 core)
+    G4int view = region >= kHole ? (region - kHole) % 3 : -1;
+    G4int layer = region >= kHole ? (region - kHole) / 3 : -1;
+
+    // The nearest surface of the region
+    Surface surface = kBulk;
+    G4double t = l.absorb[k];
+    if (region == kScintillator)
+    {
+        if (l.box[k] < t)
+        {
+            t = l.box[k];
+            surface = kBox;
+        }
+        for (G4int v = 0; v < 3; v++)
+        {
+            if (l.cylinder[v][0][k] < t)
+            {
+                t = l.cylinder[v][0][k];
+                surface = kInner;
+                view = v;
+            }
+        }
+    }
+    else if (region == kAir)
+    {
+        if (l.coating[k] < t)
+        {
+            t = l.coating[k];
+            surface = kCoatingFace;
+        }
+        if (l.cell[k] < t)
+        {
+            t = l.cell[k];
+            surface = kCellWall;
+        }
+        for (G4int v = 0; v < 3; v++)
+        {
+            if (l.cylinder[v][1][k] < t)
+            {
+                t = l.cylinder[v][1][k];
+                surface = kInner;
+                view = v;
+            }
+        }
+        layer = 0;
+    }
+    else
+    {
+        if (l.cylinder[view][layer][k] < t)
+        {
+            t = l.cylinder[view][layer][k];
+            surface = kOuter;
+        }
+        if (layer < 3 && l.cylinder[view][layer + 1][k] < t)
+        {
+            t = l.cylinder[view][layer + 1][k];
+            surface = kInner;
+        }
+        // the hole ends at the coating, the fiber at the cell wall
+        G4int axis = fAxis[view];
+        G4double d = l.d[axis][k];
+        G4double end = layer == 0 ? coated : cell;
+        G4double tEnd = d != 0 ? (std::copysign(end, d) - l.p[axis][k]) / d : DBL_MAX;
+        if (tEnd < t)
+        {
+            t = tEnd;
+            surface = kEnd;
+        }
+    }
+
+    if (t == DBL_MAX)
+    {
+        l.fate[k] = kLost;
+        return;
+    }
+    for (G4int a = 0; a < 3; a++)
+        l.p[a][k] += t * l.d[a][k];
+    l.time[k] += t * l.index[k] / c_light;
+
+    G4ThreeVector dir(l.d[0][k], l.d[1][k], l.d[2][k]);
+    G4ThreeVector pol(l.e[0][k], l.e[1][k], l.e[2][k]);
+    G4ThreeVector radial;
+    if (view >= 0)
+    {
+        radial[fU[view]] = l.p[fU[view]][k] - fCu[view];
+        radial[fW[view]] = l.p[fW[view]][k] - fCw[view];
+        radial = radial.unit();
+    }
+    G4int next = region;
+
+    switch (surface)
+    {
+        case kBulk:
+            if (region == kScintillator)
+                l.fate[k] = kAbsorbedScintillator;
+            else if (region < kCore)
+                l.fate[k] = kAbsorbedCladding;
+            else
+            {
+                Reemit(dir, pol, l.energy[k]);
+                l.time[k] += fWLSTime;
+                l.wls[k]++;
+                UpdateOptics(l, k);
+            }
+            break;
+
+        case kBox:
+        {
+            G4int a = l.boxAxis[k];
+            G4ThreeVector normal;
+            normal[a] = l.p[a][k] > 0 ? -1 : 1;
+            if (!Coating(dir, pol, normal))
+                l.fate[k] = kAbsorbedCoating;
+            break;
+        }
+
+        case kCoatingFace:
+        {
+            G4int a = l.coatingAxis[k];
+            // the face of each axis has the hole of one view
+            G4int v = 0;
+            while (fAxis[v] != a)
+                v++;
+            G4double qu = l.p[fU[v]][k] - fCu[v];
+            G4double qw = l.p[fW[v]][k] - fCw[v];
+            if (qu * qu + qw * qw < fRadius2[0])
+            {
+                next = kHole + v;
+                break;
+            }
+            G4ThreeVector normal;
+            normal[a] = l.p[a][k] > 0 ? 1 : -1;
+            if (!Coating(dir, pol, normal))
+                l.fate[k] = kAbsorbedCoating;
+            break;
+        }
+
+        case kCellWall:
+            l.fate[k] = kEscaped;
+            break;
+
+        case kEnd:
+            if (layer == 0)
+                next = kAir;
+            else
+                l.fate[k] = kCapturedX + view;
+            break;
+
+        case kOuter:
+        {
+            if (layer == 0)
+            {
+                // the hole wall: scintillator, or coating at both ends
+                if (std::abs(l.p[fAxis[view]][k]) < half)
+                {
+                    G4double n2 = Value(fIndex[kPS], l.energy[k]);
+                    if (Fresnel(dir, pol, -radial, 1., n2, fCell.holePolish))
+                        next = kScintillator;
+                }
+                else if (!Coating(dir, pol, -radial))
+                    l.fate[k] = kAbsorbedCoating;
+                break;
+            }
+            G4int out = layer > 1 ? region - 3 : std::abs(l.p[fAxis[view]][k]) < coated ? kHole + view : kAir;
+            Material m = MaterialOf(out);
+            G4double n2 = fIndex[m].energy.empty() ? 1. : Value(fIndex[m], l.energy[k]);
+            if (Fresnel(dir, pol, -radial, l.index[k], n2, 1.))
+                next = out;
+            break;
+        }
+
+        case kInner:
+        {
+            // from the scintillator into a hole, or one layer deeper
+            G4int in = region == kScintillator ? kHole + view : region == kAir ? kClad2 + view : region + 3;
+            Material m = MaterialOf(in);
+            G4double n2 = fIndex[m].energy.empty() ? 1. : Value(fIndex[m], l.energy[k]);
+            G4double polish = region == kScintillator ? fCell.holePolish : 1.;
+            if (Fresnel(dir, pol, radial, l.index[k], n2, polish))
+                next = in;
+            break;
+        }
+    }
+
+    for (G4int a = 0; a < 3; a++)
+    {
+        l.d[a][k] = dir[a];
+        l.e[a][k] = pol[a];
+    }
+    if (next != region)
+    {
+        l.region[k] = next;
+        UpdateOptics(l, k);
+    }
+    if (l.fate[k] < 0 && ++l.steps[k] >= kMaxSteps)
+        l.fate[k] = kLost;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCellTracer::Fresnel(G4ThreeVector& dir, G4ThreeVector& pol, const G4ThreeVector& normal,
+                              G4double n1, G4double n2, G4double polish) const
+{
+    // G4OpBoundaryProcess::DielectricDielectric() for the glisur model:
+    // when a rough facet sends the photon the wrong way it meets the
+    // surface again, from whichever side it is on
+    G4ThreeVector global = normal;
+    G4bool through = false;
+    for (G4int i = 0; i < 100; i++)
+    {
+        if (through)
+        {
+            global = -global;
+            std::swap(n1, n2);
+            through = false;
+        }
+
+        G4ThreeVector facet = global;
+        if (polish < 1.)
+        {
+            do
+            {
+                G4ThreeVector smear;
+                do
+                {
+                    smear.set(2. * G4UniformRand() - 1., 2. * G4UniformRand() - 1., 2. * G4UniformRand() - 1.);
+                } while (smear.mag() > 1.);
+                facet = global + (1. - polish) * smear;
+            } while (dir.dot(facet) >= 0.);
+            facet = facet.unit();
+        }
+
+        G4double cost1 = -dir.dot(facet);
+        G4double sint1 = 0;
+        G4double sint2 = 0;
+        if (std::abs(cost1) < 1. - kTolerance)
+        {
+            sint1 = std::sqrt(1. - cost1 * cost1);
+            sint2 = sint1 * n1 / n2;
+        }
+
+        G4bool refracted = false;
+        if (sint2 >= 1.)
+        {
+            // total internal reflection
+            dir -= 2. * dir.dot(facet) * facet;
+            pol = -pol + 2. * pol.dot(facet) * facet;
+        }
+        else
+        {
+            G4double cost2 = (cost1 > 0 ? 1 : -1) * std::sqrt(1. - sint2 * sint2);
+            G4ThreeVector trans;
+            G4double e1Perp = 0;
+            G4double e1Parl = 1;
+            if (sint1 > 0)
+            {
+                trans = dir.cross(facet).unit();
+                e1Perp = pol.dot(trans);
+                e1Parl = (pol - e1Perp * trans).mag();
+            }
+            else
+                trans = pol;
+            G4double s1 = n1 * cost1;
+            G4double e2Perp = 2. * s1 * e1Perp / (n1 * cost1 + n2 * cost2);
+            G4double e2Parl = 2. * s1 * e1Parl / (n2 * cost1 + n1 * cost2);
+            G4double e2Total = e2Perp * e2Perp + e2Parl * e2Parl;
+            G4double transmission = cost1 != 0 ? n2 * cost2 * e2Total / s1 : 0;
+
+            if (G4UniformRand() >= transmission)
+            {
+                // Fresnel reflection
+                G4ThreeVector reflected = dir - 2. * dir.dot(facet) * facet;
+                if (sint1 > 0)
+                {
+                    e2Parl = n2 * e2Parl / n1 - e1Parl;
+                    e2Perp = e2Perp - e1Perp;
+                    G4double e2Abs = std::sqrt(e2Perp * e2Perp + e2Parl * e2Parl);
+                    G4ThreeVector paral = reflected.cross(trans).unit();
+                    pol = (e2Parl / e2Abs) * paral + (e2Perp / e2Abs) * trans;
+                }
+                else if (n2 > n1)
+                    pol = -pol;
+                dir = reflected;
+            }
+            else
+            {
+                // refraction
+                refracted = true;
+                through = true;
+                if (sint1 > 0)
+                {
+                    G4double alpha = cost1 - cost2 * (n2 / n1);
+                    dir = (dir + alpha * facet).unit();
+                    G4ThreeVector paral = dir.cross(trans).unit();
+                    G4double e2Abs = std::sqrt(e2Total);
+                    pol = (e2Parl / e2Abs) * paral + (e2Perp / e2Abs) * trans;
+                }
+            }
+        }
+        dir = dir.unit();
+        pol = pol.unit();
+        if (refracted ? dir.dot(global) <= 0. : dir.dot(global) >= -kTolerance)
+            break;
+    }
+    return dir.dot(normal) < 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCellTracer::Coating(G4ThreeVector& dir, G4ThreeVector& pol, const G4ThreeVector& normal) const
+{
+    // DielectricMetal() with EFFICIENCY 0: absorbed, or a Lambertian
+    // reflection as ChooseReflection() picks without lobe constants
+    if (G4UniformRand() >= fCell.reflectivity)
+        return false;
+    G4ThreeVector facet;
+    G4double ndotv;
+    do
+    {
+        facet = G4RandomDirection();
+        ndotv = normal.dot(facet);
+        if (ndotv < 0)
+        {
+            facet = -facet;
+            ndotv = -ndotv;
+        }
+    } while (!(G4UniformRand() < ndotv));
+    dir = facet;
+    pol = (-pol + 2. * pol.dot(facet) * facet).unit();
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCellTracer::Reemit(G4ThreeVector& dir, G4ThreeVector& pol, G4double& energy) const
+{
+    // G4OpWLS draws up to 100 times for an energy below the absorbed one
+    G4double sampled = energy;
+    for (G4int j = 0; j < 100; j++)
+    {
+        G4double u = G4UniformRand();
+        sampled = fWLSSpectrum.Sample(u, G4UniformRand());
+        if (sampled <= energy)
+            break;
+    }
+    energy = sampled;
+    RandomDirection(dir, pol);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSCellTracer::Value(const WLSOpticalTables::Table& table, G4double energy)
+{
+    // Linear, and constant beyond the ends, as G4PhysicsVector::Value()
+    const std::vector<G4double>& x = table.energy;
+    const std::vector<G4double>& y = table.value;
+    if (energy <= x.front())
+        return y.front();
+    if (energy >= x.back())
+        return y.back();
+    size_t i = std::upper_bound(x.begin(), x.end(), energy) - x.begin();
+    G4double f = (energy - x[i - 1]) / (x[i] - x[i - 1]);
+    return y[i - 1] + f * (y[i] - y[i - 1]);
+}
@@ -0,0 +1,463 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSColumnarWriter.cc
+/// \brief Implementation of the WLSColumnarWriter class
+//
+//
+#include "WLSColumnarWriter.hh"
+#include "WLSColumnarFormat.hh"
+
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cfloat>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// What the workers leave to the master: the base names of their files
+// and their histograms
+G4Mutex workersMutex = G4MUTEX_INITIALIZER;
+std::vector<G4String> workerFiles;
+std::vector<std::vector<G4double> > workerContent;
+std::vector<std::vector<G4double> > workerSumw2;
+
+// Strip the extension the same way the Geant4 analysis managers do, so
+// that "/path/root_X1_Y2.root" and "cube" both work as file names
+G4String BaseName(const G4String& fileName)
+{
+    size_t slash = fileName.rfind('/');
+    size_t dot = fileName.rfind('.');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+        return fileName.substr(0, dot);
+    return fileName;
+}
+
+void CopyName(char* dest, size_t size, const G4String& name)
+{
+    std::memset(dest, 0, size);
+    std::strncpy(dest, name.c_str(), size - 1);
+}
+
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSColumnarWriter::WLSColumnarWriter(G4int blockRows)
+    : fBlockRows(blockRows > 0 ? blockRows : 4096)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSColumnarWriter::~WLSColumnarWriter()
+{
+    for (size_t i = 0; i < fNtuples.size(); i++)
+        CloseTable(fNtuples[i]);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t WLSColumnarWriter::DataOffset(const Table& t) const
+{
+    size_t schema = sizeof(WLSColumnarHeader) + t.columns.size() * sizeof(WLSColumnarColumn);
+    // page aligned, so the data can be mapped on its own
+    return (schema + 4095) / 4096 * 4096;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::OpenTable(Table& t, const G4String& path)
+{
+    t.fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (t.fd < 0)
+    {
+        G4ExceptionDescription o;
+        o << "Cannot create " << path << ": " << std::strerror(errno);
+        G4Exception("WLSColumnarWriter::OpenTable()", "WLSOutput01", JustWarning, o);
+        return false;
+    }
+    t.map = 0;
+    t.mapSize = 0;
+    t.nrows = 0;
+    if (!GrowTable(t, 0))
+        return false;
+
+    WLSColumnarHeader* h = reinterpret_cast<WLSColumnarHeader*>(t.map);
+    std::memcpy(h->magic, kWLSColumnarMagic, sizeof(kWLSColumnarMagic));
+    h->version = kWLSColumnarVersion;
+    h->ncolumns = t.columns.size();
+    h->nrows = 0;
+    h->blockRows = fBlockRows;
+    h->dataOffset = DataOffset(t);
+    CopyName(h->title, sizeof(h->title), t.title);
+
+    WLSColumnarColumn* c = reinterpret_cast<WLSColumnarColumn*>(t.map + sizeof(WLSColumnarHeader));
+    for (size_t i = 0; i < t.columns.size(); i++)
+    {
+        CopyName(c[i].name, sizeof(c[i].name), t.columns[i]);
+        c[i].type = kWLSColumnarFloat64;
+    }
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::GrowTable(Table& t, uint64_t nrows)
+{
+    const size_t blockBytes = t.columns.size() * fBlockRows * sizeof(G4double);
+    const size_t dataOffset = DataOffset(t);
+    const uint64_t haveBlocks = t.mapSize > dataOffset ? (t.mapSize - dataOffset) / blockBytes : 0;
+    const uint64_t needBlocks = (nrows + fBlockRows - 1) / fBlockRows;
+    if (t.map && needBlocks <= haveBlocks)
+        return true;
+
+    // double the file, so that the number of remaps is logarithmic
+    uint64_t blocks = haveBlocks ? 2 * haveBlocks : 1;
+    if (blocks < needBlocks)
+        blocks = needBlocks;
+    size_t size = dataOffset + blocks * blockBytes;
+
+    if (ftruncate(t.fd, size) != 0)
+    {
+        G4ExceptionDescription o;
+        o << "Cannot extend " << t.name << ": " << std::strerror(errno);
+        G4Exception("WLSColumnarWriter::GrowTable()", "WLSOutput02", JustWarning, o);
+        return false;
+    }
+    if (t.map)
+        munmap(t.map, t.mapSize);
+    void* addr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, t.fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        G4ExceptionDescription o;
+        o << "Cannot map " << t.name << ": " << std::strerror(errno);
+        G4Exception("WLSColumnarWriter::GrowTable()", "WLSOutput03", JustWarning, o);
+        t.map = 0;
+        t.mapSize = 0;
+        return false;
+    }
+    t.map = static_cast<char*>(addr);
+    t.mapSize = size;
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSColumnarWriter::SyncHeader(Table& t)
+{
+    if (!t.map)
+        return;
+    reinterpret_cast<WLSColumnarHeader*>(t.map)->nrows = t.nrows;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSColumnarWriter::CloseTable(Table& t)
+{
+    if (!t.map)
+        return;
+    SyncHeader(t);
+
+    // drop the blocks reserved ahead but never used
+    const size_t blockBytes = t.columns.size() * fBlockRows * sizeof(G4double);
+    const uint64_t blocks = (t.nrows + fBlockRows - 1) / fBlockRows;
+    munmap(t.map, t.mapSize);
+    if (ftruncate(t.fd, DataOffset(t) + blocks * blockBytes) != 0)
+        G4cerr << "WLSColumnarWriter: cannot truncate " << t.name << G4endl;
+    close(t.fd);
+    t.map = 0;
+    t.mapSize = 0;
+    t.fd = -1;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::OpenFile(const G4String& fileName)
+{
+    fFileName = BaseName(fileName);
+    if (G4Threading::IsWorkerThread())
+    {
+        std::ostringstream os;
+        os << fFileName << "_t" << G4Threading::G4GetThreadId();
+        fFileName = os.str();
+    }
+    G4bool ok = true;
+    for (size_t i = 0; i < fNtuples.size(); i++)
+    {
+        CloseTable(fNtuples[i]);
+        ok = OpenTable(fNtuples[i], fFileName + "_nt_" + fNtuples[i].name + ".wlscol") && ok;
+    }
+    return ok;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::Write()
+{
+    for (size_t i = 0; i < fNtuples.size(); i++)
+        SyncHeader(fNtuples[i]);
+
+    // the master writes the histograms of all threads
+    if (G4Threading::IsWorkerThread())
+        return true;
+    MergeWorkers();
+
+    // histograms are small: each is written as a table of its bins
+    G4bool ok = true;
+    for (size_t i = 0; i < fH1s.size(); i++)
+    {
+        const H1& h = fH1s[i];
+        Table t;
+        t.name = h.name;
+        t.title = h.title;
+        t.columns.push_back("low");
+        t.columns.push_back("high");
+        t.columns.push_back("content");
+        t.columns.push_back("sumw2");
+        if (!OpenTable(t, fFileName + "_h1_" + h.name + ".wlscol") || !GrowTable(t, h.nbins + 2))
+        {
+            ok = false;
+            continue;
+        }
+        G4double* data = reinterpret_cast<G4double*>(t.map + DataOffset(t));
+        const G4double width = (h.xmax - h.xmin) / h.nbins;
+        for (G4int bin = 0; bin < h.nbins + 2; bin++)
+        {
+            size_t block = bin / fBlockRows;
+            size_t row = bin % fBlockRows;
+            G4double* b = data + block * t.columns.size() * fBlockRows;
+            b[0 * fBlockRows + row] = bin == 0 ? -DBL_MAX : h.xmin + (bin - 1) * width;
+            b[1 * fBlockRows + row] = bin == h.nbins + 1 ? DBL_MAX : h.xmin + bin * width;
+            b[2 * fBlockRows + row] = h.content[bin];
+            b[3 * fBlockRows + row] = h.sumw2[bin];
+        }
+        t.nrows = h.nbins + 2;
+        CloseTable(t);
+    }
+    return ok;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::CloseFile()
+{
+    for (size_t i = 0; i < fNtuples.size(); i++)
+        CloseTable(fNtuples[i]);
+
+    if (G4Threading::IsWorkerThread())
+    {
+        G4AutoLock lock(&workersMutex);
+        workerFiles.push_back(fFileName);
+        workerContent.resize(fH1s.size());
+        workerSumw2.resize(fH1s.size());
+        for (size_t i = 0; i < fH1s.size(); i++)
+        {
+            workerContent[i].resize(fH1s[i].content.size(), 0.);
+            workerSumw2[i].resize(fH1s[i].sumw2.size(), 0.);
+            for (size_t b = 0; b < fH1s[i].content.size(); b++)
+            {
+                workerContent[i][b] += fH1s[i].content[b];
+                workerSumw2[i][b] += fH1s[i].sumw2[b];
+            }
+        }
+    }
+
+    // like the Geant4 managers, start every run with empty histograms
+    for (size_t i = 0; i < fH1s.size(); i++)
+    {
+        std::fill(fH1s[i].content.begin(), fH1s[i].content.end(), 0.);
+        std::fill(fH1s[i].sumw2.begin(), fH1s[i].sumw2.end(), 0.);
+    }
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSColumnarWriter::MergeWorkers()
+{
+    G4AutoLock lock(&workersMutex);
+    for (size_t i = 0; i < fH1s.size() && i < workerContent.size(); i++)
+    {
+        for (size_t b = 0; b < fH1s[i].content.size() && b < workerContent[i].size(); b++)
+        {
+            fH1s[i].content[b] += workerContent[i][b];
+            fH1s[i].sumw2[b] += workerSumw2[i][b];
+        }
+    }
+    workerContent.clear();
+    workerSumw2.clear();
+
+    for (size_t w = 0; w < workerFiles.size(); w++)
+    {
+        for (size_t i = 0; i < fNtuples.size(); i++)
+        {
+            G4String path = workerFiles[w] + "_nt_" + fNtuples[i].name + ".wlscol";
+            if (AppendTable(i, path))
+                unlink(path.c_str());
+        }
+    }
+    workerFiles.clear();
+
+    for (size_t i = 0; i < fNtuples.size(); i++)
+        SyncHeader(fNtuples[i]);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSColumnarWriter::AppendTable(G4int ntupleId, const G4String& path)
+{
+    Table& t = fNtuples[ntupleId];
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(WLSColumnarHeader))
+        addr = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    const char* map = static_cast<const char*>(addr);
+    const WLSColumnarHeader* h = reinterpret_cast<const WLSColumnarHeader*>(map);
+    const uint64_t ncol = t.columns.size();
+    G4bool valid = std::memcmp(h->magic, kWLSColumnarMagic, sizeof(kWLSColumnarMagic)) == 0 &&
+                   h->ncolumns == ncol && h->blockRows > 0 &&
+                   h->dataOffset + (h->nrows + h->blockRows - 1) / h->blockRows * h->blockRows * ncol * 8
+                       <= (uint64_t) st.st_size;
+    if (!valid)
+    {
+        G4ExceptionDescription o;
+        o << path << " is not a table of " << t.name << ", its rows are not merged";
+        G4Exception("WLSColumnarWriter::AppendTable()", "WLSOutput04", JustWarning, o);
+        munmap(addr, st.st_size);
+        return false;
+    }
+    const G4double* data = reinterpret_cast<const G4double*>(map + h->dataOffset);
+    for (uint64_t r = 0; r < h->nrows; r++)
+    {
+        const G4double* b = data + (r / h->blockRows) * ncol * h->blockRows;
+        for (uint64_t c = 0; c < ncol; c++)
+            t.row[c] = b[c * h->blockRows + r % h->blockRows];
+        AddNtupleRow(ntupleId);
+    }
+    munmap(addr, st.st_size);
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSColumnarWriter::CreateNtuple(const G4String& name, const G4String& title)
+{
+    Table t;
+    t.name = name;
+    t.title = title;
+    t.fd = -1;
+    t.map = 0;
+    t.mapSize = 0;
+    t.nrows = 0;
+    fNtuples.push_back(t);
+    return fNtuples.size() - 1;
+}
+
+G4int WLSColumnarWriter::CreateNtupleDColumn(G4int ntupleId, const G4String& name)
+{
+    Table& t = fNtuples.at(ntupleId);
+    t.columns.push_back(name);
+    t.row.push_back(0.);
+    return t.columns.size() - 1;
+}
+
+void WLSColumnarWriter::FinishNtuple(G4int)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSColumnarWriter::FillNtupleDColumn(G4int ntupleId, G4int columnId, G4double value)
+{
+    fNtuples[ntupleId].row[columnId] = value;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSColumnarWriter::AddNtupleRow(G4int ntupleId)
+{
+    Table& t = fNtuples[ntupleId];
+    if (t.map && GrowTable(t, t.nrows + 1))
+    {
+        const size_t ncol = t.columns.size();
+        const uint64_t block = t.nrows / fBlockRows;
+        const uint64_t row = t.nrows % fBlockRows;
+        G4double* b = reinterpret_cast<G4double*>(t.map + DataOffset(t)) + block * ncol * fBlockRows;
+        for (size_t c = 0; c < ncol; c++)
+            b[c * fBlockRows + row] = t.row[c];
+        t.nrows++;
+    }
+    // columns not filled for the next row read 0
+    std::fill(t.row.begin(), t.row.end(), 0.);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSColumnarWriter::CreateH1(const G4String& name, const G4String& title,
+                                  G4int nbins, G4double xmin, G4double xmax)
+{
+    H1 h;
+    h.name = name;
+    h.title = title;
+    h.nbins = nbins;
+    h.xmin = xmin;
+    h.xmax = xmax;
+    h.content.assign(nbins + 2, 0.);
+    h.sumw2.assign(nbins + 2, 0.);
+    fH1s.push_back(h);
+    return fH1s.size() - 1;
+}
+
+void WLSColumnarWriter::FillH1(G4int id, G4double value, G4double weight)
+{
+    H1& h = fH1s[id];
+    G4int bin;
+    if (value < h.xmin)
+        bin = 0;
+    else if (value >= h.xmax)
+        bin = h.nbins + 1;
+    else
+        bin = 1 + std::min(h.nbins - 1, G4int((value - h.xmin) / (h.xmax - h.xmin) * h.nbins));
+    h.content[bin] += weight;
+    h.sumw2[bin] += weight * weight;
+}
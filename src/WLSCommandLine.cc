@@ -0,0 +1,303 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSCommandLine.cc
+/// \brief Implementation of the WLSCommandLine class
+//
+//
+#include "WLSCommandLine.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSCommandLine::WLSCommandLine()
+  : fMacro(""), fName("cube"), fSeed(123), fPhysicsList("QGSP_BERT_HP")
+{
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCommandLine::PrintUsage()
+{
+    G4cerr << "usage: wls [macro] [name] [seed] [key=value ...] [-p physicsList]\n"
+           << "  keys: macro name seed fiber_length(cm) gap_length(cm)\n"
+           << "        mirror_reflectivity cube_reflectivity hole_radius(mm)\n"
+           << "        hole_position(mm) coating_thickness(mm) /any/ui/command\n"
+           << "  a value may be a list a,b,c or a range lo:hi:step; the macro\n"
+           << "  is then run for every combination of the listed values" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCommandLine::Parse(int argc, char** argv)
+{
+    const char* known[] = { "fiber_length", "gap_length", "mirror_reflectivity", "cube_reflectivity",
+                            "hole_radius", "hole_position", "coating_thickness" };
+    int npositional = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        G4String arg = argv[i];
+        if (arg == "-p")
+        {
+            if (i + 1 >= argc)
+            {
+                G4cerr << "Option -p requires an operand" << G4endl;
+                return false;
+            }
+            fPhysicsList = argv[++i];
+            continue;
+        }
+        if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return false;
+        }
+
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos || eq == 0)
+        {
+            // historical positional arguments
+            if (npositional == 0)
+                fMacro = arg;
+            else if (npositional == 1)
+                fName = arg;
+            else if (npositional == 2)
+                fSeed = std::atol(arg.c_str());
+            else
+            {
+                PrintUsage();
+                return false;
+            }
+            npositional++;
+            continue;
+        }
+
+        G4String key = arg.substr(0, eq);
+        G4String value = arg.substr(eq + 1);
+        if (key == "macro")
+            fMacro = value;
+        else if (key == "name")
+            fName = value;
+        else if (key == "seed")
+            fSeed = std::atol(value.c_str());
+        else
+        {
+            G4bool isKnown = (key[0] == '/');
+            for (size_t k = 0; k < sizeof(known) / sizeof(known[0]); k++)
+                isKnown = isKnown || key == known[k];
+            if (!isKnown)
+            {
+                G4cerr << "Unknown parameter " << key << G4endl;
+                PrintUsage();
+                return false;
+            }
+            Parameter p;
+            p.key = key;
+            if (!Expand(value, p.values))
+            {
+                G4cerr << "Bad value for " << key << ": " << value << G4endl;
+                return false;
+            }
+            // a later setting of the same key wins
+            size_t q = 0;
+            while (q < fParameters.size() && fParameters[q].key != key)
+                q++;
+            if (q < fParameters.size())
+                fParameters[q] = p;
+            else
+                fParameters.push_back(p);
+        }
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCommandLine::Expand(const G4String& text, std::vector<G4String>& values)
+{
+    values.clear();
+    if (text.find(',') != std::string::npos)
+    {
+        size_t begin = 0;
+        while (begin <= text.size())
+        {
+            size_t end = text.find(',', begin);
+            if (end == std::string::npos)
+                end = text.size();
+            if (end > begin)
+                values.push_back(text.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return !values.empty();
+    }
+
+    // lo:hi:step, but only if all three are numbers (a file name may have ':')
+    double range[3];
+    const char* p = text.c_str();
+    int n = 0;
+    for (; n < 3; n++)
+    {
+        char* end = 0;
+        range[n] = std::strtod(p, &end);
+        if (end == p || (n < 2 && *end != ':') || (n == 2 && *end != '\0'))
+            break;
+        p = end + 1;
+    }
+    if (n < 3)
+    {
+        values.push_back(text);
+        return !text.empty();
+    }
+    if (range[2] <= 0 || range[1] < range[0])
+        return false;
+    long npoints = (long) std::floor((range[1] - range[0]) / range[2] + 1e-9) + 1;
+    for (long i = 0; i < npoints; i++)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.10g", range[0] + i * range[2]);
+        values.push_back(buffer);
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSCommandLine::IsConstructorParameter(const G4String& key)
+{
+    return key == "fiber_length" || key == "gap_length" ||
+           key == "mirror_reflectivity" || key == "cube_reflectivity";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String WLSCommandLine::CommandFor(const G4String& key, const G4String& value)
+{
+    if (key[0] == '/')
+        return key + " " + value;
+    if (key == "fiber_length")
+        return "/WLS/setFiberLength " + value + " cm";
+    if (key == "gap_length")
+        return "/WLS/setGapLength " + value + " cm";
+    if (key == "mirror_reflectivity")
+        return "/WLS/setMirrorReflectivity " + value;
+    if (key == "cube_reflectivity")
+        return "/WLS/setCubeReflectivity " + value;
+    if (key == "hole_radius")
+        return "/WLS/setHoleRadius " + value + " mm";
+    if (key == "hole_position")
+        return "/WLS/setHolePosition " + value + " mm";
+    if (key == "coating_thickness")
+        return "/WLS/setCoatingThickness " + value + " mm";
+    return "";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSCommandLine::GetValue(const G4String& key, G4double def) const
+{
+    for (size_t p = 0; p < fParameters.size(); p++)
+        if (fParameters[p].key == key)
+            return std::atof(fParameters[p].values[0].c_str());
+    return def;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSCommandLine::GetNumberOfPoints() const
+{
+    G4int n = 1;
+    for (size_t p = 0; p < fParameters.size(); p++)
+        n *= fParameters[p].values.size();
+    return n;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t WLSCommandLine::Index(size_t p, G4int i) const
+{
+    // the last parameter varies fastest
+    for (size_t q = fParameters.size(); q-- > p + 1;)
+        i /= fParameters[q].values.size();
+    return i % fParameters[p].values.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4String> WLSCommandLine::GetCommands(G4int i) const
+{
+    // Single-valued constructor parameters go to the constructor; other
+    // single-valued settings stay in effect once applied
+    std::vector<G4String> commands;
+    for (size_t p = 0; p < fParameters.size(); p++)
+    {
+        const Parameter& par = fParameters[p];
+        if (par.values.size() > 1 || (i == 0 && !IsConstructorParameter(par.key)))
+            commands.push_back(CommandFor(par.key, par.values[Index(p, i)]));
+    }
+    return commands;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String WLSCommandLine::GetName(G4int i) const
+{
+    G4String name = fName;
+    for (size_t p = 0; p < fParameters.size(); p++)
+    {
+        const Parameter& par = fParameters[p];
+        if (par.values.size() < 2)
+            continue;
+        G4String label = par.key.substr(par.key.rfind('/') + 1) + par.values[Index(p, i)];
+        for (size_t c = 0; c < label.size(); c++)
+            if (label[c] == ' ' || label[c] == '/')
+                label[c] = 'x';
+        name += "_" + label;
+    }
+    return name;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSCommandLine::Print() const
+{
+    G4cout << "input macro name is " << fMacro << G4endl;
+    G4cout << "input rootfile name: " << fName << G4endl;
+    G4cout << "seed: " << fSeed << G4endl;
+    G4cout << "physics list: " << fPhysicsList << G4endl;
+    for (size_t p = 0; p < fParameters.size(); p++)
+    {
+        G4cout << fParameters[p].key << ":";
+        for (size_t v = 0; v < fParameters[p].values.size(); v++)
+            G4cout << " " << fParameters[p].values[v];
+        G4cout << G4endl;
+    }
+    if (GetNumberOfPoints() > 1)
+        G4cout << "sweep: " << GetNumberOfPoints() << " combinations" << G4endl;
+}
@@ -39,8 +39,13 @@
 
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVReplica.hh"
+#include "G4PVParameterised.hh"
+#include "G4VTouchable.hh"
 
 #include "G4OpBoundaryProcess.hh"
+#include "G4OpticalSurface.hh"
+#include "G4MaterialPropertiesTable.hh"
 #include "G4LogicalSkinSurface.hh"
 #include "G4LogicalBorderSurface.hh"
 
@@ -51,15 +56,30 @@
 #include "G4SolidStore.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
 
 #include "G4SubtractionSolid.hh"
 
+#ifdef G4LIB_USE_GDML
+#include "G4GDMLParser.hh"
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
 #include "G4RunManager.hh"
 
 #include "WLSDetectorConstruction.hh"
 #include "WLSDetectorMessenger.hh"
 #include "WLSMaterials.hh"
 #include "WLSPhotonDetSD.hh"
+#include "WLSArrayParameterisation.hh"
+#include "WLSOpticalTables.hh"
 
 #include "G4UserLimits.hh"
 #include "G4PhysicalConstants.hh"
@@ -75,10 +95,9 @@
 // cube_reflectivity: reflectivity of cube coating
 WLSDetectorConstruction::WLSDetectorConstruction(double length, double gaplength, double mirror_reflectivity, double cube_reflectivity)
 // : fMaterials(NULL), fLogiHole(NULL), fLogiWorld(NULL),
-    : fMaterials(NULL), fLogiFiberHoleX(NULL), fLogiFiberHoleY(NULL), fLogiFiberHoleZ(NULL),
-    fLogiWorld(NULL), fPhysWorld(NULL),
+    : fMaterials(NULL), fLogiWorld(NULL), fPhysWorld(NULL),
     // fPhysWorld(NULL), fPhysHole(NULL)
-    fPhysFiberHoleX(NULL), fPhysFiberHoleY(NULL), fPhysFiberHoleZ(NULL)
+    fLogiCell(NULL), fPhysCell(NULL), fPhysExtrusion(NULL)
 {
     fDetectorMessenger = new WLSDetectorMessenger(this);
 
@@ -92,6 +111,11 @@ WLSDetectorConstruction::WLSDetectorConstruction(double length, double gaplength
     // fWLSfiberRY  = 0.5*mm;
     fWLSfiberRY = 0.50 * mm - 0.04 * mm; // phi?
     fWLSfiberOrigin = 0.0;
+    // BuildFiber() always makes both claddings, round and smooth; these
+    // only feed GetWLSFiberRMax(), IsPerfectFiber() and the response key
+    fNumOfCladLayers = 2;
+    fXYRatio = 1.0;
+    fSurfaceRoughness = 1.0;
 
     // fWLSfiberl = -70 * cm;
     fWLSfiberl = (length / 2 - gaplength) * cm;
@@ -117,6 +141,28 @@ WLSDetectorConstruction::WLSDetectorConstruction(double length, double gaplength
     double penetration = 0.05 * mm; // value for the time being
     // fHoleLength  = 1*cm;//fBarLength;
     fHoleLength = fBarBase + fCoatingThickness * 2 + penetration * 2;
+    fHoleMode = "boolean";
+
+    fNX = 3;
+    fNY = 3;
+    fNZ = 1;
+    fGeometryFile = "";
+    fScintillationYield = -1;
+    fMPPCReflectivity = 0;
+    fDeferredPDE = false;
+    fTiO2Surface = NULL;
+    fMirrorSurface = NULL;
+    fPhotonDetSurface = NULL;
+    logicScintillator = NULL;
+    physScintillator = NULL;
+    for (int v = 0; v < 3; v++)
+    {
+        fPhysPhotonDet[v] = NULL;
+        fLogiFiberHole[v] = NULL;
+        fLogiCoatHole[v] = NULL;
+        fPhysFiberHole[v] = NULL;
+        fPhysCoatHole[v][0] = fPhysCoatHole[v][1] = NULL;
+    }
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -136,6 +182,7 @@ G4VPhysicalVolume*WLSDetectorConstruction::Construct()
     if (fPhysWorld)
     {
         G4GeometryManager::GetInstance()->OpenGeometry();
+        ReleaseRegions();
         G4PhysicalVolumeStore::GetInstance()->Clean();
         G4LogicalVolumeStore::GetInstance()->Clean();
         G4SolidStore::GetInstance()->Clean();
@@ -143,9 +190,203 @@ G4VPhysicalVolume*WLSDetectorConstruction::Construct()
         G4LogicalBorderSurface::CleanSurfaceTable();
     }
 
+    if (fGeometryFile != "")
+    {
+        G4VPhysicalVolume* world = ReadGeometry();
+        if (world)
+        {
+            UpdateMaterials();
+            AssignRegions();
+            return world;
+        }
+    }
+
     fMaterials = WLSMaterials::GetInstance();
+    UpdateMaterials();
+    UpdateGeometryParameters();
+    G4VPhysicalVolume* world = ConstructDetector();
+    AssignRegions();
+    return world;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::AssignRegions()
+{
+    // By logical volume name, so that a geometry read from GDML gets the
+    // same regions.  The regions outlive the geometry: cuts and limits set
+    // on them are kept when it is rebuilt.
+    G4RegionStore* regions = G4RegionStore::GetInstance();
+    G4Region* cubes = regions->GetRegion("CubeArray", false);
+    if (!cubes)
+        cubes = new G4Region("CubeArray");
+    G4Region* fibers = regions->GetRegion("Fibers", false);
+    if (!fibers)
+        fibers = new G4Region("Fibers");
+    G4Region* readout = regions->GetRegion("Readout", false);
+    if (!readout)
+        readout = new G4Region("Readout");
+
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for (size_t i = 0; i < store->size(); i++)
+    {
+        G4LogicalVolume* lv = (*store)[i];
+        const G4String& name = lv->GetName();
+        if (name == "Block")
+            cubes->AddRootLogicalVolume(lv);
+        // the fiber pieces inside the cells are roots of their own
+        else if (name.compare(0, 13, "LogiWLSCladOt") == 0)
+            fibers->AddRootLogicalVolume(lv);
+        else if (name == "Mirror" || name == "PhotonDetX_LV" || name == "PhotonDetY_LV" || name == "PhotonDetZ_LV")
+            readout->AddRootLogicalVolume(lv);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::ReleaseRegions()
+{
+    // Called while the old volumes still exist, before the stores are cleaned
+    const char* names[3] = { "CubeArray", "Fibers", "Readout" };
+    for (int r = 0; r < 3; r++)
+    {
+        G4Region* region = G4RegionStore::GetInstance()->GetRegion(names[r], false);
+        if (!region)
+            continue;
+        std::vector<G4LogicalVolume*> roots(region->GetRootLogicalVolumeIterator(),
+                                            region->GetRootLogicalVolumeIterator() + region->GetNumberOfRootVolumes());
+        for (size_t i = 0; i < roots.size(); i++)
+            region->RemoveRootLogicalVolume(roots[i], false);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::GetStoredParameters(std::vector<std::pair<G4String, G4double*> >& list)
+{
+    list.push_back(std::make_pair(G4String("WLSFiberHalfLength"), &fWLSfiberZ));
+    list.push_back(std::make_pair(G4String("WLSFiberOffset"), &fWLSfiberl));
+    list.push_back(std::make_pair(G4String("WLSBarLength"), &fBarLength));
+    list.push_back(std::make_pair(G4String("WLSBarBase"), &fBarBase));
+    list.push_back(std::make_pair(G4String("WLSHoleRadius"), &fHoleRadius));
+    list.push_back(std::make_pair(G4String("WLSHoleLength"), &fHoleLength));
+    list.push_back(std::make_pair(G4String("WLSHolePos"), &fHolePos));
+    list.push_back(std::make_pair(G4String("WLSCoatingThickness"), &fCoatingThickness));
+    list.push_back(std::make_pair(G4String("WLSCoatingRadius"), &fCoatingRadius));
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::ExportGeometry(const G4String& fileName)
+{
+    if (!fPhysWorld)
+    {
+        G4Exception("WLSDetectorConstruction::ExportGeometry()", "WLSGeom02", JustWarning,
+                    "No geometry to export yet, run /run/initialize first");
+        return;
+    }
+    if (std::ifstream(fileName.c_str()).good())
+    {
+        G4ExceptionDescription o;
+        o << fileName << " exists, not overwritten";
+        G4Exception("WLSDetectorConstruction::ExportGeometry()", "WLSGeom02", JustWarning, o);
+        return;
+    }
+#ifdef G4LIB_USE_GDML
+    std::vector<std::pair<G4String, G4double*> > parameters;
+    GetStoredParameters(parameters);
+    G4GDMLParser parser;
+    for (size_t i = 0; i < parameters.size(); i++)
+    {
+        std::ostringstream os;
+        os.precision(17);
+        os << *parameters[i].second / mm;
+        G4GDMLAuxStructType aux = { parameters[i].first, os.str(), "mm", 0 };
+        parser.AddVolumeAuxiliary(aux, fLogiWorld);
+    }
+    std::ostringstream os;
+    os << fNX << " " << fNY << " " << fNZ;
+    G4GDMLAuxStructType size = { "WLSArraySize", os.str(), "", 0 };
+    parser.AddVolumeAuxiliary(size, fLogiWorld);
+    G4GDMLAuxStructType mode = { "WLSHoleMode", fHoleMode, "", 0 };
+    parser.AddVolumeAuxiliary(mode, fLogiWorld);
+
+    // names get unique suffixes, which the reader strips again
+    parser.Write(fileName, fPhysWorld, true);
+    G4cout << "Geometry written to " << fileName << G4endl;
+#else
+    G4Exception("WLSDetectorConstruction::ExportGeometry()", "WLSGeom02", JustWarning,
+                "Geant4 was built without GDML support");
+#endif
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetGeometryFile(const G4String& fileName)
+{
+    fGeometryFile = (fileName == "none") ? G4String("") : fileName;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VPhysicalVolume* WLSDetectorConstruction::ReadGeometry()
+{
+#ifdef G4LIB_USE_GDML
+    G4GDMLParser parser;
+    parser.Read(fGeometryFile, false);
+    G4VPhysicalVolume* world = parser.GetWorldVolume();
+    if (!world)
+    {
+        G4ExceptionDescription o;
+        o << "No world volume in " << fGeometryFile;
+        G4Exception("WLSDetectorConstruction::ReadGeometry()", "WLSGeom03", FatalException, o);
+        return 0;
+    }
+    fPhysWorld = world;
+    fLogiWorld = world->GetLogicalVolume();
+
+    std::vector<std::pair<G4String, G4double*> > parameters;
+    GetStoredParameters(parameters);
+    const G4GDMLAuxListType aux = parser.GetVolumeAuxiliaryInformation(fLogiWorld);
+    for (size_t a = 0; a < aux.size(); a++)
+    {
+        for (size_t i = 0; i < parameters.size(); i++)
+        {
+            if (aux[a].type == parameters[i].first)
+                *parameters[i].second = std::atof(aux[a].value.c_str()) * mm;
+        }
+        if (aux[a].type == "WLSArraySize")
+        {
+            std::istringstream is(aux[a].value);
+            is >> fNX >> fNY >> fNZ;
+        }
+        else if (aux[a].type == "WLSHoleMode")
+            fHoleMode = aux[a].value;
+    }
     UpdateGeometryParameters();
-    return ConstructDetector();
+
+    // What GetChannel(), GetCube() and IsCubeCoating() compare against
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    const char* viewName[3] = { "X", "Y", "Z" };
+    for (int v = 0; v < 3; v++)
+        fPhysPhotonDet[v] = store->GetVolume(G4String("PhotonDet") + viewName[v], false);
+    physScintillator = store->GetVolume("SciCube", false);
+    fPhysExtrusion = store->GetVolume("Extrusion", false);
+    // What the surface-only setters change in place; the values in the file
+    // stay until one of them is called
+    fTiO2Surface = FindSkinSurface("TiO2Surface");
+    fMirrorSurface = FindSkinSurface("MirrorSurface");
+    fPhotonDetSurface = FindSkinSurface("PhotonDetSurface");
+
+    G4cout << "Geometry read from " << fGeometryFile << ": " << fNX << " x " << fNY << " x " << fNZ
+           << " cubes, " << store->size() << " physical volumes" << G4endl;
+    return world;
+#else
+    G4Exception("WLSDetectorConstruction::ReadGeometry()", "WLSGeom03", JustWarning,
+                "Geant4 was built without GDML support, building the geometry instead");
+    return 0;
+#endif
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -175,8 +416,7 @@ G4VPhysicalVolume*WLSDetectorConstruction::ConstructDetector()
     // G4cerr << "GetBarBase()=" << GetBarBase() << " GetBarLength()=" << GetBarLength() << G4endl;
     G4cerr << "\nExtrusion: thickness=" << thickness << G4endl;
     G4cerr << "\nScintillator cube=" << GetBarBase() / 2 << G4endl;
-    G4double gap = 0.01 * mm;
-    G4double sci_pitch = GetBarBase() + 2 * GetCoatingThickness() + gap;
+    G4double sci_pitch = GetCubePitch();
 
     G4VSolid* solidExtrusion(0);
     G4VSolid* solidSciCube(0);
@@ -198,29 +438,86 @@ G4VPhysicalVolume*WLSDetectorConstruction::ConstructDetector()
     G4ThreeVector ypVec(0,         +fHolePos, -fHolePos);
     G4ThreeVector zpVec(-fHolePos, -fHolePos,         0);
 
-    solidExtrusion = new G4SubtractionSolid("solSubExtrusion1", solidExtrusion, fFiberHole, rotMX, xpVec);
-    solidExtrusion = new G4SubtractionSolid("solSubExtrusion2", solidExtrusion, fFiberHole, rotMY, ypVec);
-    solidExtrusion = new G4SubtractionSolid("solSubExtrusion3", solidExtrusion, fFiberHole, 0,    zpVec);
+    // In the "daughter" mode the boxes stay plain and the holes are placed
+    // in them further down
+    G4bool daughterHoles = (fHoleMode == "daughter");
+    G4cerr << "\nHoles: " << fHoleMode << G4endl;
+    if (!daughterHoles)
+    {
+        solidExtrusion = new G4SubtractionSolid("solSubExtrusion1", solidExtrusion, fFiberHole, rotMX, xpVec);
+        solidExtrusion = new G4SubtractionSolid("solSubExtrusion2", solidExtrusion, fFiberHole, rotMY, ypVec);
+        solidExtrusion = new G4SubtractionSolid("solSubExtrusion3", solidExtrusion, fFiberHole, 0,    zpVec);
 
-    solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, rotMX, xpVec);
-    solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, rotMY, ypVec);
-    solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, 0,    zpVec);
+        solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, rotMX, xpVec);
+        solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, rotMY, ypVec);
+        solidSciCube = new G4SubtractionSolid("solSubSciCube", solidSciCube, fFiberHole, 0,    zpVec);
+    }
 
     fLogiExtrusion = new G4LogicalVolume(solidExtrusion, FindMaterial("Polystyrene"), "Extrusion");
     logicScintillator = new G4LogicalVolume(solidSciCube, FindMaterial("Polystyrene"), "SciCube");
 
-    for (int i = 0; i < 3; i++)
+    // ----- Cube array
+    // The block is sliced by replicas along x, then y, then z.  The last
+    // replica is a single cell holding one coated cube and the three fiber
+    // segments crossing it (see ConstructFiber), so memory does not grow
+    // with the number of cubes; the replica numbers are the cube indices.
+    G4ThreeVector blockHalf(fNX * sci_pitch / 2, fNY * sci_pitch / 2, fNZ * sci_pitch / 2);
+    G4cerr << "\nArray: " << fNX << " x " << fNY << " x " << fNZ << " cubes, pitch=" << sci_pitch << G4endl;
+
+    G4VSolid* solidBlock = new G4Box("Block", blockHalf.x(), blockHalf.y(), blockHalf.z());
+    G4VSolid* solidSlab = new G4Box("BlockSlab", sci_pitch / 2, blockHalf.y(), blockHalf.z());
+    G4VSolid* solidRow = new G4Box("BlockRow", sci_pitch / 2, sci_pitch / 2, blockHalf.z());
+    G4VSolid* solidCell = new G4Box("Cell", sci_pitch / 2, sci_pitch / 2, sci_pitch / 2);
+
+    G4LogicalVolume* logicBlock = new G4LogicalVolume(solidBlock, FindMaterial("G4_AIR"), "Block");
+    G4LogicalVolume* logicSlab = new G4LogicalVolume(solidSlab, FindMaterial("G4_AIR"), "BlockSlab");
+    G4LogicalVolume* logicRow = new G4LogicalVolume(solidRow, FindMaterial("G4_AIR"), "BlockRow");
+    fLogiCell = new G4LogicalVolume(solidCell, FindMaterial("G4_AIR"), "Cell");
+
+    new G4PVPlacement(0, G4ThreeVector(), logicBlock, "Block", fLogiWorld, false, 0);
+    new G4PVReplica("BlockSlab", logicSlab, logicBlock, kXAxis, fNX, sci_pitch);
+    new G4PVReplica("BlockRow", logicRow, logicSlab, kYAxis, fNY, sci_pitch);
+    fPhysCell = new G4PVReplica("Cell", fLogiCell, logicRow, kZAxis, fNZ, sci_pitch);
+
+    fPhysExtrusion = new G4PVPlacement(0, G4ThreeVector(), fLogiExtrusion, "Extrusion", fLogiCell, false, 0);
+    physScintillator = new G4PVPlacement(0, G4ThreeVector(), logicScintillator, "SciCube", fLogiExtrusion, false, 0);
+
+    if (daughterHoles)
     {
-        G4double xoffset_val = (i - 1) * sci_pitch;
-        G4ThreeVector xoffset(xoffset_val, 0, 0);
-        for (int j = 0; j < 3; j++)
+        // One air tube through the scintillator and, with a coating, one
+        // through the coating on either side of it, at the positions the
+        // boolean mode subtracts.  The fiber segments go inside (see
+        // ConstructFiber).
+        const char* viewName[3] = { "X", "Y", "Z" };
+        G4RotationMatrix* viewRot[3] = { rotMX, rotMY, 0 };
+        G4ThreeVector viewAxis[3] = { G4ThreeVector(0, 1, 0), G4ThreeVector(1, 0, 0), G4ThreeVector(0, 0, 1) };
+        G4ThreeVector viewOffset[3] = { xpVec, ypVec, zpVec };
+
+        G4VSolid* solidSciHole = new G4Tubs("fiberHoleSci", 0.0 * cm, GetHoleRadius(), GetBarBase() / 2, 0. * deg, tube_dPhi);
+        G4VSolid* solidCoatHole = 0;
+        if (GetCoatingThickness() > 0)
+            solidCoatHole = new G4Tubs("fiberHoleCoat", 0.0 * cm, GetHoleRadius(), GetCoatingThickness() / 2, 0. * deg, tube_dPhi);
+        G4double coatHolePos = GetBarBase() / 2 + GetCoatingThickness() / 2;
+
+        for (int v = 0; v < 3; v++)
         {
-            G4double yoffset_val = (j - 1) * sci_pitch;
-            G4ThreeVector yoffset(0, yoffset_val, 0);
-            fPhysExtrusion[i][j] = new G4PVPlacement(0, xoffset + yoffset, fLogiExtrusion, "Extrusion", fLogiWorld, false, 0);
+            G4String name = G4String("FiberHole") + viewName[v];
+            fLogiFiberHole[v] = new G4LogicalVolume(solidSciHole, FindMaterial("G4_AIR"), name);
+            fPhysFiberHole[v] = new G4PVPlacement(viewRot[v], viewOffset[v], fLogiFiberHole[v], name, logicScintillator, false, 0);
+            fLogiFiberHole[v]->SetVisAttributes(G4VisAttributes::Invisible);
+
+            fLogiCoatHole[v] = NULL;
+            fPhysCoatHole[v][0] = fPhysCoatHole[v][1] = NULL;
+            if (!solidCoatHole)
+                continue;
+            name = G4String("CoatHole") + viewName[v];
+            fLogiCoatHole[v] = new G4LogicalVolume(solidCoatHole, FindMaterial("G4_AIR"), name);
+            for (int s = 0; s < 2; s++)
+                fPhysCoatHole[v][s] = new G4PVPlacement(viewRot[v], viewOffset[v] + (s ? -coatHolePos : coatHolePos) * viewAxis[v],
+                                                        fLogiCoatHole[v], name, fLogiExtrusion, false, s);
+            fLogiCoatHole[v]->SetVisAttributes(G4VisAttributes::Invisible);
         }
     }
-    physScintillator = new G4PVPlacement(0, G4ThreeVector(), logicScintillator, "SciCube", fLogiExtrusion, false, 0);
 
     // ----- define surface and table of surface properties table
     /*
@@ -287,14 +584,25 @@ G4VPhysicalVolume*WLSDetectorConstruction::ConstructDetector()
     TiO2Surface->SetMaterialPropertiesTable(TiO2SurfaceProperty);
 
     new G4LogicalSkinSurface("TiO2Surface", fLogiExtrusion, TiO2Surface);
+    fTiO2Surface = TiO2Surface;
 
 
     // Boundary Surface Properties scinti-hole
     G4OpticalSurface* opSurface = new G4OpticalSurface("RoughSurface",
                                                        glisur, ground, dielectric_dielectric, 0.99); // SetModel SetFinish SetType SetPolish
     // unified,polished,dielectric_dielectric,0.99); //  SetModel SetFinish SetType SetPolish
-    new G4LogicalBorderSurface("surfaceHoleXOt", fPhysWorld, physScintillator, opSurface);
-    new G4LogicalBorderSurface("surfaceHoleXIn", physScintillator, fPhysWorld, opSurface);
+    new G4LogicalBorderSurface("surfaceHoleXOt", fPhysCell, physScintillator, opSurface);
+    new G4LogicalBorderSurface("surfaceHoleXIn", physScintillator, fPhysCell, opSurface);
+    // The same surface on the walls of the daughter holes; the coating holes
+    // see the TiO2 skin of the extrusion, as the boolean holes do
+    if (daughterHoles)
+    {
+        for (int v = 0; v < 3; v++)
+        {
+            new G4LogicalBorderSurface("surfaceHoleOt", fPhysFiberHole[v], physScintillator, opSurface);
+            new G4LogicalBorderSurface("surfaceHoleIn", physScintillator, fPhysFiberHole[v], opSurface);
+        }
+    }
 
     #if 0 // test
         G4OpticalSurface* scint_air = new G4OpticalSurface("Scint_Air");
@@ -329,6 +637,10 @@ G4VPhysicalVolume*WLSDetectorConstruction::ConstructDetector()
     // world_va->SetForceSolid(true);
     fLogiWorld->SetVisAttributes(world_va);
     // fLogiWorld->SetVisAttributes(G4VisAttributes::Invisible);
+    logicBlock->SetVisAttributes(G4VisAttributes::Invisible);
+    logicSlab->SetVisAttributes(G4VisAttributes::Invisible);
+    logicRow->SetVisAttributes(G4VisAttributes::Invisible);
+    fLogiCell->SetVisAttributes(G4VisAttributes::Invisible);
 
     G4VisAttributes* coating_va = new G4VisAttributes(G4Colour(0.2, 0.2, 0.2)); // RGB
     // coating_va->SetForceSolid(true);
@@ -347,10 +659,6 @@ G4VPhysicalVolume*WLSDetectorConstruction::ConstructDetector()
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-#define XFIBER
-#define YFIBER
-#define ZFIBER
-
 void WLSDetectorConstruction::ConstructFiber()
 {
     // Boundary Surface Properties
@@ -370,182 +678,122 @@ void WLSDetectorConstruction::ConstructFiber()
                                                                dielectric_dielectric, // SetType
                                                                0.95); // SetPolish
 
-    // ----- Determine the number of cladding layers to be built
-    // G4double tube_dPhi = 2.* M_PI * rad;
+    // ----- Fiber views
+    // X view fibers run along y, one per (ix, iz); Y view fibers run along
+    // x, one per (iy, iz); Z view fibers run along z, one per (ix, iy).
+    // Inside the block a fiber is the chain of its segments in consecutive
+    // cells, all made of the same materials, so photons cross from one
+    // segment to the next unaffected.  Outside the block the leaders to the
+    // photon detectors and to the mirrors, the photon detectors and the
+    // mirrors of a view are one parameterised volume each, in an air
+    // envelope of their own; the copy number is the fiber index in the view.
     G4RotationMatrix* rotMY = new G4RotationMatrix;
     G4RotationMatrix* rotMX = new G4RotationMatrix;
     rotMY->rotateY(90. * deg);
     rotMX->rotateX(90. * deg);
 
-    // G4double fiber_pos = 2 * mm;
-    G4ThreeVector xpVec(+fHolePos,   -fWLSfiberl, +fHolePos);
-    G4ThreeVector ypVec(-fWLSfiberl, +fHolePos,   -fHolePos);
-    G4ThreeVector zpVec(-fHolePos,   -fHolePos,   -fWLSfiberl);
+    G4double sci_pitch = GetCubePitch();
+    G4ThreeVector blockHalf(fNX * sci_pitch / 2, fNY * sci_pitch / 2, fNZ * sci_pitch / 2);
+    G4ThreeVector firstCube(-(fNX - 1) * sci_pitch / 2, -(fNY - 1) * sci_pitch / 2, -(fNZ - 1) * sci_pitch / 2);
+
+    // Both ends of every fiber, along its own axis
+    G4double readEnd = fWLSfiberZ - fWLSfiberl;
+    G4double farEnd = -fWLSfiberZ - fWLSfiberl;
+
     G4cout << "#### Places of the fibers in this simulation ####" << G4endl;
     G4cout << "hHolePos: center position of the fiber << " << fHolePos << " : " << fWLSfiberl << G4endl;
 
-    double fWLSfiberRClad2X = fWLSfiberRX + 0.02 * mm + 0.02 * mm;
-    G4VSolid* solWLSfiberClad2 = new G4Tubs("fWLSFiberClad2X", 0, fWLSfiberRClad2X, fWLSfiberZ, 0.0 * rad, twopi * rad);
-    G4LogicalVolume* fLogiWLSCladOtX = new G4LogicalVolume(solWLSfiberClad2, FindMaterial("FPethylene"), "LogiWLSCladOtX");
-    G4LogicalVolume* fLogiWLSCladOtY = new G4LogicalVolume(solWLSfiberClad2, FindMaterial("FPethylene"), "LogiWLSCladOtY");
-    G4LogicalVolume* fLogiWLSCladOtZ = new G4LogicalVolume(solWLSfiberClad2, FindMaterial("FPethylene"), "LogiWLSCladOtZ");
+    G4double blockHalfMax = std::max(blockHalf.x(), std::max(blockHalf.y(), blockHalf.z()));
+    if (readEnd <= blockHalfMax || -farEnd <= blockHalfMax)
+    {
+        G4ExceptionDescription o;
+        o << "The fibers (" << farEnd / cm << " cm to " << readEnd / cm << " cm) do not reach out of the "
+          << fNX << " x " << fNY << " x " << fNZ << " block (half size " << blockHalfMax / cm << " cm)";
+        G4Exception("WLSDetectorConstruction::ConstructFiber()", "WLSGeom01", FatalException, o);
+    }
 
-    G4double gap = 0.01 * mm;
-    G4double sci_pitch = GetBarBase() + 2 * GetCoatingThickness() + gap;
-    #ifdef XFIBER
-        G4VPhysicalVolume* physWLSCladOtX[3];
-        for (int i = 0; i < 3; i++)
-        {
-            G4double xoffset_val = (i - 1) * sci_pitch;
-            G4ThreeVector xoffset(xoffset_val, 0, 0);
-            physWLSCladOtX[i] = new G4PVPlacement(rotMX, xpVec + xoffset, fLogiWLSCladOtX, "WLSFiberClad2X", fLogiWorld, false, 0);
-        }
-    #endif
-    #ifdef YFIBER
-        G4VPhysicalVolume* physWLSCladOtY[3];
-        for (int j = 0; j < 3; j++)
+    const char* viewName[3] = { "X", "Y", "Z" };
+    G4RotationMatrix* viewRot[3] = { rotMX, rotMY, 0 };
+    G4ThreeVector viewAxis[3] = { G4ThreeVector(0, 1, 0), G4ThreeVector(1, 0, 0), G4ThreeVector(0, 0, 1) };
+    // Fiber position relative to its cube, as the holes in ConstructDetector
+    G4ThreeVector viewOffset[3] = { G4ThreeVector(+fHolePos, 0, +fHolePos),
+                                    G4ThreeVector(0, +fHolePos, -fHolePos),
+                                    G4ThreeVector(-fHolePos, -fHolePos, 0) };
+    // Fiber k of a view is at viewOrigin + (k % viewN1) * viewStep1 + (k / viewN1) * viewStep2
+    G4int viewN1[3] = { fNX, fNY, fNY };
+    G4int viewCopies[3] = { fNX * fNZ, fNY * fNZ, fNY * fNX };
+    G4ThreeVector viewStep1[3] = { G4ThreeVector(sci_pitch, 0, 0), G4ThreeVector(0, sci_pitch, 0), G4ThreeVector(0, sci_pitch, 0) };
+    G4ThreeVector viewStep2[3] = { G4ThreeVector(0, 0, sci_pitch), G4ThreeVector(0, 0, sci_pitch), G4ThreeVector(sci_pitch, 0, 0) };
+    G4ThreeVector viewOrigin[3];
+    // Half size of the block across the fibers of a view, and where they leave it
+    G4ThreeVector viewCross[3];
+    G4double viewBlockEnd[3];
+
+    for (int v = 0; v < 3; v++)
+    {
+        G4ThreeVector axis = viewAxis[v];
+        viewOrigin[v] = firstCube + viewOffset[v];
+        viewOrigin[v] -= axis.dot(viewOrigin[v]) * axis;
+        viewBlockEnd[v] = axis.dot(blockHalf);
+        viewCross[v] = blockHalf - viewBlockEnd[v] * axis;
+
+        G4String segmentName = G4String("WLSFiberClad2") + viewName[v];
+        if (fHoleMode != "daughter")
         {
-            G4double yoffset_val = (j - 1) * sci_pitch;
-            G4ThreeVector yoffset(0, yoffset_val, 0);
-            physWLSCladOtY[j] = new G4PVPlacement(rotMY, ypVec + yoffset, fLogiWLSCladOtY, "WLSFiberClad2Y", fLogiWorld, false, 0);
+            G4LogicalVolume* logicSegment = BuildFiber(viewName[v], sci_pitch / 2, opSurfAmongWLSComps);
+            G4VPhysicalVolume* physSegment =
+                new G4PVPlacement(viewRot[v], viewOffset[v], logicSegment, segmentName, fLogiCell, false, 0);
+            AddCladdingSurfaces(physSegment, fPhysCell, opSurfWorldCladOt, opSurfAmongWLSComps);
         }
-    #endif
-    #ifdef ZFIBER
-        G4VPhysicalVolume* physWLSCladOtZ[3][3];
-        for (int i = 0; i < 3; i++)
+        else
         {
-            G4double xoffset_val = (i - 1) * sci_pitch;
-            G4ThreeVector xoffset(xoffset_val, 0, 0);
-            for (int j = 0; j < 3; j++)
+            // The segment is cut where the hole daughters are: one piece in
+            // the scintillator hole, one in each coating hole and one in
+            // the gap between the coating and the cell wall on either side
+            G4double sciHalf = GetBarBase() / 2;
+            G4double coatHalf = GetCoatingThickness() / 2;
+            G4double gapHalf = (sci_pitch / 2 - sciHalf - 2 * coatHalf) / 2;
+
+            G4LogicalVolume* logicPiece = BuildFiber(G4String(viewName[v]) + "Sci", sciHalf, opSurfAmongWLSComps);
+            G4VPhysicalVolume* physPiece =
+                new G4PVPlacement(0, G4ThreeVector(), logicPiece, segmentName, fLogiFiberHole[v], false, 0);
+            AddCladdingSurfaces(physPiece, fPhysFiberHole[v], opSurfWorldCladOt, opSurfAmongWLSComps);
+
+            if (fLogiCoatHole[v])
             {
-                G4double yoffset_val = (j - 1) * sci_pitch;
-                G4ThreeVector yoffset(0, yoffset_val, 0);
-                physWLSCladOtZ[i][j] = new G4PVPlacement(0, zpVec + xoffset + yoffset, fLogiWLSCladOtZ, "WLSFiberClad2Z", fLogiWorld, false, 0);
+                logicPiece = BuildFiber(G4String(viewName[v]) + "Coat", coatHalf, opSurfAmongWLSComps);
+                physPiece = new G4PVPlacement(0, G4ThreeVector(), logicPiece, segmentName, fLogiCoatHole[v], false, 0);
+                AddCladdingSurfaces(physPiece, fPhysCoatHole[v][0], opSurfWorldCladOt, opSurfAmongWLSComps);
+                AddCladdingSurfaces(physPiece, fPhysCoatHole[v][1], opSurfWorldCladOt, 0);
             }
-        }
-    #endif
-
-    #ifdef XFIBER
-        for (int i = 0; i < 3; i++)
-        {
-            new G4LogicalBorderSurface("surfWLSCladOtXWorldOt", physWLSCladOtX[i], fPhysWorld, opSurfWorldCladOt); // clad2 -> world
-            new G4LogicalBorderSurface("surfWLSCladOtXWorldIn", fPhysWorld, physWLSCladOtX[i], opSurfWorldCladOt); // world -> clad2
-        }
-    #endif
-    #ifdef YFIBER
-        for (int j = 0; j < 3; j++)
-        {
-            new G4LogicalBorderSurface("surfWLSCladOtYWorldOt", physWLSCladOtY[j], fPhysWorld, opSurfWorldCladOt); // clad2 -> world
-            new G4LogicalBorderSurface("surfWLSCladOtYWorldIn", fPhysWorld, physWLSCladOtY[j], opSurfWorldCladOt); // world -> clad2
-        }
-    #endif
-    #ifdef ZFIBER
-        for (int i = 0; i < 3; i++)
-        {
-            for (int j = 0; j < 3; j++)
+            if (gapHalf > 0)
             {
-                new G4LogicalBorderSurface("surfWLSCladOtZWorldOt", physWLSCladOtZ[i][j], fPhysWorld, opSurfWorldCladOt); // clad2 -> world
-                new G4LogicalBorderSurface("surfWLSCladOtZWorldIn", fPhysWorld, physWLSCladOtZ[i][j], opSurfWorldCladOt); // world -> clad2
+                logicPiece = BuildFiber(G4String(viewName[v]) + "Gap", gapHalf, opSurfAmongWLSComps);
+                for (int s = 0; s < 2; s++)
+                {
+                    G4ThreeVector pos = viewOffset[v] + (s ? gapHalf - sci_pitch / 2 : sci_pitch / 2 - gapHalf) * axis;
+                    physPiece = new G4PVPlacement(viewRot[v], pos, logicPiece, segmentName, fLogiCell, false, s);
+                    AddCladdingSurfaces(physPiece, fPhysCell, opSurfWorldCladOt, opSurfAmongWLSComps);
+                }
             }
         }
-    #endif
 
-    // -----
-    double fWLSfiberRCladX = fWLSfiberRX + 0.02 * mm;
-    G4VSolid* solWLSfiberClad = new G4Tubs("fWLSFiberCladX", 0, fWLSfiberRCladX, fWLSfiberZ, 0.0 * rad, twopi * rad);
-    G4LogicalVolume* fLogiWLSCladInX = new G4LogicalVolume(solWLSfiberClad, FindMaterial("PMMA"), "LogiWLSCladInX");
-    G4LogicalVolume* fLogiWLSCladInY = new G4LogicalVolume(solWLSfiberClad, FindMaterial("PMMA"), "LogiWLSCladInY");
-    G4LogicalVolume* fLogiWLSCladInZ = new G4LogicalVolume(solWLSfiberClad, FindMaterial("PMMA"), "LogiWLSCladInZ");
-
-    #ifdef XFIBER
-        G4VPhysicalVolume* physWLSCladInX = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCladInX, "WLSFiberCladX", fLogiWLSCladOtX, false, 0);
-    #endif
-    #ifdef YFIBER
-        G4VPhysicalVolume* physWLSCladInY = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCladInY, "WLSFiberCladY", fLogiWLSCladOtY, false, 0);
-    #endif
-    #ifdef ZFIBER
-        G4VPhysicalVolume* physWLSCladInZ = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCladInZ, "WLSFiberCladZ", fLogiWLSCladOtZ, false, 0);
-    #endif
-
-    #ifdef XFIBER
-        for (int i = 0; i < 3; i++)
+        const char* side[2] = { "Read", "Far" };
+        G4double leaderHalf[2] = { (readEnd - viewBlockEnd[v]) / 2, (-viewBlockEnd[v] - farEnd) / 2 };
+        G4double leaderCentre[2] = { (readEnd + viewBlockEnd[v]) / 2, (farEnd - viewBlockEnd[v]) / 2 };
+        for (int s = 0; s < 2; s++)
         {
-            new G4LogicalBorderSurface("surfWLSCladInXOt", physWLSCladInX, physWLSCladOtX[i], opSurfAmongWLSComps); // clad -> clad2
-            new G4LogicalBorderSurface("surfWLSCladInXIn", physWLSCladOtX[i], physWLSCladInX, opSurfAmongWLSComps); // clad2  -> clad
+            G4String name = G4String(viewName[v]) + side[s];
+            G4VPhysicalVolume* envelope =
+                PlaceEnvelope("FiberEnvelope" + name, viewCross[v] + leaderHalf[s] * axis, leaderCentre[s] * axis);
+            G4LogicalVolume* logicLeader = BuildFiber(name, leaderHalf[s], opSurfAmongWLSComps);
+            G4VPhysicalVolume* physLeader =
+                new G4PVParameterised(G4String("WLSFiberClad2") + viewName[v], logicLeader, envelope->GetLogicalVolume(),
+                                      kUndefined, viewCopies[v],
+                                      new WLSArrayParameterisation(viewN1[v], viewStep1[v], viewStep2[v], viewOrigin[v], viewRot[v]));
+            AddCladdingSurfaces(physLeader, envelope, opSurfWorldCladOt, opSurfAmongWLSComps);
         }
-    #endif
-    #ifdef YFIBER
-        for (int j = 0; j < 3; j++)
-        {
-            new G4LogicalBorderSurface("surfWLSCladInYOt", physWLSCladInY, physWLSCladOtY[j], opSurfAmongWLSComps); // clad -> clad2
-            new G4LogicalBorderSurface("surfWLSCladInYIn", physWLSCladOtY[j], physWLSCladInY, opSurfAmongWLSComps); // clad2  -> clad
-        }
-    #endif
-    #ifdef ZFIBER
-        for (int i = 0; i < 3; i++)
-        {
-            for (int j = 0; j < 3; j++)
-            {
-                new G4LogicalBorderSurface("surfWLSCladInZOt", physWLSCladInZ, physWLSCladOtZ[i][j], opSurfAmongWLSComps); // clad -> clad2
-                new G4LogicalBorderSurface("surfWLSCladInZIn", physWLSCladOtZ[i][j], physWLSCladInZ, opSurfAmongWLSComps); // clad2  -> clad
-            }
-        }
-    #endif
-
-    // -----
-    G4VSolid* solWLSfiber = new G4Tubs("fWLSFiberX", 0, fWLSfiberRX, fWLSfiberZ, 0.0 * rad, twopi * rad);
-    G4LogicalVolume* fLogiWLSCoreX = new G4LogicalVolume(solWLSfiber, FindMaterial("Pethylene"), "LogiWLSFiberX");
-    G4LogicalVolume* fLogiWLSCoreY = new G4LogicalVolume(solWLSfiber, FindMaterial("Pethylene"), "LogiWLSFiberY");
-    G4LogicalVolume* fLogiWLSCoreZ = new G4LogicalVolume(solWLSfiber, FindMaterial("Pethylene"), "LogiWLSFiberZ");
-    // fLogiWLSCoreX->SetUserLimits(new G4UserLimits(DBL_MAX,DBL_MAX,10*ms));
-    // fLogiWLSCoreY->SetUserLimits(new G4UserLimits(DBL_MAX,DBL_MAX,10*ms));
-    // fLogiWLSCoreZ->SetUserLimits(new G4UserLimits(DBL_MAX,DBL_MAX,10*ms));
-
-    #ifdef XFIBER
-        G4VPhysicalVolume* physWLSfiberX = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCoreX, "WLSFiberX", fLogiWLSCladInX, false, 0);
-    #endif
-    #ifdef YFIBER
-        G4VPhysicalVolume* physWLSfiberY = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCoreY, "WLSFiberY", fLogiWLSCladInY, false, 0);
-    #endif
-    #ifdef ZFIBER
-        G4VPhysicalVolume* physWLSfiberZ = new G4PVPlacement(0, G4ThreeVector(), fLogiWLSCoreZ, "WLSFiberZ", fLogiWLSCladInZ, false, 0);
-    #endif
-
-    #ifdef XFIBER
-        new G4LogicalBorderSurface("surfWLSCoreXOt", physWLSfiberX, physWLSCladInX, opSurfAmongWLSComps); // fiber -> clad
-        new G4LogicalBorderSurface("surfWLSCoreXIn", physWLSCladInX, physWLSfiberX, opSurfAmongWLSComps); // clad  -> fiber
-    #endif
-    #ifdef YFIBER
-        new G4LogicalBorderSurface("surfWLSCoreYOt", physWLSfiberY, physWLSCladInY, opSurfAmongWLSComps); // fiber -> clad
-        new G4LogicalBorderSurface("surfWLSCoreYIn", physWLSCladInY, physWLSfiberY, opSurfAmongWLSComps); // clad  -> fiber
-    #endif
-    #ifdef ZFIBER
-        new G4LogicalBorderSurface("surfWLSCoreZOt", physWLSfiberZ, physWLSCladInZ, opSurfAmongWLSComps); // fiber -> clad
-        new G4LogicalBorderSurface("surfWLSCoreZIn", physWLSCladInZ, physWLSfiberZ, opSurfAmongWLSComps); // clad  -> fiber
-    #endif
-
-    G4VisAttributes* vaCladOt = new G4VisAttributes(G4Colour(0.1, 0.3, 0.1)); // RGB
-    G4VisAttributes* vaCladIn = new G4VisAttributes(G4Colour(0.2, 0.5, 0.2)); // RGB
-    G4VisAttributes* vaWLSCore = new G4VisAttributes(G4Colour(0.4, 0.7, 0.4)); // RGB
-    vaCladOt->SetForceSolid(true);
-    vaCladIn->SetForceSolid(true);
-    vaWLSCore->SetForceSolid(true);
-
-    #ifdef XFIBER
-        fLogiWLSCladOtX->SetVisAttributes(vaCladOt);
-        fLogiWLSCladInX->SetVisAttributes(vaCladIn);
-        fLogiWLSCoreX->SetVisAttributes(vaWLSCore);
-    #endif
-    #ifdef YFIBER
-        fLogiWLSCladOtY->SetVisAttributes(vaCladOt);
-        fLogiWLSCladInY->SetVisAttributes(vaCladIn);
-        fLogiWLSCoreY->SetVisAttributes(vaWLSCore);
-    #endif
-    #ifdef ZFIBER
-        fLogiWLSCladOtZ->SetVisAttributes(vaCladOt);
-        fLogiWLSCladInZ->SetVisAttributes(vaCladIn);
-        fLogiWLSCoreZ->SetVisAttributes(vaWLSCore);
-    #endif
+    }
 
 
     // --------------------------------------------------
@@ -615,33 +863,18 @@ void WLSDetectorConstruction::ConstructFiber()
     G4LogicalVolume* logicPhotonDetY = new G4LogicalVolume(solidPhotonDetY, FindMaterial("G4_Al"), "PhotonDetY_LV");
     G4LogicalVolume* logicPhotonDetZ = new G4LogicalVolume(solidPhotonDetZ, FindMaterial("G4_Al"), "PhotonDetZ_LV");
 
-    // new G4PVPlacement(0, G4ThreeVector(0.0,0.0,0.0), logicPhotonDet, "PhotonDet", logicClrfiber, false, 0);
-    //	G4double fiber_pos = 2*mm;
-    char pvname[32];
-    for (int i = 0; i < 3; i++)
-    {
-        G4double xoffset_val = (i - 1) * sci_pitch;
-        sprintf(pvname, "PhotonDetX%d", i);
-        // new G4PVPlacement(rotMX, G4ThreeVector(xoffset_val + fiber_pos, fWLSfiberZ - fWLSfiberl, +fiber_pos), logicPhotonDetX, pvname, fLogiWorld, false, 0);
-        new G4PVPlacement(rotMX, G4ThreeVector(xoffset_val + fHolePos, fWLSfiberZ - fWLSfiberl, xoffset_val + fHolePos), logicPhotonDetX, pvname, fLogiWorld, false, i+1);
-    }
-    for (int j = 0; j < 3; j++)
+    // One photon detector per fiber, against the readout end; the copy
+    // number is the fiber index in the view (see GetChannel)
+    G4LogicalVolume* logicPhotonDet[3] = { logicPhotonDetX, logicPhotonDetY, logicPhotonDetZ };
+    for (int v = 0; v < 3; v++)
     {
-        G4double yoffset_val = (j - 1) * sci_pitch;
-        sprintf(pvname, "PhotonDetY%d", j);
-        // new G4PVPlacement(rotMY, G4ThreeVector(fWLSfiberZ - fWLSfiberl, yoffset_val + fiber_pos, -fiber_pos), logicPhotonDetY, pvname, fLogiWorld, false, 0);
-        new G4PVPlacement(rotMY, G4ThreeVector(fWLSfiberZ - fWLSfiberl, yoffset_val + fHolePos, -fHolePos), logicPhotonDetY, pvname, fLogiWorld, false, j+3+1);
-    }
-    for (int i = 0; i < 3; i++)
-    {
-        G4double xoffset_val = (i - 1) * sci_pitch;
-        for (int j = 0; j < 3; j++)
-        {
-            G4double yoffset_val = (j - 1) * sci_pitch;
-            sprintf(pvname, "PhotonDetZ%d%d", i, j);
-            // new G4PVPlacement(0, G4ThreeVector(xoffset_val - fiber_pos, yoffset_val - fiber_pos, fWLSfiberZ - fWLSfiberl), logicPhotonDetZ, pvname, fLogiWorld, false, 0);
-            new G4PVPlacement(0, G4ThreeVector(xoffset_val - fHolePos, yoffset_val - fHolePos, fWLSfiberZ - fWLSfiberl), logicPhotonDetZ, pvname, fLogiWorld, false, 3*i+j+6+1);
-        }
+        G4VPhysicalVolume* envelope = PlaceEnvelope(G4String("PhotonDetEnvelope") + viewName[v],
+                                                    viewCross[v] + fMPPCZ * viewAxis[v],
+                                                    (readEnd + fMPPCZ) * viewAxis[v]);
+        fPhysPhotonDet[v] =
+            new G4PVParameterised(G4String("PhotonDet") + viewName[v], logicPhotonDet[v], envelope->GetLogicalVolume(),
+                                  kUndefined, viewCopies[v],
+                                  new WLSArrayParameterisation(viewN1[v], viewStep1[v], viewStep2[v], viewOrigin[v], viewRot[v]));
     }
 
     G4cout << "length beween cube and MPPCs = " << fWLSfiberZ - fWLSfiberl << G4endl;
@@ -662,37 +895,28 @@ void WLSDetectorConstruction::ConstructFiber()
 
     G4MaterialPropertiesTable* photonDetSurfProp = new G4MaterialPropertiesTable();
 
-    G4double p_mppc[NSpectrumMPPC];
-    for (int i = 0; i < NSpectrumMPPC; i++)
-    {
-        p_mppc[i] = parameter::photonEnergy_mppc[i];
-    }
-    const G4int nbins = sizeof(p_mppc) / sizeof(G4double);
-
-    // ----- refrection parameter
-    fMPPCReflectivity = 0;
-    G4double refl_mppc[NSpectrumMPPC];
-    for (int i = 0; i < NSpectrumMPPC; i++)
-    {
-        refl_mppc[i] = fMPPCReflectivity;
-    }
-    assert(sizeof(refl_mppc) == sizeof(p_mppc));
-    // ----- efficiency parameter
+    // ----- efficiency parameter (parameter::effi_mppc unless /WLS/setOpticalTables)
     // G4double effi_mppc[] = { 1, 1 };   // original
-    G4double effi_mppc[NSpectrumMPPC];
-    for (int i = 0; i < NSpectrumMPPC; i++)
-    {
-        effi_mppc[i] = parameter::effi_mppc[i];
-    }
-    assert(sizeof(effi_mppc) == sizeof(p_mppc));
+    const WLSOpticalTables::Table& effi_mppc = WLSOpticalTables::GetInstance()->GetTable("effi_mppc");
+    std::vector<G4double> p_mppc = effi_mppc.energy;
 
-    photonDetSurfProp->AddProperty("REFLECTIVITY", p_mppc, refl_mppc, nbins);
-    photonDetSurfProp->AddProperty("EFFICIENCY",  p_mppc, effi_mppc, nbins);
+    // ----- refrection parameter (0 unless /WLS/setPhotonDetReflectivity)
+    std::vector<G4double> refl_mppc(p_mppc.size(), fMPPCReflectivity);
+
+    // ----- with /WLS/setPhotonDetDeferred every absorbed photon is detected
+    std::vector<G4double> effi_all(p_mppc.size(), 1.);
+
+    photonDetSurfProp->AddProperty("REFLECTIVITY", &p_mppc[0], &refl_mppc[0], p_mppc.size());
+    if (fDeferredPDE)
+        photonDetSurfProp->AddProperty("EFFICIENCY", &p_mppc[0], &effi_all[0], p_mppc.size());
+    else
+        WLSOpticalTables::GetInstance()->AddProperty(photonDetSurfProp, "EFFICIENCY", "effi_mppc");
     photonDetSurface->SetMaterialPropertiesTable(photonDetSurfProp);
 
     new G4LogicalSkinSurface("PhotonDetSurface", logicPhotonDetX, photonDetSurface);
     new G4LogicalSkinSurface("PhotonDetSurface", logicPhotonDetY, photonDetSurface);
     new G4LogicalSkinSurface("PhotonDetSurface", logicPhotonDetZ, photonDetSurface);
+    fPhotonDetSurface = photonDetSurface;
 
     // ----- Mirror for reflection at one of the end
     /*
@@ -703,7 +927,9 @@ void WLSDetectorConstruction::ConstructFiber()
 
     // Place the mirror only if the user wants the mirror
     // G4VSolid* solidMirror = new G4Box("Mirror", fMirrorRmax, fMirrorRmax, fMirrorZ);
-    G4VSolid* solidMirror = new G4Box("Mirror", 5 * mm, 5 * mm, fMirrorZ);
+    // 5 mm unless the cubes are too small for that
+    G4double mirrorHalf = std::min(5 * mm, sci_pitch / 2 - 0.01 * mm);
+    G4VSolid* solidMirror = new G4Box("Mirror", mirrorHalf, mirrorHalf, fMirrorZ);
     G4LogicalVolume* logicMirror = new G4LogicalVolume(solidMirror, FindMaterial("G4_Al"), "Mirror");
 
     // ----- define surface
@@ -725,9 +951,18 @@ void WLSDetectorConstruction::ConstructFiber()
     #if 1
         //   G4double fHolePos = 2*mm;
         new G4LogicalSkinSurface("MirrorSurface", logicMirror, mirrorSurface);
-        new G4PVPlacement(rotMX, G4ThreeVector(+fHolePos, -fWLSfiberZ + fWLSfiberl, +fHolePos), logicMirror, "Mirror", fLogiWorld, false, 0);
-        new G4PVPlacement(rotMY, G4ThreeVector(-fWLSfiberZ + fWLSfiberl, +fHolePos, -fHolePos), logicMirror, "Mirror", fLogiWorld, false, 0);
-        new G4PVPlacement(0,     G4ThreeVector(-fHolePos, -fHolePos, -fWLSfiberZ + fWLSfiberl), logicMirror, "Mirror", fLogiWorld, false, 0);
+        fMirrorSurface = mirrorSurface;
+        // The mirrors of the outermost fibers stick out of the block outline
+        G4double mirrorPad = std::max(0., mirrorHalf + fHolePos - sci_pitch / 2);
+        for (int v = 0; v < 3; v++)
+        {
+            G4ThreeVector across = G4ThreeVector(1, 1, 1) - viewAxis[v];
+            G4VPhysicalVolume* envelope = PlaceEnvelope(G4String("MirrorEnvelope") + viewName[v],
+                                                        viewCross[v] + mirrorPad * across + fMirrorZ * viewAxis[v],
+                                                        (farEnd - fMirrorZ) * viewAxis[v]);
+            new G4PVParameterised("Mirror", logicMirror, envelope->GetLogicalVolume(), kUndefined, viewCopies[v],
+                                  new WLSArrayParameterisation(viewN1[v], viewStep1[v], viewStep2[v], viewOrigin[v], viewRot[v]));
+        }
         G4cout << "Mirrors are implemented in this simulation " << G4endl;
         G4cout << ">> Reflectivity of this mirror = " << fMirrorReflectivity << G4endl;
         G4cout << ">> Efficiency of this mirror = " << effi_mirror[0] << G4endl;
@@ -736,6 +971,67 @@ void WLSDetectorConstruction::ConstructFiber()
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4LogicalVolume* WLSDetectorConstruction::BuildFiber(const G4String& name, G4double halfLength,
+                                                     G4OpticalSurface* innerSurface)
+{
+    G4VSolid* solWLSfiberClad2 = new G4Tubs("fWLSFiberClad2" + name, 0, GetFiberOuterCladRadius(), halfLength, 0.0 * rad, twopi * rad);
+    G4VSolid* solWLSfiberClad = new G4Tubs("fWLSFiberClad" + name, 0, GetFiberInnerCladRadius(), halfLength, 0.0 * rad, twopi * rad);
+    G4VSolid* solWLSfiber = new G4Tubs("fWLSFiber" + name, 0, GetFiberCoreRadius(), halfLength, 0.0 * rad, twopi * rad);
+
+    G4LogicalVolume* logiCladOt = new G4LogicalVolume(solWLSfiberClad2, FindMaterial("FPethylene"), "LogiWLSCladOt" + name);
+    G4LogicalVolume* logiCladIn = new G4LogicalVolume(solWLSfiberClad, FindMaterial("PMMA"), "LogiWLSCladIn" + name);
+    G4LogicalVolume* logiCore = new G4LogicalVolume(solWLSfiber, FindMaterial("Pethylene"), "LogiWLSFiber" + name);
+
+    G4VPhysicalVolume* physCladIn = new G4PVPlacement(0, G4ThreeVector(), logiCladIn, "WLSFiberClad" + name, logiCladOt, false, 0);
+    G4VPhysicalVolume* physCore = new G4PVPlacement(0, G4ThreeVector(), logiCore, "WLSFiber" + name, logiCladIn, false, 0);
+
+    // Border pairs, not skins: the core and the inner cladding end flush
+    // against the photon detectors and the mirrors, where a skin of the
+    // fiber would be taken before their surfaces
+    new G4LogicalBorderSurface("surfWLSCore" + name + "Ot", physCore, physCladIn, innerSurface); // fiber -> clad
+    new G4LogicalBorderSurface("surfWLSCore" + name + "In", physCladIn, physCore, innerSurface); // clad  -> fiber
+
+    G4VisAttributes* vaCladOt = new G4VisAttributes(G4Colour(0.1, 0.3, 0.1)); // RGB
+    G4VisAttributes* vaCladIn = new G4VisAttributes(G4Colour(0.2, 0.5, 0.2)); // RGB
+    G4VisAttributes* vaWLSCore = new G4VisAttributes(G4Colour(0.4, 0.7, 0.4)); // RGB
+    vaCladOt->SetForceSolid(true);
+    vaCladIn->SetForceSolid(true);
+    vaWLSCore->SetForceSolid(true);
+    logiCladOt->SetVisAttributes(vaCladOt);
+    logiCladIn->SetVisAttributes(vaCladIn);
+    logiCore->SetVisAttributes(vaWLSCore);
+
+    return logiCladOt;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::AddCladdingSurfaces(G4VPhysicalVolume* cladOt, G4VPhysicalVolume* mother,
+                                                  G4OpticalSurface* outerSurface, G4OpticalSurface* innerSurface)
+{
+    G4VPhysicalVolume* cladIn = cladOt->GetLogicalVolume()->GetDaughter(0);
+    G4String name = cladOt->GetName();
+
+    new G4LogicalBorderSurface("surf" + name + "WorldOt", cladOt, mother, outerSurface); // clad2 -> world
+    new G4LogicalBorderSurface("surf" + name + "WorldIn", mother, cladOt, outerSurface); // world -> clad2
+    if (!innerSurface)
+        return;
+    new G4LogicalBorderSurface("surf" + name + "CladOt", cladIn, cladOt, innerSurface);  // clad -> clad2
+    new G4LogicalBorderSurface("surf" + name + "CladIn", cladOt, cladIn, innerSurface);  // clad2  -> clad
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VPhysicalVolume* WLSDetectorConstruction::PlaceEnvelope(const G4String& name, const G4ThreeVector& halfSize,
+                                                          const G4ThreeVector& position)
+{
+    G4VSolid* solid = new G4Box(name, halfSize.x(), halfSize.y(), halfSize.z());
+    G4LogicalVolume* logic = new G4LogicalVolume(solid, FindMaterial("G4_AIR"), name);
+    logic->SetVisAttributes(G4VisAttributes::Invisible);
+    return new G4PVPlacement(0, position, logic, name, fLogiWorld, false, 0);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void WLSDetectorConstruction::ConstructSDandField()
 {
@@ -850,7 +1146,7 @@ void WLSDetectorConstruction::SetPhotonDetGeometry(G4String shape)
 {
     if (shape == "Circle" || shape == "Square")
         fMPPCShape = shape;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -860,7 +1156,7 @@ void WLSDetectorConstruction::SetNumberOfCladding(G4int num)
 // Pre: 0 <= num <= 2
 {
     fNumOfCladLayers = num;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -869,7 +1165,27 @@ void WLSDetectorConstruction::SetWLSLength(G4double length)
 // Set the TOTAL length of the WLS fiber
 {
     fWLSfiberZ = length;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetFiberLength(G4double length)
+// Same meaning as the length argument of the constructor
+{
+    G4double gap = fWLSfiberZ - fWLSfiberl;
+    fWLSfiberZ = length / 2;
+    fWLSfiberl = fWLSfiberZ - gap;
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetGapLength(G4double gap)
+// Same meaning as the gaplength argument of the constructor
+{
+    fWLSfiberl = fWLSfiberZ - gap;
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -878,7 +1194,7 @@ void WLSDetectorConstruction::SetWLSRadius(G4double radius)
 // Set the Y radius of WLS fiber
 {
     fWLSfiberRY = radius;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -887,7 +1203,7 @@ void WLSDetectorConstruction::SetClad1Radius(G4double radius)
 // Set the Y radius of Cladding 1
 {
     fClad1RY = radius;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -896,7 +1212,7 @@ void WLSDetectorConstruction::SetClad2Radius(G4double radius)
 // Set the Y radius of Cladding 2
 {
     fClad2RY = radius;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -906,7 +1222,7 @@ void WLSDetectorConstruction::SetPhotonDetHalfLength(G4double halfL)
 // The half length will be the radius if PhotonDet is circular
 {
     fMPPCHalfL = halfL;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -915,7 +1231,7 @@ void WLSDetectorConstruction::SetGap(G4double gap)
 // Set the distance between fiber end and PhotonDet
 {
     fMPPCDist = gap;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -927,7 +1243,7 @@ void WLSDetectorConstruction::SetPhotonDetAlignment(G4double theta)
 // facing towards the center of the fiber
 {
     fMPPCTheta = theta;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -937,7 +1253,7 @@ void WLSDetectorConstruction::SetSurfaceRoughness(G4double roughness)
 // Pre: 0 < roughness <= 1
 {
     fSurfaceRoughness = roughness;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -947,7 +1263,7 @@ void WLSDetectorConstruction::SetMirrorPolish(G4double polish)
 // Pre: 0 < polish <= 1
 {
     fMirrorPolish = polish;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kSurfaceOnly);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -957,7 +1273,7 @@ void WLSDetectorConstruction::SetMirrorReflectivity(G4double reflectivity)
 // Pre: 0 < reflectivity <= 1
 {
     fMirrorReflectivity = reflectivity;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kSurfaceOnly);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -967,7 +1283,7 @@ void WLSDetectorConstruction::SetPhotonDetPolish(G4double polish)
 // Pre: 0 < polish <= 1
 {
     fMPPCPolish = polish;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kSurfaceOnly);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -977,7 +1293,17 @@ void WLSDetectorConstruction::SetPhotonDetReflectivity(G4double reflectivity)
 // Pre: 0 < reflectivity <= 1
 {
     fMPPCReflectivity = reflectivity;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kSurfaceOnly);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetPhotonDetDeferred(G4bool deferred)
+// Detect every photon absorbed by the PhotonDet (efficiency 1) and leave
+// the efficiency to WLSEventAction, or go back to effi_mppc on the surface
+{
+    fDeferredPDE = deferred;
+    GeometryChanged(kSurfaceOnly);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -987,7 +1313,7 @@ void WLSDetectorConstruction::SetMirror(G4bool flag)
 // True means place the mirror, false means otherwise
 {
     fMirrorToggle = flag;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -997,7 +1323,7 @@ void WLSDetectorConstruction::SetXYRatio(G4double r)
 // a ratio of 1 would produce a circle
 {
     fXYRatio = r;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1006,7 +1332,7 @@ void WLSDetectorConstruction::SetBarLength(G4double length)
 // Set the length of the scintillator bar
 {
     fBarLength = length;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1015,7 +1341,7 @@ void WLSDetectorConstruction::SetBarBase(G4double side)
 // Set the side of the scintillator bar
 {
     fBarBase = side;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1024,7 +1350,16 @@ void WLSDetectorConstruction::SetHoleRadius(G4double radius)
 // Set the radius of the fiber hole
 {
     fHoleRadius = radius;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetHolePosition(G4double pos)
+// Set the offset of the fiber holes from the centre of the cube
+{
+    fHolePos = pos;
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1033,7 +1368,7 @@ void WLSDetectorConstruction::SetCoatingThickness(G4double thick)
 // Set thickness of the coating on the bars
 {
     fCoatingThickness = thick;
-    G4RunManager::GetRunManager()->ReinitializeGeometry();
+    GeometryChanged(kShapeChanging);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1042,11 +1377,163 @@ void WLSDetectorConstruction::SetCoatingRadius(G4double radius)
 // Set inner radius of the corner bar coating
 {
     fCoatingRadius = radius;
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetHoleMode(G4String mode)
+// Set how the fiber holes are modelled
+// Pre: mode must be either "boolean" or "daughter"
+{
+    if (mode == "boolean" || mode == "daughter")
+        fHoleMode = mode;
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetCubeReflectivity(G4double reflectivity)
+// Set the reflectivity of the cube coating
+// Pre: 0 <= reflectivity <= 1
+{
+    fCubeReflectivity = reflectivity;
+    GeometryChanged(kSurfaceOnly);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetScintillationYield(G4double yield)
+// Set the scintillation yield of the cubes (photons per energy)
+// Pre: yield >= 0
+{
+    fScintillationYield = yield;
+    GeometryChanged(kMaterialOnly);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::GeometryChanged(ChangeKind kind)
+{
+    // Surface and material properties are looked up by the optical
+    // processes at every step, so once the geometry exists they are
+    // changed in place: no rebuild, no re-voxelisation, and the next run
+    // uses them.  Before that Construct() picks the new values up.
+    if (fPhysWorld && kind == kSurfaceOnly)
+    {
+        UpdateSurfaces();
+        return;
+    }
+    if (fPhysWorld && kind == kMaterialOnly)
+    {
+        UpdateMaterials();
+        return;
+    }
     G4RunManager::GetRunManager()->ReinitializeGeometry();
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace {
+
+void SetReflectivity(G4OpticalSurface* surface, G4double reflectivity)
+{
+    G4MaterialPropertiesTable* mpt = surface->GetMaterialPropertiesTable();
+    G4MaterialPropertyVector* v = mpt ? mpt->GetProperty("REFLECTIVITY") : 0;
+    if (!v)
+        return;
+    for (size_t i = 0; i < v->GetVectorLength(); i++)
+        v->PutValue(i, reflectivity);
+}
+
+// 1 everywhere, or the effi_mppc table.  Rebuilt rather than written in
+// place: a surface read from a GDML snapshot may carry a vector of
+// another length.
+void SetEfficiency(G4OpticalSurface* surface, G4bool all)
+{
+    G4MaterialPropertiesTable* mpt = surface->GetMaterialPropertiesTable();
+    if (!mpt)
+    {
+        G4ExceptionDescription o;
+        o << surface->GetName() << " has no material properties: its efficiency is left "
+          << "alone, and with /WLS/setPhotonDetDeferred true the efficiency is applied twice";
+        G4Exception("WLSDetectorConstruction::UpdateSurfaces()", "WLSGeom04", JustWarning, o);
+        return;
+    }
+    const WLSOpticalTables::Table& effi_mppc = WLSOpticalTables::GetInstance()->GetTable("effi_mppc");
+    std::vector<G4double> energy = effi_mppc.energy;
+    std::vector<G4double> value = all ? std::vector<G4double>(energy.size(), 1.) : effi_mppc.value;
+    mpt->RemoveProperty("EFFICIENCY");
+    mpt->AddProperty("EFFICIENCY", &energy[0], &value[0], energy.size());
+}
+
+}
+
+void WLSDetectorConstruction::UpdateSurfaces()
+{
+    if (fTiO2Surface)
+        SetReflectivity(fTiO2Surface, fCubeReflectivity);
+    if (fMirrorSurface)
+    {
+        SetReflectivity(fMirrorSurface, fMirrorReflectivity);
+        fMirrorSurface->SetPolish(fMirrorPolish);
+    }
+    if (fPhotonDetSurface)
+    {
+        SetReflectivity(fPhotonDetSurface, fMPPCReflectivity);
+        SetEfficiency(fPhotonDetSurface, fDeferredPDE);
+        fPhotonDetSurface->SetPolish(fMPPCPolish);
+    }
+    G4cout << "Surfaces updated: cube reflectivity " << fCubeReflectivity
+           << ", mirror reflectivity " << fMirrorReflectivity << " polish " << fMirrorPolish
+           << ", photon detector reflectivity " << fMPPCReflectivity << " polish " << fMPPCPolish
+           << (fDeferredPDE ? ", efficiency deferred" : "") << G4endl;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::UpdateMaterials()
+{
+    // negative: keep the yield of WLSMaterials
+    if (fScintillationYield < 0)
+        return;
+    G4Material* scintillator = G4Material::GetMaterial("Polystyrene", false);
+    G4MaterialPropertiesTable* mpt = scintillator ? scintillator->GetMaterialPropertiesTable() : 0;
+    if (!mpt)
+        return;
+    mpt->AddConstProperty("SCINTILLATIONYIELD", fScintillationYield);
+    G4cout << "Scintillation yield set to " << fScintillationYield * MeV << " / MeV" << G4endl;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4OpticalSurface* WLSDetectorConstruction::FindSkinSurface(const G4String& name)
+{
+    // GDML may have appended a suffix to the name
+    const G4LogicalSkinSurfaceTable* table = G4LogicalSkinSurface::GetSurfaceTable();
+    for (size_t i = 0; table && i < table->size(); i++)
+    {
+        G4OpticalSurface* surface = dynamic_cast<G4OpticalSurface*>((*table)[i]->GetSurfaceProperty());
+        if (surface && surface->GetName().compare(0, name.size(), name) == 0)
+            return surface;
+    }
+    return 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::SetArraySize(G4int nx, G4int ny, G4int nz)
+// Set the number of cubes along x, y and z
+// Pre: nx, ny, nz >= 1
+{
+    fNX = nx;
+    fNY = ny;
+    fNZ = nz;
+    GeometryChanged(kShapeChanging);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4double WLSDetectorConstruction::GetWLSFiberLength()
 {
     return fWLSfiberZ;
@@ -1089,6 +1576,27 @@ G4double WLSDetectorConstruction::GetFiberRadius()
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4double WLSDetectorConstruction::GetFiberCoreRadius() const
+{
+    return fWLSfiberRX;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSDetectorConstruction::GetFiberInnerCladRadius() const
+{
+    return fWLSfiberRX + 0.02 * mm;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSDetectorConstruction::GetFiberOuterCladRadius() const
+{
+    return fWLSfiberRX + 0.02 * mm + 0.02 * mm;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4double WLSDetectorConstruction::GetCoatingThickness()
 {
     return fCoatingThickness;
@@ -1103,6 +1611,127 @@ G4double WLSDetectorConstruction::GetCoatingRadius()
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4bool WLSDetectorConstruction::IsNineCubeLayer() const
+{
+    return fNX == 3 && fNY == 3 && fNZ == 1;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSDetectorConstruction::GetCubePitch()
+{
+    G4double gap = 0.01 * mm;
+    return GetBarBase() + 2 * GetCoatingThickness() + gap;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSDetectorConstruction::GetScintillatorTopZ()
+{
+    return (fNZ - 1) * GetCubePitch() / 2 + GetBarBase() / 2;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSDetectorConstruction::GetChannel(const G4VPhysicalVolume* pv, G4int copyNo) const
+{
+    if (pv == fPhysPhotonDet[0])
+        return 1 + copyNo;
+    if (pv == fPhysPhotonDet[1])
+        return 1 + fNX * fNZ + copyNo;
+    if (pv == fPhysPhotonDet[2])
+        return 1 + fNX * fNZ + fNY * fNZ + copyNo;
+    return 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSDetectorConstruction::GetChannelView(G4int channel) const
+{
+    if (channel < 1)
+        return -1;
+    if (channel <= fNX * fNZ)
+        return 0;
+    if (channel <= fNX * fNZ + fNY * fNZ)
+        return 1;
+    if (channel <= GetNumberOfChannels())
+        return 2;
+    return -1;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector WLSDetectorConstruction::GetCubeCentre(G4int cube)
+{
+    // The block is centred on the world origin (ConstructDetector)
+    G4int ix = cube % fNX;
+    G4int iy = (cube / fNX) % fNY;
+    G4int iz = cube / (fNX * fNY);
+    G4double pitch = GetCubePitch();
+    return G4ThreeVector((ix - (fNX - 1) / 2.) * pitch, (iy - (fNY - 1) / 2.) * pitch,
+                         (iz - (fNZ - 1) / 2.) * pitch);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSDetectorConstruction::GetCube(const G4VTouchable* touchable) const
+{
+    if (!physScintillator || touchable->GetVolume() != physScintillator)
+        return -1;
+    // SciCube in Extrusion in Cell (z replica) in BlockRow (y) in BlockSlab (x)
+    G4int iz = touchable->GetReplicaNumber(2);
+    G4int iy = touchable->GetReplicaNumber(3);
+    G4int ix = touchable->GetReplicaNumber(4);
+    return ix + fNX * (iy + fNY * iz);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSDetectorConstruction::GetNumberOfChannels() const
+{
+    return fNX * fNZ + fNY * fNZ + fNX * fNY;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSDetectorConstruction::GetCubeChannel(G4int cube, G4int view) const
+{
+    G4int ix = cube % fNX;
+    G4int iy = (cube / fNX) % fNY;
+    G4int iz = cube / (fNX * fNY);
+    if (view == 0)
+        return 1 + ix + fNX * iz;
+    if (view == 1)
+        return 1 + fNX * fNZ + iy + fNY * iz;
+    return 1 + fNX * fNZ + fNY * fNZ + iy + fNY * ix;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSDetectorConstruction::WriteResponseParameters(std::ostream& os) const
+{
+    // Exact values: any change is a different response
+    std::streamsize precision = os.precision(17);
+    os << "array " << fNX << " " << fNY << " " << fNZ << "\n"
+       << "holeMode " << fHoleMode << "\n"
+       << "photonDetShape " << fMPPCShape << "\n"
+       << "cladLayers " << fNumOfCladLayers << "\n"
+       << "mirror " << fMirrorToggle << "\n";
+    const G4double values[] = {
+        fBarBase, fBarLength, fHoleRadius, fHoleLength, fHolePos,
+        fCoatingThickness, fCoatingRadius, fCubeReflectivity,
+        fWLSfiberRX, fWLSfiberRY, fWLSfiberZ, fWLSfiberl, fWLSfiberOrigin,
+        fClad1RX, fClad1RY, fClad2RX, fClad2RY, fXYRatio, fSurfaceRoughness,
+        fMirrorReflectivity, fMirrorPolish, fMPPCReflectivity, fMPPCPolish,
+        fMPPCHalfL, fMPPCDist, fMPPCTheta
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+        os << values[i] << "\n";
+    os.precision(precision);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4double WLSDetectorConstruction::GetWLSFiberEnd()
 {
     return fWLSfiberOrigin + fWLSfiberZ;
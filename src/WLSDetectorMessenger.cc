@@ -30,6 +30,8 @@
 //
 //
 #include "WLSDetectorMessenger.hh"
+#include "WLSOpticalTables.hh"
+#include "WLSPhotonDetEfficiency.hh"
 
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithABool.hh"
@@ -38,6 +40,10 @@
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithoutParameter.hh"
+#include "G4UIparameter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -110,9 +116,48 @@ WLSDetectorMessenger::WLSDetectorMessenger(WLSDetectorConstruction * det)
                              SetGuidance("Set the reflectivity of the mirror");
   fSetPhotonDetReflectivityCmd->SetParameterName("reflectivity",false);
   fSetPhotonDetReflectivityCmd->SetRange("reflectivity>=0 && reflectivity<=1");
-  fSetPhotonDetReflectivityCmd->AvailableForStates(G4State_PreInit);
+  fSetPhotonDetReflectivityCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
   fSetPhotonDetReflectivityCmd->SetToBeBroadcasted(false);
 
+  fSetPhotonDetDeferredCmd =
+                 new G4UIcmdWithABool("/WLS/setPhotonDetDeferred", this);
+  fSetPhotonDetDeferredCmd->SetGuidance("Detect every photon reaching a photon detector");
+  fSetPhotonDetDeferredCmd->SetGuidance("and apply the efficiency curves per event:");
+  fSetPhotonDetDeferredCmd->SetGuidance("the default one to the cube ntuple, every");
+  fSetPhotonDetDeferredCmd->SetGuidance("curve of /WLS/addPhotonDetPDE to the pde ntuple.");
+  fSetPhotonDetDeferredCmd->SetParameterName("deferred",false);
+  fSetPhotonDetDeferredCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetPhotonDetDeferredCmd->SetToBeBroadcasted(false);
+
+  fAddPhotonDetPDECmd = new G4UIcommand("/WLS/addPhotonDetPDE",this);
+  fAddPhotonDetPDECmd->SetGuidance("Register the effi_mppc table of a wls-optical-tables");
+  fAddPhotonDetPDECmd->SetGuidance("file as a further efficiency curve, used with");
+  fAddPhotonDetPDECmd->SetGuidance("/WLS/setPhotonDetDeferred true.");
+  fAddPhotonDetPDECmd->SetParameter(new G4UIparameter("name",'s',false));
+  fAddPhotonDetPDECmd->SetParameter(new G4UIparameter("fileName",'s',false));
+  fAddPhotonDetPDECmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fAddPhotonDetPDECmd->SetToBeBroadcasted(false);
+
+  // The reflectivities and polishes only change surface property tables
+  // and the yield a material property table: after /run/initialize they
+  // are applied in place, without rebuilding the geometry.
+  fSetCubeReflectivityCmd =
+                    new G4UIcmdWithADouble("/WLS/setCubeReflectivity", this);
+  fSetCubeReflectivityCmd->SetGuidance("Set the reflectivity of the cube coating");
+  fSetCubeReflectivityCmd->SetParameterName("reflectivity",false);
+  fSetCubeReflectivityCmd->SetRange("reflectivity>=0 && reflectivity<=1");
+  fSetCubeReflectivityCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetCubeReflectivityCmd->SetToBeBroadcasted(false);
+
+  fSetScintillationYieldCmd =
+                  new G4UIcmdWithADouble("/WLS/setScintillationYield", this);
+  fSetScintillationYieldCmd->SetGuidance("Set the scintillation yield of the cubes");
+  fSetScintillationYieldCmd->SetGuidance("in photons per MeV");
+  fSetScintillationYieldCmd->SetParameterName("yield",false);
+  fSetScintillationYieldCmd->SetRange("yield>=0");
+  fSetScintillationYieldCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetScintillationYieldCmd->SetToBeBroadcasted(false);
+
   fSetWLSLengthCmd = new G4UIcmdWithADoubleAndUnit("/WLS/setWLSLength",this);
   fSetWLSLengthCmd->SetGuidance("Set the half length of the WLS fiber");
   fSetWLSLengthCmd->SetParameterName("length",false);
@@ -162,6 +207,27 @@ WLSDetectorMessenger::WLSDetectorMessenger(WLSDetectorConstruction * det)
   fSetPhotonDetHalfLengthCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
   fSetPhotonDetHalfLengthCmd->SetToBeBroadcasted(false);
 
+  fSetFiberLengthCmd =
+                    new G4UIcmdWithADoubleAndUnit("/WLS/setFiberLength",this);
+  fSetFiberLengthCmd->SetGuidance("Set the full length of the WLS fibers,");
+  fSetFiberLengthCmd->SetGuidance("keeping the distance from the cubes to the readout");
+  fSetFiberLengthCmd->SetParameterName("length",false);
+  fSetFiberLengthCmd->SetRange("length>0.");
+  fSetFiberLengthCmd->SetUnitCategory("Length");
+  fSetFiberLengthCmd->SetDefaultUnit("cm");
+  fSetFiberLengthCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetFiberLengthCmd->SetToBeBroadcasted(false);
+
+  fSetGapLengthCmd = new G4UIcmdWithADoubleAndUnit("/WLS/setGapLength",this);
+  fSetGapLengthCmd->SetGuidance("Set the distance from the cubes to the readout end");
+  fSetGapLengthCmd->SetGuidance("of the fibers");
+  fSetGapLengthCmd->SetParameterName("length",false);
+  fSetGapLengthCmd->SetRange("length>0.");
+  fSetGapLengthCmd->SetUnitCategory("Length");
+  fSetGapLengthCmd->SetDefaultUnit("cm");
+  fSetGapLengthCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetGapLengthCmd->SetToBeBroadcasted(false);
+
   fSetGapCmd = new G4UIcmdWithADoubleAndUnit("/WLS/setGap",this);
   fSetGapCmd->SetGuidance("Set the distance between PhotonDet and fiber end");
   fSetGapCmd->SetParameterName("theta",false);
@@ -214,6 +280,15 @@ WLSDetectorMessenger::WLSDetectorMessenger(WLSDetectorConstruction * det)
   fSetHoleRadiusCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
   fSetHoleRadiusCmd->SetToBeBroadcasted(false);
 
+  fSetHolePositionCmd = new G4UIcmdWithADoubleAndUnit("/WLS/setHolePosition",this);
+  fSetHolePositionCmd->SetGuidance("Set the offset of the fiber holes from the cube centre");
+  fSetHolePositionCmd->SetParameterName("pos",false);
+  fSetHolePositionCmd->SetRange("pos>=0.");
+  fSetHolePositionCmd->SetUnitCategory("Length");
+  fSetHolePositionCmd->SetDefaultUnit("mm");
+  fSetHolePositionCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetHolePositionCmd->SetToBeBroadcasted(false);
+
   fSetCoatingThicknessCmd =
                new G4UIcmdWithADoubleAndUnit("/WLS/setCoatingThickness",this);
   fSetCoatingThicknessCmd->
@@ -235,6 +310,65 @@ WLSDetectorMessenger::WLSDetectorMessenger(WLSDetectorConstruction * det)
   fSetCoatingRadiusCmd->SetRange("cradius>=0.");
   fSetCoatingRadiusCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
   fSetCoatingRadiusCmd->SetToBeBroadcasted(false);
+
+  fSetHoleModeCmd = new G4UIcmdWithAString("/WLS/setHoleMode",this);
+  fSetHoleModeCmd->SetGuidance("Select how the fiber holes are modelled");
+  fSetHoleModeCmd->SetGuidance("  boolean  : boxes with the holes subtracted (default)");
+  fSetHoleModeCmd->SetGuidance("  daughter : plain boxes with air tube daughters");
+  fSetHoleModeCmd->SetParameterName("mode",false);
+  fSetHoleModeCmd->SetCandidates("boolean daughter");
+  fSetHoleModeCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetHoleModeCmd->SetToBeBroadcasted(false);
+
+  fArrayDir = new G4UIdirectory("/WLS/array/");
+  fArrayDir->SetGuidance(" Cube array ");
+
+  fSetArraySizeCmd = new G4UIcommand("/WLS/array/size",this);
+  fSetArraySizeCmd->SetGuidance("Set the number of cubes along x, y and z.");
+  fSetArraySizeCmd->SetGuidance("Every cube has one X, one Y and one Z fiber hole;");
+  fSetArraySizeCmd->SetGuidance("fibers run through the whole array, giving");
+  fSetArraySizeCmd->SetGuidance("NX*NZ + NY*NZ + NX*NY readout channels.");
+  fSetArraySizeCmd->SetGuidance("The default 3 3 1 is the nine-cube layer.");
+  G4UIparameter* nx = new G4UIparameter("nx",'i',false);
+  nx->SetParameterRange("nx>=1");
+  fSetArraySizeCmd->SetParameter(nx);
+  G4UIparameter* ny = new G4UIparameter("ny",'i',false);
+  ny->SetParameterRange("ny>=1");
+  fSetArraySizeCmd->SetParameter(ny);
+  G4UIparameter* nz = new G4UIparameter("nz",'i',false);
+  nz->SetParameterRange("nz>=1");
+  fSetArraySizeCmd->SetParameter(nz);
+  fSetArraySizeCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fSetArraySizeCmd->SetToBeBroadcasted(false);
+
+  fGeometryDir = new G4UIdirectory("/WLS/geometry/");
+  fGeometryDir->SetGuidance(" Geometry snapshots (GDML) ");
+
+  fExportGeometryCmd = new G4UIcmdWithAString("/WLS/geometry/export",this);
+  fExportGeometryCmd->SetGuidance("Write the constructed geometry to a GDML file,");
+  fExportGeometryCmd->SetGuidance("with materials, property tables, optical surfaces");
+  fExportGeometryCmd->SetGuidance("and the cube array parameters.");
+  fExportGeometryCmd->SetGuidance("An existing file is not overwritten.");
+  fExportGeometryCmd->SetParameterName("fileName",false);
+  fExportGeometryCmd->AvailableForStates(G4State_Idle);
+  fExportGeometryCmd->SetToBeBroadcasted(false);
+
+  fLoadGeometryCmd = new G4UIcmdWithAString("/WLS/geometry/load",this);
+  fLoadGeometryCmd->SetGuidance("Read the world from a file written by export");
+  fLoadGeometryCmd->SetGuidance("instead of building it; 'none' builds it again.");
+  fLoadGeometryCmd->SetParameterName("fileName",false);
+  fLoadGeometryCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  fLoadGeometryCmd->SetToBeBroadcasted(false);
+
+  fSetOpticalTablesCmd = new G4UIcmdWithAString("/WLS/setOpticalTables",this);
+  fSetOpticalTablesCmd->SetGuidance("Read the optical property tables (spectra,");
+  fSetOpticalTablesCmd->SetGuidance("absorption lengths, refractive indices, MPPC PDE)");
+  fSetOpticalTablesCmd->SetGuidance("from a file instead of the compiled-in ones.");
+  fSetOpticalTablesCmd->SetGuidance("Only before /run/initialize: the materials are");
+  fSetOpticalTablesCmd->SetGuidance("built once and shared by all threads.");
+  fSetOpticalTablesCmd->SetParameterName("fileName",false);
+  fSetOpticalTablesCmd->AvailableForStates(G4State_PreInit);
+  fSetOpticalTablesCmd->SetToBeBroadcasted(false);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -250,18 +384,34 @@ WLSDetectorMessenger::~WLSDetectorMessenger()
   delete fSetClad1RadiusCmd;
   delete fSetClad2RadiusCmd;
   delete fSetPhotonDetHalfLengthCmd;
+  delete fSetFiberLengthCmd;
+  delete fSetGapLengthCmd;
   delete fSetGapCmd;
   delete fSetPhotonDetAlignmentCmd;
   delete fSetSurfaceRoughnessCmd;
   delete fSetMirrorPolishCmd;
   delete fSetMirrorReflectivityCmd;
+  delete fSetPhotonDetPolishCmd;
+  delete fSetPhotonDetReflectivityCmd;
+  delete fSetPhotonDetDeferredCmd;
+  delete fAddPhotonDetPDECmd;
+  delete fSetCubeReflectivityCmd;
+  delete fSetScintillationYieldCmd;
   delete fSetXYRatioCmd;
   delete fSetMirrorCmd;
   delete fSetBarLengthCmd;
   delete fSetBarBaseCmd;
   delete fSetHoleRadiusCmd;
+  delete fSetHolePositionCmd;
   delete fSetCoatingThicknessCmd;
   delete fSetCoatingRadiusCmd;
+  delete fSetHoleModeCmd;
+  delete fSetArraySizeCmd;
+  delete fArrayDir;
+  delete fExportGeometryCmd;
+  delete fLoadGeometryCmd;
+  delete fGeometryDir;
+  delete fSetOpticalTablesCmd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -302,6 +452,17 @@ void WLSDetectorMessenger::SetNewValue(G4UIcommand* command,G4String val)
     fDetector->
           SetPhotonDetReflectivity(G4UIcmdWithADouble::GetNewDoubleValue(val));
   }
+  else if( command == fSetPhotonDetDeferredCmd ) {
+
+    fDetector->SetPhotonDetDeferred(G4UIcmdWithABool::GetNewBoolValue(val));
+  }
+  else if( command == fAddPhotonDetPDECmd ) {
+
+    std::istringstream is(val);
+    G4String name, fileName;
+    is >> name >> fileName;
+    WLSPhotonDetEfficiency::GetInstance()->AddCurve(name, fileName);
+  }
   else if( command == fSetWLSLengthCmd ) {
  
     fDetector->SetWLSLength(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
@@ -325,6 +486,14 @@ void WLSDetectorMessenger::SetNewValue(G4UIcommand* command,G4String val)
     fDetector->
      SetPhotonDetHalfLength(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
   }
+  else if( command == fSetFiberLengthCmd ) {
+
+   fDetector->SetFiberLength(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  }
+  else if( command == fSetGapLengthCmd ) {
+
+   fDetector->SetGapLength(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  }
   else if( command == fSetGapCmd ) {
  
    fDetector->SetGap(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
@@ -340,22 +509,57 @@ void WLSDetectorMessenger::SetNewValue(G4UIcommand* command,G4String val)
   }
   else if( command == fSetBarLengthCmd ) {
 
-   fDetector->SetBarLength(G4UIcmdWithABool::GetNewBoolValue(val));
+   fDetector->SetBarLength(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
   }
   else if( command == fSetBarBaseCmd ) {
 
-   fDetector->SetBarBase(G4UIcmdWithABool::GetNewBoolValue(val));
+   fDetector->SetBarBase(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
   }
   else if( command == fSetHoleRadiusCmd ) {
 
-   fDetector->SetHoleRadius(G4UIcmdWithABool::GetNewBoolValue(val));
+   fDetector->SetHoleRadius(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  }
+  else if( command == fSetHolePositionCmd ) {
+
+   fDetector->SetHolePosition(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
   }
   else if( command == fSetCoatingThicknessCmd ) {
 
-   fDetector->SetCoatingThickness(G4UIcmdWithABool::GetNewBoolValue(val));
+   fDetector->SetCoatingThickness(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
   }
   else if( command == fSetCoatingRadiusCmd ) {
 
-   fDetector->SetCoatingRadius(G4UIcmdWithABool::GetNewBoolValue(val));
+   fDetector->SetCoatingRadius(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  }
+  else if( command == fSetCubeReflectivityCmd ) {
+
+   fDetector->SetCubeReflectivity(G4UIcmdWithADouble::GetNewDoubleValue(val));
+  }
+  else if( command == fSetScintillationYieldCmd ) {
+
+   fDetector->SetScintillationYield(G4UIcmdWithADouble::GetNewDoubleValue(val) / MeV);
+  }
+  else if( command == fSetHoleModeCmd ) {
+
+   fDetector->SetHoleMode(val);
+  }
+  else if( command == fSetArraySizeCmd ) {
+
+   std::istringstream is(val);
+   G4int nx = 3, ny = 3, nz = 1;
+   is >> nx >> ny >> nz;
+   fDetector->SetArraySize(nx, ny, nz);
+  }
+  else if( command == fExportGeometryCmd ) {
+
+   fDetector->ExportGeometry(val);
+  }
+  else if( command == fLoadGeometryCmd ) {
+
+   fDetector->SetGeometryFile(val);
+  }
+  else if( command == fSetOpticalTablesCmd ) {
+
+   WLSOpticalTables::GetInstance()->Load(val);
   }
 }
@@ -31,31 +31,49 @@
 //
 #include "WLSEventAction.hh"
 #include "WLSRunAction.hh"
+#include "WLSDetectorConstruction.hh"
 
 #include "WLSEventActionMessenger.hh"
 
 #include "WLSPhotonDetHit.hh"
 #include "WLSTrajectory.hh"
+#include "WLSSharedMemorySink.hh"
+#include "WLSOutputWriter.hh"
+#include "WLSPhotonDetEfficiency.hh"
 
 #include "G4Event.hh"
 #include "G4EventManager.hh"
+#include "G4RunManager.hh"
+#include "G4Run.hh"
 
 #include "G4TrajectoryContainer.hh"
 #include "G4VVisManager.hh"
 #include "G4SDManager.hh"
 
 #include "Randomize.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
 
 // Purpose: Invoke visualization at the end
 //          Also can accumulate statistics regarding hits
 //          in the PhotonDet detector
 
+// Channels of the nine-cube layer (3 x 3 x 1) behind the npx, npy and npz
+// columns of the "cube" ntuple
+static G4int LegacyChannelX(G4int i) { return 1 + i; }
+static G4int LegacyChannelY(G4int j) { return 4 + j; }
+static G4int LegacyChannelZ(G4int i, G4int j) { return 7 + 3 * i + j; }
+
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-WLSEventAction::WLSEventAction(WLSRunAction* runaction, WLSPrimaryGeneratorAction* primarysource, WLSStackingAction* stacking)
+WLSEventAction::WLSEventAction(WLSRunAction* runaction, WLSPrimaryGeneratorAction* primarysource, WLSStackingAction* stacking,
+                               WLSDetectorConstruction* detector)
     : /* initialize with different name */ fRunAction(runaction),
     /* initialize with different name */ fPrimarysource(primarysource),
     /* initialize with different name */ fStacking(stacking),
+    fDetector(detector),
     fVerboseLevel(0),
     fPrintModulo(100), fDrawFlag("charged")
 {
@@ -65,6 +83,13 @@ WLSEventAction::WLSEventAction(WLSRunAction* runaction, WLSPrimaryGeneratorActio
 
     fForceDrawPhotons = false;
     fForceNoPhotons = false;
+
+    fTriggerMode = kTriggerNone;
+    fTriggerThreshold = 1;
+
+    fTotalDeposit = 0;
+    fPhotonHistory = false;
+    fDeferredPDE = false;
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -90,16 +115,13 @@ void WLSEventAction::BeginOfEventAction(const G4Event* evt)
     fPrimaryX = 0;
     fPrimaryY = 0;
     fPrimaryZ = 0;
-    for (int i = 0; i < 3; i++)
-        fPhotCountX[i] = 0;
-    for (int j = 0; j < 3; j++)
-        fPhotCountY[j] = 0;
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-        {
-            fPhotCountZ[i][j] = 0;
-            fHittimeZ[i][j] = 0;
-        }
+    fChannelHits.clear();
+    fCubeDeposits.clear();
+    fTotalDeposit = 0;
+    fPhotonHistory = fRunAction->GetPhotonHistory();
+    fDetectedPhotons.clear();
+    fDeferredPDE = fDetector->IsPhotonDetDeferred();
+    fArrivingPhotons.clear();
 
     fPhottime = 0;
     fPhotlasttime = 0;
@@ -204,8 +226,8 @@ void WLSEventAction::EndOfEventAction(const G4Event* evt)
 
 
     // if (fVerboseLevel>0)
-    double ene = fPrimarysource->GetSouce()->GetParticleEnergy();
-    G4ThreeVector a = fPrimarysource->GetSouce()->GetParticlePosition();
+    double ene = fPrimarysource->GetPrimaryEnergy();
+    G4ThreeVector a = fPrimarysource->GetPrimaryPosition();
     // fStacking->NewStage();
     G4cout << "<<< Event  " << evt->GetEventID() << " ended." << G4endl;
     G4cout << "<<< energy= " << ene << G4endl; // add
@@ -213,12 +235,14 @@ void WLSEventAction::EndOfEventAction(const G4Event* evt)
     G4cout << "<<< fPrimaryY= " << a.getY() << G4endl; // add
     G4cout << "<<< fPrimaryZ= " << a.getZ() << G4endl; // add
     G4cout << "<<< Ngenerated photon= " << fStacking->GetOpticalNPhotons() << G4endl; // add
-    G4cout << "<<< fPhotCountX_1= " << fPhotCountX[1] << G4endl; // add
-    G4cout << "<<< fPhotCountY_1= " << fPhotCountY[1] << G4endl; // add
-    G4cout << "<<< fPhotCountZ_11= " << fPhotCountZ[1][1] << G4endl; // add
+    G4cout << "<<< fPhotCountX_1= " << GetChannelPhotons(LegacyChannelX(1)) << G4endl; // add
+    G4cout << "<<< fPhotCountY_1= " << GetChannelPhotons(LegacyChannelY(1)) << G4endl; // add
+    G4cout << "<<< fPhotCountZ_11= " << GetChannelPhotons(LegacyChannelZ(1, 1)) << G4endl; // add
     G4cout << "<<< fPhotTime= "   << fPhottime   << G4endl; // add
     G4cout << "<<< fPhotlastTime= " << fPhotlasttime << G4endl; // add
-    G4cout << "<<< fHittimeZ_11= " << fHittimeZ[1][1] << G4endl;
+    G4cout << "<<< fHittimeZ_11= " << GetChannelFirstTime(LegacyChannelZ(1, 1)) << G4endl;
+    G4cout << "<<< hit channels= " << fChannelHits.size() << G4endl;
+    G4cout << "<<< edep= " << fTotalDeposit << G4endl;
     G4cout << "<<< fCubeInPosX= " << fCubeInPos.getX() << G4endl;
     G4cout << "<<< fCubeInPosY= " << fCubeInPos.getY() << G4endl;
     G4cout << "<<< fCubeInPosZ= " << fCubeInPos.getZ() << G4endl;
@@ -228,44 +252,313 @@ void WLSEventAction::EndOfEventAction(const G4Event* evt)
 
 
 
-    G4AnalysisManager* ana = G4AnalysisManager::Instance();
+    WLSOutputWriter* ana = fRunAction->GetWriter();
+
+    // Trigger summary: bin 0 = rejected, bin 1 = accepted
+    G4bool accepted = PassesTrigger();
+    ana->FillH1(0, accepted ? 1 : 0);
+    if (!accepted)
+    {
+        G4int total = 0;
+        std::map<G4int, ChannelHits>::const_iterator it;
+        for (it = fChannelHits.begin(); it != fChannelHits.end(); ++it)
+            total += it->second.photons;
+        ana->FillH1(1, total);
+        return;
+    }
+
+    // The npx/npy/npz columns only describe the nine-cube layer; for any
+    // other array they stay 0 and the "hits" ntuple holds the readout
+    G4bool legacy = fDetector->IsNineCubeLayer();
+
     int ii = 0;
-    ana->FillNtupleDColumn(ii++, evt->GetEventID());
-    ana->FillNtupleDColumn(ii++, ene);
-    ana->FillNtupleDColumn(ii++, a.getX());
-    ana->FillNtupleDColumn(ii++, a.getY());
-    ana->FillNtupleDColumn(ii++, a.getZ());
-    ana->FillNtupleDColumn(ii++, fStacking->GetOpticalNPhotons());
+    ana->FillNtupleDColumn(0, ii++, evt->GetEventID());
+    ana->FillNtupleDColumn(0, ii++, ene);
+    ana->FillNtupleDColumn(0, ii++, a.getX());
+    ana->FillNtupleDColumn(0, ii++, a.getY());
+    ana->FillNtupleDColumn(0, ii++, a.getZ());
+    ana->FillNtupleDColumn(0, ii++, fStacking->GetOpticalNPhotons());
     for (int i = 0; i < 3; i++)
-        ana->FillNtupleDColumn(ii++, fPhotCountX[i]);
+        ana->FillNtupleDColumn(0, ii++, legacy ? GetChannelPhotons(LegacyChannelX(i)) : 0);
     for (int j = 0; j < 3; j++)
-        ana->FillNtupleDColumn(ii++, fPhotCountY[j]);
+        ana->FillNtupleDColumn(0, ii++, legacy ? GetChannelPhotons(LegacyChannelY(j)) : 0);
     for (int i = 0; i < 3; i++)
         for (int j = 0; j < 3; j++)
         {
-            ana->FillNtupleDColumn(ii++, fPhotCountZ[i][j]);
+            ana->FillNtupleDColumn(0, ii++, legacy ? GetChannelPhotons(LegacyChannelZ(i, j)) : 0);
         }
-    ana->FillNtupleDColumn(ii++, fPhottime);
-    ana->FillNtupleDColumn(ii++, fPhotlasttime);
+    ana->FillNtupleDColumn(0, ii++, fPhottime);
+    ana->FillNtupleDColumn(0, ii++, fPhotlasttime);
     for (int i = 0; i < 3; i++)
     {
         for (int j = 0; j < 3; j++)
         {
-            if(fHittimeZ[i][j] != 0.0)
-                ana->FillNtupleDColumn(ii++, fHittimeZ[i][j]);
+            G4double hittime = legacy ? GetChannelFirstTime(LegacyChannelZ(i, j)) : 0;
+            if(hittime != 0.0)
+                ana->FillNtupleDColumn(0, ii++, hittime);
             else
                 ii++;
         }
     }
-    ana->FillNtupleDColumn(ii++, fCubeInPos.getX());
-    ana->FillNtupleDColumn(ii++, fCubeInPos.getY());
-    ana->FillNtupleDColumn(ii++, fCubeInPos.getZ());
+    ana->FillNtupleDColumn(0, ii++, fCubeInPos.getX());
+    ana->FillNtupleDColumn(0, ii++, fCubeInPos.getY());
+    ana->FillNtupleDColumn(0, ii++, fCubeInPos.getZ());
+
+    ana->FillNtupleDColumn(0, ii++, fCubeOutPos.getX());
+    ana->FillNtupleDColumn(0, ii++, fCubeOutPos.getY());
+    ana->FillNtupleDColumn(0, ii++, fCubeOutPos.getZ());
+
+    // Cube (i, j) of the nine-cube layer is the one read by npz<i><j>
+    ana->FillNtupleDColumn(0, ii++, fTotalDeposit);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            ana->FillNtupleDColumn(0, ii++, legacy ? GetCubeDeposit(i + 3 * j) : 0);
+        }
+
+    ana->AddNtupleRow(0);
+
+    // One row per channel that saw light
+    std::map<G4int, ChannelHits>::const_iterator it;
+    for (it = fChannelHits.begin(); it != fChannelHits.end(); ++it)
+    {
+        ana->FillNtupleDColumn(1, 0, evt->GetEventID());
+        ana->FillNtupleDColumn(1, 1, it->first);
+        ana->FillNtupleDColumn(1, 2, it->second.photons);
+        ana->FillNtupleDColumn(1, 3, it->second.firstTime);
+        ana->AddNtupleRow(1);
+    }
+
+    // One row per cube with energy deposited
+    std::map<G4int, G4double>::const_iterator dep;
+    for (dep = fCubeDeposits.begin(); dep != fCubeDeposits.end(); ++dep)
+    {
+        ana->FillNtupleDColumn(2, 0, evt->GetEventID());
+        ana->FillNtupleDColumn(2, 1, dep->first);
+        ana->FillNtupleDColumn(2, 2, dep->second);
+        ana->AddNtupleRow(2);
+    }
+
+    // One row per detected photon
+    G4int photons = fRunAction->GetPhotonsNtuple();
+    for (size_t p = 0; photons >= 0 && p < fDetectedPhotons.size(); p++)
+    {
+        const DetectedPhoton& photon = fDetectedPhotons[p];
+        const WLSPhotonHistory& h = photon.history;
+        G4double energyBefore = h.shifts > 0 ? h.energyBefore : photon.energy;
+        int c = 0;
+        ana->FillNtupleDColumn(photons, c++, evt->GetEventID());
+        ana->FillNtupleDColumn(photons, c++, photon.channel);
+        ana->FillNtupleDColumn(photons, c++, photon.time);
+        ana->FillNtupleDColumn(photons, c++, h.cubeReflections);
+        ana->FillNtupleDColumn(photons, c++, h.mirrorReflections);
+        ana->FillNtupleDColumn(photons, c++, h.shifts);
+        ana->FillNtupleDColumn(photons, c++, h.cubePathBefore / mm);
+        ana->FillNtupleDColumn(photons, c++, h.cubePath / mm);
+        ana->FillNtupleDColumn(photons, c++, h.fiberPath / mm);
+        ana->FillNtupleDColumn(photons, c++, h_Planck * c_light / energyBefore / nm);
+        ana->FillNtupleDColumn(photons, c++, h_Planck * c_light / photon.energy / nm);
+        ana->AddNtupleRow(photons);
+    }
+
+    if (fDeferredPDE)
+        FillEfficiencyCurves(evt);
+
+    WLSSharedMemorySink* sink = WLSSharedMemorySink::GetInstance();
+    if (sink->IsOpen())
+    {
+        WLSEventRecord record;
+        FillEventRecord(evt, record);
+        sink->Publish(record);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSEventAction::AddArrivingPhoton(G4int channel, G4double t, G4double energy)
+{
+    ArrivingPhoton photon = { channel, t, energy, G4UniformRand() };
+    fArrivingPhotons.push_back(photon);
+    return photon.u < WLSPhotonDetEfficiency::GetInstance()->GetEfficiency(0, energy);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSEventAction::FillEfficiencyCurves(const G4Event* evt)
+{
+    WLSOutputWriter* ana = fRunAction->GetWriter();
+    G4int pde = fRunAction->GetPDENtuple();
+    G4int arrivals = fRunAction->GetArrivalsNtuple();
+    if (pde < 0)
+        return;
+
+    // One row per curve: the columns of the "cube" ntuple the curve changes
+    WLSPhotonDetEfficiency* curves = WLSPhotonDetEfficiency::GetInstance();
+    G4bool legacy = fDetector->IsNineCubeLayer();
+    for (G4int k = 0; k < curves->GetNumberOfCurves(); k++)
+    {
+        std::map<G4int, G4int> counts;
+        G4int total = 0;
+        for (size_t p = 0; p < fArrivingPhotons.size(); p++)
+        {
+            const ArrivingPhoton& photon = fArrivingPhotons[p];
+            if (photon.u < curves->GetEfficiency(k, photon.energy))
+            {
+                counts[photon.channel]++;
+                total++;
+            }
+        }
+        int c = 0;
+        ana->FillNtupleDColumn(pde, c++, evt->GetEventID());
+        ana->FillNtupleDColumn(pde, c++, k);
+        for (int i = 0; i < 3; i++)
+            ana->FillNtupleDColumn(pde, c++, legacy ? counts[LegacyChannelX(i)] : 0);
+        for (int j = 0; j < 3; j++)
+            ana->FillNtupleDColumn(pde, c++, legacy ? counts[LegacyChannelY(j)] : 0);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                ana->FillNtupleDColumn(pde, c++, legacy ? counts[LegacyChannelZ(i, j)] : 0);
+        ana->FillNtupleDColumn(pde, c++, total);
+        ana->AddNtupleRow(pde);
+    }
+
+    // One row per photon that reached a photon detector, for curves
+    // applied offline
+    for (size_t p = 0; p < fArrivingPhotons.size(); p++)
+    {
+        const ArrivingPhoton& photon = fArrivingPhotons[p];
+        ana->FillNtupleDColumn(arrivals, 0, evt->GetEventID());
+        ana->FillNtupleDColumn(arrivals, 1, photon.channel);
+        ana->FillNtupleDColumn(arrivals, 2, photon.time);
+        ana->FillNtupleDColumn(arrivals, 3, h_Planck * c_light / photon.energy / nm);
+        ana->FillNtupleDColumn(arrivals, 4, photon.u);
+        ana->AddNtupleRow(arrivals);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSEventAction::SetTrigger(const G4String& mode, G4int threshold)
+{
+    if (mode == "none")
+        fTriggerMode = kTriggerNone;
+    else if (mode == "any")
+        fTriggerMode = kTriggerAny;
+    else if (mode == "coincidence")
+        fTriggerMode = kTriggerCoincidence;
+    else if (mode == "total")
+        fTriggerMode = kTriggerTotal;
+    else
+    {
+        G4ExceptionDescription o;
+        o << "Unknown trigger mode " << mode;
+        G4Exception("WLSEventAction::SetTrigger()", "WLSEvent01", JustWarning, o);
+        return;
+    }
+    fTriggerThreshold = threshold;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSEventAction::PassesTrigger() const
+{
+    if (fTriggerMode == kTriggerNone)
+        return true;
+
+    // largest channel of the X, Y and Z views
+    G4int maxView[3] = { 0, 0, 0 };
+    G4int total = 0;
+    std::map<G4int, ChannelHits>::const_iterator it;
+    for (it = fChannelHits.begin(); it != fChannelHits.end(); ++it)
+    {
+        G4int view = fDetector->GetChannelView(it->first);
+        if (view >= 0)
+            maxView[view] = std::max(maxView[view], it->second.photons);
+        total += it->second.photons;
+    }
+    G4int maxX = maxView[0], maxY = maxView[1], maxZ = maxView[2];
 
-    ana->FillNtupleDColumn(ii++, fCubeOutPos.getX());
-    ana->FillNtupleDColumn(ii++, fCubeOutPos.getY());
-    ana->FillNtupleDColumn(ii++, fCubeOutPos.getZ());
+    switch (fTriggerMode)
+    {
+    case kTriggerAny:
+        return std::max(maxX, std::max(maxY, maxZ)) >= fTriggerThreshold;
+    case kTriggerCoincidence:
+        return maxX >= fTriggerThreshold && maxY >= fTriggerThreshold &&
+               maxZ >= fTriggerThreshold;
+    case kTriggerTotal:
+        return total >= fTriggerThreshold;
+    default:
+        return true;
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    ana->AddNtupleRow();
+void WLSEventAction::FillEventRecord(const G4Event* evt, WLSEventRecord& record)
+{
+    G4ThreeVector a = fPrimarysource->GetPrimaryPosition();
+
+    record.eventID = evt->GetEventID();
+    record.runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+    record.energy = fPrimarysource->GetPrimaryEnergy();
+    record.position[0] = a.getX();
+    record.position[1] = a.getY();
+    record.position[2] = a.getZ();
+    record.nPhotons = fStacking->GetOpticalNPhotons();
+    G4bool legacy = fDetector->IsNineCubeLayer();
+    for (int i = 0; i < 3; i++)
+        record.npx[i] = legacy ? GetChannelPhotons(LegacyChannelX(i)) : 0;
+    for (int j = 0; j < 3; j++)
+        record.npy[j] = legacy ? GetChannelPhotons(LegacyChannelY(j)) : 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            record.npz[i][j] = legacy ? GetChannelPhotons(LegacyChannelZ(i, j)) : 0;
+            record.hittimez[i][j] = legacy ? GetChannelFirstTime(LegacyChannelZ(i, j)) : 0;
+        }
+    record.time = fPhottime;
+    record.lasttime = fPhotlasttime;
+    for (int i = 0; i < 3; i++)
+    {
+        record.cubeInPos[i] = fCubeInPos[i];
+        record.cubeOutPos[i] = fCubeOutPos[i];
+    }
+
+    record.nChannelsHit = fChannelHits.size();
+    record.nChannels = 0;
+    std::map<G4int, ChannelHits>::const_iterator it;
+    for (it = fChannelHits.begin();
+         it != fChannelHits.end() && record.nChannels < kWLSShmMaxChannels; ++it)
+    {
+        WLSChannelRecord& channel = record.channels[record.nChannels++];
+        channel.channel = it->first;
+        channel.photons = it->second.photons;
+        channel.firstTime = it->second.firstTime;
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSEventAction::GetChannelPhotons(G4int channel) const
+{
+    std::map<G4int, ChannelHits>::const_iterator it = fChannelHits.find(channel);
+    return it == fChannelHits.end() ? 0 : it->second.photons;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSEventAction::GetChannelFirstTime(G4int channel) const
+{
+    std::map<G4int, ChannelHits>::const_iterator it = fChannelHits.find(channel);
+    return it == fChannelHits.end() ? 0 : it->second.firstTime;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSEventAction::GetCubeDeposit(G4int cube) const
+{
+    std::map<G4int, G4double>::const_iterator it = fCubeDeposits.find(cube);
+    return it == fCubeDeposits.end() ? 0 : it->second;
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -33,6 +33,10 @@
 
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
 
 #include "WLSEventAction.hh"
 #include "WLSEventActionMessenger.hh"
@@ -60,6 +64,24 @@ WLSEventActionMessenger::WLSEventActionMessenger(WLSEventAction* eventaction)
   fPrintCmd->SetParameterName("EventNb",false);
   fPrintCmd->SetRange("EventNb>0");
   fPrintCmd->AvailableForStates(G4State_Idle);
+
+  fTriggerCmd = new G4UIcommand("/WLS/output/trigger",this);
+  fTriggerCmd->SetGuidance("Only write events passing a readout trigger.");
+  fTriggerCmd->SetGuidance("  none        : write every event (default)");
+  fTriggerCmd->SetGuidance("  any         : some channel has >= threshold photons");
+  fTriggerCmd->SetGuidance("  coincidence : X, Y and Z views each have a channel");
+  fTriggerCmd->SetGuidance("                with >= threshold photons");
+  fTriggerCmd->SetGuidance("  total       : all channels together >= threshold");
+  fTriggerCmd->SetGuidance("Rejected events are only counted in the trigger");
+  fTriggerCmd->SetGuidance("histograms.");
+  G4UIparameter* mode = new G4UIparameter("mode",'s',false);
+  mode->SetParameterCandidates("none any coincidence total");
+  fTriggerCmd->SetParameter(mode);
+  G4UIparameter* threshold = new G4UIparameter("threshold",'i',true);
+  threshold->SetDefaultValue(1);
+  threshold->SetParameterRange("threshold>=0");
+  fTriggerCmd->SetParameter(threshold);
+  fTriggerCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -69,6 +91,7 @@ WLSEventActionMessenger::~WLSEventActionMessenger()
   delete fSetVerboseCmd;
   delete fDrawCmd;
   delete fPrintCmd;
+  delete fTriggerCmd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -84,4 +107,12 @@ void WLSEventActionMessenger::SetNewValue(G4UIcommand* command,
 
   if (command == fPrintCmd)
     fEventAction->SetPrintModulo(fPrintCmd->GetNewIntValue(newValue));
+
+  if (command == fTriggerCmd) {
+    std::istringstream is(newValue);
+    G4String mode;
+    G4int threshold = 1;
+    is >> mode >> threshold;
+    fEventAction->SetTrigger(mode, threshold);
+  }
 }
@@ -33,6 +33,7 @@
 
 #include "G4SystemOfUnits.hh"
 
+#include "WLSOpticalTables.hh"
 #include "parameter.hh"
 
 WLSMaterials* WLSMaterials::fInstance = 0;
@@ -229,12 +230,17 @@ void WLSMaterials::CreateMaterials()
     // 476.923  471.483     466.165     460.967  455.882     450.909     446.043  441.281     436.62      432.056
     // 427.586  423.208     418.919     414.716  410.596     406.557     402.597  398.714     394.904     391.167
     // 387.5    383.901     380.368     376.9    373.494     370.149     366.864  363.636     360.465     357.349
-    G4double photonEnergy[] = {
-        2.00 * eV, 2.03 * eV, 2.06 * eV, 2.09 * eV, 2.12 * eV, 2.15 * eV, 2.18 * eV, 2.21 * eV, 2.24 * eV, 2.27 * eV,
-        2.30 * eV, 2.33 * eV, 2.36 * eV, 2.39 * eV, 2.42 * eV, 2.45 * eV, 2.48 * eV, 2.51 * eV, 2.54 * eV, 2.57 * eV,
-        2.60 * eV, 2.63 * eV, 2.66 * eV, 2.69 * eV, 2.72 * eV, 2.75 * eV, 2.78 * eV, 2.81 * eV, 2.84 * eV, 2.87 * eV,
-        2.90 * eV, 2.93 * eV, 2.96 * eV, 2.99 * eV, 3.02 * eV, 3.05 * eV, 3.08 * eV, 3.11 * eV, 3.14 * eV, 3.17 * eV,
-        3.20 * eV, 3.23 * eV, 3.26 * eV, 3.29 * eV, 3.32 * eV, 3.35 * eV, 3.38 * eV, 3.41 * eV, 3.44 * eV, 3.47 * eV };
+    // Air and silicone are flat; every other spectrum comes from
+    // WLSOpticalTables (parameter.hh unless /WLS/setOpticalTables)
+    WLSOpticalTables* tables = WLSOpticalTables::GetInstance();
+    tables->Lock();
+    G4cout << "Optical tables: " << tables->GetSource() << G4endl;
+
+    G4double photonEnergy[NSpectrum];
+    for (int i = 0; i < NSpectrum; i++)
+    {
+        photonEnergy[i] = parameter::photonEnergy[i];
+    }
     const G4int nEntries = sizeof(photonEnergy) / sizeof(G4double);
 
     // ----- Air
@@ -257,72 +263,26 @@ void WLSMaterials::CreateMaterials()
     // https://indico.cern.ch/event/143675/contributions/164201/
     // https://doi.org/10.1016/j.nima.2010.09.027
 
-    G4double refractiveIndexWLSfiber[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        refractiveIndexWLSfiber[i] = parameter::refractiveIndexWLSfiber[i];
-    }
-    assert(sizeof(refractiveIndexWLSfiber) == sizeof(photonEnergy));
-    /* //  default
-       G4double absWLSfiber[] = {
-       5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,
-       5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,
-       5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,5.40*m,1.10*m,
-       1.10*m,1.10*m,1.10*m,1.10*m,1.10*m,1.10*m,1.0*mm,1.0*mm,1.0*mm,1.0*mm,
-       1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm,1.0*mm};
-    */
-    G4double absWLSfiber[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        absWLSfiber[i] = parameter::absWLSfiber[i];
-    }
-
-    G4double emissionFib[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        emissionFib[i] = parameter::emissionFib[i];
-    }
-    assert(sizeof(emissionFib) == sizeof(photonEnergy));
-
     // Add entries into properties table
     G4MaterialPropertiesTable* mptWLSfiber = new G4MaterialPropertiesTable();
-    mptWLSfiber->AddProperty("RINDEX", photonEnergy, refractiveIndexWLSfiber, nEntries);
-    // mptWLSfiber->AddProperty("ABSLENGTH",photonEnergy,absWLSfiber,nEntries);
-    mptWLSfiber->AddProperty("WLSABSLENGTH", photonEnergy, absWLSfiber, nEntries);
-    mptWLSfiber->AddProperty("WLSCOMPONENT", photonEnergy, emissionFib, nEntries);
-    mptWLSfiber->AddConstProperty("WLSTIMECONSTANT", parameter::WLSTime);
+    tables->AddProperty(mptWLSfiber, "RINDEX", "refractiveIndexWLSfiber");
+    // tables->AddProperty(mptWLSfiber, "ABSLENGTH", "absWLSfiber");
+    tables->AddProperty(mptWLSfiber, "WLSABSLENGTH", "absWLSfiber");
+    tables->AddProperty(mptWLSfiber, "WLSCOMPONENT", "emissionFib");
+    mptWLSfiber->AddConstProperty("WLSTIMECONSTANT", tables->GetConstant("WLSTime"));
 
     // ----- PMMA (inner claddig)
     // http://kuraraypsf.jp/pdf/all.pdf
-    G4double refractiveIndexClad1[NSpectrum];
-    G4double absClad[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        refractiveIndexClad1[i] = parameter::refractiveIndexClad1[i];
-        absClad[i] = parameter::absClad[i];
-    }
-    assert(sizeof(refractiveIndexClad1) == sizeof(photonEnergy));
-    assert(sizeof(absClad) == sizeof(photonEnergy));
-
-    // Add entries into properties table
     G4MaterialPropertiesTable* mptClad1 = new G4MaterialPropertiesTable();
-    mptClad1->AddProperty("RINDEX", photonEnergy, refractiveIndexClad1, nEntries);
-    mptClad1->AddProperty("ABSLENGTH", photonEnergy, absClad, nEntries);
+    tables->AddProperty(mptClad1, "RINDEX", "refractiveIndexClad1");
+    tables->AddProperty(mptClad1, "ABSLENGTH", "absClad");
 
 
     // ----- Fluorinated Polyethylene (outer cladding(FP))
     // http://kuraraypsf.jp/pdf/all.pdf
-    G4double refractiveIndexClad2[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        refractiveIndexClad2[i] = parameter::refractiveIndexClad2[i];
-    }
-    assert(sizeof(refractiveIndexClad2) == sizeof(photonEnergy));
-
-    // Add entries into properties table
     G4MaterialPropertiesTable* mptClad2 = new G4MaterialPropertiesTable();
-    mptClad2->AddProperty("RINDEX", photonEnergy, refractiveIndexClad2, nEntries);
-    mptClad2->AddProperty("ABSLENGTH", photonEnergy, absClad, nEntries);
+    tables->AddProperty(mptClad2, "RINDEX", "refractiveIndexClad2");
+    tables->AddProperty(mptClad2, "ABSLENGTH", "absClad");
 
     // ----- set table
     #if 0 // original
@@ -351,7 +311,7 @@ void WLSMaterials::CreateMaterials()
     // Add entries into properties table
     G4MaterialPropertiesTable* mptSilicone = new G4MaterialPropertiesTable();
     mptSilicone->AddProperty("RINDEX", photonEnergy, refractiveIndexSilicone, nEntries);
-    mptSilicone->AddProperty("ABSLENGTH", photonEnergy, absClad, nEntries);
+    tables->AddProperty(mptSilicone, "ABSLENGTH", "absClad");
 
     fSilicone->SetMaterialPropertiesTable(mptSilicone);
 
@@ -361,24 +321,6 @@ void WLSMaterials::CreateMaterials()
     // 476.923  471.483     466.165     460.967  455.882     450.909     446.043  441.281     436.62      432.056
     // 427.586  423.208     418.919     414.716  410.596     406.557     402.597  398.714     394.904     391.167
     // 387.5    383.901     380.368     376.9    373.494     370.149     366.864  363.636     360.465     357.349
-    G4double refractiveIndexPS[] =
-    { 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
-      1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50,
-      1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50, 1.50 };
-    assert(sizeof(refractiveIndexPS) == sizeof(photonEnergy));
-    G4double absPS[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        absPS[i] = parameter::absPS[i];
-    }
-    assert(sizeof(absPS) == sizeof(photonEnergy));
-    G4double scintilFast[NSpectrum];
-    for (int i = 0; i < NSpectrum; i++)
-    {
-        scintilFast[i] = parameter::scintilFast[i];
-    }
-    assert(sizeof(scintilFast) == sizeof(photonEnergy));
-
     // Add entries into properties table
     #if 0 // default
         G4MaterialPropertiesTable* mptPolystyrene = new G4MaterialPropertiesTable();
@@ -391,15 +333,15 @@ void WLSMaterials::CreateMaterials()
     #endif
     #if 1
         G4MaterialPropertiesTable* mptPolystyrene = new G4MaterialPropertiesTable();
-        mptPolystyrene->AddProperty("RINDEX", photonEnergy, refractiveIndexPS, nEntries);
-        mptPolystyrene->AddProperty("ABSLENGTH", photonEnergy, absPS, nEntries);
-        mptPolystyrene->AddProperty("FASTCOMPONENT", photonEnergy, scintilFast, nEntries);
+        tables->AddProperty(mptPolystyrene, "RINDEX", "refractiveIndexPS");
+        tables->AddProperty(mptPolystyrene, "ABSLENGTH", "absPS");
+        tables->AddProperty(mptPolystyrene, "FASTCOMPONENT", "scintilFast");
 
         mptPolystyrene->AddConstProperty("EFFICIENCY", 1);
-        mptPolystyrene->AddConstProperty("SCINTILLATIONYIELD", parameter::scintiLY); // typical pla-scinti ~ 10,000/MeV
+        mptPolystyrene->AddConstProperty("SCINTILLATIONYIELD", tables->GetConstant("scintiLY")); // typical pla-scinti ~ 10,000/MeV
         // mptPolystyrene->AddConstProperty("SCINTILLATIONYIELD",50./keV);
         mptPolystyrene->AddConstProperty("RESOLUTIONSCALE", 1.0);
-        mptPolystyrene->AddConstProperty("FASTTIMECONSTANT", parameter::scintiTime);
+        mptPolystyrene->AddConstProperty("FASTTIMECONSTANT", tables->GetConstant("scintiTime"));
         // mptPolystyrene->AddConstProperty("SLOWTIMECONSTANT",5.*ns);
     #endif
     fPolystyrene->SetMaterialPropertiesTable(mptPolystyrene);
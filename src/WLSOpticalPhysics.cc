@@ -37,19 +37,24 @@
 #include "G4SystemOfUnits.hh"
 
 #include "WLSOpticalPhysics.hh"
+#include "WLSRegionProcess.hh"
+#include "WLSBatchScintillation.hh"
+
+G4ThreadLocal G4OpWLS*             WLSOpticalPhysics::fWLSProcess = NULL;
+G4ThreadLocal G4Cerenkov*          WLSOpticalPhysics::fCerenkovProcess = NULL;
+G4ThreadLocal G4Scintillation*     WLSOpticalPhysics::fScintProcess = NULL;
+G4ThreadLocal G4OpAbsorption*      WLSOpticalPhysics::fAbsorptionProcess = NULL;
+G4ThreadLocal G4OpRayleigh*        WLSOpticalPhysics::fRayleighScattering = NULL;
+G4ThreadLocal G4OpMieHG*           WLSOpticalPhysics::fMieHGScatteringProcess = NULL;
+G4ThreadLocal G4OpBoundaryProcess* WLSOpticalPhysics::fBoundaryProcess = NULL;
 
 WLSOpticalPhysics::WLSOpticalPhysics(G4bool toggle)
     : G4VPhysicsConstructor("Optical")
 {
-  fWLSProcess                = NULL;
-  fScintProcess              = NULL;
-  fCerenkovProcess           = NULL;
-  fBoundaryProcess           = NULL;
-  fAbsorptionProcess         = NULL;
-  fRayleighScattering        = NULL;
-  fMieHGScatteringProcess    = NULL;
-
   fAbsorptionOn              = toggle;
+  fCerenkovOn                = true;
+  fBatchScintOn              = false;
+  fMaxNumPhotons             = 300;
 }
 
 WLSOpticalPhysics::~WLSOpticalPhysics() { }
@@ -70,12 +75,13 @@ void WLSOpticalPhysics::ConstructProcess()
 
   	fWLSProcess = new G4OpWLS();
 
-  	fScintProcess = new G4Scintillation();
+  	if (fBatchScintOn) fScintProcess = new WLSBatchScintillation();
+  	else fScintProcess = new G4Scintillation();
   	fScintProcess->SetScintillationYieldFactor(1.);
   	fScintProcess->SetTrackSecondariesFirst(true);
 
   fCerenkovProcess = new G4Cerenkov();
-  fCerenkovProcess->SetMaxNumPhotonsPerStep(300);
+  fCerenkovProcess->SetMaxNumPhotonsPerStep(fMaxNumPhotons);
   fCerenkovProcess->SetTrackSecondariesFirst(true);
 
   fAbsorptionProcess      = new G4OpAbsorption();
@@ -114,6 +120,13 @@ void WLSOpticalPhysics::ConstructProcess()
   G4EmSaturation* emSaturation = G4LossTableManager::Instance()->EmSaturation();
   fScintProcess->AddSaturation(emSaturation);
 
+  // Both go through a region filter (WLSRegionProcess) of this thread,
+  // which follows the switches shared by all threads
+  WLSRegionProcess* cerenkovFilter =
+                new WLSRegionProcess(fCerenkovProcess, &fCerenkovSwitches);
+  WLSRegionProcess* scintFilter =
+                new WLSRegionProcess(fScintProcess, &fScintSwitches);
+
   //G4ParticleTable::G4PTblDicIterator* aParticleIterator = GetParticleIterator();
   aParticleIterator->reset();
   while ( (*aParticleIterator)() ){
@@ -129,14 +142,14 @@ void WLSOpticalPhysics::ConstructProcess()
                     FatalException,o.str().c_str());
     }
 
-    if(fCerenkovProcess->IsApplicable(*particle)){
-      pManager->AddProcess(fCerenkovProcess);
-      pManager->SetProcessOrdering(fCerenkovProcess,idxPostStep);
+    if(fCerenkovOn && fCerenkovProcess->IsApplicable(*particle)){
+      pManager->AddProcess(cerenkovFilter);
+      pManager->SetProcessOrdering(cerenkovFilter,idxPostStep);
     }
     if(fScintProcess->IsApplicable(*particle)){
-      pManager->AddProcess(fScintProcess);
-      pManager->SetProcessOrderingToLast(fScintProcess,idxAtRest);
-      pManager->SetProcessOrderingToLast(fScintProcess,idxPostStep);
+      pManager->AddProcess(scintFilter);
+      pManager->SetProcessOrderingToLast(scintFilter,idxAtRest);
+      pManager->SetProcessOrderingToLast(scintFilter,idxPostStep);
     }
 
   }
@@ -144,5 +157,37 @@ void WLSOpticalPhysics::ConstructProcess()
 
 void WLSOpticalPhysics::SetNbOfPhotonsCerenkov(G4int maxNumber)
 {
-  fCerenkovProcess->SetMaxNumPhotonsPerStep(maxNumber);
+  // taken by the process of every thread in ConstructProcess()
+  fMaxNumPhotons = maxNumber;
+}
+
+void WLSOpticalPhysics::SetCerenkovInRegion(const G4String& region, G4bool on)
+{
+  fCerenkovRegions[region] = on;
+  fCerenkovSwitches.SetActive(region, fCerenkovOn && on);
+}
+
+void WLSOpticalPhysics::SetScintillationInRegion(const G4String& region, G4bool on)
+{
+  fScintSwitches.SetActive(region, on);
+}
+
+void WLSOpticalPhysics::SetCerenkov(G4bool on)
+{
+  fCerenkovOn = on;
+  // Once added, the process is switched off in every region instead
+  fCerenkovSwitches.SetActive(on);
+  std::map<G4String, G4bool>::const_iterator r;
+  for (r = fCerenkovRegions.begin(); r != fCerenkovRegions.end(); ++r)
+    fCerenkovSwitches.SetActive(r->first, on && r->second);
+}
+
+void WLSOpticalPhysics::CopySwitches(const WLSOpticalPhysics& other)
+{
+  fCerenkovOn = other.fCerenkovOn;
+  fBatchScintOn = other.fBatchScintOn;
+  fMaxNumPhotons = other.fMaxNumPhotons;
+  fCerenkovRegions = other.fCerenkovRegions;
+  fCerenkovSwitches.Set(other.fCerenkovSwitches);
+  fScintSwitches.Set(other.fScintSwitches);
 }
@@ -0,0 +1,363 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSOpticalTables.cc
+/// \brief Implementation of the WLSOpticalTables class
+//
+//
+#include "WLSOpticalTables.hh"
+
+#include "G4MaterialPropertiesTable.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "parameter.hh"
+
+#include <fstream>
+#include <sstream>
+
+WLSOpticalTables* WLSOpticalTables::fInstance = 0;
+
+namespace {
+
+// Value of a unit name: "1" for none, "/unit" for its inverse, 0 if unknown
+G4double UnitValue(const G4String& unit)
+{
+    if (unit == "1")
+        return 1.;
+    G4bool inverse = (unit[0] == '/');
+    G4String name = inverse ? unit.substr(1) : unit;
+    if (!G4UnitDefinition::IsUnitDefined(name))
+        return 0.;
+    G4double value = G4UnitDefinition::GetValueOf(name);
+    return inverse ? 1. / value : value;
+}
+
+void Fail(const G4String& fileName, G4int line, const G4String& what)
+{
+    G4ExceptionDescription o;
+    o << fileName << ":" << line << ": " << what;
+    G4Exception("WLSOpticalTables::Load()", "WLSTables01", FatalException, o);
+}
+
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSOpticalTables::WLSOpticalTables() : fSource("compiled-in"), fLocked(false)
+{
+    const G4double* e = parameter::photonEnergy;
+    SetDefault("absPS", e, parameter::absPS, NSpectrum);
+    SetDefault("scintilFast", e, parameter::scintilFast, NSpectrum);
+    SetDefault("refractiveIndexPS", e, parameter::refractiveIndexPS, NSpectrum);
+    SetDefault("absWLSfiber", e, parameter::absWLSfiber, NSpectrum);
+    SetDefault("emissionFib", e, parameter::emissionFib, NSpectrum);
+    SetDefault("refractiveIndexWLSfiber", e, parameter::refractiveIndexWLSfiber, NSpectrum);
+    SetDefault("absClad", e, parameter::absClad, NSpectrum);
+    SetDefault("refractiveIndexClad1", e, parameter::refractiveIndexClad1, NSpectrum);
+    SetDefault("refractiveIndexClad2", e, parameter::refractiveIndexClad2, NSpectrum);
+    SetDefault("effi_mppc", parameter::photonEnergy_mppc, parameter::effi_mppc, NSpectrumMPPC);
+
+    fConstants["scintiLY"] = parameter::scintiLY;
+    fConstants["scintiTime"] = parameter::scintiTime;
+    fConstants["WLSTime"] = parameter::WLSTime;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSOpticalTables* WLSOpticalTables::GetInstance()
+{
+    if (fInstance == 0)
+        fInstance = new WLSOpticalTables();
+    return fInstance;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSOpticalTables::SetDefault(const G4String& name, const G4double* energy,
+                                  const G4double* value, G4int n)
+{
+    Table& table = fTables[name];
+    table.energy.assign(energy, energy + n);
+    table.value.assign(value, value + n);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String WLSOpticalTables::Check(const G4String& name, const Table& table)
+{
+    if (table.energy.size() < 2)
+        return "fewer than 2 points";
+    for (size_t i = 0; i < table.energy.size(); i++)
+    {
+        if (table.energy[i] <= 0 || (i > 0 && table.energy[i] <= table.energy[i - 1]))
+            return "energies must be positive and increasing";
+    }
+
+    G4double sum = 0;
+    for (size_t i = 0; i < table.value.size(); i++)
+    {
+        G4double v = table.value[i];
+        if (name.compare(0, 3, "abs") == 0 && v <= 0)
+            return "lengths must be positive";
+        if (name.compare(0, 15, "refractiveIndex") == 0 && v < 1)
+            return "refractive indices must be at least 1";
+        if (name == "effi_mppc" && (v < 0 || v > 1))
+            return "efficiencies must be within [0, 1]";
+        if (v < 0)
+            return "values must not be negative";
+        sum += v;
+    }
+    if (sum <= 0)
+        return "all values are 0";
+    return "";
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSOpticalTables::Load(const G4String& fileName)
+{
+    if (fLocked)
+    {
+        G4ExceptionDescription o;
+        o << "The materials are built already, " << fileName << " ignored";
+        G4Exception("WLSOpticalTables::Load()", "WLSTables02", JustWarning, o);
+        return;
+    }
+
+    // Everything is read and checked before anything is replaced
+    std::map<G4String, Table> tables;
+    std::map<G4String, G4double> constants;
+    if (!Read(fileName, tables, constants))
+        return;
+
+    for (std::map<G4String, Table>::const_iterator t = tables.begin(); t != tables.end(); ++t)
+        fTables[t->first] = t->second;
+    for (std::map<G4String, G4double>::const_iterator c = constants.begin(); c != constants.end(); ++c)
+        fConstants[c->first] = c->second;
+    fSource = fileName;
+    G4cout << "Optical tables: " << tables.size() << " tables and " << constants.size()
+           << " constants from " << fileName << G4endl;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSOpticalTables::Table WLSOpticalTables::ReadTable(const G4String& fileName,
+                                                    const G4String& name) const
+{
+    std::map<G4String, Table> tables;
+    std::map<G4String, G4double> constants;
+    if (!Read(fileName, tables, constants))
+        return Table();
+    std::map<G4String, Table>::const_iterator t = tables.find(name);
+    if (t == tables.end())
+    {
+        Fail(fileName, 0, "has no table " + name);
+        return Table();
+    }
+    return t->second;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSOpticalTables::Read(const G4String& fileName, std::map<G4String, Table>& tables,
+                              std::map<G4String, G4double>& constants) const
+{
+    std::ifstream in(fileName);
+    if (!in)
+    {
+        Fail(fileName, 0, "cannot be read");
+        return false;
+    }
+
+    G4String tableName;
+    G4double energyUnit = 0, valueUnit = 0;
+    G4int version = 0;
+
+    std::string text;
+    for (G4int line = 1; std::getline(in, text); line++)
+    {
+        size_t comment = text.find('#');
+        if (comment != std::string::npos)
+            text.erase(comment);
+        std::istringstream is(text);
+        std::string word;
+        if (!(is >> word))
+            continue;
+
+        if (version == 0)
+        {
+            if (word != "wls-optical-tables" || !(is >> version) || version != 1)
+            {
+                Fail(fileName, line, "not a version 1 wls-optical-tables file");
+                return false;
+            }
+            continue;
+        }
+
+        if (tableName != "")
+        {
+            if (word == "end")
+            {
+                G4String why = Check(tableName, tables[tableName]);
+                if (why != "")
+                {
+                    Fail(fileName, line, "table " + tableName + ": " + why);
+                    return false;
+                }
+                tableName = "";
+                continue;
+            }
+            std::istringstream row(text);
+            G4double energy, value;
+            std::string rest;
+            if (!(row >> energy >> value) || (row >> rest))
+            {
+                Fail(fileName, line, "expected: energy value");
+                return false;
+            }
+            tables[tableName].energy.push_back(energy * energyUnit);
+            tables[tableName].value.push_back(value * valueUnit);
+        }
+        else if (word == "table")
+        {
+            std::string name, eunit, vunit;
+            is >> name >> eunit >> vunit;
+            if (fTables.find(name) == fTables.end())
+            {
+                Fail(fileName, line, "unknown table '" + name + "'");
+                return false;
+            }
+            energyUnit = UnitValue(eunit);
+            valueUnit = vunit == "" ? 0. : UnitValue(vunit);
+            if (energyUnit <= 0 || valueUnit <= 0)
+            {
+                Fail(fileName, line, "expected: table name energyUnit valueUnit");
+                return false;
+            }
+            tableName = name;
+            tables[tableName] = Table();
+        }
+        else if (word == "const")
+        {
+            std::string name, unit;
+            G4double value = 0;
+            is >> name >> value >> unit;
+            if (fConstants.find(name) == fConstants.end())
+            {
+                Fail(fileName, line, "unknown constant '" + name + "'");
+                return false;
+            }
+            G4double scale = unit == "" ? 0. : UnitValue(unit);
+            if (scale <= 0 || value <= 0)
+            {
+                Fail(fileName, line, "expected: const name value unit, value > 0");
+                return false;
+            }
+            constants[name] = value * scale;
+        }
+        else
+        {
+            Fail(fileName, line, "unexpected '" + word + "'");
+            return false;
+        }
+    }
+    if (version == 0 || tableName != "")
+    {
+        Fail(fileName, 0, version == 0 ? "is empty" : "table " + tableName + " has no end");
+        return false;
+    }
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const WLSOpticalTables::Table& WLSOpticalTables::GetTable(const G4String& name) const
+{
+    std::map<G4String, Table>::const_iterator t = fTables.find(name);
+    if (t == fTables.end())
+    {
+        G4ExceptionDescription o;
+        o << "No optical table " << name;
+        G4Exception("WLSOpticalTables::GetTable()", "WLSTables01", FatalException, o);
+    }
+    return t->second;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSOpticalTables::Lock()
+{
+    if (fLocked)
+        return;
+    fLocked = true;
+    const char* spectra[] = { "scintilFast", "emissionFib" };
+    for (size_t i = 0; i < sizeof(spectra) / sizeof(spectra[0]); i++)
+    {
+        const Table& table = GetTable(spectra[i]);
+        fSamplers[spectra[i]].Build(table.energy, table.value);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const WLSAliasTable& WLSOpticalTables::GetSampler(const G4String& name) const
+{
+    std::map<G4String, WLSAliasTable>::const_iterator s = fSamplers.find(name);
+    if (s == fSamplers.end() || s->second.IsEmpty())
+    {
+        G4ExceptionDescription o;
+        o << "No spectrum sampler for " << name
+          << (fLocked ? "" : " (the optical tables are not locked yet)");
+        G4Exception("WLSOpticalTables::GetSampler()", "WLSTables03", FatalException, o);
+    }
+    return s->second;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSOpticalTables::GetConstant(const G4String& name) const
+{
+    std::map<G4String, G4double>::const_iterator c = fConstants.find(name);
+    if (c == fConstants.end())
+    {
+        G4ExceptionDescription o;
+        o << "No optical constant " << name;
+        G4Exception("WLSOpticalTables::GetConstant()", "WLSTables01", FatalException, o);
+        return 0;
+    }
+    return c->second;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSOpticalTables::AddProperty(G4MaterialPropertiesTable* mpt, const G4String& key,
+                                   const G4String& name) const
+{
+    // G4MaterialPropertiesTable copies the values into its own vector
+    const Table& table = GetTable(name);
+    mpt->AddProperty(key, const_cast<G4double*>(&table.energy[0]),
+                     const_cast<G4double*>(&table.value[0]), table.energy.size());
+}
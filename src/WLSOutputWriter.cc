@@ -0,0 +1,48 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSOutputWriter.cc
+/// \brief Implementation of the WLSOutputWriter class
+//
+//
+#include "WLSOutputWriter.hh"
+#include "WLSAnalysisManagerWriter.hh"
+#include "WLSColumnarWriter.hh"
+
+#include "G4RootAnalysisManager.hh"
+#include "G4CsvAnalysisManager.hh"
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSOutputWriter* WLSOutputWriter::Create(const G4String& format)
+{
+    if (format == "root")
+        return new WLSAnalysisManagerWriter(G4RootAnalysisManager::Instance());
+    if (format == "csv")
+        return new WLSAnalysisManagerWriter(G4CsvAnalysisManager::Instance());
+    if (format == "bin")
+        return new WLSColumnarWriter();
+    return 0;
+}
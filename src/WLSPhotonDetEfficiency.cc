@@ -0,0 +1,108 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSPhotonDetEfficiency.cc
+/// \brief Implementation of the WLSPhotonDetEfficiency class
+//
+//
+#include "WLSPhotonDetEfficiency.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+
+WLSPhotonDetEfficiency* WLSPhotonDetEfficiency::fInstance = 0;
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSPhotonDetEfficiency::WLSPhotonDetEfficiency()
+{
+    fNames.push_back("default");
+    fDefault = &WLSOpticalTables::GetInstance()->GetTable("effi_mppc");
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSPhotonDetEfficiency* WLSPhotonDetEfficiency::GetInstance()
+{
+    if (fInstance == 0)
+        fInstance = new WLSPhotonDetEfficiency();
+    return fInstance;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhotonDetEfficiency::AddCurve(const G4String& name, const G4String& fileName)
+{
+    WLSOpticalTables::Table curve = WLSOpticalTables::GetInstance()->ReadTable(fileName, "effi_mppc");
+    if (curve.energy.empty())
+        return;
+
+    std::vector<G4String>::iterator it = std::find(fNames.begin(), fNames.end(), name);
+    if (it == fNames.begin())
+    {
+        G4ExceptionDescription o;
+        o << "Curve 0 is the effi_mppc table in use (/WLS/setOpticalTables), "
+          << fileName << " ignored";
+        G4Exception("WLSPhotonDetEfficiency::AddCurve()", "WLSPDE01", JustWarning, o);
+        return;
+    }
+    if (it != fNames.end())
+        fCurves[it - fNames.begin() - 1] = curve;
+    else
+    {
+        fNames.push_back(name);
+        fCurves.push_back(curve);
+    }
+    G4cout << "Photon detection efficiency " << name << " from " << fileName << G4endl;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSPhotonDetEfficiency::GetEfficiency(G4int curve, G4double energy) const
+{
+    const WLSOpticalTables::Table& t = curve == 0 ? *fDefault : fCurves[curve - 1];
+    const std::vector<G4double>& e = t.energy;
+    if (energy <= e.front())
+        return t.value.front();
+    if (energy >= e.back())
+        return t.value.back();
+    size_t i = std::upper_bound(e.begin(), e.end(), energy) - e.begin();
+    G4double f = (energy - e[i - 1]) / (e[i] - e[i - 1]);
+    return t.value[i - 1] + f * (t.value[i] - t.value[i - 1]);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhotonDetEfficiency::Print() const
+{
+    G4cout << "Photon detection efficiency curves (\"pde\" ntuple):" << G4endl;
+    for (size_t k = 0; k < fNames.size(); k++)
+    {
+        const WLSOpticalTables::Table& t = k == 0 ? *fDefault : fCurves[k - 1];
+        G4cout << "  " << k << "  " << fNames[k] << "  " << t.energy.size() << " points, "
+               << t.energy.front() / eV << " - " << t.energy.back() / eV << " eV" << G4endl;
+    }
+}
@@ -64,6 +64,11 @@
 
 #include "G4SystemOfUnits.hh"
 
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
+
 #include "G4Scintillation.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4OpticalProcessIndex.hh"
@@ -102,6 +107,7 @@ WLSPhysicsList::WLSPhysicsList(G4String physName) : G4VModularPhysicsList()
  	}
 
     fAbsorptionOn = true;
+    fOpticalOn = true;
     
     //This looks complex, but it is not:
     //Get from base-class the pointer of the phsyicsVector
@@ -256,14 +262,33 @@ void WLSPhysicsList::RemoveFromPhysicsList(const G4String& name)
 void WLSPhysicsList::SetAbsorption(G4bool toggle)
 {
        fAbsorptionOn = toggle;
+       WLSOpticalPhysics* old = fOpticalPhysics;
+       fOpticalPhysics = new WLSOpticalPhysics(toggle);
+       fOpticalPhysics->CopySwitches(*old);
+       // Without optical physics the new one waits for SetOptical(true)
+       if (!fOpticalOn) return;
        RemoveFromPhysicsList("Optical");
-       fPhysicsVector->
-                    push_back(fOpticalPhysics = new WLSOpticalPhysics(toggle));
+       fPhysicsVector->push_back(fOpticalPhysics);
        fOpticalPhysics->ConstructProcess();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void WLSPhysicsList::SetOptical(G4bool on)
+{
+    if (on == fOpticalOn) return;
+    fOpticalOn = on;
+    // The constructor is kept, so the Cerenkov and scintillation switches
+    // survive switching it off and on again
+    if (on)
+       fPhysicsVector->push_back(fOpticalPhysics);
+    else
+       RemoveFromPhysicsList("Optical");
+    G4cout << "WLSPhysicsList: optical physics " << (on ? "on" : "off") << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void WLSPhysicsList::SetCuts()
 {
     if (verboseLevel >0) {
@@ -278,6 +303,8 @@ void WLSPhysicsList::SetCuts()
     SetCutValue(fCutForElectron, "e-");
     SetCutValue(fCutForPositron, "e+");
 
+    ApplyRegionSettings();
+
     if (verboseLevel>0) DumpCutValuesTable();
 }
 
@@ -314,6 +341,59 @@ void WLSPhysicsList::SetStepMax(G4double step)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void WLSPhysicsList::SetRegionCut(const G4String& region, G4double cut)
+{
+    if (region == "World" || region == "DefaultRegionForTheWorld") {
+       SetCutForGamma(cut);
+       SetCutForElectron(cut);
+       SetCutForPositron(cut);
+       return;
+    }
+    fRegionCuts[region] = cut;
+    ApplyRegionSettings();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::SetRegionStepMax(const G4String& region, G4double step)
+{
+    fRegionStepMax[region == "World" ? G4String("DefaultRegionForTheWorld") : region] = step;
+    ApplyRegionSettings();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::ApplyRegionSettings()
+{
+    G4RegionStore* store = G4RegionStore::GetInstance();
+
+    std::map<G4String, G4double>::const_iterator i;
+    for (i = fRegionCuts.begin(); i != fRegionCuts.end(); ++i) {
+        G4Region* region = store->GetRegion(i->first, false);
+        if (!region) continue;
+        // A region without cuts of its own may share those of the world
+        // region (G4RunManagerKernel::CheckRegions), so never change them
+        // in place
+        G4ProductionCuts* cuts = region->GetProductionCuts();
+        if (cuts && cuts != store->GetRegion("DefaultRegionForTheWorld")->GetProductionCuts()
+                 && cuts->GetProductionCut(0) == i->second) continue;
+        cuts = new G4ProductionCuts();
+        cuts->SetProductionCut(i->second);
+        region->SetProductionCuts(cuts);
+    }
+
+    for (i = fRegionStepMax.begin(); i != fRegionStepMax.end(); ++i) {
+        G4Region* region = store->GetRegion(i->first, false);
+        if (!region) continue;
+        if (region->GetUserLimits())
+            region->GetUserLimits()->SetMaxAllowedStep(i->second);
+        else
+            region->SetUserLimits(new G4UserLimits(i->second));
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 WLSStepMax* WLSPhysicsList::GetStepMaxProcess()
 {
   return fStepMaxProcess;
@@ -341,17 +421,66 @@ void WLSPhysicsList::AddStepMax()
 
 void WLSPhysicsList::SetNbOfPhotonsCerenkov(G4int maxNumber)
 {
+   // Only stored (before /run/initialize): safe with optical physics off
    fOpticalPhysics->SetNbOfPhotonsCerenkov(maxNumber);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void WLSPhysicsList::SetCerenkovInRegion(const G4String& region, G4bool on)
+{
+   fOpticalPhysics->SetCerenkovInRegion(
+       region == "World" ? G4String("DefaultRegionForTheWorld") : region, on);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::SetScintillationInRegion(const G4String& region, G4bool on)
+{
+   fOpticalPhysics->SetScintillationInRegion(
+       region == "World" ? G4String("DefaultRegionForTheWorld") : region, on);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::SetCerenkov(G4bool on)
+{
+   fOpticalPhysics->SetCerenkov(on);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::SetBatchScintillation(G4bool on)
+{
+   fOpticalPhysics->SetBatchScintillation(on);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPhysicsList::WriteResponseParameters(std::ostream& os) const
+{
+   os << "optical " << fOpticalOn << "\n"
+      << "absorption " << fAbsorptionOn << "\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void WLSPhysicsList::SetVerbose(G4int verbose)
 {
-   fOpticalPhysics->GetCerenkovProcess()->SetVerboseLevel(verbose);
-   fOpticalPhysics->GetScintillationProcess()->SetVerboseLevel(verbose);
-   fOpticalPhysics->GetAbsorptionProcess()->SetVerboseLevel(verbose);
-   fOpticalPhysics->GetRayleighScatteringProcess()->SetVerboseLevel(verbose);
-   fOpticalPhysics->GetMieHGScatteringProcess()->SetVerboseLevel(verbose);
-   fOpticalPhysics->GetBoundaryProcess()->SetVerboseLevel(verbose);
+   // The optical processes exist only once WLSOpticalPhysics is constructed
+   if (!fOpticalOn) {
+      G4cout << "WLSPhysicsList: optical physics off, no verbose level set"
+             << G4endl;
+      return;
+   }
+   G4VProcess* processes[] = {
+      fOpticalPhysics->GetCerenkovProcess(),
+      fOpticalPhysics->GetScintillationProcess(),
+      fOpticalPhysics->GetAbsorptionProcess(),
+      fOpticalPhysics->GetRayleighScatteringProcess(),
+      fOpticalPhysics->GetMieHGScatteringProcess(),
+      fOpticalPhysics->GetBoundaryProcess()
+   };
+   for (size_t i = 0; i < sizeof(processes) / sizeof(processes[0]); i++)
+      if (processes[i]) processes[i]->SetVerboseLevel(verbose);
 }
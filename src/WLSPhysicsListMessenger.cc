@@ -40,6 +40,9 @@
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithoutParameter.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
 
 #include "G4PhaseSpaceDecayChannel.hh"
 #include "G4PionRadiativeDecayChannel.hh"
@@ -67,9 +70,10 @@ WLSPhysicsListMessenger::WLSPhysicsListMessenger(WLSPhysicsList* pPhys)
     fCerenkovCmd =
                 new G4UIcmdWithAnInteger("/WLS/phys/cerenkovMaxPhotons",this);
     fCerenkovCmd->SetGuidance("set max nb of photons per step");
+    fCerenkovCmd->SetGuidance("(before /run/initialize, for every thread)");
     fCerenkovCmd->SetParameterName("MaxNumber",false);
     fCerenkovCmd->SetRange("MaxNumber>=0");
-    fCerenkovCmd->AvailableForStates(G4State_Idle);
+    fCerenkovCmd->AvailableForStates(G4State_PreInit);
 
     fGammaCutCMD = new G4UIcmdWithADoubleAndUnit("/WLS/phys/gammaCut",this);
     fGammaCutCMD->SetGuidance("Set gamma cut");
@@ -111,6 +115,75 @@ WLSPhysicsListMessenger::WLSPhysicsListMessenger(WLSPhysicsList* pPhys)
     fStepMaxCMD->SetDefaultUnit("mm");
     fStepMaxCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
 
+    fRegionCutCMD = new G4UIcommand("/WLS/phys/regionCut",this);
+    fRegionCutCMD->SetGuidance("Set the production cut of one region:");
+    fRegionCutCMD->SetGuidance("CubeArray, Fibers, Readout or World");
+    G4UIparameter* param = new G4UIparameter("region",'s',false);
+    param->SetParameterCandidates("CubeArray Fibers Readout World");
+    fRegionCutCMD->SetParameter(param);
+    param = new G4UIparameter("cut",'d',false);
+    param->SetParameterRange("cut>0.0");
+    fRegionCutCMD->SetParameter(param);
+    param = new G4UIparameter("unit",'s',true);
+    param->SetDefaultValue("mm");
+    fRegionCutCMD->SetParameter(param);
+    fRegionCutCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    fRegionStepMaxCMD = new G4UIcommand("/WLS/phys/regionStepMax",this);
+    fRegionStepMaxCMD->SetGuidance("Set max. step length of charged particles");
+    fRegionStepMaxCMD->SetGuidance("in one region; overrides /WLS/phys/stepMax there");
+    param = new G4UIparameter("region",'s',false);
+    param->SetParameterCandidates("CubeArray Fibers Readout World");
+    fRegionStepMaxCMD->SetParameter(param);
+    param = new G4UIparameter("mxStep",'d',false);
+    param->SetParameterRange("mxStep>0.0");
+    fRegionStepMaxCMD->SetParameter(param);
+    param = new G4UIparameter("unit",'s',true);
+    param->SetDefaultValue("mm");
+    fRegionStepMaxCMD->SetParameter(param);
+    fRegionStepMaxCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    fCerenkovOnCMD = new G4UIcmdWithABool("/WLS/phys/cerenkov",this);
+    fCerenkovOnCMD->SetGuidance("Produce Cerenkov photons (default true).");
+    fCerenkovOnCMD->SetGuidance("false before /run/initialize does not even");
+    fCerenkovOnCMD->SetGuidance("add the process.");
+    fCerenkovOnCMD->SetParameterName("on",false);
+    fCerenkovOnCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    fRegionCerenkovCMD = new G4UIcommand("/WLS/phys/regionCerenkov",this);
+    fRegionCerenkovCMD->SetGuidance("Switch Cerenkov photons on or off in a region");
+    param = new G4UIparameter("region",'s',false);
+    param->SetParameterCandidates("CubeArray Fibers Readout World");
+    fRegionCerenkovCMD->SetParameter(param);
+    param = new G4UIparameter("on",'b',false);
+    fRegionCerenkovCMD->SetParameter(param);
+    fRegionCerenkovCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    fRegionScintCMD = new G4UIcommand("/WLS/phys/regionScintillation",this);
+    fRegionScintCMD->SetGuidance("Switch scintillation on or off in a region");
+    param = new G4UIparameter("region",'s',false);
+    param->SetParameterCandidates("CubeArray Fibers Readout World");
+    fRegionScintCMD->SetParameter(param);
+    param = new G4UIparameter("on",'b',false);
+    fRegionScintCMD->SetParameter(param);
+    fRegionScintCMD->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    fOpticalCMD = new G4UIcmdWithAString("/WLS/phys/optical",this);
+    fOpticalCMD->SetGuidance("on (default): full optical physics.");
+    fOpticalCMD->SetGuidance("off: no optical photons at all, for beam and");
+    fOpticalCMD->SetGuidance("geometry checks; the ntuple then only has the");
+    fOpticalCMD->SetGuidance("energy deposits and the cube entry/exit points.");
+    fOpticalCMD->SetParameterName("mode",false);
+    fOpticalCMD->SetCandidates("on off");
+    fOpticalCMD->AvailableForStates(G4State_PreInit);
+
+    fBatchScintCMD = new G4UIcmdWithABool("/WLS/phys/batchScintillation",this);
+    fBatchScintCMD->SetGuidance("Make the scintillation photons of a step in");
+    fBatchScintCMD->SetGuidance("batches (default false): same distributions,");
+    fBatchScintCMD->SetGuidance("different random sequence than G4Scintillation.");
+    fBatchScintCMD->SetParameterName("on",false);
+    fBatchScintCMD->AvailableForStates(G4State_PreInit);
+
     fClearPhysicsCMD =
                   new G4UIcmdWithoutParameter("/WLS/phys/clearPhysics",this);
     fClearPhysicsCMD->SetGuidance("Clear the physics list");
@@ -150,6 +223,14 @@ WLSPhysicsListMessenger::~WLSPhysicsListMessenger()
     delete fElectCutCMD;
     delete fPosCutCMD;
     delete fAllCutCMD;
+    delete fStepMaxCMD;
+    delete fRegionCutCMD;
+    delete fRegionStepMaxCMD;
+    delete fCerenkovOnCMD;
+    delete fRegionCerenkovCMD;
+    delete fRegionScintCMD;
+    delete fOpticalCMD;
+    delete fBatchScintCMD;
 
     delete fClearPhysicsCMD;
     delete fRemovePhysicsCMD;
@@ -224,6 +305,35 @@ void WLSPhysicsListMessenger::SetNewValue(G4UIcommand* command,
         fPhysicsList->SetStepMax(fStepMaxCMD
                                      ->GetNewDoubleValue(newValue));
     }
+    else if (command == fRegionCutCMD || command == fRegionStepMaxCMD) {
+        std::istringstream is(newValue);
+        G4String region, unit;
+        G4double value;
+        is >> region >> value >> unit;
+        value *= G4UIcommand::ValueOf(unit);
+        if (command == fRegionCutCMD)
+            fPhysicsList->SetRegionCut(region, value);
+        else
+            fPhysicsList->SetRegionStepMax(region, value);
+    }
+    else if (command == fCerenkovOnCMD) {
+        fPhysicsList->SetCerenkov(fCerenkovOnCMD->GetNewBoolValue(newValue));
+    }
+    else if (command == fRegionCerenkovCMD || command == fRegionScintCMD) {
+        std::istringstream is(newValue);
+        G4String region, on;
+        is >> region >> on;
+        if (command == fRegionCerenkovCMD)
+            fPhysicsList->SetCerenkovInRegion(region, G4UIcommand::ConvertToBool(on));
+        else
+            fPhysicsList->SetScintillationInRegion(region, G4UIcommand::ConvertToBool(on));
+    }
+    else if (command == fOpticalCMD) {
+        fPhysicsList->SetOptical(newValue == "on");
+    }
+    else if (command == fBatchScintCMD) {
+        fPhysicsList->SetBatchScintillation(fBatchScintCMD->GetNewBoolValue(newValue));
+    }
     else if (command == fClearPhysicsCMD) {
         fPhysicsList->ClearPhysics();
     }
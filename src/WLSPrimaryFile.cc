@@ -0,0 +1,142 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSPrimaryFile.cc
+/// \brief Implementation of the WLSPrimaryFile class
+//
+//
+#include "WLSPrimaryFile.hh"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSPrimaryFile::WLSPrimaryFile()
+    : fMap(0), fMapSize(0), fRecords(0), fCount(0)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSPrimaryFile::~WLSPrimaryFile()
+{
+    Close();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSPrimaryFile::Open(const G4String& fileName)
+{
+    Close();
+
+    G4ExceptionDescription o;
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        o << "Cannot open " << fileName;
+        if (fd >= 0)
+            close(fd);
+        G4Exception("WLSPrimaryFile::Open()", "WLSGun03", JustWarning, o);
+        return false;
+    }
+    if (st.st_size < (off_t) sizeof(WLSPrimaryFileHeader))
+    {
+        close(fd);
+        o << fileName << " is not a primary event file (too short)";
+        G4Exception("WLSPrimaryFile::Open()", "WLSGun03", JustWarning, o);
+        return false;
+    }
+    void* map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        o << "Cannot map " << fileName;
+        G4Exception("WLSPrimaryFile::Open()", "WLSGun03", JustWarning, o);
+        return false;
+    }
+
+    const WLSPrimaryFileHeader* header = static_cast<const WLSPrimaryFileHeader*>(map);
+    if (std::memcmp(header->magic, kWLSPrimaryMagic, sizeof(kWLSPrimaryMagic)) != 0 ||
+        header->version != kWLSPrimaryVersion ||
+        header->recordSize != sizeof(WLSPrimaryRecord) ||
+        header->count == 0 ||
+        header->count > ((uint64_t) st.st_size - sizeof(WLSPrimaryFileHeader)) / sizeof(WLSPrimaryRecord))
+    {
+        munmap(map, st.st_size);
+        o << fileName << " is not a primary event file of version " << kWLSPrimaryVersion
+          << ", or it is empty or truncated";
+        G4Exception("WLSPrimaryFile::Open()", "WLSGun03", JustWarning, o);
+        return false;
+    }
+
+    fFileName = fileName;
+    fMap = map;
+    fMapSize = st.st_size;
+    fCount = header->count;
+    fRecords = reinterpret_cast<const WLSPrimaryRecord*>(
+        static_cast<const char*>(map) + sizeof(WLSPrimaryFileHeader));
+
+    // the records are read in order once to find the events; this also
+    // brings the file into the page cache
+    madvise(map, fMapSize, MADV_SEQUENTIAL);
+    for (uint64_t k = 0; k < fCount; k++)
+        if (k == 0 || fRecords[k].event != fRecords[k - 1].event)
+            fEventStart.push_back(k);
+    madvise(map, fMapSize, MADV_RANDOM);
+
+    G4cout << "Primary events: " << fEventStart.size() << " events, " << fCount
+           << " primaries from " << fileName << G4endl;
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPrimaryFile::Close()
+{
+    if (fMap)
+        munmap(fMap, fMapSize);
+    fMap = 0;
+    fMapSize = 0;
+    fRecords = 0;
+    fCount = 0;
+    fEventStart.clear();
+    fFileName = "";
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const WLSPrimaryRecord* WLSPrimaryFile::GetEvent(G4int i, G4int& n) const
+{
+    uint64_t first = fEventStart[i];
+    uint64_t end = i + 1 < (G4int) fEventStart.size() ? fEventStart[i + 1] : fCount;
+    n = end - first;
+    return fRecords + first;
+}
@@ -34,23 +34,32 @@
 
 #include "G4GeneralParticleSource.hh"
 
-#include "G4Material.hh"
-#include "G4MaterialPropertiesTable.hh"
-
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
 
-#include "G4PhysicsTable.hh"
-
 #include "Randomize.hh"
 
 #include "WLSPrimaryGeneratorAction.hh"
 
 #include "WLSDetectorConstruction.hh"
 #include "WLSPrimaryGeneratorMessenger.hh"
-
+#include "WLSRunAction.hh"
+#include "WLSOpticalTables.hh"
+#include "WLSPrimaryFile.hh"
+
+#include "G4OpticalPhoton.hh"
+#include "G4Positron.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4Threading.hh"
+
+#include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
+#include <algorithm>
+
 #include "G4AutoLock.hh"
 
 namespace {
@@ -59,14 +68,11 @@ namespace {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4bool WLSPrimaryGeneratorAction::fFirst = false;
-
 WLSPrimaryGeneratorAction:: WLSPrimaryGeneratorAction(WLSDetectorConstruction* dc)
 //WLSPrimaryGeneratorAction:: WLSPrimaryGeneratorAction(WLSDetectorConstruction* dc, WLSEventAction* eventAction)
 //  : fEventAction(eventAction) // add
 {
   fDetector = dc;
-  fIntegralTable = NULL;
 
   fParticleGun = new G4GeneralParticleSource();
  
@@ -79,6 +85,29 @@ WLSPrimaryGeneratorAction:: WLSPrimaryGeneratorAction(WLSDetectorConstruction* d
 
   fTimeConstant = 0.;
 
+  fBombPhotons = 0;
+  fBombCube = -1;
+  fBombFixed = false;
+  fBombEnergy = 0.;
+  fNavigator = new G4Navigator();
+
+  // as run.mac sets up the GPS
+  fBeamShape = kBeamOff;
+  fBeamParticle = G4Positron::Definition();
+  fBeamEnergy = 500.*MeV;
+  fBeamCentre = G4ThreeVector(0., 0., 5.*cm);
+  fBeamDirection = G4ThreeVector(0., 0., -1.);
+  fBeamSigma = 0.;
+  fBeamHalfX = 0.;
+  fBeamHalfY = 0.;
+
+  fPrimaryFile = new WLSPrimaryFile();
+  fFileOffset = 0;
+  fFilePartition = false;
+  fFileCursor = 0;
+  fFileWarned = false;
+  fFileEnergy = 0.;
+
 //  fParticleGun->SetParticleDefinition(particleTable->
 //                               FindParticle(particleName="opticalphoton"));
 }
@@ -89,10 +118,8 @@ WLSPrimaryGeneratorAction::~WLSPrimaryGeneratorAction()
 {
   delete fParticleGun;
   delete fGunMessenger;
-  if (fIntegralTable) {
-     fIntegralTable->clearAndDestroy();
-     delete fIntegralTable;
-  }
+  delete fNavigator;
+  delete fPrimaryFile;
 }
 
 
@@ -111,97 +138,33 @@ void WLSPrimaryGeneratorAction::SetDecayTimeConstant(G4double time)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void WLSPrimaryGeneratorAction::BuildEmissionSpectrum()
-{
-   if (fIntegralTable) return;
-
-   const G4MaterialTable* theMaterialTable = G4Material::GetMaterialTable();
-
-   G4int numOfMaterials = G4Material::GetNumberOfMaterials();
-
-   if(!fIntegralTable)fIntegralTable = new G4PhysicsTable(numOfMaterials);
-
-   for (G4int i=0 ; i < numOfMaterials; i++) {
-
-       G4PhysicsOrderedFreeVector* aPhysicsOrderedFreeVector =
-                                           new G4PhysicsOrderedFreeVector();
-
-       G4Material* aMaterial = (*theMaterialTable)[i];
-
-       G4MaterialPropertiesTable* aMaterialPropertiesTable =
-                                    aMaterial->GetMaterialPropertiesTable();
-
-       if (aMaterialPropertiesTable) {
-          G4MaterialPropertyVector* theWLSVector =
-                      aMaterialPropertiesTable->GetProperty("WLSCOMPONENT");
-
-          if (theWLSVector) {
-             G4double currentIN = (*theWLSVector)[0];
-             if (currentIN >= 0.0) {
-                G4double currentPM = theWLSVector->Energy(0);
-                G4double currentCII = 0.0;
-                aPhysicsOrderedFreeVector->
-                                     InsertValues(currentPM , currentCII);
-                G4double prevPM  = currentPM;
-                G4double prevCII = currentCII;
-                G4double prevIN  = currentIN;
-
-                for (size_t j = 1;
-                     j < theWLSVector->GetVectorLength();
-                     j++)
-                {
-                  currentPM = theWLSVector->Energy(j);
-                  currentIN = (*theWLSVector)[j];
-                  currentCII = 0.5 * (prevIN + currentIN);
-                  currentCII = prevCII + (currentPM - prevPM) * currentCII;
-                  aPhysicsOrderedFreeVector->
-                                     InsertValues(currentPM, currentCII);
-                  prevPM  = currentPM;
-                  prevCII = currentCII;
-                  prevIN  = currentIN;
-                }
-             }
-          }
-       }
-       fIntegralTable->insertAt(i,aPhysicsOrderedFreeVector);
-   }
-}
-
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-
 void WLSPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
-  if (!fFirst) {
-     fFirst = true;
-     BuildEmissionSpectrum();
-  }
-
-#ifdef use_sampledEnergy
-  const G4MaterialTable* theMaterialTable = G4Material::GetMaterialTable();
+  // first thing of the event to draw random numbers
+  WLSRunAction::SeedEvent(anEvent->GetEventID());
 
-  G4double sampledEnergy = 3*eV;
-
-  for (size_t j=0 ; j<theMaterialTable->size() ; j++) {
-      G4Material* fMaterial = (*theMaterialTable)[j];
-      if (fMaterial->GetName() == "PMMA" ) {
-         G4MaterialPropertiesTable* aMaterialPropertiesTable =
-                                      fMaterial->GetMaterialPropertiesTable();
-         const G4MaterialPropertyVector* WLSIntensity =
-                   aMaterialPropertiesTable->GetProperty("WLSCOMPONENT");
-
-         if (WLSIntensity) {
-            G4int MaterialIndex = fMaterial->GetIndex();
-            G4PhysicsOrderedFreeVector* WLSIntegral =
-              (G4PhysicsOrderedFreeVector*)((*fIntegralTable)(MaterialIndex));
+  if (fBombPhotons > 0) {
+     GeneratePhotonBomb(anEvent);
+     return;
+  }
 
-            G4double CIImax = WLSIntegral->GetMaxValue();
-            G4double CIIvalue = G4UniformRand()*CIImax;
+  if (fPrimaryFile->IsOpen()) {
+     GenerateFromFile(anEvent);
+     return;
+  }
 
-            sampledEnergy = WLSIntegral->GetEnergy(CIIvalue);
-         }
-      }
+  if (fBeamShape != kBeamOff) {
+     GenerateBeam(anEvent);
+     return;
   }
 
+#ifdef use_sampledEnergy
+  // WLS emission spectrum of the fiber, shared read-only by all threads
+  const WLSAliasTable& emission =
+                 WLSOpticalTables::GetInstance()->GetSampler("emissionFib");
+  G4double u = G4UniformRand();  // the two draws in a fixed order
+  G4double sampledEnergy = emission.Sample(u, G4UniformRand());
+
   //fParticleGun->SetParticleEnergy(sampledEnergy);
 #endif
 
@@ -235,8 +198,16 @@ void WLSPrimaryGeneratorAction::SetOptPhotonPolar(G4double angle)
      return;
   }
 
-  G4ThreeVector normal (1., 0., 0.);
   G4ThreeVector kphoton = fParticleGun->GetParticleMomentumDirection();
+  fParticleGun->SetParticlePolarization(PolarizationFor(kphoton, angle));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector WLSPrimaryGeneratorAction::PolarizationFor(
+                                const G4ThreeVector& kphoton, G4double angle)
+{
+  G4ThreeVector normal (1., 0., 0.);
   G4ThreeVector product = normal.cross(kphoton);
   G4double modul2       = product*product;
 
@@ -244,9 +215,7 @@ void WLSPrimaryGeneratorAction::SetOptPhotonPolar(G4double angle)
   if (modul2 > 0.) e_perpend = (1./std::sqrt(modul2))*product;
   G4ThreeVector e_paralle    = e_perpend.cross(kphoton);
 
-  G4ThreeVector polar = std::cos(angle)*e_paralle + std::sin(angle)*e_perpend;
-  fParticleGun->SetParticlePolarization(polar);
-
+  return std::cos(angle)*e_paralle + std::sin(angle)*e_perpend;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -256,3 +225,223 @@ void WLSPrimaryGeneratorAction::SetOptPhotonTime()
    G4double time = -std::log(G4UniformRand())*fTimeConstant;
    fParticleGun->SetParticleTime(time);
 }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPrimaryGeneratorAction::GeneratePhotonBomb(G4Event* anEvent)
+{
+  fBombPosition = SampleBombPosition();
+  G4double decayTime = WLSOpticalTables::GetInstance()->GetConstant("scintiTime");
+
+  // One vertex per photon, as each has its own emission time
+  fBombEnergy = 0.;
+  for (G4int i = 0; i < fBombPhotons; i++) {
+     G4double energy = SampleBombEnergy();
+     G4double cost = 1. - 2.*G4UniformRand();
+     G4double sint = std::sqrt((1. - cost)*(1. + cost));
+     G4double phi = twopi*G4UniformRand();
+     G4ThreeVector direction(sint*std::cos(phi), sint*std::sin(phi), cost);
+
+     G4PrimaryParticle* photon =
+              new G4PrimaryParticle(G4OpticalPhoton::Definition(), 0., 0., 0.);
+     photon->SetMomentum(energy*direction.x(), energy*direction.y(),
+                         energy*direction.z());
+     G4ThreeVector polar =
+              PolarizationFor(direction, G4UniformRand()*360.0*deg);
+     photon->SetPolarization(polar.x(), polar.y(), polar.z());
+
+     G4double time = -std::log(G4UniformRand())*decayTime;
+     G4PrimaryVertex* vertex = new G4PrimaryVertex(fBombPosition, time);
+     vertex->SetPrimary(photon);
+     anEvent->AddPrimaryVertex(vertex);
+     fBombEnergy += energy;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector WLSPrimaryGeneratorAction::SampleBombPosition()
+{
+  if (fBombFixed) return fBombPosition;
+
+  // Uniform in the cube box, rejecting the fiber holes (and anything
+  // else that is not scintillator) with a navigator of our own
+  G4Navigator* tracking = G4TransportationManager::GetTransportationManager()
+                                                  ->GetNavigatorForTracking();
+  fNavigator->SetWorldVolume(tracking->GetWorldVolume());
+  G4int ncubes = fDetector->GetNumberOfCubes();
+  G4double half = fDetector->GetBarBase()/2;
+  for (G4int tries = 0; tries < 1000; tries++) {
+     G4int cube = fBombCube >= 0 && fBombCube < ncubes
+                ? fBombCube : std::min(G4int(G4UniformRand()*ncubes), ncubes - 1);
+     G4ThreeVector p = fDetector->GetCubeCentre(cube) +
+                       half*G4ThreeVector(2*G4UniformRand() - 1,
+                                          2*G4UniformRand() - 1,
+                                          2*G4UniformRand() - 1);
+     G4VPhysicalVolume* pv =
+                     fNavigator->LocateGlobalPointAndSetup(p, 0, false, true);
+     if (fDetector->IsScintillator(pv)) return p;
+  }
+  G4Exception("WLSPrimaryGeneratorAction::SampleBombPosition()", "WLSGun01",
+              JustWarning, "No point in the scintillator found, using the cube centre");
+  return fDetector->GetCubeCentre(fBombCube >= 0 && fBombCube < ncubes ? fBombCube : 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSPrimaryGeneratorAction::SampleBombEnergy()
+{
+  // the distribution G4Scintillation draws from the same table
+  const WLSAliasTable& spectrum =
+                 WLSOpticalTables::GetInstance()->GetSampler("scintilFast");
+  G4double u = G4UniformRand();  // the two draws in a fixed order
+  return spectrum.Sample(u, G4UniformRand());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSPrimaryGeneratorAction::SetBeamShape(const G4String& shape)
+{
+  if (shape == "off") fBeamShape = kBeamOff;
+  else if (shape == "pencil") fBeamShape = kBeamPencil;
+  else if (shape == "gauss") fBeamShape = kBeamGauss;
+  else if (shape == "square") fBeamShape = kBeamSquare;
+  else return false;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSPrimaryGeneratorAction::SetBeamParticle(const G4String& name)
+{
+  G4ParticleDefinition* particle =
+                      G4ParticleTable::GetParticleTable()->FindParticle(name);
+  if (!particle) return false;
+  fBeamParticle = particle;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPrimaryGeneratorAction::GenerateBeam(G4Event* anEvent)
+{
+  fBeamPosition = fBeamCentre;
+  if (fBeamShape == kBeamGauss) {
+     G4double dx = G4RandGauss::shoot(0., fBeamSigma);
+     fBeamPosition += G4ThreeVector(dx, G4RandGauss::shoot(0., fBeamSigma), 0.);
+  }
+  else if (fBeamShape == kBeamSquare) {
+     G4double dx = (2.*G4UniformRand() - 1.)*fBeamHalfX;
+     fBeamPosition += G4ThreeVector(dx, (2.*G4UniformRand() - 1.)*fBeamHalfY, 0.);
+  }
+
+  G4PrimaryParticle* particle = new G4PrimaryParticle(fBeamParticle);
+  particle->SetKineticEnergy(fBeamEnergy);
+  particle->SetMomentumDirection(fBeamDirection);
+
+  G4double time = 0.;
+  if (fBeamParticle == G4OpticalPhoton::Definition()) {
+     G4ThreeVector polar =
+              PolarizationFor(fBeamDirection, G4UniformRand()*360.0*deg);
+     particle->SetPolarization(polar.x(), polar.y(), polar.z());
+     time = -std::log(G4UniformRand())*fTimeConstant;
+  }
+
+  G4PrimaryVertex* vertex = new G4PrimaryVertex(fBeamPosition, time);
+  vertex->SetPrimary(particle);
+  anEvent->AddPrimaryVertex(vertex);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSPrimaryGeneratorAction::SetPrimaryFile(const G4String& fileName)
+{
+  fFileCursor = 0;
+  fFileWarned = false;
+  if (fileName == "none") {
+     fPrimaryFile->Close();
+     return true;
+  }
+  return fPrimaryFile->Open(fileName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSPrimaryGeneratorAction::GenerateFromFile(G4Event* anEvent)
+{
+  G4int nevents = fPrimaryFile->GetNumberOfEvents();
+  G4int i;
+  if (fFilePartition) {
+     // share t of n: file events [t*N/n, (t+1)*N/n)
+     G4int nthreads = std::max(G4Threading::GetNumberOfRunningWorkerThreads(), 1);
+     G4int thread = std::max(G4Threading::G4GetThreadId(), 0);
+     G4int first = G4int(G4double(nevents)*thread/nthreads);
+     G4int size = G4int(G4double(nevents)*(thread + 1)/nthreads) - first;
+     if (size <= 0) {    // more threads than events
+        first = 0;
+        size = nevents;
+     }
+     i = first + (fFileOffset + fFileCursor++) % size;
+  }
+  else
+     i = (fFileOffset + anEvent->GetEventID()) % nevents;
+
+  G4int n = 0;
+  const WLSPrimaryRecord* record = fPrimaryFile->GetEvent(i, n);
+  fFileEnergy = 0.;
+  fFilePosition = G4ThreeVector(record->position[0], record->position[1],
+                                record->position[2]);
+  for (G4int k = 0; k < n; k++) {
+     const WLSPrimaryRecord& r = record[k];
+     G4ParticleDefinition* definition = r.pdg == -22 ? G4OpticalPhoton::Definition()
+                          : G4ParticleTable::GetParticleTable()->FindParticle(r.pdg);
+     if (!definition) {
+        if (!fFileWarned) {
+           G4ExceptionDescription o;
+           o << "Unknown PDG code " << r.pdg << " in " << fPrimaryFile->GetFileName()
+             << ", such primaries are left out";
+           G4Exception("WLSPrimaryGeneratorAction::GenerateFromFile()", "WLSGun04",
+                       JustWarning, o);
+           fFileWarned = true;
+        }
+        continue;
+     }
+
+     G4ThreeVector direction =
+          G4ThreeVector(r.direction[0], r.direction[1], r.direction[2]).unit();
+     G4PrimaryParticle* particle = new G4PrimaryParticle(definition);
+     particle->SetKineticEnergy(r.energy);
+     particle->SetMomentumDirection(direction);
+     if (definition == G4OpticalPhoton::Definition()) {
+        G4ThreeVector polar =
+              PolarizationFor(direction, G4UniformRand()*360.0*deg);
+        particle->SetPolarization(polar.x(), polar.y(), polar.z());
+     }
+
+     G4ThreeVector position(r.position[0], r.position[1], r.position[2]);
+     G4PrimaryVertex* vertex = new G4PrimaryVertex(position, r.time);
+     vertex->SetPrimary(particle);
+     anEvent->AddPrimaryVertex(vertex);
+     fFileEnergy += r.energy;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSPrimaryGeneratorAction::GetPrimaryEnergy()
+{
+  if (fBombPhotons > 0) return fBombEnergy;
+  if (fPrimaryFile->IsOpen()) return fFileEnergy;
+  if (fBeamShape != kBeamOff) return fBeamEnergy;
+  return fParticleGun->GetParticleEnergy();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector WLSPrimaryGeneratorAction::GetPrimaryPosition()
+{
+  if (fBombPhotons > 0) return fBombPosition;
+  if (fPrimaryFile->IsOpen()) return fFilePosition;
+  if (fBeamShape != kBeamOff) return fBeamPosition;
+  return fParticleGun->GetParticlePosition();
+}
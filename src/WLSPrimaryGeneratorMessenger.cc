@@ -32,6 +32,11 @@
 #include "G4UIdirectory.hh"
 
 #include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWith3Vector.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
 
 #include "WLSPrimaryGeneratorAction.hh"
 #include "WLSPrimaryGeneratorMessenger.hh"
@@ -62,6 +67,109 @@ WLSPrimaryGeneratorMessenger::
   fSetDecayTimeConstantCmd->SetUnitCategory("Time");
   fSetDecayTimeConstantCmd->SetRange("time_const>=0");
   fSetDecayTimeConstantCmd->AvailableForStates(G4State_Idle);
+
+  fBombPhotonsCmd = new G4UIcmdWithAnInteger("/WLS/gun/bomb",this);
+  fBombPhotonsCmd->SetGuidance("Photon bomb: start every event with n optical photons");
+  fBombPhotonsCmd->SetGuidance("in the scintillator instead of the GPS particle");
+  fBombPhotonsCmd->SetGuidance("(scintilFast spectrum, isotropic, scintiTime).");
+  fBombPhotonsCmd->SetGuidance("0 = off (default)");
+  fBombPhotonsCmd->SetParameterName("n",false);
+  fBombPhotonsCmd->SetRange("n>=0");
+  fBombPhotonsCmd->AvailableForStates(G4State_Idle);
+
+  fBombCubeCmd = new G4UIcmdWithAnInteger("/WLS/gun/bombCube",this);
+  fBombCubeCmd->SetGuidance("Cube the photon bomb goes off in, at a random point");
+  fBombCubeCmd->SetGuidance("of its scintillator; -1 = a random cube (default).");
+  fBombCubeCmd->SetGuidance("Cube number ix + NX*(iy + NY*iz).");
+  fBombCubeCmd->SetParameterName("cube",false);
+  fBombCubeCmd->SetRange("cube>=-1");
+  fBombCubeCmd->AvailableForStates(G4State_Idle);
+
+  fBombPositionCmd = new G4UIcmdWith3VectorAndUnit("/WLS/gun/bombPosition",this);
+  fBombPositionCmd->SetGuidance("Fixed point of the photon bomb (global coordinates);");
+  fBombPositionCmd->SetGuidance("/WLS/gun/bombCube goes back to random points.");
+  fBombPositionCmd->SetParameterName("x","y","z",false);
+  fBombPositionCmd->SetUnitCategory("Length");
+  fBombPositionCmd->SetDefaultUnit("mm");
+  fBombPositionCmd->AvailableForStates(G4State_Idle);
+
+  fBeamShapeCmd = new G4UIcmdWithAString("/WLS/gun/beam",this);
+  fBeamShapeCmd->SetGuidance("Start the events with the beam of /WLS/gun/beam*");
+  fBeamShapeCmd->SetGuidance("instead of the GPS (off, the default).  Its settings");
+  fBeamShapeCmd->SetGuidance("are per thread, so no event waits for another.");
+  fBeamShapeCmd->SetGuidance("  pencil: at the centre");
+  fBeamShapeCmd->SetGuidance("  gauss:  centre + Gaussian x, y offsets (beamSigma)");
+  fBeamShapeCmd->SetGuidance("  square: uniform in centre +- (beamHalfX, beamHalfY)");
+  fBeamShapeCmd->SetParameterName("shape",false);
+  fBeamShapeCmd->SetCandidates("off pencil gauss square");
+  fBeamShapeCmd->AvailableForStates(G4State_Idle);
+
+  fBeamParticleCmd = new G4UIcmdWithAString("/WLS/gun/beamParticle",this);
+  fBeamParticleCmd->SetGuidance("Particle of the beam (default e+)");
+  fBeamParticleCmd->SetParameterName("particle",false);
+  fBeamParticleCmd->AvailableForStates(G4State_Idle);
+
+  fBeamEnergyCmd = new G4UIcmdWithADoubleAndUnit("/WLS/gun/beamEnergy",this);
+  fBeamEnergyCmd->SetGuidance("Kinetic energy of the beam (default 500 MeV)");
+  fBeamEnergyCmd->SetParameterName("energy",false);
+  fBeamEnergyCmd->SetUnitCategory("Energy");
+  fBeamEnergyCmd->SetRange("energy>0");
+  fBeamEnergyCmd->AvailableForStates(G4State_Idle);
+
+  fBeamCentreCmd = new G4UIcmdWith3VectorAndUnit("/WLS/gun/beamCentre",this);
+  fBeamCentreCmd->SetGuidance("Centre of the beam spot (default 0 0 5 cm)");
+  fBeamCentreCmd->SetParameterName("x","y","z",false);
+  fBeamCentreCmd->SetUnitCategory("Length");
+  fBeamCentreCmd->SetDefaultUnit("cm");
+  fBeamCentreCmd->AvailableForStates(G4State_Idle);
+
+  fBeamDirectionCmd = new G4UIcmdWith3Vector("/WLS/gun/beamDirection",this);
+  fBeamDirectionCmd->SetGuidance("Direction of the beam (default 0 0 -1)");
+  fBeamDirectionCmd->SetParameterName("dx","dy","dz",false);
+  fBeamDirectionCmd->SetRange("dx != 0 || dy != 0 || dz != 0");
+  fBeamDirectionCmd->AvailableForStates(G4State_Idle);
+
+  fBeamSigmaCmd = new G4UIcmdWithADoubleAndUnit("/WLS/gun/beamSigma",this);
+  fBeamSigmaCmd->SetGuidance("sigma of the x and y offsets of the gauss beam");
+  fBeamSigmaCmd->SetParameterName("sigma_r",false);
+  fBeamSigmaCmd->SetUnitCategory("Length");
+  fBeamSigmaCmd->SetRange("sigma_r>=0");
+  fBeamSigmaCmd->AvailableForStates(G4State_Idle);
+
+  fBeamHalfXCmd = new G4UIcmdWithADoubleAndUnit("/WLS/gun/beamHalfX",this);
+  fBeamHalfXCmd->SetGuidance("Half width in x of the square beam");
+  fBeamHalfXCmd->SetParameterName("halfx",false);
+  fBeamHalfXCmd->SetUnitCategory("Length");
+  fBeamHalfXCmd->SetRange("halfx>=0");
+  fBeamHalfXCmd->AvailableForStates(G4State_Idle);
+
+  fBeamHalfYCmd = new G4UIcmdWithADoubleAndUnit("/WLS/gun/beamHalfY",this);
+  fBeamHalfYCmd->SetGuidance("Half width in y of the square beam");
+  fBeamHalfYCmd->SetParameterName("halfy",false);
+  fBeamHalfYCmd->SetUnitCategory("Length");
+  fBeamHalfYCmd->SetRange("halfy>=0");
+  fBeamHalfYCmd->AvailableForStates(G4State_Idle);
+
+  fFileCmd = new G4UIcmdWithAString("/WLS/gun/file",this);
+  fFileCmd->SetGuidance("Take the primaries from a primary event file written");
+  fFileCmd->SetGuidance("by wls-primaries instead of the beam or the GPS;");
+  fFileCmd->SetGuidance("none (default) closes it.  Event n of a run is file");
+  fFileCmd->SetGuidance("event (offset + n) modulo the events in the file.");
+  fFileCmd->SetParameterName("file",false);
+  fFileCmd->AvailableForStates(G4State_Idle);
+
+  fFileOffsetCmd = new G4UIcmdWithAnInteger("/WLS/gun/fileOffset",this);
+  fFileOffsetCmd->SetGuidance("File event taken for event 0 (default 0)");
+  fFileOffsetCmd->SetParameterName("offset",false);
+  fFileOffsetCmd->SetRange("offset>=0");
+  fFileOffsetCmd->AvailableForStates(G4State_Idle);
+
+  fFilePartitionCmd = new G4UIcmdWithABool("/WLS/gun/filePartition",this);
+  fFilePartitionCmd->SetGuidance("Every thread reads its own contiguous share of");
+  fFilePartitionCmd->SetGuidance("the file in order (default false).  Only repeats");
+  fFilePartitionCmd->SetGuidance("exactly with the same number of threads.");
+  fFilePartitionCmd->SetParameterName("on",false);
+  fFilePartitionCmd->AvailableForStates(G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -71,6 +179,20 @@ WLSPrimaryGeneratorMessenger::~WLSPrimaryGeneratorMessenger()
   delete fGunDir;
   delete fSetPolarizationCmd;
   delete fSetDecayTimeConstantCmd;
+  delete fBombPhotonsCmd;
+  delete fBombCubeCmd;
+  delete fBombPositionCmd;
+  delete fBeamShapeCmd;
+  delete fBeamParticleCmd;
+  delete fBeamEnergyCmd;
+  delete fBeamCentreCmd;
+  delete fBeamDirectionCmd;
+  delete fBeamSigmaCmd;
+  delete fBeamHalfXCmd;
+  delete fBeamHalfYCmd;
+  delete fFileCmd;
+  delete fFileOffsetCmd;
+  delete fFilePartitionCmd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -84,4 +206,38 @@ void WLSPrimaryGeneratorMessenger::
   else if ( command == fSetDecayTimeConstantCmd )
      fAction->
        SetDecayTimeConstant(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  else if ( command == fBombPhotonsCmd )
+     fAction->SetBombPhotons(G4UIcmdWithAnInteger::GetNewIntValue(val));
+  else if ( command == fBombCubeCmd )
+     fAction->SetBombCube(G4UIcmdWithAnInteger::GetNewIntValue(val));
+  else if ( command == fBombPositionCmd )
+     fAction->SetBombPosition(G4UIcmdWith3VectorAndUnit::GetNew3VectorValue(val));
+  else if ( command == fBeamShapeCmd )
+     fAction->SetBeamShape(val);
+  else if ( command == fBeamParticleCmd ) {
+     if (!fAction->SetBeamParticle(val)) {
+        G4ExceptionDescription o;
+        o << "Unknown particle " << val << ", the beam particle is unchanged";
+        G4Exception("WLSPrimaryGeneratorMessenger::SetNewValue()", "WLSGun02",
+                    JustWarning, o);
+     }
+  }
+  else if ( command == fBeamEnergyCmd )
+     fAction->SetBeamEnergy(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  else if ( command == fBeamCentreCmd )
+     fAction->SetBeamCentre(G4UIcmdWith3VectorAndUnit::GetNew3VectorValue(val));
+  else if ( command == fBeamDirectionCmd )
+     fAction->SetBeamDirection(G4UIcmdWith3Vector::GetNew3VectorValue(val));
+  else if ( command == fBeamSigmaCmd )
+     fAction->SetBeamSigma(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  else if ( command == fBeamHalfXCmd )
+     fAction->SetBeamHalfX(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  else if ( command == fBeamHalfYCmd )
+     fAction->SetBeamHalfY(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(val));
+  else if ( command == fFileCmd )
+     fAction->SetPrimaryFile(val);
+  else if ( command == fFileOffsetCmd )
+     fAction->SetPrimaryFileOffset(G4UIcmdWithAnInteger::GetNewIntValue(val));
+  else if ( command == fFilePartitionCmd )
+     fAction->SetPrimaryFilePartition(G4UIcmdWithABool::GetNewBoolValue(val));
 }
@@ -0,0 +1,160 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSRegionProcess.cc
+/// \brief Implementation of the WLSRegionProcess class
+//
+//
+#include "WLSRegionProcess.hh"
+
+#include "G4Track.hh"
+#include "G4Region.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4AutoLock.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSRegionSwitches::WLSRegionSwitches()
+  : fDefault(true), fVersion(0)
+{
+    G4MUTEXINIT(fMutex);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRegionSwitches::SetActive(const G4String& region, G4bool active)
+{
+    G4AutoLock lock(&fMutex);
+    fRegions[region] = active;
+    fVersion++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRegionSwitches::SetActive(G4bool active)
+{
+    G4AutoLock lock(&fMutex);
+    fDefault = active;
+    fVersion++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRegionSwitches::Get(std::map<G4String, G4bool>& regions, G4bool& active) const
+{
+    G4AutoLock lock(&fMutex);
+    regions = fRegions;
+    active = fDefault;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRegionSwitches::Set(const WLSRegionSwitches& other)
+{
+    std::map<G4String, G4bool> regions;
+    G4bool active;
+    other.Get(regions, active);
+    G4AutoLock lock(&fMutex);
+    fRegions = regions;
+    fDefault = active;
+    fVersion++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSRegionProcess::WLSRegionProcess(G4VProcess* process, const WLSRegionSwitches* switches)
+  : G4WrapperProcess(process->GetProcessName(), process->GetProcessType()),
+    fSwitches(switches), fVersion(-1), fDefault(true), fLastRegion(0), fLastActive(true)
+{
+    SetProcessSubType(process->GetProcessSubType());
+    RegisterProcess(process);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSRegionProcess::~WLSRegionProcess() { }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRegionProcess::StartTracking(G4Track* track)
+{
+    // one atomic read per track; the maps are copied only after a change
+    if (fSwitches->GetVersion() != fVersion)
+    {
+        fVersion = fSwitches->GetVersion();
+        fSwitches->Get(fRegions, fDefault);
+        fLastRegion = 0;
+    }
+    G4WrapperProcess::StartTracking(track);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSRegionProcess::IsActive(const G4Track& track)
+{
+    const G4VPhysicalVolume* volume = track.GetVolume();
+    const G4Region* region = volume ? volume->GetLogicalVolume()->GetRegion() : 0;
+    if (region && region == fLastRegion)
+        return fLastActive;
+
+    fLastRegion = region;
+    fLastActive = fDefault;
+    if (region)
+    {
+        std::map<G4String, G4bool>::const_iterator i = fRegions.find(region->GetName());
+        if (i != fRegions.end())
+            fLastActive = i->second;
+    }
+    return fLastActive;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSRegionProcess::PostStepGetPhysicalInteractionLength(const G4Track& track,
+                                                                 G4double previousStepSize,
+                                                                 G4ForceCondition* condition)
+{
+    if (!IsActive(track))
+    {
+        *condition = NotForced;
+        return DBL_MAX;
+    }
+    return G4WrapperProcess::PostStepGetPhysicalInteractionLength(track, previousStepSize, condition);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VParticleChange* WLSRegionProcess::AtRestDoIt(const G4Track& track, const G4Step& step)
+{
+    // The stepping manager may pick this process even with an infinite
+    // lifetime, so the rest step is filtered here rather than in AtRestGPIL
+    if (!IsActive(track))
+    {
+        aParticleChange.Initialize(track);
+        return &aParticleChange;
+    }
+    return G4WrapperProcess::AtRestDoIt(track, step);
+}
@@ -0,0 +1,499 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSResponseCache.cc
+/// \brief Implementation of the WLSResponseCache class
+//
+//
+#include "WLSResponseCache.hh"
+
+#include "WLSDetectorConstruction.hh"
+#include "WLSPhysicsList.hh"
+#include "WLSOpticalTables.hh"
+
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+namespace {
+    G4Mutex cacheMutex = G4MUTEX_INITIALIZER;
+}
+
+WLSResponseCache* WLSResponseCache::fInstance = 0;
+G4ThreadLocal WLSResponseCache::VoxelMap* WLSResponseCache::fLocal = 0;
+G4ThreadLocal G4long WLSResponseCache::fLastKey = -1;
+G4ThreadLocal WLSResponseCache::Voxel* WLSResponseCache::fLastVoxel = 0;
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSResponseCache::WLSResponseCache()
+    : fDirectory(""), fVoxelSize(1. * mm), fMaxError(0.1),
+    fKey(""), fCubeSize(0), fPitch(0), fSize(1. * mm), fPerSide(1), fNVoxels(1)
+{
+    fArray[0] = fArray[1] = fArray[2] = 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSResponseCache* WLSResponseCache::GetInstance()
+{
+    G4AutoLock l(&cacheMutex);
+    if (fInstance == 0)
+    {
+        fInstance = new WLSResponseCache();
+    }
+    return fInstance;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::SetDirectory(const G4String& name)
+{
+    G4String directory = (name == "none") ? G4String("") : name;
+    while (directory.size() > 1 && directory[directory.size() - 1] == '/')
+        directory.erase(directory.size() - 1);
+    if (directory == fDirectory)
+        return;
+    fDirectory = directory;
+    fKey = "";
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::SetVoxelSize(G4double size)
+{
+    if (size <= 0)
+        return;
+    fVoxelSize = size;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::BeginRun(WLSDetectorConstruction* detector,
+                                const WLSPhysicsList* physics)
+{
+    if (!IsEnabled() || !detector)
+        return;
+    if (!physics)
+    {
+        G4ExceptionDescription o;
+        o << "Not a WLSPhysicsList: its optical switches are unknown, "
+          << "the response cache is not filled";
+        G4Exception("WLSResponseCache::BeginRun()", "WLSCache03", JustWarning, o);
+        fKey = "";
+        fRun.clear();
+        return;
+    }
+
+    // FNV-1a of the parameters and tables written out in full
+    std::ostringstream os;
+    detector->WriteResponseParameters(os);
+    physics->WriteResponseParameters(os);
+    os.precision(17);
+    const WLSOpticalTables* tables = WLSOpticalTables::GetInstance();
+    std::map<G4String, WLSOpticalTables::Table>::const_iterator t;
+    for (t = tables->GetTables().begin(); t != tables->GetTables().end(); ++t)
+    {
+        os << t->first << "\n";
+        for (size_t i = 0; i < t->second.energy.size(); i++)
+            os << t->second.energy[i] << " " << t->second.value[i] << "\n";
+    }
+    std::map<G4String, G4double>::const_iterator c;
+    for (c = tables->GetConstants().begin(); c != tables->GetConstants().end(); ++c)
+        os << c->first << " " << c->second << "\n";
+    const std::string text = os.str();
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        hash ^= (unsigned char) text[i];
+        hash *= 1099511628211ULL;
+    }
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", hash);
+
+    fKey = key;
+    fCubeSize = detector->GetBarBase();
+    fPitch = detector->GetCubePitch();
+    fArray[0] = detector->GetArrayNX();
+    fArray[1] = detector->GetArrayNY();
+    fArray[2] = detector->GetArrayNZ();
+
+    // Re-read every run: other jobs may have added to the file
+    fVoxels.clear();
+    fRun.clear();
+    G4double size = fVoxelSize;
+    G4bool found = Read(GetFileName(), fVoxels, size);
+    fSize = size;
+    fPerSide = std::max(1, (G4int) std::ceil(fCubeSize / fSize - 1e-9));
+    fNVoxels = (G4long) fPerSide * fPerSide * fPerSide;
+    Print(found ? "loaded" : "new");
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::Flush()
+{
+    if (!fLocal || fLocal->empty())
+        return;
+    G4AutoLock l(&cacheMutex);
+    for (VoxelMap::const_iterator i = fLocal->begin(); i != fLocal->end(); ++i)
+    {
+        Voxel& total = fRun[i->first];
+        total.emitted += i->second.emitted;
+        for (int r = 0; r < kNRelations; r++)
+            total.detected[r] += i->second.detected[r];
+    }
+    l.unlock();
+    fLocal->clear();
+    fLastVoxel = 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::EndRun()
+{
+    if (!IsEnabled() || fKey == "")
+        return;
+
+    if (mkdir(fDirectory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        G4ExceptionDescription o;
+        o << "Cannot create " << fDirectory << ": " << std::strerror(errno)
+          << ", the statistics of this run are lost";
+        G4Exception("WLSResponseCache::EndRun()", "WLSCache02", JustWarning, o);
+        fRun.clear();
+        return;
+    }
+
+    // The file may have grown since BeginRun(): read it again under the lock
+    // and add this run to what is there
+    const G4String fileName = GetFileName();
+    int lock = open((fileName + ".lock").c_str(), O_CREAT | O_RDWR, 0644);
+    if (lock >= 0)
+        flock(lock, LOCK_EX);
+
+    VoxelMap voxels;
+    G4double size = fSize;
+    Read(fileName, voxels, size);
+    if (std::fabs(size - fSize) > 1e-6 * fSize)
+    {
+        G4ExceptionDescription o;
+        o << fileName << " was created with " << size / mm << " mm voxels while this run used "
+          << fSize / mm << " mm, the statistics of this run are lost";
+        G4Exception("WLSResponseCache::EndRun()", "WLSCache02", JustWarning, o);
+    }
+    else
+    {
+        G4long added = 0;
+        for (VoxelMap::const_iterator i = fRun.begin(); i != fRun.end(); ++i)
+        {
+            Voxel& total = voxels[i->first];
+            total.emitted += i->second.emitted;
+            for (int r = 0; r < kNRelations; r++)
+                total.detected[r] += i->second.detected[r];
+            added += i->second.emitted;
+        }
+        Write(fileName, voxels);
+        fVoxels.swap(voxels);
+        std::ostringstream what;
+        what << added << " photons added";
+        Print(what.str());
+    }
+    fRun.clear();
+
+    if (lock >= 0)
+    {
+        flock(lock, LOCK_UN);
+        close(lock);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int WLSResponseCache::GetVoxel(const G4ThreeVector& local) const
+{
+    G4int index[3];
+    for (int c = 0; c < 3; c++)
+    {
+        G4double u = (local[c] + 0.5 * fCubeSize) / fSize;
+        if (u < -1e-6 || u > fCubeSize / fSize + 1e-6)
+            return -1;
+        // points on the faces go to the voxels next to them
+        index[c] = std::min(std::max((G4int) u, 0), fPerSide - 1);
+    }
+    return index[0] + fPerSide * (index[1] + fPerSide * index[2]);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSResponseCache::Voxel& WLSResponseCache::GetLocal(G4long key)
+{
+    // The photons of one step come one after the other from the same voxel
+    if (!fLastVoxel || key != fLastKey)
+    {
+        if (!fLocal)
+            fLocal = new VoxelMap();
+        fLastVoxel = &(*fLocal)[key];
+        fLastKey = key;
+    }
+    return *fLastVoxel;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::AddEmitted(G4int cube, G4int voxel)
+{
+    GetLocal(GetKey(cube, voxel)).emitted++;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::AddDetected(G4int cube, G4int voxel, Relation relation)
+{
+    GetLocal(GetKey(cube, voxel)).detected[relation]++;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSResponseCache::GetResponse(G4int cube, const G4ThreeVector& local,
+                                     G4double* response) const
+{
+    G4int voxel = GetVoxel(local);
+    if (voxel < 0)
+        return false;
+    VoxelMap::const_iterator i = fVoxels.find(GetKey(cube, voxel));
+    if (i == fVoxels.end() || GetError(i->second) > fMaxError)
+        return false;
+    for (int r = 0; r < kNRelations; r++)
+        response[r] = (G4double) i->second.detected[r] / i->second.emitted;
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double WLSResponseCache::GetError(const Voxel& voxel)
+{
+    // Binomial: sigma(p) / p = sqrt((1 - p) / k) for k of n photons
+    G4double error = 0;
+    for (int r = kFiberX; r <= kFiberZ; r++)
+    {
+        G4long k = voxel.detected[r];
+        if (k == 0)
+            return DBL_MAX;
+        G4double p = (G4double) k / voxel.emitted;
+        error = std::max(error, std::sqrt(std::max(0., 1 - p) / k));
+    }
+    return error;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String WLSResponseCache::GetFileName() const
+{
+    return fDirectory + "/" + fKey + ".wlsresp";
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool WLSResponseCache::Read(const G4String& fileName, VoxelMap& voxels, G4double& size) const
+{
+    std::ifstream in(fileName.c_str());
+    if (!in)
+        return false;
+
+    G4ExceptionDescription o;
+    std::string line;
+    std::string word;
+    G4int version = 0;
+    G4int array[3] = { 0, 0, 0 };
+    G4double voxelSize = 0;
+    G4int perSide = 0;
+    G4int lineNumber = 0;
+    G4bool header = true;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        std::istringstream is(line);
+        if (!(is >> word) || word[0] == '#')
+            continue;
+        if (lineNumber == 1)
+        {
+            if (word != "wls-response-cache" || !(is >> version) || version != 1)
+            {
+                o << "not a version 1 response cache";
+                break;
+            }
+        }
+        else if (header && word == "key")
+        {
+            std::string key;
+            if (!(is >> key) || key != fKey)
+            {
+                o << "line " << lineNumber << ": key " << key << " instead of " << fKey;
+                break;
+            }
+        }
+        else if (header && word == "voxel")
+        {
+            if (!(is >> voxelSize) || voxelSize <= 0)
+            {
+                o << "line " << lineNumber << ": bad voxel size";
+                break;
+            }
+            voxelSize *= mm;
+            perSide = std::max(1, (G4int) std::ceil(fCubeSize / voxelSize - 1e-9));
+        }
+        else if (header && word == "array")
+        {
+            is >> array[0] >> array[1] >> array[2];
+        }
+        else if (header && (word == "pitch" || word == "size"))
+        {
+            // for wls-response, the key covers them
+        }
+        else if (header && word == "cube")
+        {
+            if (perSide == 0)
+            {
+                o << "line " << lineNumber << ": no voxel size before the voxels";
+                break;
+            }
+            header = false;
+        }
+        else if (!header)
+        {
+            G4int cube = std::atoi(word.c_str());
+            G4int index[3];
+            Voxel voxel;
+            if (!(is >> index[0] >> index[1] >> index[2] >> voxel.emitted) ||
+                cube < 0 || cube >= fArray[0] * fArray[1] * fArray[2])
+            {
+                o << "line " << lineNumber << ": bad voxel";
+                break;
+            }
+            G4bool valid = true;
+            for (int c = 0; c < 3; c++)
+                valid = valid && index[c] >= 0 && index[c] < perSide;
+            for (int r = 0; r < kNRelations; r++)
+                valid = valid && (is >> voxel.detected[r]) && voxel.detected[r] >= 0;
+            if (!valid)
+            {
+                o << "line " << lineNumber << ": bad voxel";
+                break;
+            }
+            G4long key = (G4long) cube * perSide * perSide * perSide
+                         + index[0] + perSide * (index[1] + perSide * index[2]);
+            Voxel& total = voxels[key];
+            total.emitted += voxel.emitted;
+            for (int r = 0; r < kNRelations; r++)
+                total.detected[r] += voxel.detected[r];
+        }
+        else
+        {
+            o << "line " << lineNumber << ": unknown entry " << word;
+            break;
+        }
+    }
+
+    if (o.str() == "" && header)
+        o << "no voxel table";
+    if (o.str() == "" && (array[0] != fArray[0] || array[1] != fArray[1] || array[2] != fArray[2]))
+        o << "array " << array[0] << " x " << array[1] << " x " << array[2] << " instead of "
+          << fArray[0] << " x " << fArray[1] << " x " << fArray[2];
+    if (o.str() != "")
+    {
+        G4ExceptionDescription e;
+        e << fileName << ": " << o.str() << "; repair or remove the file";
+        G4Exception("WLSResponseCache::Read()", "WLSCache01", FatalException, e);
+        return false;
+    }
+    size = voxelSize;
+    return true;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::Write(const G4String& fileName, const VoxelMap& voxels) const
+{
+    // Written aside and renamed, so a reader never sees half a file
+    const G4String temporary = fileName + ".tmp";
+    std::ofstream out(temporary.c_str());
+    out << "wls-response-cache 1\n"
+        << "key " << fKey << "\n"
+        << "voxel " << fSize / mm << "\n"
+        << "array " << fArray[0] << " " << fArray[1] << " " << fArray[2] << "\n"
+        << "size " << fCubeSize / mm << "\n"
+        << "pitch " << fPitch / mm << "\n"
+        << "cube ix iy iz emitted x y z other\n";
+    for (VoxelMap::const_iterator i = voxels.begin(); i != voxels.end(); ++i)
+    {
+        G4long voxel = i->first % fNVoxels;
+        out << i->first / fNVoxels << " " << voxel % fPerSide << " "
+            << (voxel / fPerSide) % fPerSide << " " << voxel / (fPerSide * fPerSide) << " "
+            << i->second.emitted;
+        for (int r = 0; r < kNRelations; r++)
+            out << " " << i->second.detected[r];
+        out << "\n";
+    }
+    out.close();
+    if (!out || std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        G4ExceptionDescription o;
+        o << "Cannot write " << fileName << ", the statistics of this run are lost";
+        G4Exception("WLSResponseCache::Write()", "WLSCache02", JustWarning, o);
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSResponseCache::Print(const G4String& what) const
+{
+    G4long photons = 0;
+    G4long flagged = 0;
+    for (VoxelMap::const_iterator i = fVoxels.begin(); i != fVoxels.end(); ++i)
+    {
+        photons += i->second.emitted;
+        if (GetError(i->second) > fMaxError)
+            flagged++;
+    }
+    G4cout << "### Response cache " << GetFileName() << " (" << what << "): "
+           << fVoxels.size() << " of " << fNVoxels * fArray[0] * fArray[1] * fArray[2]
+           << " voxels of " << fSize / mm << " mm, " << photons << " photons, "
+           << flagged << " voxels above " << fMaxError * 100 << "% error" << G4endl;
+}
@@ -38,14 +38,25 @@
 #include "Randomize.hh"
 
 #include "WLSDetectorConstruction.hh"
+#include "WLSPhysicsList.hh"
 #include "WLSSteppingAction.hh"
+#include "WLSStackingAction.hh"
+#include "WLSSharedMemorySink.hh"
+#include "WLSOutputWriter.hh"
+#include "WLSPhotonDetEfficiency.hh"
+#include "WLSResponseCache.hh"
 
 #include <ctime>
 
+G4bool WLSRunAction::fEventSeeds = false;
+G4long WLSRunAction::fEventSeedBase = 0;
+
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 WLSRunAction::WLSRunAction(G4String name)
-    : fSaveRndm(0), fAutoSeed(false), fName(name)
+    : fWriter(0), fOutputFormat("root"), fPhotonHistory(false),
+      fPhotonsNtuple(-1), fPDENtuple(-1), fArrivalsNtuple(-1),
+      fSaveRndm(0), fAutoSeed(false), fName(name)
 {
     fRunMessenger = new WLSRunActionMessenger(this);
 }
@@ -55,6 +66,7 @@ WLSRunAction::WLSRunAction(G4String name)
 WLSRunAction::~WLSRunAction()
 {
     delete fRunMessenger;
+    delete fWriter;
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -63,98 +75,339 @@ void WLSRunAction::BeginOfRunAction(const G4Run* aRun)
 {
     G4cout << "### Run " << aRun->GetRunID() << " start." << G4endl;
 
+    if (IsMaster())
+        WLSStackingAction::ResetPhotonSources();
+
     G4RunManager::GetRunManager()->SetRandomNumberStore(true);
     G4RunManager::GetRunManager()->SetRandomNumberStoreDir("random/");
 
-    G4AnalysisManager* ana = G4AnalysisManager::Instance();
-    G4cout << "### G4AnalysisManager : " << ana->GetType() << G4endl;
+    // Ntuples and histograms are booked once, the file is reopened every run
+    if (!fWriter)
+    {
+        fWriter = WLSOutputWriter::Create(fOutputFormat);
+        Book();
+    }
+    G4cout << "### Output : " << fWriter->GetType() << G4endl;
+    fWriter->OpenFile(fName);
+
+    const WLSDetectorConstruction* detector = static_cast<const WLSDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (IsMaster() && detector && detector->IsPhotonDetDeferred())
+    {
+        if (fPDENtuple < 0)
+        {
+            G4ExceptionDescription o;
+            o << "The ntuples are booked at the first run: without the pde ntuple "
+              << "only the default efficiency curve is applied";
+            G4Exception("WLSRunAction::BeginOfRunAction()", "WLSRun03", JustWarning, o);
+        }
+        else
+            WLSPhotonDetEfficiency::GetInstance()->Print();
+    }
+
+    // The stream stays mapped across runs so a consumer can follow several
+    // /run/beamOn in a row
+    WLSSharedMemorySink* sink = WLSSharedMemorySink::GetInstance();
+    if (sink->IsEnabled())
+        sink->Open();
+
+    // Statistics of the current geometry and optical tables, read before
+    // the workers start
+    WLSResponseCache* cache = WLSResponseCache::GetInstance();
+    if (IsMaster() && cache->IsEnabled())
+        cache->BeginRun(const_cast<WLSDetectorConstruction*>(detector),
+                        dynamic_cast<const WLSPhysicsList*>(
+                            G4RunManager::GetRunManager()->GetUserPhysicsList()));
+
+    if (fAutoSeed)
+    {
+        // automatic (time-based) random seeds for each run
+        G4cout << "*******************" << G4endl;
+        G4cout << "*** AUTOSEED ON ***" << G4endl;
+        G4cout << "*******************" << G4endl;
+        long seeds[2];
+        time_t systime = time(NULL);
+        seeds[0] = (long) systime;
+        seeds[1] = (long) (systime * G4UniformRand());
+        G4Random::setTheSeeds(seeds);
+        G4Random::showEngineStatus();
+    }
+    else
+    {
+        G4Random::showEngineStatus();
+    }
+
+    if (fSaveRndm > 0)
+        G4Random::saveEngineStatus("BeginOfRun.rndm");
+
+    // Drawn after the seeding above, so it follows /random/setSeeds and
+    // the seed of every sweep point
+    if (IsMaster() && fEventSeeds)
+    {
+        fEventSeedBase = (G4long) (G4UniformRand() * 2147483648.) * 2147483648L
+                         + (G4long) (G4UniformRand() * 2147483648.);
+        G4cout << "### Per-event seeds from " << fEventSeedBase << G4endl;
+    }
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SeedEvent(G4int eventID)
+{
+    if (!fEventSeeds)
+        return;
+    // splitmix64 of the run seed and the event number, folded into the
+    // ranges of the RanecuEngine seed pair.  Event n takes the outputs
+    // 2n+1 and 2n+2 of the sequence, so no two events share an input.
+    long seeds[3] = { 0, 0, 0 };
+    for (int i = 0; i < 2; i++)
+    {
+        unsigned long long x = (unsigned long long) fEventSeedBase + 0x9E3779B97F4A7C15ULL
+                               * (2ULL * (unsigned long long) eventID + i + 1);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        seeds[i] = (long) (x % 2147483398ULL) + 1;
+    }
+    G4Random::setTheSeeds(seeds);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::EndOfRunAction(const G4Run*)
+{
+    if (IsMaster())
+        WLSStackingAction::PrintPhotonSources();
+
+    // The workers end their runs before the master
+    WLSResponseCache* cache = WLSResponseCache::GetInstance();
+    cache->Flush();
+    if (IsMaster())
+        cache->EndRun();
+
+    if (fSaveRndm == 1)
+    {
+        G4Random::showEngineStatus();
+        G4Random::saveEngineStatus("endOfRun.rndm");
+    }
+
+    fWriter->Write();
+    fWriter->CloseFile();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::Book()
+{
+    WLSOutputWriter* ana = fWriter;
+    G4int next = 3;
     char cname[32];
-    // Open an output file
-    ana->OpenFile(fName);
     // Create ntuple
-    // ana->SetVerboseLevel(1);
     ana->CreateNtuple("cube", "nine cubes");
-    ana->CreateNtupleDColumn("n");
-    ana->CreateNtupleDColumn("e");
-    ana->CreateNtupleDColumn("x");
-    ana->CreateNtupleDColumn("y");
-    ana->CreateNtupleDColumn("z");
-    ana->CreateNtupleDColumn("nPhotons");
+    ana->CreateNtupleDColumn(0, "n");
+    ana->CreateNtupleDColumn(0, "e");
+    ana->CreateNtupleDColumn(0, "x");
+    ana->CreateNtupleDColumn(0, "y");
+    ana->CreateNtupleDColumn(0, "z");
+    ana->CreateNtupleDColumn(0, "nPhotons");
     for (int i = 0; i < 3; i++)
     {
         sprintf(cname, "npx%d", i);
-        ana->CreateNtupleDColumn(cname);
+        ana->CreateNtupleDColumn(0, cname);
     }
     for (int j = 0; j < 3; j++)
     {
         sprintf(cname, "npy%d", j);
-        ana->CreateNtupleDColumn(cname);
+        ana->CreateNtupleDColumn(0, cname);
     }
     for (int i = 0; i < 3; i++)
     {
         for (int j = 0; j < 3; j++)
         {
             sprintf(cname, "npz%d%d", i, j);
-            ana->CreateNtupleDColumn(cname);
+            ana->CreateNtupleDColumn(0, cname);
         }
     }
-    ana->CreateNtupleDColumn("time");
-    ana->CreateNtupleDColumn("lasttime");
+    ana->CreateNtupleDColumn(0, "time");
+    ana->CreateNtupleDColumn(0, "lasttime");
     for (int i = 0; i < 3; i++)
     {
         for (int j = 0; j < 3; j++)
         {
             sprintf(cname, "hittimez%d%d", i, j);
-            ana->CreateNtupleDColumn(cname);
+            ana->CreateNtupleDColumn(0, cname);
         }
     }
     char coordinate[3] = { 'x', 'y', 'z' };
     for (int i = 0; i < 3; i++)
     {
         sprintf(cname, "cubeinpos%c", coordinate[i]);
-        ana->CreateNtupleDColumn(cname);
+        ana->CreateNtupleDColumn(0, cname);
     }
     for (int i = 0; i < 3; i++)
     {
         sprintf(cname, "cubeoutpos%c", coordinate[i]);
-        ana->CreateNtupleDColumn(cname);
+        ana->CreateNtupleDColumn(0, cname);
+    }
+    // Energy deposited in the scintillator: all cubes, then the cubes of
+    // the nine-cube layer (the only response with /WLS/phys/optical off)
+    ana->CreateNtupleDColumn(0, "edep");
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            sprintf(cname, "edep%d%d", i, j);
+            ana->CreateNtupleDColumn(0, cname);
+        }
     }
 
     ana->FinishNtuple(0);
 
-    if (fAutoSeed)
+    // Sparse readout of any array size: one row per event and channel
+    // with light (channel numbering in WLSDetectorConstruction.hh)
+    ana->CreateNtuple("hits", "photons per readout channel");
+    ana->CreateNtupleDColumn(1, "n");
+    ana->CreateNtupleDColumn(1, "channel");
+    ana->CreateNtupleDColumn(1, "photons");
+    ana->CreateNtupleDColumn(1, "firsttime");
+    ana->FinishNtuple(1);
+
+    // Sparse energy deposits of any array size: one row per event and cube
+    // (cube numbering in WLSDetectorConstruction.hh)
+    ana->CreateNtuple("deposits", "energy deposit per cube");
+    ana->CreateNtupleDColumn(2, "n");
+    ana->CreateNtupleDColumn(2, "cube");
+    ana->CreateNtupleDColumn(2, "edep");
+    ana->FinishNtuple(2);
+
+    // Detected photons with what a reflectivity or an attenuation length
+    // enters their survival with (WLSPhotonHistory); lengths in mm,
+    // wavelengths in nm, lambda0 before the first wavelength shift
+    if (fPhotonHistory)
     {
-        // automatic (time-based) random seeds for each run
-        G4cout << "*******************" << G4endl;
-        G4cout << "*** AUTOSEED ON ***" << G4endl;
-        G4cout << "*******************" << G4endl;
-        long seeds[2];
-        time_t systime = time(NULL);
-        seeds[0] = (long) systime;
-        seeds[1] = (long) (systime * G4UniformRand());
-        G4Random::setTheSeeds(seeds);
-        G4Random::showEngineStatus();
+        fPhotonsNtuple = next++;
+        ana->CreateNtuple("photons", "path of every detected photon");
+        const char* columns[] = { "n", "channel", "time", "nCube", "nMirror", "nWLS",
+                                  "cubePath0", "cubePath", "fiberPath", "lambda0", "lambda" };
+        for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++)
+            ana->CreateNtupleDColumn(fPhotonsNtuple, columns[c]);
+        ana->FinishNtuple(fPhotonsNtuple);
     }
-    else
+
+    // Deferred photon detection efficiency: the photon counts of the
+    // "cube" ntuple once per efficiency curve (curve 0 is the one applied
+    // to the "cube" ntuple, the others are listed at the start of the
+    // run), and every photon that reached a detector with its wavelength
+    // in nm and the uniform number u it is accepted with (u < PDE)
+    const WLSDetectorConstruction* detector = static_cast<const WLSDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (detector && detector->IsPhotonDetDeferred())
     {
-        G4Random::showEngineStatus();
+        fPDENtuple = next++;
+        ana->CreateNtuple("pde", "photons per efficiency curve");
+        ana->CreateNtupleDColumn(fPDENtuple, "n");
+        ana->CreateNtupleDColumn(fPDENtuple, "curve");
+        for (int i = 0; i < 3; i++)
+        {
+            sprintf(cname, "npx%d", i);
+            ana->CreateNtupleDColumn(fPDENtuple, cname);
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            sprintf(cname, "npy%d", j);
+            ana->CreateNtupleDColumn(fPDENtuple, cname);
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                sprintf(cname, "npz%d%d", i, j);
+                ana->CreateNtupleDColumn(fPDENtuple, cname);
+            }
+        }
+        ana->CreateNtupleDColumn(fPDENtuple, "photons");
+        ana->FinishNtuple(fPDENtuple);
+
+        fArrivalsNtuple = next++;
+        ana->CreateNtuple("arrivals", "every photon reaching a photon detector");
+        const char* columns[] = { "n", "channel", "time", "lambda", "u" };
+        for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++)
+            ana->CreateNtupleDColumn(fArrivalsNtuple, columns[c]);
+        ana->FinishNtuple(fArrivalsNtuple);
     }
 
-    if (fSaveRndm > 0)
-        G4Random::saveEngineStatus("BeginOfRun.rndm");
+    // Trigger summary (see /WLS/output/trigger): every event is counted here,
+    // only accepted ones go to the ntuple
+    ana->CreateH1("trigger", "rejected (0) / accepted (1) events", 2, -0.5, 1.5);
+    ana->CreateH1("rejectedTotal", "total photons of rejected events", 200, -0.5, 199.5);
 }
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void WLSRunAction::EndOfRunAction(const G4Run*)
+void WLSRunAction::SetOutputFormat(const G4String& format)
 {
-    if (fSaveRndm == 1)
+    if (format == fOutputFormat)
+        return;
+    if (fWriter)
     {
-        G4Random::showEngineStatus();
-        G4Random::saveEngineStatus("endOfRun.rndm");
+        // the Geant4 analysis managers cannot be unbooked
+        G4ExceptionDescription o;
+        o << "The output format is fixed at the first run (" << fOutputFormat
+          << "), " << format << " ignored";
+        G4Exception("WLSRunAction::SetOutputFormat()", "WLSRun01", JustWarning, o);
+        return;
+    }
+    fOutputFormat = format;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SetPhotonHistory(G4bool on)
+{
+    if (on == fPhotonHistory)
+        return;
+    if (fWriter)
+    {
+        G4ExceptionDescription o;
+        o << "The ntuples are booked at the first run, /WLS/output/photonHistory "
+          << (on ? "true" : "false") << " ignored";
+        G4Exception("WLSRunAction::SetPhotonHistory()", "WLSRun02", JustWarning, o);
+        return;
     }
+    fPhotonHistory = on;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SetStreamName(const G4String& name)
+{
+    WLSSharedMemorySink::GetInstance()->SetName(name);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    G4AnalysisManager* ana = G4AnalysisManager::Instance();
-    ana->Write();
-    ana->CloseFile();
+void WLSRunAction::SetStreamCapacity(G4int n)
+{
+    WLSSharedMemorySink::GetInstance()->SetCapacity(n);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SetResponseCache(const G4String& directory)
+{
+    WLSResponseCache::GetInstance()->SetDirectory(directory);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SetResponseVoxel(G4double size)
+{
+    WLSResponseCache::GetInstance()->SetVoxelSize(size);
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSRunAction::SetResponseMaxError(G4double error)
+{
+    WLSResponseCache::GetInstance()->SetMaxError(error);
 }
@@ -76,6 +76,85 @@ WLSRunActionMessenger::WLSRunActionMessenger(WLSRunAction* runaction)
   fSetAutoSeedCmd->SetGuidance("Default = false");
   fSetAutoSeedCmd->SetParameterName("autoSeed", false);
   fSetAutoSeedCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fPerEventSeedCmd = new G4UIcmdWithABool("/rndm/perEvent",this);
+  fPerEventSeedCmd->SetGuidance("Seed every event from the run seed and its number,");
+  fPerEventSeedCmd->SetGuidance("so runs started from the same seed (sweep points)");
+  fPerEventSeedCmd->SetGuidance("see the same random numbers event by event.");
+  fPerEventSeedCmd->SetGuidance("Default = false");
+  fPerEventSeedCmd->SetParameterName("perEvent", false);
+  fPerEventSeedCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fOutputDir = new G4UIdirectory("/WLS/output/");
+  fOutputDir->SetGuidance("Output control.");
+
+  fShmNameCmd = new G4UIcmdWithAString("/WLS/output/shm",this);
+  fShmNameCmd->SetGuidance("Stream per-event records to a POSIX shared-memory");
+  fShmNameCmd->SetGuidance("ring buffer (layout in WLSEventRecord.hh).");
+  fShmNameCmd->SetGuidance("The segment is created at the next /run/beamOn.");
+  fShmNameCmd->SetGuidance("none = disabled (default)");
+  fShmNameCmd->SetParameterName("name",false);
+  fShmNameCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fShmSlotsCmd = new G4UIcmdWithAnInteger("/WLS/output/shmSlots",this);
+  fShmSlotsCmd->SetGuidance("Number of event slots in the shared-memory ring.");
+  fShmSlotsCmd->SetParameterName("slots",false);
+  fShmSlotsCmd->SetRange("slots>0");
+  fShmSlotsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fFormatCmd = new G4UIcmdWithAString("/WLS/output/format",this);
+  fFormatCmd->SetGuidance("Output file format.");
+  fFormatCmd->SetGuidance("  root : ROOT file (default)");
+  fFormatCmd->SetGuidance("  csv  : one CSV file per ntuple and histogram");
+  fFormatCmd->SetGuidance("  bin  : memory-mapped columnar files (WLSColumnarFormat.hh)");
+  fFormatCmd->SetGuidance("Must be given before the first /run/beamOn.");
+  fFormatCmd->SetParameterName("format",false);
+  fFormatCmd->SetCandidates("root csv bin");
+  fFormatCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fFileNameCmd = new G4UIcmdWithAString("/WLS/output/fileName",this);
+  fFileNameCmd->SetGuidance("Output file name, without extension.");
+  fFileNameCmd->SetGuidance("Takes effect at the next /run/beamOn.");
+  fFileNameCmd->SetParameterName("name",false);
+  fFileNameCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fPhotonHistoryCmd = new G4UIcmdWithABool("/WLS/output/photonHistory",this);
+  fPhotonHistoryCmd->SetGuidance("Write one row per detected photon with its");
+  fPhotonHistoryCmd->SetGuidance("reflections, path lengths and wavelengths");
+  fPhotonHistoryCmd->SetGuidance("(\"photons\" ntuple), for wls-reweight.");
+  fPhotonHistoryCmd->SetGuidance("Must be given before the first /run/beamOn.");
+  fPhotonHistoryCmd->SetParameterName("on",false);
+  fPhotonHistoryCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fResponseCacheCmd = new G4UIcmdWithAString("/WLS/output/responseCache",this);
+  fResponseCacheCmd->SetGuidance("Directory of the response cache: where the photons");
+  fResponseCacheCmd->SetGuidance("of every run start in their cube and which fibers");
+  fResponseCacheCmd->SetGuidance("detect them, one file per geometry and optical");
+  fResponseCacheCmd->SetGuidance("tables, added to at the end of every run.");
+  fResponseCacheCmd->SetGuidance("none = disabled (default)");
+  fResponseCacheCmd->SetParameterName("directory",false);
+  fResponseCacheCmd->SetToBeBroadcasted(false);
+  fResponseCacheCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fResponseVoxelCmd =
+              new G4UIcmdWithADoubleAndUnit("/WLS/output/responseVoxel",this);
+  fResponseVoxelCmd->SetGuidance("Voxel edge of new response cache files;");
+  fResponseVoxelCmd->SetGuidance("an existing file keeps its own.  Default 1 mm");
+  fResponseVoxelCmd->SetParameterName("size",false);
+  fResponseVoxelCmd->SetRange("size>0");
+  fResponseVoxelCmd->SetDefaultUnit("mm");
+  fResponseVoxelCmd->SetToBeBroadcasted(false);
+  fResponseVoxelCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  fResponseMaxErrorCmd =
+              new G4UIcmdWithADouble("/WLS/output/responseMaxError",this);
+  fResponseMaxErrorCmd->SetGuidance("Voxels of the response cache whose X, Y or Z");
+  fResponseMaxErrorCmd->SetGuidance("fiber probability has a larger relative error");
+  fResponseMaxErrorCmd->SetGuidance("are flagged and not used.  Default 0.1");
+  fResponseMaxErrorCmd->SetParameterName("error",false);
+  fResponseMaxErrorCmd->SetRange("error>0");
+  fResponseMaxErrorCmd->SetToBeBroadcasted(false);
+  fResponseMaxErrorCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -83,7 +162,10 @@ WLSRunActionMessenger::WLSRunActionMessenger(WLSRunAction* runaction)
 WLSRunActionMessenger::~WLSRunActionMessenger()
 {
   delete fRndmDir; delete fRndmSaveCmd;
-  delete fRndmReadCmd; delete fSetAutoSeedCmd;
+  delete fRndmReadCmd; delete fSetAutoSeedCmd; delete fPerEventSeedCmd;
+  delete fOutputDir; delete fShmNameCmd; delete fShmSlotsCmd;
+  delete fFormatCmd; delete fFileNameCmd; delete fPhotonHistoryCmd;
+  delete fResponseCacheCmd; delete fResponseVoxelCmd; delete fResponseMaxErrorCmd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -101,4 +183,31 @@ void WLSRunActionMessenger::SetNewValue(G4UIcommand* command,G4String newValue)
 
   if(command == fSetAutoSeedCmd)
       fRunAction->SetAutoSeed(fSetAutoSeedCmd->GetNewBoolValue(newValue));
+
+  if (command == fPerEventSeedCmd)
+      WLSRunAction::SetEventSeeds(fPerEventSeedCmd->GetNewBoolValue(newValue));
+
+  if (command == fShmNameCmd)
+      fRunAction->SetStreamName(newValue);
+
+  if (command == fShmSlotsCmd)
+      fRunAction->SetStreamCapacity(fShmSlotsCmd->GetNewIntValue(newValue));
+
+  if (command == fFormatCmd)
+      fRunAction->SetOutputFormat(newValue);
+
+  if (command == fFileNameCmd)
+      fRunAction->SetFileName(newValue);
+
+  if (command == fPhotonHistoryCmd)
+      fRunAction->SetPhotonHistory(fPhotonHistoryCmd->GetNewBoolValue(newValue));
+
+  if (command == fResponseCacheCmd)
+      fRunAction->SetResponseCache(newValue);
+
+  if (command == fResponseVoxelCmd)
+      fRunAction->SetResponseVoxel(fResponseVoxelCmd->GetNewDoubleValue(newValue));
+
+  if (command == fResponseMaxErrorCmd)
+      fRunAction->SetResponseMaxError(fResponseMaxErrorCmd->GetNewDoubleValue(newValue));
 }
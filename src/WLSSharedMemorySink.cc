@@ -0,0 +1,190 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/src/WLSSharedMemorySink.cc
+/// \brief Implementation of the WLSSharedMemorySink class
+//
+//
+#include "WLSSharedMemorySink.hh"
+
+#include "G4AutoLock.hh"
+
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+    G4Mutex shm_mutex = G4MUTEX_INITIALIZER;
+}
+
+WLSSharedMemorySink* WLSSharedMemorySink::fInstance = 0;
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSSharedMemorySink::WLSSharedMemorySink()
+    : fName(""), fCapacity(kWLSShmDefaultCapacity),
+    fHeader(0), fSlots(0), fSize(0)
+{
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSSharedMemorySink::~WLSSharedMemorySink()
+{
+    Close();
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+WLSSharedMemorySink* WLSSharedMemorySink::GetInstance()
+{
+    G4AutoLock l(&shm_mutex);
+    if (fInstance == 0)
+    {
+        fInstance = new WLSSharedMemorySink();
+    }
+    return fInstance;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSSharedMemorySink::SetName(const G4String& name)
+{
+    G4AutoLock l(&shm_mutex);
+    G4String newName = (name == "none") ? G4String("") : name;
+    // shm_open wants a single leading slash
+    if (newName != "" && newName[0] != '/')
+        newName = "/" + newName;
+    if (newName == fName)
+        return;
+    l.unlock();
+    Close();
+    l.lock();
+    fName = newName;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSSharedMemorySink::SetCapacity(G4int n)
+{
+    G4AutoLock l(&shm_mutex);
+    if (fHeader)
+    {
+        G4cerr << "WLSSharedMemorySink: segment " << fName << " is already open,"
+               << " the new capacity applies to the next segment" << G4endl;
+    }
+    fCapacity = n;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSSharedMemorySink::Open()
+{
+    G4AutoLock l(&shm_mutex);
+    if (fHeader || fName == "")
+        return;
+
+    size_t size = WLSShmSegmentSize(fCapacity);
+
+    int fd = shm_open(fName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        G4ExceptionDescription o;
+        o << "shm_open(" << fName << ") failed: " << std::strerror(errno);
+        G4Exception("WLSSharedMemorySink::Open()", "WLSShm01", JustWarning, o);
+        return;
+    }
+    if (ftruncate(fd, size) != 0)
+    {
+        G4ExceptionDescription o;
+        o << "ftruncate(" << fName << ") failed: " << std::strerror(errno);
+        G4Exception("WLSSharedMemorySink::Open()", "WLSShm02", JustWarning, o);
+        close(fd);
+        return;
+    }
+    void* addr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        G4ExceptionDescription o;
+        o << "mmap(" << fName << ") failed: " << std::strerror(errno);
+        G4Exception("WLSSharedMemorySink::Open()", "WLSShm03", JustWarning, o);
+        return;
+    }
+
+    // Start from a clean segment: consumers detect a restart through the
+    // writeIndex going backwards
+    std::memset(addr, 0, size);
+
+    fHeader = static_cast<WLSShmHeader*>(addr);
+    fSlots = reinterpret_cast<WLSShmSlot*>(static_cast<char*>(addr) + sizeof(WLSShmHeader));
+    fSize = size;
+
+    fHeader->version = kWLSShmVersion;
+    fHeader->recordSize = sizeof(WLSEventRecord);
+    fHeader->capacity = fCapacity;
+    fHeader->writeIndex.store(0, std::memory_order_relaxed);
+    // the magic goes last so that a consumer never sees a half-initialised header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(fHeader->magic, kWLSShmMagic, sizeof(kWLSShmMagic));
+
+    G4cout << "### Event stream: " << fName << " (" << fCapacity << " slots, "
+           << size << " bytes)" << G4endl;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSSharedMemorySink::Close()
+{
+    G4AutoLock l(&shm_mutex);
+    if (!fHeader)
+        return;
+    // The segment is not unlinked: consumers may still be draining it.
+    // The next Open() with the same name reuses and resets it.
+    munmap(fHeader, fSize);
+    fHeader = 0;
+    fSlots = 0;
+    fSize = 0;
+}
+
+// ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSSharedMemorySink::Publish(const WLSEventRecord& record)
+{
+    if (!fHeader)
+        return;
+
+    uint64_t ticket = fHeader->writeIndex.fetch_add(1, std::memory_order_acq_rel);
+    WLSShmSlot& slot = fSlots[ticket % fHeader->capacity];
+
+    slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.record, &record, sizeof(WLSEventRecord));
+    slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+}
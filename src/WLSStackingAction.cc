@@ -36,10 +36,21 @@
 #include "G4Track.hh"
 #include "G4ParticleTypes.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4Region.hh"
+#include "G4VProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4AutoLock.hh"
+
+#include <iomanip>
+
+namespace { G4Mutex sourcesMutex = G4MUTEX_INITIALIZER; }
+
+WLSStackingAction::SourceMap WLSStackingAction::fTotalSources;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-WLSStackingAction::WLSStackingAction() : fPhotonCounter(0) { }
+WLSStackingAction::WLSStackingAction()
+  : fPhotonCounter(0), fLastCreator(0), fLastRegion(0), fLastCount(0) { }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -58,6 +69,20 @@ G4ClassificationOfNewTrack
   if (particleType == G4OpticalPhoton::OpticalPhotonDefinition()) {
      // keep optical photon
      fPhotonCounter++;
+
+     const G4VProcess* creator = aTrack->GetCreatorProcess();
+     const G4VPhysicalVolume* volume = aTrack->GetVolume();
+     const G4Region* region =
+                      volume ? volume->GetLogicalVolume()->GetRegion() : 0;
+     if (creator && region) {
+        if (creator != fLastCreator || region != fLastRegion || !fLastCount) {
+           fLastCreator = creator;
+           fLastRegion = region;
+           fLastCount = &fSources[std::make_pair(region->GetName(),
+                                                 creator->GetProcessName())];
+        }
+        (*fLastCount)++;
+     }
      return fUrgent;
   } else {
      // discard all other secondaries
@@ -69,6 +94,7 @@ G4ClassificationOfNewTrack
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void WLSStackingAction::NewStage() {
+   FlushPhotonSources();
    G4cout << "\n\n##### Number of optical photons produces in this event : "
           << fPhotonCounter << " #####\n\n" << G4endl;
 }
@@ -81,3 +107,37 @@ int WLSStackingAction::GetOpticalNPhotons()
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void WLSStackingAction::PrepareNewEvent() { fPhotonCounter = 0; }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSStackingAction::FlushPhotonSources()
+{
+   if (fSources.empty()) return;
+   G4AutoLock lock(&sourcesMutex);
+   for (SourceMap::const_iterator i = fSources.begin(); i != fSources.end(); ++i)
+      fTotalSources[i->first] += i->second;
+   fSources.clear();
+   fLastCount = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSStackingAction::ResetPhotonSources()
+{
+   G4AutoLock lock(&sourcesMutex);
+   fTotalSources.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSStackingAction::PrintPhotonSources()
+{
+   G4AutoLock lock(&sourcesMutex);
+   G4cout << "### Optical photons created, by region and process" << G4endl;
+   for (SourceMap::const_iterator i = fTotalSources.begin();
+                                  i != fTotalSources.end(); ++i) {
+      G4cout << "    " << std::setw(26) << std::left << i->first.first
+             << std::setw(15) << i->first.second << std::right
+             << std::setw(14) << i->second << G4endl;
+   }
+}
@@ -31,6 +31,10 @@
 //
 #include "G4Track.hh"
 #include "G4VParticleChange.hh"
+#include "G4Region.hh"
+#include "G4UserLimits.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
 
 #include "WLSStepMax.hh"
 
@@ -66,7 +70,7 @@ void WLSStepMax::SetStepMax(G4double step) { fMaxChargedStep = step ; }
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4double WLSStepMax::PostStepGetPhysicalInteractionLength(
-                                              const G4Track&,
+                                              const G4Track& track,
                                               G4double,
                                               G4ForceCondition* condition)
 {
@@ -77,6 +81,12 @@ G4double WLSStepMax::PostStepGetPhysicalInteractionLength(
 
   if ( fMaxChargedStep > 0.) ProposedStep = fMaxChargedStep;
 
+  // a limit set on the region (WLSPhysicsList::SetRegionStepMax) wins
+  const G4VPhysicalVolume* volume = track.GetVolume();
+  G4Region* region = volume ? volume->GetLogicalVolume()->GetRegion() : 0;
+  G4UserLimits* limits = region ? region->GetUserLimits() : 0;
+  if ( limits ) ProposedStep = limits->GetMaxAllowedStep(track);
+
    return ProposedStep;
 }
 
@@ -33,8 +33,12 @@
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4StepPoint.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4VProcess.hh"
 #include "G4TrackStatus.hh"
 #include "G4VPhysicalVolume.hh"
+#include "G4Material.hh"
 #include "G4ParticleDefinition.hh"
 
 #include "WLSSteppingAction.hh"
@@ -42,6 +46,7 @@
 #include "WLSSteppingActionMessenger.hh"
 #include "WLSPhotonDetSD.hh"
 #include "WLSStackingAction.hh"
+#include "WLSResponseCache.hh"
 
 #include "G4ParticleTypes.hh"
 
@@ -57,12 +62,16 @@
 #include "G4ThreeVector.hh"
 #include "G4ios.hh"
 #include "G4SystemOfUnits.hh"
+#include <cmath>
 #include <sstream>
 
 // Purpose: Save relevant information into User Track Information
 
 static const G4ThreeVector ZHat = G4ThreeVector(0.0, 0.0, 1.0);
 
+// Replica transformations can move a face by a few ulps
+static const G4double kFaceTolerance = 1.0 * nm;
+
 G4int WLSSteppingAction::fMaxRndmSave = 10000;
 
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -80,6 +89,9 @@ WLSSteppingAction::WLSSteppingAction(WLSDetectorConstruction* detector, WLSEvent
     fBounceLimit = 1000000;
 
     fOpProcess = NULL;
+    fScintillatorMaterial = NULL;
+    fCoreMaterial = NULL;
+    fResponseCache = WLSResponseCache::GetInstance();
     ResetCounters();
 }
 
@@ -194,16 +206,50 @@ void WLSSteppingAction::UserSteppingAction(const G4Step* theStep)
         // }
 
         // TrackがCubeに入ったとき/出たときのTrack位置を保存
+        // (the top face of the top layer and the bottom face of the bottom one)
         G4ThreeVector pos = theStep->GetPreStepPoint()->GetPosition();
-        if (pos.getZ() == 5.0)
+        G4double cubeTop = fDetector->GetScintillatorTopZ();
+        if (std::fabs(pos.getZ() - cubeTop) < kFaceTolerance)
             fEventAction->AddCubeInPos(pos);
-        else if(pos.getZ() == -5.0)
+        else if (std::fabs(pos.getZ() + cubeTop) < kFaceTolerance)
             fEventAction->AddCubeOutPos(pos);
 
         // G4double pz = theTrack->GetVertexMomentumDirection().z();
         // G4double fInitTheta = theTrack->GetVertexMomentumDirection().angle(ZHat);
     }
 
+    // Energy deposited in the scintillator; absorbed optical photons are
+    // not counted
+    G4double edep = theStep->GetTotalEnergyDeposit();
+    if (edep > 0 && theTrack->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition())
+    {
+        G4int cube = fDetector->GetCube(thePrePoint->GetTouchable());
+        if (cube >= 0)
+            fEventAction->AddCubeDeposit(cube, edep);
+    }
+
+    // Scintillation photons (and photon-bomb primaries) remember the voxel
+    // they start in for the response cache
+    if (fResponseCache->IsEnabled() && theTrack->GetCurrentStepNumber() == 1 &&
+        trackInformation->GetOriginCube() < 0 &&
+        theTrack->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition())
+    {
+        const G4VProcess* creator = theTrack->GetCreatorProcess();
+        const G4VTouchable* touchable = thePrePoint->GetTouchable();
+        G4int cube = fDetector->GetCube(touchable);
+        if (cube >= 0 && (!creator || creator->GetProcessName() == "Scintillation"))
+        {
+            G4ThreeVector local =
+                touchable->GetHistory()->GetTopTransform().TransformPoint(thePrePoint->GetPosition());
+            G4int voxel = fResponseCache->GetVoxel(local);
+            if (voxel >= 0)
+            {
+                trackInformation->SetOrigin(cube, voxel);
+                fResponseCache->AddEmitted(cube, voxel);
+            }
+        }
+    }
+
     // Retrieve the status of the photon
     G4OpBoundaryProcessStatus theStatus = Undefined;
 
@@ -226,6 +272,32 @@ void WLSSteppingAction::UserSteppingAction(const G4Step* theStep)
         }
     }
 
+    // What reflectivities and attenuation lengths the photon has seen so far
+    if (fEventAction->IsPhotonHistoryOn() &&
+        theTrack->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition())
+    {
+        if (!fScintillatorMaterial)
+        {
+            fScintillatorMaterial = G4Material::GetMaterial("Polystyrene", false);
+            fCoreMaterial = G4Material::GetMaterial("Pethylene", false);
+        }
+        WLSPhotonHistory& history = trackInformation->GetHistory();
+        const G4Material* material = thePrePoint->GetMaterial();
+        if (material == fScintillatorMaterial)
+            history.cubePath += theStep->GetStepLength();
+        else if (material == fCoreMaterial)
+            history.fiberPath += theStep->GetStepLength();
+
+        if (theStatus == LambertianReflection || theStatus == LobeReflection ||
+            theStatus == SpikeReflection || theStatus == BackScattering)
+        {
+            if (fDetector->IsCubeCoating(thePostPV))
+                history.cubeReflections++;
+            else if (thePostPVname == "Mirror")
+                history.mirrorReflections++;
+        }
+    }
+
     // Find the skewness of the ray at first change of boundary
     if (fInitGamma == -1 &&
         (theStatus == TotalInternalReflection ||
@@ -257,7 +329,7 @@ void WLSSteppingAction::UserSteppingAction(const G4Step* theStep)
         return;
     }
 
-    char pvname[32];
+    G4int channel;
     // Assumed photons are originated at the fiber OR
     // the fiber is the first material the photon hits
     switch (theStatus) {
@@ -362,45 +434,41 @@ void WLSSteppingAction::UserSteppingAction(const G4Step* theStep)
         case Detection: // Detected by a detector
             // G4cout << "\nthePostPVname = " << thePostPVname << G4endl;
 
-            for (int i = 0; i < 3; i++)
+            // Photon detectors are parameterised, the copy number gives the channel
+            channel = fDetector->GetChannel(thePostPV, thePostPoint->GetTouchable()->GetCopyNumber());
+            if (channel > 0)
             {
-                sprintf(pvname, "PhotonDetX%d", i);
-                if (thePostPVname == pvname)
+                // With /WLS/setPhotonDetDeferred the surface detects every
+                // photon; it is kept for all efficiency curves and counts
+                // here only if the default curve accepts it
+                if (fEventAction->IsPhotonDetDeferred() &&
+                    !fEventAction->AddArrivingPhoton(channel, theTrack->GetGlobalTime(),
+                                                     theTrack->GetTotalEnergy()))
                 {
-                    fEventAction->AddPhotCountX(i, 1);
                     ResetCounters();
                     theTrack->SetTrackStatus(fStopAndKill);
                     return;
                 }
-            }
-            for (int j = 0; j < 3; j++)
-            {
-                sprintf(pvname, "PhotonDetY%d", j);
-                if (thePostPVname == pvname)
+                fEventAction->AddChannelHit(channel, theTrack->GetGlobalTime()); // add
+                if (trackInformation->GetOriginCube() >= 0)
                 {
-                    fEventAction->AddPhotCountY(j, 1);
-                    ResetCounters();
-                    theTrack->SetTrackStatus(fStopAndKill);
-                    return;
-                }
-            }
-            for (int i = 0; i < 3; i++)
-            {
-                for (int j = 0; j < 3; j++)
-                {
-                    sprintf(pvname, "PhotonDetZ%d%d", i, j);
-                    if (thePostPVname == pvname)
-                    {
-                        fEventAction->AddPhotCountZ(i, j, 1); // add
-                        // fEventAction->AddPhottime(theTrack->GetGlobalTime()); // add
-                        // fEventAction->AddPhotlasttime(theTrack->GetGlobalTime()); // add
-                        fEventAction->AddHittimeZ(i, j, theTrack->GetGlobalTime()); // add
-                        // G4cout << "The time when a photn reached MPCC (for z-read out fiber_" << i << j << " ) = " << theTrack->GetGlobalTime() << G4endl;
-                        ResetCounters();
-                        theTrack->SetTrackStatus(fStopAndKill);
-                        return;
-                    }
+                    G4int cube = trackInformation->GetOriginCube();
+                    G4int relation = WLSResponseCache::kOther;
+                    for (int v = 0; v < 3; v++)
+                        if (channel == fDetector->GetCubeChannel(cube, v))
+                            relation = v;
+                    fResponseCache->AddDetected(cube, trackInformation->GetOriginVoxel(),
+                                                (WLSResponseCache::Relation) relation);
                 }
+                if (fEventAction->IsPhotonHistoryOn())
+                    fEventAction->AddDetectedPhoton(channel, theTrack->GetGlobalTime(),
+                                                    theTrack->GetTotalEnergy(),
+                                                    trackInformation->GetHistory());
+                // fEventAction->AddPhottime(theTrack->GetGlobalTime()); // add
+                // fEventAction->AddPhotlasttime(theTrack->GetGlobalTime()); // add
+                ResetCounters();
+                theTrack->SetTrackStatus(fStopAndKill);
+                return;
             }
 
             // Check if the photon hits the detector and process the hit if it does
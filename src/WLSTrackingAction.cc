@@ -52,7 +52,12 @@ void WLSTrackingAction::PreUserTrackingAction(const G4Track* aTrack)
   //Use custom trajectory class
   fpTrackingManager->SetTrajectory(new WLSTrajectory(aTrack));
 
-  WLSUserTrackInformation* trackInformation = new WLSUserTrackInformation();
+  // A wavelength-shifted photon already carries the history of the photon
+  // it was absorbed as (see PostUserTrackingAction)
+  WLSUserTrackInformation* trackInformation =
+      (WLSUserTrackInformation*) aTrack->GetUserInformation();
+  G4bool inherited = trackInformation != 0;
+  if (!inherited) trackInformation = new WLSUserTrackInformation();
 
   if (aTrack->GetMomentumDirection().z()>0.0) {
      trackInformation->AddStatusFlag(right);
@@ -65,7 +70,7 @@ void WLSTrackingAction::PreUserTrackingAction(const G4Track* aTrack)
   if (PVName == "WLSFiber" || PVName == "Clad1" || PVName == "Clad2")
      trackInformation->AddStatusFlag(InsideOfFiber);
 
-  fpTrackingManager->SetUserTrackInformation(trackInformation);
+  if (!inherited) fpTrackingManager->SetUserTrackInformation(trackInformation);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -78,6 +83,9 @@ void WLSTrackingAction::PostUserTrackingAction(const G4Track* aTrack)
 	//trajectory->SetDrawTrajectory(true); // test
 	//return;
 
+  	if (aTrack->GetDefinition()==G4OpticalPhoton::OpticalPhotonDefinition())
+     	PassHistory(aTrack);
+
   	if (aTrack->GetDefinition()==G4OpticalPhoton::OpticalPhotonDefinition()) {
 		//G4cout << "aTrack->GetDefinition()=" << aTrack->GetDefinition() << G4endl;
      	if (aTrack->GetParentID()==0) trajectory->SetDrawTrajectory(true);
@@ -93,3 +101,36 @@ void WLSTrackingAction::PostUserTrackingAction(const G4Track* aTrack)
    	trajectory->SetDrawTrajectory(true);
 	}
 }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void WLSTrackingAction::PassHistory(const G4Track* aTrack)
+{
+  G4TrackVector* secondaries = fpTrackingManager->GimmeSecondaries();
+  if (!secondaries || secondaries->empty()) return;
+
+  const WLSUserTrackInformation* info =
+      (const WLSUserTrackInformation*) aTrack->GetUserInformation();
+  const WLSPhotonHistory& parent = info->GetHistory();
+
+  for (size_t i = 0; i < secondaries->size(); i++) {
+      G4Track* secondary = (*secondaries)[i];
+      const G4VProcess* creator = secondary->GetCreatorProcess();
+      if (secondary->GetUserInformation() || !creator ||
+          creator->GetProcessName() != "OpWLS") continue;
+
+      // Reflections add up; what the absorbed photon travelled in the
+      // scintillator before the first shift is kept, later paths restart
+      WLSUserTrackInformation* daughter = new WLSUserTrackInformation();
+      WLSPhotonHistory& history = daughter->GetHistory();
+      history.cubeReflections = parent.cubeReflections;
+      history.mirrorReflections = parent.mirrorReflections;
+      history.shifts = parent.shifts + 1;
+      history.cubePathBefore =
+          parent.shifts ? parent.cubePathBefore : parent.cubePath;
+      history.energyBefore =
+          parent.shifts ? parent.energyBefore : aTrack->GetVertexKineticEnergy();
+      daughter->SetOrigin(info->GetOriginCube(), info->GetOriginVoxel());
+      secondary->SetUserInformation(daughter);
+  }
+}
@@ -40,6 +40,8 @@ WLSUserTrackInformation::WLSUserTrackInformation ()
 {
    fStatus = undefined;
    fExitPosition = G4ThreeVector(0.,0.,0.);
+   fOriginCube = -1;
+   fOriginVoxel = -1;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,131 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/WLSBoundedQueue.hh
+/// \brief Small threading helpers shared by the offline tools
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSBoundedQueue_h
+#define WLSBoundedQueue_h 1
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Multi-producer / multi-consumer FIFO with a fixed capacity.  Push()
+// blocks while the queue is full, which is what keeps the memory of the
+// offline tools bounded no matter how many input files there are.
+
+template <class T>
+class WLSBoundedQueue
+{
+  public:
+
+    explicit WLSBoundedQueue(size_t capacity)
+        : fCapacity(capacity ? capacity : 1), fClosed(false) {}
+
+    // Returns false if the queue was closed before the item could be queued
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotFull.wait(lock, [this] { return fClosed || fItems.size() < fCapacity; });
+        if (fClosed)
+            return false;
+        fItems.push_back(std::move(item));
+        fNotEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained
+    bool Pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotEmpty.wait(lock, [this] { return fClosed || !fItems.empty(); });
+        if (fItems.empty())
+            return false;
+        item = std::move(fItems.front());
+        fItems.pop_front();
+        fNotFull.notify_one();
+        return true;
+    }
+
+    // No more Push(); consumers still get what is already queued
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fClosed = true;
+        fNotEmpty.notify_all();
+        fNotFull.notify_all();
+    }
+
+  private:
+
+    size_t                  fCapacity;
+    bool                    fClosed;
+    std::deque<T>           fItems;
+    std::mutex              fMutex;
+    std::condition_variable fNotEmpty;
+    std::condition_variable fNotFull;
+};
+
+// Calls work(index, thread) for index = 0 .. n-1 on nThreads threads.
+// Items are handed out one at a time so that slow files do not stall a
+// whole static block.
+
+inline void WLSParallelFor(size_t n, unsigned nThreads,
+                           const std::function<void(size_t, unsigned)>& work)
+{
+    if (nThreads == 0)
+        nThreads = 1;
+    if (nThreads > n)
+        nThreads = n ? n : 1;
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&, t] {
+            for (size_t i = next++; i < n; i = next++)
+                work(i, t);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+}
+
+inline unsigned WLSDefaultThreads()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 4;
+}
+
+#endif
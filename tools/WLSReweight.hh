@@ -0,0 +1,159 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/WLSReweight.hh
+/// \brief Light yield under other reflectivities and attenuation lengths
+//
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
+#ifndef WLSReweight_h
+#define WLSReweight_h 1
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// One row of the "photons" ntuple (/WLS/output/photonHistory): lengths in
+// mm, wavelengths in nm, lambda0 before the first wavelength shift
+struct WLSPhotonPath
+{
+    int    nCube;       // reflections on the TiO2 coating
+    int    nMirror;     // reflections on the mirrors
+    int    nWLS;        // wavelength shifts
+    double cubePath0;   // in the scintillator, before the first shift
+    double cubePath;    // in the scintillator, after the last shift
+    double fiberPath;   // in the fiber core, after the last shift
+    double lambda0;
+    double lambda;
+};
+
+// Absorption length (mm) as a function of wavelength (nm): a constant or
+// a table, interpolated linearly and constant beyond its ends.  A length
+// of 0 means no absorption.
+class WLSAttenuation
+{
+  public:
+
+    explicit WLSAttenuation(double length = 0) : fLength(length) {}
+
+    // Rows (wavelength, length) in any order
+    explicit WLSAttenuation(std::vector<std::pair<double, double> > table)
+        : fLength(0), fTable(table)
+    {
+        std::sort(fTable.begin(), fTable.end());
+    }
+
+    double InverseLength(double lambda) const
+    {
+        double length = fLength;
+        if (!fTable.empty())
+        {
+            std::vector<std::pair<double, double> >::const_iterator hi =
+                std::lower_bound(fTable.begin(), fTable.end(), std::make_pair(lambda, 0.));
+            if (hi == fTable.begin())
+                length = hi->second;
+            else if (hi == fTable.end())
+                length = fTable.back().second;
+            else
+            {
+                std::vector<std::pair<double, double> >::const_iterator lo = hi - 1;
+                double f = (lambda - lo->first) / (hi->first - lo->first);
+                length = lo->second + f * (hi->second - lo->second);
+            }
+        }
+        return length > 0 ? 1. / length : 0.;
+    }
+
+  private:
+
+    double fLength;
+    std::vector<std::pair<double, double> > fTable;
+};
+
+// Weight of a photon detected in a reference run for a configuration that
+// differs in reflectivities or absorption lengths: the ratio of the
+// probabilities to survive the same path.  A weight can only move light
+// that the reference kept, so the reference should be the less lossy one
+// (higher reflectivity, longer lengths); weights above 1 are valid but
+// increase the variance.  Absorption in the fiber core is wavelength
+// shifting, not loss, so the fiber factor is exact only for photons that
+// shift once (nWLS == 1), which are most of them.
+class WLSReweight
+{
+  public:
+
+    WLSReweight() : fCube(1, 1), fMirror(1, 1) {}
+
+    void SetCubeReflectivity(double reference, double alternative)
+    {
+        fCube = std::make_pair(reference, alternative);
+    }
+
+    void SetMirrorReflectivity(double reference, double alternative)
+    {
+        fMirror = std::make_pair(reference, alternative);
+    }
+
+    void SetCubeAttenuation(const WLSAttenuation& reference, const WLSAttenuation& alternative)
+    {
+        fCubeLength = std::make_pair(reference, alternative);
+    }
+
+    void SetFiberAttenuation(const WLSAttenuation& reference, const WLSAttenuation& alternative)
+    {
+        fFiberLength = std::make_pair(reference, alternative);
+    }
+
+    double Weight(const WLSPhotonPath& p) const
+    {
+        double w = 1;
+        if (p.nCube > 0)
+            w *= std::pow(fCube.second / fCube.first, p.nCube);
+        if (p.nMirror > 0)
+            w *= std::pow(fMirror.second / fMirror.first, p.nMirror);
+        double exponent =
+            p.cubePath0 * Delta(fCubeLength, p.lambda0) +
+            p.cubePath * Delta(fCubeLength, p.lambda) +
+            p.fiberPath * Delta(fFiberLength, p.lambda);
+        return w * std::exp(-exponent);
+    }
+
+  private:
+
+    static double Delta(const std::pair<WLSAttenuation, WLSAttenuation>& lengths, double lambda)
+    {
+        return lengths.second.InverseLength(lambda) - lengths.first.InverseLength(lambda);
+    }
+
+    std::pair<double, double> fCube;
+    std::pair<double, double> fMirror;
+    std::pair<WLSAttenuation, WLSAttenuation> fCubeLength;
+    std::pair<WLSAttenuation, WLSAttenuation> fFiberLength;
+};
+
+#endif
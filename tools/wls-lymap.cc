@@ -0,0 +1,378 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-lymap.cc
+/// \brief Light-yield map of a position scan (compiled version of plot.C)
+//
+// Usage: wls-lymap [-d dir | -f scan.root] [-n N] [-j threads] [-o out.root] [-p prefix]
+//
+//   -d dir      directory holding root_X<i>_Y<j>.root from run.sh
+//               (default ../output, as in plot.C); N is taken from the
+//               largest i/j found unless -n is given
+//   -f file     one file with all scan points; events are binned by their
+//               primary x, y into an N x N grid over the central cube
+//   -n N        grid size (default 30 with -f)
+//   -o file     output ROOT file with the histograms and canvases
+//               (default lymap.root)
+//   -p prefix   also save the canvases as <prefix>_c1.png, _c2.png, _c3.png
+//
+//   The histograms, canvases and printed averages are those of plot.C.
+//   Like the GetMean() of its (200,0,200) histograms, the Xread, Yread and
+//   Zread means leave out events with 200 or more photons on the channel;
+//   nAllPhotoMap, filled from an automatically ranged histogram there,
+//   averages every event.
+//   Xread/Yread/Zread are the readouts of the central cube (npx1, npy1,
+//   npz11), i.e. the channels next to the cube the scan runs over.
+//   Each file is read once, with only the needed branches enabled; files
+//   (or, with -f, entry ranges) are spread over the worker threads.
+//
+
+#include "WLSBoundedQueue.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1F.h"
+#include "TH2F.h"
+#include "TCanvas.h"
+#include "TStyle.h"
+#include "TROOT.h"
+#include "TSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum { kAll, kX, kY, kZ, kNQuantities };
+
+const char* kBranches[kNQuantities] = { "nPhotons", "npx1", "npy1", "npz11" };
+
+// Half width of the scanned cube in the unit of the map axes (cm, as in
+// plot.C); the ntuple positions are in mm.
+const double kHalfCube = 0.5;
+const double kMMPerAxisUnit = 10.;
+
+// Range of the readout histograms of plot.C, outside which GetMean() does
+// not count an event
+const double kReadMax = 200.;
+
+struct WorkItem
+{
+    std::string file;
+    int         cell;       // >= 0: whole file belongs to this cell (-d)
+    Long64_t    first;      // entry range
+    Long64_t    last;
+};
+
+// Everything one thread accumulates
+struct Partial
+{
+    Partial(int ncell)
+        : sum(ncell * kNQuantities, 0.), count(ncell * kNQuantities, 0)
+    {
+        yieldX.reset(new TH1F("nPhotoXreadAll", "nPhotoXreadAll", 200, 0, 200));
+        yieldY.reset(new TH1F("nPhotoYreadAll", "nPhotoYreadAll", 200, 0, 200));
+        yieldZ.reset(new TH1F("nPhotoZreadAll", "nPhotoZreadAll", 200, 0, 200));
+    }
+
+    std::vector<double> sum;     // [cell][quantity]
+    std::vector<long>   count;   // [cell][quantity]
+    std::unique_ptr<TH1F> yieldX;
+    std::unique_ptr<TH1F> yieldY;
+    std::unique_ptr<TH1F> yieldZ;
+};
+
+bool ParseScanName(const std::string& name, int& i, int& j)
+{
+    return std::sscanf(name.c_str(), "root_X%d_Y%d.root", &i, &j) == 2;
+}
+
+void Process(const WorkItem& item, int n, Partial& p)
+{
+    std::unique_ptr<TFile> file(TFile::Open(item.file.c_str(), "READ"));
+    if (!file || file->IsZombie())
+    {
+        std::cerr << "wls-lymap: cannot open " << item.file << std::endl;
+        return;
+    }
+    TTree* tree = dynamic_cast<TTree*>(file->Get("cube"));
+    if (!tree)
+    {
+        std::cerr << "wls-lymap: no cube ntuple in " << item.file << std::endl;
+        return;
+    }
+
+    double v[kNQuantities] = { 0, 0, 0, 0 };
+    double x = 0, y = 0;
+    tree->SetBranchStatus("*", 0);
+    for (int q = 0; q < kNQuantities; q++)
+    {
+        tree->SetBranchStatus(kBranches[q], 1);
+        tree->SetBranchAddress(kBranches[q], &v[q]);
+    }
+    if (item.cell < 0)
+    {
+        tree->SetBranchStatus("x", 1);
+        tree->SetBranchStatus("y", 1);
+        tree->SetBranchAddress("x", &x);
+        tree->SetBranchAddress("y", &y);
+    }
+
+    Long64_t last = item.last < 0 ? tree->GetEntries() : item.last;
+    for (Long64_t e = item.first; e < last; e++)
+    {
+        tree->GetEntry(e);
+        int cell = item.cell;
+        if (cell < 0)
+        {
+            int i = (int) std::floor((x / kMMPerAxisUnit + kHalfCube) / (2 * kHalfCube) * n);
+            int j = (int) std::floor((y / kMMPerAxisUnit + kHalfCube) / (2 * kHalfCube) * n);
+            if (i < 0 || i >= n || j < 0 || j >= n)
+                continue;
+            cell = i * n + j;
+        }
+        for (int q = 0; q < kNQuantities; q++)
+        {
+            if (q != kAll && (v[q] < 0 || v[q] >= kReadMax))
+                continue;
+            p.sum[cell * kNQuantities + q] += v[q];
+            p.count[cell * kNQuantities + q]++;
+        }
+        p.yieldX->Fill(v[kX]);
+        p.yieldY->Fill(v[kY]);
+        p.yieldZ->Fill(v[kZ]);
+    }
+}
+
+void Usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0
+              << " [-d dir | -f scan.root] [-n N] [-j threads] [-o out.root] [-p prefix]"
+              << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = "../output";
+    std::string scanFile;
+    std::string output = "lymap.root";
+    std::string prefix;
+    int n = 0;
+    unsigned nThreads = WLSDefaultThreads();
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc)
+            dir = argv[++i];
+        else if (arg == "-f" && i + 1 < argc)
+            scanFile = argv[++i];
+        else if (arg == "-n" && i + 1 < argc)
+            n = std::atoi(argv[++i]);
+        else if (arg == "-j" && i + 1 < argc)
+            nThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "-p" && i + 1 < argc)
+            prefix = argv[++i];
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+    gROOT->SetBatch(true);
+
+    std::vector<WorkItem> items;
+    if (scanFile.empty())
+    {
+        void* d = gSystem->OpenDirectory(dir.c_str());
+        if (!d)
+        {
+            std::cerr << "wls-lymap: cannot read directory " << dir << std::endl;
+            return 1;
+        }
+        std::vector<std::pair<int, int> > index;
+        int maxIndex = -1;
+        while (const char* entry = gSystem->GetDirEntry(d))
+        {
+            int i, j;
+            if (!ParseScanName(entry, i, j))
+                continue;
+            WorkItem item;
+            item.file = dir + "/" + entry;
+            item.first = 0;
+            item.last = -1;
+            items.push_back(item);
+            index.push_back(std::make_pair(i, j));
+            if (i > maxIndex) maxIndex = i;
+            if (j > maxIndex) maxIndex = j;
+        }
+        gSystem->FreeDirectory(d);
+        if (items.empty())
+        {
+            std::cerr << "wls-lymap: no root_X*_Y*.root in " << dir << std::endl;
+            return 1;
+        }
+        if (n == 0)
+            n = maxIndex + 1;
+        for (size_t k = 0; k < items.size(); k++)
+        {
+            if (index[k].first >= n || index[k].second >= n)
+            {
+                std::cerr << "wls-lymap: " << items[k].file << " is outside the "
+                          << n << "x" << n << " grid" << std::endl;
+                return 1;
+            }
+            items[k].cell = index[k].first * n + index[k].second;
+        }
+    }
+    else
+    {
+        if (n == 0)
+            n = 30;
+        std::unique_ptr<TFile> file(TFile::Open(scanFile.c_str(), "READ"));
+        TTree* tree = file ? dynamic_cast<TTree*>(file->Get("cube")) : 0;
+        if (!tree)
+        {
+            std::cerr << "wls-lymap: no cube ntuple in " << scanFile << std::endl;
+            return 1;
+        }
+        Long64_t entries = tree->GetEntries();
+        Long64_t step = entries / (4 * nThreads) + 1;
+        for (Long64_t first = 0; first < entries; first += step)
+        {
+            WorkItem item;
+            item.file = scanFile;
+            item.cell = -1;
+            item.first = first;
+            item.last = std::min(first + step, entries);
+            items.push_back(item);
+        }
+    }
+
+    const int ncell = n * n;
+    std::vector<std::unique_ptr<Partial> > partial;
+    for (unsigned t = 0; t < nThreads; t++)
+        partial.push_back(std::unique_ptr<Partial>(new Partial(ncell)));
+
+    WLSParallelFor(items.size(), nThreads, [&](size_t k, unsigned t) {
+        Process(items[k], n, *partial[t]);
+    });
+
+    Partial total(ncell);
+    for (unsigned t = 0; t < nThreads; t++)
+    {
+        for (int c = 0; c < ncell * kNQuantities; c++)
+        {
+            total.sum[c] += partial[t]->sum[c];
+            total.count[c] += partial[t]->count[c];
+        }
+        total.yieldX->Add(partial[t]->yieldX.get());
+        total.yieldY->Add(partial[t]->yieldY.get());
+        total.yieldZ->Add(partial[t]->yieldZ.get());
+    }
+
+    gStyle->SetOptStat(0);
+    gStyle->SetNumberContours(45);
+    gStyle->SetPadRightMargin(0.12);
+
+    TH2F* map[kNQuantities];
+    const char* mapName[kNQuantities] = { "nAllPhotoMap", "nPhotoXread", "nPhotoYread", "nPhotoZread" };
+    for (int q = 0; q < kNQuantities; q++)
+        map[q] = new TH2F(mapName[q], mapName[q], n, -kHalfCube, kHalfCube, n, -kHalfCube, kHalfCube);
+
+    double aveYield[kNQuantities] = { 0, 0, 0, 0 };
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            int cell = i * n + j;
+            for (int q = 0; q < kNQuantities; q++)
+            {
+                // an empty histogram has GetMean() 0 in plot.C
+                const int c = cell * kNQuantities + q;
+                double mean = total.count[c] ? total.sum[c] / total.count[c] : 0.;
+                map[q]->SetBinContent(i + 1, j + 1, mean);
+                aveYield[q] += mean;
+            }
+        }
+    }
+
+    std::cerr << "ave Yield X = " << aveYield[kX] / std::pow(n, 2) << std::endl;
+    std::cerr << "ave Yield Y = " << aveYield[kY] / std::pow(n, 2) << std::endl;
+    std::cerr << "ave Yield Z = " << aveYield[kZ] / std::pow(n, 2) << std::endl;
+
+    TFile out(output.c_str(), "RECREATE");
+
+    TCanvas* c1 = new TCanvas("c1", "c1");
+    map[kAll]->Draw("colz");
+
+    TCanvas* c2 = new TCanvas("c2", "c2", 800, 800);
+    c2->Divide(2, 2);
+    c2->cd(1); map[kX]->Draw("colz");
+    c2->cd(2); map[kY]->Draw("colz");
+    c2->cd(3); map[kZ]->Draw("colz");
+
+    TCanvas* c3 = new TCanvas("c3", "c3", 900, 300);
+    c3->Divide(3, 1);
+    c3->cd(1); total.yieldX->Draw(" ");
+    c3->cd(2); total.yieldY->Draw(" ");
+    c3->cd(3); total.yieldZ->Draw(" ");
+
+    map[kX]->GetZaxis()->SetRangeUser(10, 35);
+    map[kY]->GetZaxis()->SetRangeUser(10, 35);
+    map[kZ]->GetZaxis()->SetRangeUser(10, 35);
+
+    out.cd();
+    for (int q = 0; q < kNQuantities; q++)
+        map[q]->Write();
+    total.yieldX->Write();
+    total.yieldY->Write();
+    total.yieldZ->Write();
+    c1->Write();
+    c2->Write();
+    c3->Write();
+    out.Close();
+
+    if (!prefix.empty())
+    {
+        c1->SaveAs((prefix + "_c1.png").c_str());
+        c2->SaveAs((prefix + "_c2.png").c_str());
+        c3->SaveAs((prefix + "_c3.png").c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,556 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-merge.cc
+/// \brief Parallel merge of sharded wls output files
+//
+// Usage: wls-merge [options] shard.root ... | -l list.txt
+//
+//   -o file     output file (default merged.root)
+//   -j n        reader threads (default: number of cores)
+//   -s          summary mode: do not copy events, only write the per-channel
+//               distributions and the mean yield per channel
+//   -l file     read the shard names from a file, one per line
+//   -q n        queue depth in chunks (default 4 per thread)
+//   -c n        rows per chunk (default 4096)
+//
+//   In the default (concatenate) mode every ntuple of the shards ("cube",
+//   "hits", "deposits" and whichever of "photons", "pde" and "arrivals" the
+//   run booked) is copied into one tree of the same name with an extra
+//   integer column "shard", and the histograms of the shards are added.
+//   The shard number is taken from the file name ("name-17.root" -> 17, as
+//   written by run100-100.sh) or, failing that, is the position of the file
+//   on the command line.  The first readable shard defines the ntuples and
+//   their columns; a shard with other ntuples or columns is skipped.
+//   Readers run concurrently, so the chunks of different shards interleave
+//   in the output: select on "shard" (and "n") rather than on the row
+//   order.  Summary mode reads only the "cube" ntuple.
+//
+//   Memory does not depend on the number of shards: readers hand fixed-size
+//   chunks to a single writer through a bounded queue, and in summary mode
+//   every thread fills its own histograms which are added at the end.
+//
+
+#include "WLSBoundedQueue.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TH1D.h"
+#include "TROOT.h"
+#include "TObjArray.h"
+#include "TKey.h"
+#include "TClass.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Chunk
+{
+    int                 shard;
+    size_t              ntuple;   // index in the ntuples of the first shard
+    size_t              rows;
+    std::vector<double> values;   // rows * ncolumns, row major
+};
+
+// Per-channel columns of the "cube" ntuple, in ntuple order
+const char* kChannels[] = {
+    "npx0", "npx1", "npx2",
+    "npy0", "npy1", "npy2",
+    "npz00", "npz01", "npz02", "npz10", "npz11", "npz12", "npz20", "npz21", "npz22"
+};
+const int kNChannels = sizeof(kChannels) / sizeof(kChannels[0]);
+
+int ShardNumber(const std::string& name, int fallback)
+{
+    // "<anything>-<digits>.root"
+    size_t dot = name.rfind(".root");
+    if (dot == std::string::npos || dot == 0)
+        return fallback;
+    size_t start = dot;
+    while (start > 0 && std::isdigit(static_cast<unsigned char>(name[start - 1])))
+        start--;
+    if (start == dot || start == 0 || name[start - 1] != '-')
+        return fallback;
+    return std::atoi(name.substr(start, dot - start).c_str());
+}
+
+std::vector<std::string> ColumnNames(TTree* tree)
+{
+    std::vector<std::string> names;
+    TObjArray* branches = tree->GetListOfBranches();
+    for (int i = 0; i < branches->GetEntries(); i++)
+        names.push_back(branches->At(i)->GetName());
+    return names;
+}
+
+struct Ntuple
+{
+    std::string              name;
+    std::string              title;
+    std::vector<std::string> columns;
+};
+
+// The ntuples (trees, with their columns) and histograms of a file, once
+// each whatever the number of key cycles
+void ListObjects(TFile* file, std::vector<Ntuple>& ntuples, std::vector<std::string>& histograms)
+{
+    TIter next(file->GetListOfKeys());
+    while (TKey* key = static_cast<TKey*>(next()))
+    {
+        TClass* type = TClass::GetClass(key->GetClassName());
+        if (!type)
+            continue;
+        std::string name = key->GetName();
+        if (type->InheritsFrom(TTree::Class()))
+        {
+            bool seen = false;
+            for (size_t i = 0; i < ntuples.size(); i++)
+                seen = seen || ntuples[i].name == name;
+            TTree* tree = seen ? 0 : dynamic_cast<TTree*>(file->Get(name.c_str()));
+            if (!tree)
+                continue;
+            Ntuple n;
+            n.name = name;
+            n.title = tree->GetTitle();
+            n.columns = ColumnNames(tree);
+            ntuples.push_back(n);
+        }
+        else if (type->InheritsFrom(TH1::Class()) &&
+                 std::find(histograms.begin(), histograms.end(), name) == histograms.end())
+            histograms.push_back(name);
+    }
+}
+
+// Opens a shard and checks that it has the ntuples of the first shard
+// (only "cube" if all is false).  Returns false (and prints why) if the
+// shard cannot be used.
+bool OpenShard(const std::string& name, const std::vector<Ntuple>& ntuples, bool all,
+               std::unique_ptr<TFile>& file, std::vector<std::string>& histograms)
+{
+    file.reset(TFile::Open(name.c_str(), "READ"));
+    if (!file || file->IsZombie())
+    {
+        std::cerr << "wls-merge: cannot open " << name << ", skipped" << std::endl;
+        return false;
+    }
+    std::vector<Ntuple> found;
+    ListObjects(file.get(), found, histograms);
+    for (size_t i = 0; i < ntuples.size(); i++)
+    {
+        if (!all && ntuples[i].name != "cube")
+            continue;
+        size_t j = 0;
+        while (j < found.size() && found[j].name != ntuples[i].name)
+            j++;
+        if (j == found.size())
+        {
+            std::cerr << "wls-merge: no " << ntuples[i].name << " ntuple in " << name
+                      << ", skipped" << std::endl;
+            return false;
+        }
+        if (found[j].columns != ntuples[i].columns)
+        {
+            std::cerr << "wls-merge: " << ntuples[i].name << " of " << name
+                      << " has different columns, skipped" << std::endl;
+            return false;
+        }
+    }
+    if (all && found.size() != ntuples.size())
+    {
+        std::cerr << "wls-merge: " << name << " has ntuples the first shard has not, skipped"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Binds every column of one ntuple of an opened shard to values[]
+TTree* BindNtuple(TFile* file, const Ntuple& ntuple, std::vector<double>& values)
+{
+    TTree* tree = dynamic_cast<TTree*>(file->Get(ntuple.name.c_str()));
+    if (!tree)
+        return 0;
+    values.assign(ntuple.columns.size(), 0.);
+    tree->SetBranchStatus("*", 1);
+    for (size_t c = 0; c < ntuple.columns.size(); c++)
+        tree->SetBranchAddress(ntuple.columns[c].c_str(), &values[c]);
+    return tree;
+}
+
+struct Summary
+{
+    Summary()
+    {
+        char name[64];
+        for (int c = 0; c < kNChannels; c++)
+        {
+            std::snprintf(name, sizeof(name), "%s", kChannels[c]);
+            fChannel[c] = new TH1D(name, name, 200, 0, 200);
+            fSum[c] = fSum2[c] = 0;
+        }
+        fNPhotons = new TH1D("nPhotons", "nPhotons", 200, 0, 20000);
+        fTime = new TH1D("time", "time", 200, 0, 100);
+        fLastTime = new TH1D("lasttime", "lasttime", 200, 0, 100);
+        fN = 0;
+    }
+
+    ~Summary()
+    {
+        for (int c = 0; c < kNChannels; c++)
+            delete fChannel[c];
+        delete fNPhotons;
+        delete fTime;
+        delete fLastTime;
+    }
+
+    void Add(const Summary& o)
+    {
+        for (int c = 0; c < kNChannels; c++)
+        {
+            fChannel[c]->Add(o.fChannel[c]);
+            fSum[c] += o.fSum[c];
+            fSum2[c] += o.fSum2[c];
+        }
+        fNPhotons->Add(o.fNPhotons);
+        fTime->Add(o.fTime);
+        fLastTime->Add(o.fLastTime);
+        fN += o.fN;
+    }
+
+    TH1D*  fChannel[kNChannels];
+    TH1D*  fNPhotons;
+    TH1D*  fTime;
+    TH1D*  fLastTime;
+    double fSum[kNChannels];
+    double fSum2[kNChannels];
+    long   fN;
+};
+
+int Index(const std::vector<std::string>& columns, const char* name)
+{
+    for (size_t c = 0; c < columns.size(); c++)
+        if (columns[c] == name)
+            return c;
+    return -1;
+}
+
+void Usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0
+              << " [-o out.root] [-j threads] [-s] [-q depth] [-c rows] [-l list] shard.root ..."
+              << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string output = "merged.root";
+    unsigned nThreads = WLSDefaultThreads();
+    bool summary = false;
+    size_t queueDepth = 0;
+    size_t chunkRows = 4096;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "-j" && i + 1 < argc)
+            nThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-s")
+            summary = true;
+        else if (arg == "-q" && i + 1 < argc)
+            queueDepth = std::atoi(argv[++i]);
+        else if (arg == "-c" && i + 1 < argc)
+            chunkRows = std::atoi(argv[++i]);
+        else if (arg == "-l" && i + 1 < argc)
+        {
+            std::ifstream list(argv[++i]);
+            std::string line;
+            while (std::getline(list, line))
+                if (!line.empty() && line[0] != '#')
+                    inputs.push_back(line);
+        }
+        else if (arg[0] == '-')
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty())
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (queueDepth == 0)
+        queueDepth = 4 * nThreads;
+    if (chunkRows == 0)
+        chunkRows = 1;
+
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+
+    // The first readable shard with a cube ntuple defines the ntuples and
+    // their columns
+    std::vector<Ntuple> ntuples;
+    std::vector<std::string> columns;
+    for (size_t i = 0; i < inputs.size() && columns.empty(); i++)
+    {
+        std::unique_ptr<TFile> f(TFile::Open(inputs[i].c_str(), "READ"));
+        if (!f || f->IsZombie())
+            continue;
+        std::vector<Ntuple> found;
+        std::vector<std::string> histograms;
+        ListObjects(f.get(), found, histograms);
+        for (size_t n = 0; n < found.size(); n++)
+            if (found[n].name == "cube")
+            {
+                ntuples = found;
+                columns = found[n].columns;
+            }
+    }
+    if (columns.empty())
+    {
+        std::cerr << "wls-merge: none of the inputs has a cube ntuple" << std::endl;
+        return 1;
+    }
+    size_t cube = 0;
+    while (ntuples[cube].name != "cube")
+        cube++;
+
+    std::vector<long> rowsPerShard(inputs.size(), -1);
+
+    if (summary)
+    {
+        int channel[kNChannels];
+        for (int c = 0; c < kNChannels; c++)
+            channel[c] = Index(columns, kChannels[c]);
+        const int iNPhotons = Index(columns, "nPhotons");
+        const int iTime = Index(columns, "time");
+        const int iLastTime = Index(columns, "lasttime");
+
+        std::vector<std::unique_ptr<Summary>> perThread(nThreads);
+        for (unsigned t = 0; t < nThreads; t++)
+            perThread[t].reset(new Summary());
+
+        WLSParallelFor(inputs.size(), nThreads, [&](size_t i, unsigned t) {
+            std::unique_ptr<TFile> file;
+            std::vector<double> values;
+            std::vector<std::string> names;
+            TTree* tree = OpenShard(inputs[i], ntuples, false, file, names)
+                              ? BindNtuple(file.get(), ntuples[cube], values) : 0;
+            if (!tree)
+                return;
+            Summary& s = *perThread[t];
+            const Long64_t n = tree->GetEntries();
+            for (Long64_t e = 0; e < n; e++)
+            {
+                tree->GetEntry(e);
+                for (int c = 0; c < kNChannels; c++)
+                {
+                    if (channel[c] < 0)
+                        continue;
+                    double v = values[channel[c]];
+                    s.fChannel[c]->Fill(v);
+                    s.fSum[c] += v;
+                    s.fSum2[c] += v * v;
+                }
+                if (iNPhotons >= 0) s.fNPhotons->Fill(values[iNPhotons]);
+                if (iTime >= 0)     s.fTime->Fill(values[iTime]);
+                if (iLastTime >= 0) s.fLastTime->Fill(values[iLastTime]);
+            }
+            s.fN += n;
+            rowsPerShard[i] = n;
+        });
+
+        Summary total;
+        for (unsigned t = 0; t < nThreads; t++)
+            total.Add(*perThread[t]);
+
+        TH1D meanYield("meanYield", "mean photons per channel", kNChannels, 0, kNChannels);
+        for (int c = 0; c < kNChannels; c++)
+        {
+            meanYield.GetXaxis()->SetBinLabel(c + 1, kChannels[c]);
+            if (total.fN == 0)
+                continue;
+            double mean = total.fSum[c] / total.fN;
+            double var = total.fSum2[c] / total.fN - mean * mean;
+            meanYield.SetBinContent(c + 1, mean);
+            meanYield.SetBinError(c + 1, var > 0 ? std::sqrt(var / total.fN) : 0);
+            std::cout << kChannels[c] << " mean = " << mean << std::endl;
+        }
+
+        TFile out(output.c_str(), "RECREATE");
+        for (int c = 0; c < kNChannels; c++)
+            total.fChannel[c]->Write();
+        total.fNPhotons->Write();
+        total.fTime->Write();
+        total.fLastTime->Write();
+        meanYield.Write();
+        out.Close();
+    }
+    else
+    {
+        WLSBoundedQueue<Chunk> queue(queueDepth);
+        long written = 0;
+
+        // Histograms of all shards, added by the readers
+        std::mutex histogramMutex;
+        std::map<std::string, std::unique_ptr<TH1> > histograms;
+
+        // Single writer: TTree::Fill is not thread safe
+        std::thread writer([&] {
+            TFile out(output.c_str(), "RECREATE");
+            std::vector<std::unique_ptr<TTree> > trees;
+            std::vector<std::vector<double> > rows(ntuples.size());
+            Int_t shard = 0;
+            for (size_t n = 0; n < ntuples.size(); n++)
+            {
+                const std::vector<std::string>& cols = ntuples[n].columns;
+                trees.emplace_back(new TTree(ntuples[n].name.c_str(), ntuples[n].title.c_str()));
+                rows[n].assign(cols.size(), 0.);
+                for (size_t c = 0; c < cols.size(); c++)
+                    trees[n]->Branch(cols[c].c_str(), &rows[n][c], (cols[c] + "/D").c_str());
+                trees[n]->Branch("shard", &shard, "shard/I");
+            }
+
+            Chunk chunk;
+            while (queue.Pop(chunk))
+            {
+                shard = chunk.shard;
+                std::vector<double>& row = rows[chunk.ntuple];
+                const size_t ncol = row.size();
+                for (size_t r = 0; r < chunk.rows; r++)
+                {
+                    std::memcpy(&row[0], &chunk.values[r * ncol], ncol * sizeof(double));
+                    trees[chunk.ntuple]->Fill();
+                }
+                if (chunk.ntuple == cube)
+                    written += chunk.rows;
+            }
+            out.cd();
+            for (size_t n = 0; n < trees.size(); n++)
+                trees[n]->Write();
+            trees.clear();
+            out.Close();
+        });
+
+        WLSParallelFor(inputs.size(), nThreads, [&](size_t i, unsigned) {
+            std::unique_ptr<TFile> file;
+            std::vector<std::string> names;
+            if (!OpenShard(inputs[i], ntuples, true, file, names))
+                return;
+            const int shard = ShardNumber(inputs[i], i);
+
+            for (size_t t = 0; t < ntuples.size(); t++)
+            {
+                std::vector<double> values;
+                TTree* tree = BindNtuple(file.get(), ntuples[t], values);
+                if (!tree)
+                    continue;
+                const size_t ncol = values.size();
+                const Long64_t n = tree->GetEntries();
+
+                Chunk chunk;
+                chunk.shard = shard;
+                chunk.ntuple = t;
+                chunk.rows = 0;
+                chunk.values.reserve(chunkRows * ncol);
+                for (Long64_t e = 0; e < n; e++)
+                {
+                    tree->GetEntry(e);
+                    chunk.values.insert(chunk.values.end(), values.begin(), values.end());
+                    if (++chunk.rows == chunkRows)
+                    {
+                        queue.Push(std::move(chunk));
+                        chunk = Chunk();
+                        chunk.shard = shard;
+                        chunk.ntuple = t;
+                        chunk.rows = 0;
+                        chunk.values.reserve(chunkRows * ncol);
+                    }
+                }
+                if (chunk.rows)
+                    queue.Push(std::move(chunk));
+                if (t == cube)
+                    rowsPerShard[i] = n;
+            }
+
+            // not attached to the file (TH1::AddDirectory(false)): ours
+            for (size_t h = 0; h < names.size(); h++)
+            {
+                std::unique_ptr<TH1> histogram(dynamic_cast<TH1*>(file->Get(names[h].c_str())));
+                if (!histogram)
+                    continue;
+                std::lock_guard<std::mutex> lock(histogramMutex);
+                std::unique_ptr<TH1>& total = histograms[names[h]];
+                if (!total)
+                    total = std::move(histogram);
+                else
+                    total->Add(histogram.get());
+            }
+        });
+        queue.Close();
+        writer.join();
+
+        if (!histograms.empty())
+        {
+            TFile out(output.c_str(), "UPDATE");
+            std::map<std::string, std::unique_ptr<TH1> >::const_iterator h;
+            for (h = histograms.begin(); h != histograms.end(); ++h)
+                h->second->Write();
+            out.Close();
+        }
+
+        std::cout << "wls-merge: " << written << " events written to " << output << std::endl;
+    }
+
+    size_t bad = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+        if (rowsPerShard[i] < 0)
+            bad++;
+    std::cout << "wls-merge: " << inputs.size() - bad << " shards read, "
+              << bad << " skipped" << std::endl;
+    return bad == inputs.size() ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-paired.cc
+/// \brief Paired light-yield differences between runs with per-event seeds
+//
+// Usage: wls-paired [-c channel] reference.root variant.root ...
+//
+//   The files are sweep points of one job with /rndm/perEvent true, e.g.
+//
+//     wls run.mac cmp "/rndm/perEvent=true" hole_radius=0.70,0.75,0.80
+//
+//   Event n of every file then started from the same random numbers, so
+//   the photons per event (all channels, or one with -c) are compared
+//   event by event: for each variant the mean difference to the reference
+//   is printed with its paired error and with the error the same numbers
+//   of independent runs would have, and the ratio of their variances (the
+//   statistics saved).  Only events present in both files are used, so
+//   the runs should not use /WLS/output/trigger.
+//
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Photons per event of a file, every event of the "cube" ntuple included
+bool ReadEvents(const std::string& name, int channel, std::map<long, double>& photons)
+{
+    std::unique_ptr<TFile> file(TFile::Open(name.c_str(), "READ"));
+    TTree* cube = file ? dynamic_cast<TTree*>(file->Get("cube")) : 0;
+    TTree* hits = file ? dynamic_cast<TTree*>(file->Get("hits")) : 0;
+    if (!cube || !hits)
+    {
+        std::cerr << "wls-paired: no cube and hits ntuples in " << name << std::endl;
+        return false;
+    }
+
+    double n = 0;
+    cube->SetBranchStatus("*", 0);
+    cube->SetBranchStatus("n", 1);
+    cube->SetBranchAddress("n", &n);
+    for (Long64_t e = 0; e < cube->GetEntries(); e++)
+    {
+        cube->GetEntry(e);
+        photons[(long) n] = 0;
+    }
+
+    double values[3];
+    const char* columns[] = { "n", "channel", "photons" };
+    hits->SetBranchStatus("*", 0);
+    for (int c = 0; c < 3; c++)
+    {
+        hits->SetBranchStatus(columns[c], 1);
+        hits->SetBranchAddress(columns[c], &values[c]);
+    }
+    for (Long64_t e = 0; e < hits->GetEntries(); e++)
+    {
+        hits->GetEntry(e);
+        if (channel <= 0 || (int) values[1] == channel)
+            photons[(long) values[0]] += values[2];
+    }
+    return true;
+}
+
+void Usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [-c channel] reference.root variant.root ..." << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int channel = 0;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc)
+            channel = std::atoi(argv[++i]);
+        else if (arg[0] != '-')
+            files.push_back(arg);
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (files.size() < 2)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::map<long, double> reference;
+    if (!ReadEvents(files[0], channel, reference) || reference.empty())
+        return 1;
+
+    std::printf("%-32s %8s %12s %12s %10s %10s %8s\n", "file", "events", "mean",
+                "difference", "paired", "unpaired", "gain");
+    for (size_t f = 1; f < files.size(); f++)
+    {
+        std::map<long, double> variant;
+        if (!ReadEvents(files[f], channel, variant))
+            continue;
+
+        // Sums over the events of both files
+        double n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sdd = 0;
+        for (std::map<long, double>::const_iterator it = variant.begin(); it != variant.end(); ++it)
+        {
+            std::map<long, double>::const_iterator ref = reference.find(it->first);
+            if (ref == reference.end())
+                continue;
+            double x = ref->second, y = it->second;
+            n += 1;
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            syy += y * y;
+            sdd += (y - x) * (y - x);
+        }
+        if (n < 2)
+        {
+            std::cerr << "wls-paired: fewer than 2 events in common with " << files[f] << std::endl;
+            continue;
+        }
+
+        double mx = sx / n, my = sy / n, d = my - mx;
+        double vx = (sxx - n * mx * mx) / (n - 1);
+        double vy = (syy - n * my * my) / (n - 1);
+        double vd = (sdd - n * d * d) / (n - 1);
+        double paired = std::sqrt(std::max(vd, 0.) / n);
+        double unpaired = std::sqrt(std::max(vx + vy, 0.) / n);
+        std::printf("%-32s %8.0f %12.4f %12.4f %10.4f %10.4f %8.1f\n", files[f].c_str(), n, my,
+                    d, paired, unpaired, paired > 0 ? unpaired * unpaired / (paired * paired) : 0.);
+    }
+    std::fprintf(stderr, "wls-paired: reference %s, %zu events\n", files[0].c_str(), reference.size());
+    return 0;
+}
@@ -0,0 +1,189 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-primaries.cc
+/// \brief Writes and dumps primary event files for /WLS/gun/file
+//
+// Usage: wls-primaries -w <file> [text]
+//        wls-primaries -d <file> [-n nrecords]
+//
+//   -w converts text (a file, or standard input) into a primary event
+//   file.  Every line is one primary:
+//
+//       event pdg energy/MeV x y z/mm dx dy dz time/ns
+//
+//   with consecutive lines of the same event number making one event;
+//   '#' starts a comment.  -22 stands for an optical photon.
+//   -d prints the records of a file in the same format (all, or the
+//   first nrecords), so that a dump converts back to the same file.
+//
+
+#include "WLSPrimaryRecord.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+int Write(const char* fileName, FILE* in)
+{
+    FILE* out = std::fopen(fileName, "wb");
+    if (!out)
+    {
+        std::fprintf(stderr, "cannot write %s\n", fileName);
+        return 1;
+    }
+    WLSPrimaryFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kWLSPrimaryMagic, sizeof(kWLSPrimaryMagic));
+    header.version = kWLSPrimaryVersion;
+    header.recordSize = sizeof(WLSPrimaryRecord);
+    std::fwrite(&header, sizeof(header), 1, out);
+
+    char line[1024];
+    long lineNumber = 0;
+    while (std::fgets(line, sizeof(line), in))
+    {
+        lineNumber++;
+        if (char* comment = std::strchr(line, '#'))
+            *comment = 0;
+        WLSPrimaryRecord r;
+        unsigned long event;
+        int n = std::sscanf(line, "%lu %d %lf %lf %lf %lf %lf %lf %lf %lf", &event, &r.pdg,
+                            &r.energy, &r.position[0], &r.position[1], &r.position[2],
+                            &r.direction[0], &r.direction[1], &r.direction[2], &r.time);
+        if (n <= 0)
+            continue;
+        if (n != 10 || (r.direction[0] == 0 && r.direction[1] == 0 && r.direction[2] == 0))
+        {
+            std::fprintf(stderr, "line %ld: expected event pdg energy x y z dx dy dz time\n",
+                         lineNumber);
+            std::fclose(out);
+            return 1;
+        }
+        r.event = event;
+        std::fwrite(&r, sizeof(r), 1, out);
+        header.count++;
+    }
+
+    std::fseek(out, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, out);
+    if (std::fclose(out) != 0)
+    {
+        std::fprintf(stderr, "cannot write %s\n", fileName);
+        return 1;
+    }
+    std::fprintf(stderr, "wls-primaries: %lu records written to %s\n",
+                 (unsigned long) header.count, fileName);
+    return 0;
+}
+
+int Dump(const char* fileName, long maxRecords)
+{
+    int fd = open(fileName, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(WLSPrimaryFileHeader))
+    {
+        std::fprintf(stderr, "cannot read %s\n", fileName);
+        return 1;
+    }
+    void* map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 1;
+
+    const WLSPrimaryFileHeader* header = static_cast<const WLSPrimaryFileHeader*>(map);
+    if (std::memcmp(header->magic, kWLSPrimaryMagic, sizeof(kWLSPrimaryMagic)) != 0 ||
+        header->version != kWLSPrimaryVersion || header->recordSize != sizeof(WLSPrimaryRecord) ||
+        sizeof(WLSPrimaryFileHeader) + header->count * sizeof(WLSPrimaryRecord) > (uint64_t) st.st_size)
+    {
+        std::fprintf(stderr, "%s is not a primary event file of version %u\n", fileName,
+                     kWLSPrimaryVersion);
+        munmap(map, st.st_size);
+        return 1;
+    }
+
+    const WLSPrimaryRecord* records = reinterpret_cast<const WLSPrimaryRecord*>(
+        static_cast<const char*>(map) + sizeof(WLSPrimaryFileHeader));
+    uint64_t n = header->count;
+    if (maxRecords >= 0 && (uint64_t) maxRecords < n)
+        n = maxRecords;
+    std::printf("# event pdg energy/MeV x y z/mm dx dy dz time/ns\n");
+    for (uint64_t k = 0; k < n; k++)
+    {
+        const WLSPrimaryRecord& r = records[k];
+        std::printf("%u %d %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n", r.event, r.pdg,
+                    r.energy, r.position[0], r.position[1], r.position[2],
+                    r.direction[0], r.direction[1], r.direction[2], r.time);
+    }
+    munmap(map, st.st_size);
+    return 0;
+}
+
+void Usage(const char* name)
+{
+    std::fprintf(stderr, "usage: %s -w <file> [text]\n"
+                         "       %s -d <file> [-n nrecords]\n", name, name);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (!std::strcmp(argv[1], "-w"))
+    {
+        FILE* in = argc > 3 ? std::fopen(argv[3], "r") : stdin;
+        if (!in)
+        {
+            std::fprintf(stderr, "cannot read %s\n", argv[3]);
+            return 1;
+        }
+        int status = Write(argv[2], in);
+        if (in != stdin)
+            std::fclose(in);
+        return status;
+    }
+    if (!std::strcmp(argv[1], "-d"))
+    {
+        long maxRecords = -1;
+        if (argc > 4 && !std::strcmp(argv[3], "-n"))
+            maxRecords = std::atol(argv[4]);
+        return Dump(argv[2], maxRecords);
+    }
+    Usage(argv[0]);
+    return 1;
+}
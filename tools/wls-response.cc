@@ -0,0 +1,251 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-response.cc
+/// \brief Summary and flagged voxels of a response cache file
+//
+// Usage: wls-response <file.wlsresp> [-e maxerror] [-f] [-m photons]
+//
+//   Reads a file written by /WLS/output/responseCache (format in
+//   WLSResponseCache.hh) and prints, per cube, the photons that started
+//   in it, the fraction detected on its X, Y and Z fiber and on other
+//   channels, and the voxels still flagged: a voxel is flagged while one
+//   of its three fiber fractions has a relative error above maxerror
+//   (default 0.1, as /WLS/output/responseMaxError).
+//   -f also lists the flagged voxels with their errors.
+//   -m prints instead a macro that fills them: for every flagged voxel a
+//   photon bomb of the given photons per event at its centre, with enough
+//   events to bring its error down to maxerror.
+//
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kNRelations = 4;   // X, Y, Z fiber of the cube, other channels
+
+struct Voxel
+{
+    int cube;
+    int index[3];
+    long emitted;
+    long detected[kNRelations];
+};
+
+struct Cache
+{
+    double voxel;
+    double size;
+    double pitch;
+    int array[3];
+    std::vector<Voxel> voxels;
+};
+
+bool Read(const char* fileName, Cache& cache)
+{
+    std::ifstream in(fileName);
+    std::string line;
+    if (!in || !std::getline(in, line) || line.compare(0, 20, "wls-response-cache 1") != 0)
+        return false;
+    cache.voxel = cache.size = cache.pitch = 0;
+    cache.array[0] = cache.array[1] = cache.array[2] = 0;
+    bool header = true;
+    while (std::getline(in, line))
+    {
+        std::istringstream is(line);
+        std::string word;
+        if (!(is >> word) || word[0] == '#')
+            continue;
+        if (header)
+        {
+            if (word == "voxel")
+                is >> cache.voxel;
+            else if (word == "size")
+                is >> cache.size;
+            else if (word == "pitch")
+                is >> cache.pitch;
+            else if (word == "array")
+                is >> cache.array[0] >> cache.array[1] >> cache.array[2];
+            else if (word == "cube")
+                header = false;
+            continue;
+        }
+        Voxel v;
+        v.cube = std::atoi(word.c_str());
+        if (!(is >> v.index[0] >> v.index[1] >> v.index[2] >> v.emitted))
+            return false;
+        for (int r = 0; r < kNRelations; r++)
+            if (!(is >> v.detected[r]))
+                return false;
+        cache.voxels.push_back(v);
+    }
+    return !header && cache.voxel > 0 && cache.size > 0 && cache.array[0] > 0;
+}
+
+// Largest relative error of the three fiber fractions, as WLSResponseCache
+double Error(const Voxel& v)
+{
+    double error = 0;
+    for (int r = 0; r < 3; r++)
+    {
+        if (v.detected[r] == 0)
+            return DBL_MAX;
+        double p = (double) v.detected[r] / v.emitted;
+        error = std::max(error, std::sqrt(std::max(0., 1 - p) / v.detected[r]));
+    }
+    return error;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <file.wlsresp> [-e maxerror] [-f] [-m photons]\n", argv[0]);
+        return 1;
+    }
+    double maxError = 0.1;
+    bool list = false;
+    long bomb = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "-e") && i + 1 < argc)
+            maxError = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "-f"))
+            list = true;
+        else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+            bomb = std::atol(argv[++i]);
+    }
+
+    Cache cache;
+    if (!Read(argv[1], cache))
+    {
+        std::fprintf(stderr, "%s: not a valid response cache\n", argv[1]);
+        return 1;
+    }
+    const int ncubes = cache.array[0] * cache.array[1] * cache.array[2];
+
+    // Per cube: photons, detected per relation, voxels, flagged voxels
+    std::vector<long> emitted(ncubes, 0);
+    std::vector<long> detected(ncubes * kNRelations, 0);
+    std::vector<long> voxels(ncubes, 0);
+    std::vector<long> flagged(ncubes, 0);
+    for (size_t i = 0; i < cache.voxels.size(); i++)
+    {
+        const Voxel& v = cache.voxels[i];
+        if (v.cube < 0 || v.cube >= ncubes)
+            continue;
+        emitted[v.cube] += v.emitted;
+        for (int r = 0; r < kNRelations; r++)
+            detected[v.cube * kNRelations + r] += v.detected[r];
+        voxels[v.cube]++;
+        if (Error(v) > maxError)
+            flagged[v.cube]++;
+    }
+
+    if (bomb > 0)
+    {
+        // Photons a voxel needs: (1 - p) / (p e^2) for its least detected
+        // fiber, with the cube average where the voxel has nothing yet
+        std::printf("# photon bombs for the voxels of %s above %g relative error\n",
+                    argv[1], maxError);
+        std::printf("/WLS/gun/bomb %ld\n", bomb);
+        for (size_t i = 0; i < cache.voxels.size(); i++)
+        {
+            const Voxel& v = cache.voxels[i];
+            if (v.cube < 0 || v.cube >= ncubes || Error(v) <= maxError)
+                continue;
+            double needed = 0;
+            for (int r = 0; r < 3; r++)
+            {
+                double p = v.detected[r] > 0 ? (double) v.detected[r] / v.emitted
+                         : emitted[v.cube] > 0 ? (double) detected[v.cube * kNRelations + r] / emitted[v.cube]
+                         : 0;
+                if (p <= 0)
+                    p = 1e-3;
+                needed = std::max(needed, (1 - p) / (p * maxError * maxError));
+            }
+            long events = (long) std::ceil((needed - v.emitted) / bomb);
+            if (events < 1)
+                events = 1;
+            int c[3] = { v.cube % cache.array[0], (v.cube / cache.array[0]) % cache.array[1],
+                         v.cube / (cache.array[0] * cache.array[1]) };
+            double x[3];
+            for (int k = 0; k < 3; k++)
+                x[k] = (c[k] - (cache.array[k] - 1) / 2.) * cache.pitch
+                       + std::min((v.index[k] + 0.5) * cache.voxel, cache.size) - cache.size / 2;
+            std::printf("/WLS/gun/bombPosition %g %g %g mm\n/run/beamOn %ld\n", x[0], x[1], x[2], events);
+        }
+        return 0;
+    }
+
+    std::printf("%s: %d x %d x %d cubes, %g mm voxels\n", argv[1],
+                cache.array[0], cache.array[1], cache.array[2], cache.voxel);
+    std::printf("%6s %12s %10s %10s %10s %10s %8s %8s\n",
+                "cube", "photons", "x", "y", "z", "other", "voxels", "flagged");
+    long total = 0;
+    long totalFlagged = 0;
+    for (int c = 0; c < ncubes; c++)
+    {
+        if (!voxels[c])
+            continue;
+        std::printf("%6d %12ld", c, emitted[c]);
+        for (int r = 0; r < kNRelations; r++)
+            std::printf(" %10.5f", (double) detected[c * kNRelations + r] / emitted[c]);
+        std::printf(" %8ld %8ld\n", voxels[c], flagged[c]);
+        total += voxels[c];
+        totalFlagged += flagged[c];
+    }
+    std::printf("%ld voxels filled, %ld above %g relative error\n", total, totalFlagged, maxError);
+
+    if (list)
+    {
+        std::printf("%6s %4s %4s %4s %12s %10s\n", "cube", "ix", "iy", "iz", "photons", "error");
+        for (size_t i = 0; i < cache.voxels.size(); i++)
+        {
+            const Voxel& v = cache.voxels[i];
+            double error = Error(v);
+            if (error <= maxError)
+                continue;
+            std::printf("%6d %4d %4d %4d %12ld ", v.cube, v.index[0], v.index[1], v.index[2], v.emitted);
+            if (error == DBL_MAX)
+                std::printf("%10s\n", "-");
+            else
+                std::printf("%10.4f\n", error);
+        }
+    }
+    return 0;
+}
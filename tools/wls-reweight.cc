@@ -0,0 +1,190 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-reweight.cc
+/// \brief Light yield per channel for other reflectivities and attenuation lengths
+//
+// Usage: wls-reweight [-r ref:alt] [-m ref:alt] [-c ref:alt] [-f ref:alt] file.root ...
+//
+//   -r ref:alt  reflectivity of the cube coating (TiO2)
+//   -m ref:alt  reflectivity of the mirrors
+//   -c ref:alt  absorption length of the scintillator, mm (0 = none)
+//   -f ref:alt  absorption length of the fiber core, mm (0 = none)
+//
+//   The files are from runs with /WLS/output/photonHistory true, made with
+//   the reference values.  Every detected photon of the "photons" ntuple
+//   is weighted by WLSReweight (WLSReweight.hh) and the photons per event
+//   of each channel are printed for the reference and the alternative,
+//   with their ratio.  The number of events is that of the "cube" ntuple,
+//   so the runs should not use /WLS/output/trigger.  Wavelength-dependent
+//   lengths need WLSAttenuation tables and a few lines around
+//   WLSReweight::Weight() instead of this tool.
+//
+
+#include "WLSReweight.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Sums
+{
+    Sums() : reference(0), weighted(0), weighted2(0) {}
+
+    double reference;
+    double weighted;
+    double weighted2;
+};
+
+bool ParsePair(const char* arg, double& reference, double& alternative)
+{
+    return std::sscanf(arg, "%lf:%lf", &reference, &alternative) == 2;
+}
+
+void Usage(const char* name)
+{
+    std::cerr << "usage: " << name
+              << " [-r ref:alt] [-m ref:alt] [-c ref:alt] [-f ref:alt] file.root ..." << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    WLSReweight reweight;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        double reference, alternative;
+        if ((arg == "-r" || arg == "-m" || arg == "-c" || arg == "-f") && i + 1 < argc)
+        {
+            if (!ParsePair(argv[++i], reference, alternative))
+            {
+                Usage(argv[0]);
+                return 1;
+            }
+            if (arg == "-r")
+                reweight.SetCubeReflectivity(reference, alternative);
+            else if (arg == "-m")
+                reweight.SetMirrorReflectivity(reference, alternative);
+            else if (arg == "-c")
+                reweight.SetCubeAttenuation(WLSAttenuation(reference), WLSAttenuation(alternative));
+            else
+                reweight.SetFiberAttenuation(WLSAttenuation(reference), WLSAttenuation(alternative));
+        }
+        else if (arg[0] != '-')
+            files.push_back(arg);
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (files.empty())
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    const char* columns[] = { "channel", "nCube", "nMirror", "nWLS",
+                              "cubePath0", "cubePath", "fiberPath", "lambda0", "lambda" };
+    const int nColumns = sizeof(columns) / sizeof(columns[0]);
+
+    std::map<int, Sums> channels;
+    long long events = 0;
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        std::unique_ptr<TFile> file(TFile::Open(files[f].c_str(), "READ"));
+        TTree* cube = file ? dynamic_cast<TTree*>(file->Get("cube")) : 0;
+        TTree* photons = file ? dynamic_cast<TTree*>(file->Get("photons")) : 0;
+        if (!cube || !photons)
+        {
+            std::cerr << "wls-reweight: no cube and photons ntuples in " << files[f]
+                      << ", skipped" << std::endl;
+            continue;
+        }
+        events += cube->GetEntries();
+
+        double values[nColumns];
+        photons->SetBranchStatus("*", 0);
+        for (int c = 0; c < nColumns; c++)
+        {
+            photons->SetBranchStatus(columns[c], 1);
+            photons->SetBranchAddress(columns[c], &values[c]);
+        }
+        Long64_t entries = photons->GetEntries();
+        for (Long64_t e = 0; e < entries; e++)
+        {
+            photons->GetEntry(e);
+            WLSPhotonPath p;
+            p.nCube = (int) values[1];
+            p.nMirror = (int) values[2];
+            p.nWLS = (int) values[3];
+            p.cubePath0 = values[4];
+            p.cubePath = values[5];
+            p.fiberPath = values[6];
+            p.lambda0 = values[7];
+            p.lambda = values[8];
+            double w = reweight.Weight(p);
+
+            Sums& s = channels[(int) values[0]];
+            s.reference += 1;
+            s.weighted += w;
+            s.weighted2 += w * w;
+        }
+    }
+    if (events == 0)
+    {
+        std::cerr << "wls-reweight: no events" << std::endl;
+        return 1;
+    }
+
+    // The error of the ratio is dominated by the spread of the weights,
+    // the photons being the same
+    std::printf("%8s %14s %14s %10s %10s\n", "channel", "reference", "alternative", "ratio", "error");
+    for (std::map<int, Sums>::const_iterator it = channels.begin(); it != channels.end(); ++it)
+    {
+        const Sums& s = it->second;
+        double ratio = s.weighted / s.reference;
+        double spread = s.weighted2 / s.reference - ratio * ratio;
+        double error = std::sqrt(std::max(spread, 0.) / s.reference);
+        std::printf("%8d %14.4f %14.4f %10.4f %10.4f\n", it->first,
+                    s.reference / events, s.weighted / events, ratio, error);
+    }
+    std::fprintf(stderr, "wls-reweight: %lld events from %zu files\n", events, files.size());
+    return 0;
+}
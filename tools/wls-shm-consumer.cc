@@ -0,0 +1,193 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/wls/tools/wls-shm-consumer.cc
+/// \brief Reference reader for the wls shared-memory event stream
+//
+// Usage: wls-shm-consumer <name> [-n nevents] [-q]
+//
+//   Attaches to the segment created by "/WLS/output/shm <name>" and prints
+//   one line per event as it is produced.  -n stops after nevents records,
+//   -q only prints the summary (events read, events lost).
+//   The consumer only reads the segment; start it before or after wls.
+//
+
+#include "WLSEventRecord.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+volatile sig_atomic_t gStop = 0;
+
+void HandleSignal(int)
+{
+    gStop = 1;
+}
+
+const WLSShmHeader* Attach(const std::string& name, size_t& size)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(WLSShmHeader))
+    {
+        close(fd);
+        return 0;
+    }
+    size = st.st_size;
+    void* addr = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return 0;
+
+    const WLSShmHeader* header = static_cast<const WLSShmHeader*>(addr);
+    if (std::memcmp(header->magic, kWLSShmMagic, sizeof(kWLSShmMagic)) != 0 ||
+        header->version != kWLSShmVersion ||
+        header->recordSize != sizeof(WLSEventRecord) ||
+        WLSShmSegmentSize(header->capacity) > size)
+    {
+        munmap(addr, size);
+        return 0;
+    }
+    return header;
+}
+
+void Print(const WLSEventRecord& r)
+{
+    double npz = 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            npz += r.npz[i][j];
+    std::printf("run %d event %d  e=%g  (%g, %g, %g)  nPhotons=%g"
+                "  npx=%g/%g/%g  npy=%g/%g/%g  npz=%g  t=%g..%g  channels=%d",
+                r.runID, r.eventID, r.energy,
+                r.position[0], r.position[1], r.position[2], r.nPhotons,
+                r.npx[0], r.npx[1], r.npx[2], r.npy[0], r.npy[1], r.npy[2],
+                npz, r.time, r.lasttime, r.nChannelsHit);
+    for (int i = 0; i < r.nChannels && i < kWLSShmMaxChannels; i++)
+        std::printf(" %d:%d", r.channels[i].channel, r.channels[i].photons);
+    std::printf(r.nChannels < r.nChannelsHit ? " ...\n" : "\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <name> [-n nevents] [-q]\n", argv[0]);
+        return 1;
+    }
+    std::string name = argv[1];
+    if (name[0] != '/')
+        name = "/" + name;
+    long maxEvents = -1;
+    bool quiet = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            maxEvents = std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "-q"))
+            quiet = true;
+    }
+
+    std::signal(SIGINT, HandleSignal);
+    std::signal(SIGTERM, HandleSignal);
+
+    size_t size = 0;
+    const WLSShmHeader* header = 0;
+    while (!gStop && !(header = Attach(name, size)))
+        usleep(100000);
+    if (!header)
+        return 0;
+
+    const WLSShmSlot* slots = reinterpret_cast<const WLSShmSlot*>(
+        reinterpret_cast<const char*>(header) + sizeof(WLSShmHeader));
+    const uint64_t capacity = header->capacity;
+
+    uint64_t next = 0;
+    long nread = 0;
+    long nlost = 0;
+    while (!gStop && (maxEvents < 0 || nread < maxEvents))
+    {
+        uint64_t written = header->writeIndex.load(std::memory_order_acquire);
+        if (written < next)
+        {
+            // the producer restarted and reset the segment
+            next = 0;
+            continue;
+        }
+        if (written == next)
+        {
+            usleep(1000);
+            continue;
+        }
+        if (written - next > capacity)
+        {
+            // too slow: skip to the oldest slot that can still be valid
+            nlost += written - next - capacity;
+            next = written - capacity;
+        }
+
+        const WLSShmSlot& slot = slots[next % capacity];
+        const uint64_t expected = 2 * next + 2;
+        uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq < expected)
+        {
+            // ticket taken but record not complete yet
+            usleep(100);
+            continue;
+        }
+        WLSEventRecord record;
+        std::memcpy(&record, &slot.record, sizeof(WLSEventRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq != expected || slot.sequence.load(std::memory_order_relaxed) != expected)
+        {
+            nlost++;
+            next++;
+            continue;
+        }
+        next++;
+        nread++;
+        if (!quiet)
+            Print(record);
+    }
+
+    std::fprintf(stderr, "wls-shm-consumer: %ld events read, %ld lost\n", nread, nlost);
+    munmap(const_cast<WLSShmHeader*>(header), size);
+    return 0;
+}
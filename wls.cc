@@ -30,14 +30,6 @@
 //
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-#ifndef WIN32
-    #include <unistd.h>
-#endif
-
-// #include <regex>
-// #include <iostream>
-// using namespace std;
-
 #ifdef G4MULTITHREADED
     #include "G4MTRunManager.hh"
 #else
@@ -48,6 +40,7 @@
 
 #include "Randomize.hh"
 
+#include "WLSCommandLine.hh"
 #include "WLSPhysicsList.hh"
 #include "WLSDetectorConstruction.hh"
 
@@ -61,130 +54,40 @@
     #include "G4UIExecutive.hh"
 #endif
 
-// argc holds the number of arguments (including the name) on the command line
-// -> it is ONE when only the name is  given !!!
-// argv[0] is always the name of the program
-// argv[1] points to the first argument, and so on
-// please
+// The arguments are described in WLSCommandLine.hh
 // ....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 int main(int argc, char** argv)
 {
-    #ifdef G4MULTITHREADED
-        G4MTRunManager* runManager = new G4MTRunManager;
-    #else
-
-
-
-        G4String inpName;
-        if (argc > 2)
-            inpName = argv[2];
-        else
-            inpName = "cube";
-
-        G4int seed = 123;
-        G4double fiber_length = 200;  // cm
-        G4double gap_length = fiber_length/2;
-        G4double mirror_reflectivity = 0;
-        G4double cube_reflectivity = 0.97;
-
-        if (argc > 3)
-        {
-            seed = atoi(argv[3]);
-            // regex search_regex(R"(^(seed|fiber_length|gap_length|mirror_reflectivity|cube_reflectivity)\s*=\s*(([1-9]\d*|0)(\.\d+)?$))");
-            // smatch matched_words;
-            // for(int i=3; i<argc; i++)
-            // {
-            //     string arg = argv[i];
-            //     if(regex_match(arg, matched_words, search_regex))
-            //     {
-            //         cout << matched_words[1] << ": " << matched_words[2] << endl;
-            //         if(matched_words[1] == "seed")
-            //         {
-            //             seed = stoi(matched_words[2]);
-            //         }
-            //         else if(matched_words[1] == "fiber_length")
-            //         {
-            //             fiber_length = stod(matched_words[2]);
-            //         }
-            //         else if(matched_words[1] == "gap_length")
-            //         {
-            //             gap_length = stod(matched_words[2]);
-            //         }
-            //         else if(matched_words[1] == "mirror_reflectivity")
-            //         {
-            //             mirror_reflectivity = stod(matched_words[2]);
-            //         }
-            //         else if(matched_words[1] == "cube_reflectivity")
-            //         {
-            //             cube_reflectivity = stod(matched_words[2]);
-            //         }
-            //         else
-            //         {
-            //             cerr << "Parameter setting error!" << endl;
-            //             return 1;
-            //         }
-            //     }
-            // }
-        }
-        if(argc > 4)
-        {
-            G4cerr << "wls <macro file name> <root file name> <seed>" << G4endl;
-            return 1;
-
-        }
-
-        if (argv[1] != NULL)
-        {
-            G4cout << "input macro name is " << argv[1] << G4endl;
-        }
+    WLSCommandLine commandLine;
+    if (!commandLine.Parse(argc, argv))
+        return 1;
+    commandLine.Print();
 
-        G4cout << "input rootfile name: " << inpName << G4endl;
+    // Choose the Random engine and set the seed
 
-        G4cout << "seed: " << seed << G4endl;
-        G4cout << "fiber_length: " << fiber_length << G4endl;
-        G4cout << "gap_length: " << gap_length <<G4endl;
-        G4cout << "mirror_reflectivity: " << mirror_reflectivity <<G4endl;
-        G4cout << "cube_reflectivity: " << cube_reflectivity << G4endl;
-
-        // Choose the Random engine and set the seed
-
-        G4Random::setTheEngine(new CLHEP::RanecuEngine);
-        G4Random::setTheSeed(seed);
+    G4Random::setTheEngine(new CLHEP::RanecuEngine);
+    G4Random::setTheSeed(commandLine.GetSeed());
 
+    #ifdef G4MULTITHREADED
+        G4MTRunManager* runManager = new G4MTRunManager;
+    #else
         G4RunManager* runManager = new G4RunManager;
     #endif
 
-    G4String physName = "QGSP_BERT_HP";
-
-    #ifndef WIN32
-        G4int c = 0;
-        while ((c = getopt(argc, argv, "p")) != -1)
-        {
-            switch (c)
-            {
-                case 'p':
-                    physName = optarg;
-                    G4cout << "Physics List used is " <<  physName << G4endl;
-                    break;
-                case ':': /* -p without operand */
-                    fprintf(stderr, "Option -%c requires an operand\n", optopt);
-                    break;
-                case '?':
-                    fprintf(stderr, "Unrecognised option: -%c\n", optopt);
-            }
-        }
-    #endif
-
     // Set mandatory initialization classes
     //
     // Detector construction
+    G4double fiber_length = commandLine.GetValue("fiber_length", 200);  // cm
+    G4double gap_length = commandLine.GetValue("gap_length", fiber_length / 2);
+    G4double mirror_reflectivity = commandLine.GetValue("mirror_reflectivity", 0);
+    G4double cube_reflectivity = commandLine.GetValue("cube_reflectivity", 0.97);
     WLSDetectorConstruction* detector = new WLSDetectorConstruction(fiber_length, gap_length, mirror_reflectivity, cube_reflectivity);
     runManager->SetUserInitialization(detector);
     // Physics list
-    runManager->SetUserInitialization(new WLSPhysicsList(physName));
+    runManager->SetUserInitialization(new WLSPhysicsList(commandLine.GetPhysicsList()));
     // User action initialization
-    runManager->SetUserInitialization(new WLSActionInitialization(detector, inpName));
+    runManager->SetUserInitialization(new WLSActionInitialization(detector, commandLine.GetName()));
 
     #ifdef G4VIS_USE
         // Initialize visualization
@@ -199,32 +102,33 @@ int main(int argc, char** argv)
 
     G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
-    #ifndef WIN32
-        G4int optmax = argc;
-        if (argc > 2)
-        {
-            optmax = optmax - 1;
-        }
-
-        if (optind < optmax)
-        {
-            G4String command = "/control/execute ";
-            for (; optind < optmax; optind++)
-            {
-                G4String macroFilename = argv[optind];
-                UImanager->ApplyCommand(command + macroFilename);
-            }
-        }
-    #else // Simple UI for Windows runs, no possibility of additional arguments
-        if (argc != 1)
+    if (commandLine.GetMacro() != "")
+    {
+        // One pass of the macro per combination of the swept values.  The
+        // physics is built by the first /run/initialize only; later passes
+        // rebuild the geometry (or just update surfaces and materials).
+        // Every pass starts from the same seed.
+        G4int npoints = commandLine.GetNumberOfPoints();
+        for (G4int i = 0; i < npoints; i++)
         {
-            G4String command = "/control/execute ";
-            G4String fileName = argv[1];
-            UImanager->ApplyCommand(command + fileName);
+            if (npoints > 1)
+                G4cout << "### Sweep point " << i + 1 << "/" << npoints << " : "
+                       << commandLine.GetName(i) << G4endl;
+            G4Random::setTheSeed(commandLine.GetSeed());
+            std::vector<G4String> commands = commandLine.GetCommands(i);
+            for (size_t c = 0; c < commands.size(); c++)
+                UImanager->ApplyCommand(commands[c]);
+            UImanager->ApplyCommand("/WLS/output/fileName " + commandLine.GetName(i));
+            UImanager->ApplyCommand("/control/execute " + commandLine.GetMacro());
         }
-    #endif
+    }
     else
     {
+        // '/' commands given on the command line still apply
+        std::vector<G4String> commands = commandLine.GetCommands(0);
+        for (size_t c = 0; c < commands.size(); c++)
+            UImanager->ApplyCommand(commands[c]);
+
         // Define (G)UI terminal for interactive mode
         #ifdef G4UI_USE
             G4UIExecutive* ui = new G4UIExecutive(argc, argv);